@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,6 +18,9 @@ enum scoreboard_log_level {
 typedef void (*scoreboard_log_fn)(enum scoreboard_log_level level,
 				  const char *message);
 
+/* Monotonic nanoseconds; any fixed origin */
+typedef uint64_t (*scoreboard_time_fn)(void);
+
 enum scoreboard_clock_direction {
 	SCOREBOARD_CLOCK_COUNT_DOWN = 0,
 	SCOREBOARD_CLOCK_COUNT_UP
@@ -63,19 +67,65 @@ struct scoreboard_penalty {
 const char *scoreboard_description(void);
 bool scoreboard_on_load(scoreboard_log_fn log_fn);
 void scoreboard_on_unload(scoreboard_log_fn log_fn);
+/* Also freezes the time source, so only scoreboard_clock_tick() moves a
+   running clock until a test installs its own */
 void scoreboard_reset_state_for_tests(void);
 
+/* Contexts — one per game, for running several rinks from one process.
+   Every other scoreboard_* call without a _ctx suffix acts on the
+   selected context, which starts out as the default one, so single-game
+   callers need no changes. Each context has its own state, output
+   directory, dirty set, write stats, event log and clock. Selecting a
+   destroyed context is ignored; destroying the selected one selects the
+   default. Not thread-safe: pick one thread to drive every context. */
+#define SCOREBOARD_MAX_CONTEXTS 4
+
+struct scoreboard_ctx;
+
+struct scoreboard_ctx *scoreboard_ctx_create(void);
+void scoreboard_ctx_destroy(struct scoreboard_ctx *ctx);
+struct scoreboard_ctx *scoreboard_ctx_default(void);
+struct scoreboard_ctx *scoreboard_ctx_current(void);
+/* Returns the previously selected context */
+struct scoreboard_ctx *scoreboard_ctx_select(struct scoreboard_ctx *ctx);
+/* The per-tick and per-write calls for one given context, so a caller
+   driving several never has to select one or put the selection back.
+   A destroyed context is left alone: not dirty, no deadline, no write. */
+void scoreboard_clock_sync_ctx(struct scoreboard_ctx *ctx);
+int64_t scoreboard_ns_until_display_change_ctx(struct scoreboard_ctx *ctx);
+bool scoreboard_is_dirty_ctx(struct scoreboard_ctx *ctx);
+bool scoreboard_write_all_files_ctx(struct scoreboard_ctx *ctx);
+
 /* Clock */
 void scoreboard_clock_start(void);
 void scoreboard_clock_stop(void);
 bool scoreboard_clock_is_running(void);
 void scoreboard_clock_reset(void);
+/* Test-only: advances a running clock by hand. Ignored unless
+   scoreboard_reset_state_for_tests() froze the time source, since a
+   measured clock would count the same time twice. */
 void scoreboard_clock_tick(int elapsed_tenths);
+/* Running time is measured from the moment the clock started, not summed
+   from ticks. Sync applies whatever whole tenths have elapsed since then
+   and not yet been applied, to the clock and running penalties alike, so
+   it may be called at any rate without losing or gaining time. Stopping
+   the clock syncs first. NULL restores the platform monotonic clock. */
+void scoreboard_clock_sync(void);
+void scoreboard_set_time_source(scoreboard_time_fn fn);
+/* The running value, derived from the start time whether or not a sync
+   has applied it yet; so is scoreboard_clock_format() */
 int scoreboard_clock_get_tenths(void);
 void scoreboard_clock_set_tenths(int tenths);
 void scoreboard_clock_adjust_seconds(int delta);
 void scoreboard_clock_adjust_minutes(int delta);
 void scoreboard_clock_format(char *buf, size_t size);
+/* Tenths of running time until the clock or a running penalty next
+   changes its displayed text (or the clock runs out); -1 while the clock
+   is stopped, since nothing changes on its own then */
+int scoreboard_tenths_until_display_change(void);
+/* The same deadline measured on the time source: nanoseconds from now
+   until a sync would change the display; -1 while stopped */
+int64_t scoreboard_ns_until_display_change(void);
 
 void scoreboard_set_clock_direction(enum scoreboard_clock_direction dir);
 enum scoreboard_clock_direction scoreboard_get_clock_direction(void);
@@ -190,9 +240,230 @@ void scoreboard_format_penalty_time(int slot, bool home, char *buf,
 void scoreboard_format_all_penalty_numbers(bool home, char *buf, size_t size);
 void scoreboard_format_all_penalty_times(bool home, char *buf, size_t size);
 
-/* Dirty flag — true when internal state has changed since last write */
+/* Output files — one dirty bit per file in the output directory */
+enum scoreboard_output_field {
+	SCOREBOARD_FIELD_CLOCK = 0,
+	SCOREBOARD_FIELD_PERIOD,
+	SCOREBOARD_FIELD_HOME_NAME,
+	SCOREBOARD_FIELD_AWAY_NAME,
+	SCOREBOARD_FIELD_HOME_SCORE,
+	SCOREBOARD_FIELD_AWAY_SCORE,
+	SCOREBOARD_FIELD_HOME_SHOTS,
+	SCOREBOARD_FIELD_AWAY_SHOTS,
+	SCOREBOARD_FIELD_HOME_FACEOFFS,
+	SCOREBOARD_FIELD_AWAY_FACEOFFS,
+	SCOREBOARD_FIELD_HOME_FOULS,
+	SCOREBOARD_FIELD_AWAY_FOULS,
+	SCOREBOARD_FIELD_HOME_FOULS2,
+	SCOREBOARD_FIELD_AWAY_FOULS2,
+	SCOREBOARD_FIELD_HOME_PENALTY_NUMBERS,
+	SCOREBOARD_FIELD_HOME_PENALTY_TIMES,
+	SCOREBOARD_FIELD_AWAY_PENALTY_NUMBERS,
+	SCOREBOARD_FIELD_AWAY_PENALTY_TIMES,
+	SCOREBOARD_FIELD_SPORT,
+	SCOREBOARD_FIELD_DEFAULT_PENALTY_DURATION,
+	SCOREBOARD_FIELD_DEFAULT_MAJOR_PENALTY_DURATION,
+	SCOREBOARD_FIELD_PERIOD_LABELS,
+	SCOREBOARD_FIELD_COUNT
+};
+
+#define SCOREBOARD_FIELD_BIT(field) (1u << (field))
+#define SCOREBOARD_FIELDS_ALL ((1u << SCOREBOARD_FIELD_COUNT) - 1u)
+
+const char *scoreboard_output_field_filename(enum scoreboard_output_field field);
+void scoreboard_format_output_field(enum scoreboard_output_field field,
+				    char *buf, size_t size);
+
+/* Dirty flag — true when internal state has changed since last write.
+   Files the writer thread failed to publish count as dirty again. */
 bool scoreboard_is_dirty(void);
 void scoreboard_mark_dirty(void);
+unsigned int scoreboard_get_dirty_fields(void);
+
+/* Write statistics — files rewritten vs. skipped because unchanged */
+struct scoreboard_write_stats {
+	unsigned long long writes;
+	unsigned long long files_written;
+	unsigned long long files_skipped;
+	unsigned long long write_errors;
+};
+
+void scoreboard_get_write_stats(struct scoreboard_write_stats *out);
+void scoreboard_reset_write_stats(void);
+
+/* Performance counters — calls, total and worst latency and a fixed
+   bucket latency histogram for each instrumented path. The core times
+   file writes and reads itself; the dock records its label refresh and
+   tick. Paths are recorded on the thread that owns the scoreboard state;
+   the writer thread keeps its own counters in scoreboard_writer_stats. */
+enum scoreboard_perf_path {
+	SCOREBOARD_PERF_WRITE_FILES = 0,
+	SCOREBOARD_PERF_READ_FILES,
+	SCOREBOARD_PERF_UPDATE_LABELS,
+	SCOREBOARD_PERF_TICK,
+	SCOREBOARD_PERF_PATH_COUNT
+};
+
+#define SCOREBOARD_PERF_BUCKETS 8
+
+struct scoreboard_perf_stats {
+	unsigned long long calls;
+	unsigned long long items; /* files written, where that applies */
+	unsigned long long total_ns;
+	unsigned long long max_ns;
+	unsigned long long buckets[SCOREBOARD_PERF_BUCKETS];
+};
+
+uint64_t scoreboard_perf_now(void);
+/* Upper bound of a histogram bucket in ns; 0 for the open-ended last */
+uint64_t scoreboard_perf_bucket_limit_ns(int bucket);
+const char *scoreboard_perf_path_name(enum scoreboard_perf_path path);
+void scoreboard_perf_add(struct scoreboard_perf_stats *stats, uint64_t ns,
+			 unsigned int items);
+void scoreboard_perf_record(enum scoreboard_perf_path path, uint64_t start_ns,
+			    unsigned int items);
+void scoreboard_get_perf_stats(enum scoreboard_perf_path path,
+			       struct scoreboard_perf_stats *out);
+void scoreboard_reset_perf_stats(void);
+/* Plain-text report of every path plus the writer thread */
+size_t scoreboard_format_perf_stats(char *buf, size_t size);
+bool scoreboard_write_perf_stats(const char *path);
+
+/* Background output writer — while running, file output is handed to a
+   worker thread that publishes each file via temp file plus rename and
+   drops values superseded before they reach disk */
+struct scoreboard_writer_stats {
+	unsigned long long queued;
+	unsigned long long written;
+	unsigned long long coalesced;
+	unsigned long long errors;
+	struct scoreboard_perf_stats replace; /* per file, on the thread */
+};
+
+bool scoreboard_writer_start(void);
+void scoreboard_writer_stop(void);
+bool scoreboard_writer_is_running(void);
+bool scoreboard_writer_submit(const char *path, const char *content);
+void scoreboard_writer_flush(void);
+/* Hands each path whose latest write failed on the worker to fn, on the
+   caller's thread; a path fn returns true for is forgotten, the rest are
+   kept for another caller. Returns how many were taken. */
+typedef bool (*scoreboard_writer_failed_fn)(const char *path, void *data);
+int scoreboard_writer_take_failed(scoreboard_writer_failed_fn fn, void *data);
+void scoreboard_writer_get_stats(struct scoreboard_writer_stats *out);
+
+/* Shared-memory snapshot — publishes a seqlock-guarded copy of the state
+   for other local processes; see scoreboard-shm.h for layout and reader.
+   scoreboard_shm_publish() returns true only if the state changed. */
+#define SCOREBOARD_SHM_DEFAULT_NAME "streamn-scoreboard"
+
+bool scoreboard_shm_open(const char *name);
+void scoreboard_shm_close(void);
+bool scoreboard_shm_is_open(void);
+bool scoreboard_shm_publish(void);
+
+/* Local HTTP feed — serves the JSON snapshot at /state and pushes changed
+   fields to /events (Server-Sent Events) on 127.0.0.1 only. Port 0 picks
+   a free port. scoreboard_http_publish() runs on the thread that owns the
+   scoreboard state and returns true if anything changed. */
+bool scoreboard_http_start(unsigned short port);
+void scoreboard_http_stop(void);
+bool scoreboard_http_is_running(void);
+unsigned short scoreboard_http_get_port(void);
+bool scoreboard_http_publish(void);
+
+/* Command queue — how threads other than the one that owns the scoreboard
+   change it. Any thread may post; posting never blocks or locks and fails
+   only when the ring is full. The owner thread drains in batches of up to
+   one ring's worth, applying built-in commands itself and handing types
+   from SCOREBOARD_CMD_USER up to the callback. */
+#define SCOREBOARD_COMMAND_CAPACITY 256
+
+enum scoreboard_team {
+	/* For game events that belong to neither team */
+	SCOREBOARD_TEAM_NONE = -1,
+	SCOREBOARD_TEAM_HOME = 0,
+	SCOREBOARD_TEAM_AWAY,
+};
+
+enum scoreboard_command_type {
+	SCOREBOARD_CMD_NONE = 0,
+	SCOREBOARD_CMD_CLOCK_START,
+	SCOREBOARD_CMD_CLOCK_STOP,
+	SCOREBOARD_CMD_CLOCK_TOGGLE,
+	SCOREBOARD_CMD_CLOCK_RESET,
+	SCOREBOARD_CMD_CLOCK_ADJUST_SECONDS, /* a = seconds */
+	SCOREBOARD_CMD_PERIOD_ADVANCE,
+	SCOREBOARD_CMD_PERIOD_REWIND,
+	/* a = team, b = +1 or -1 */
+	SCOREBOARD_CMD_SCORE,
+	SCOREBOARD_CMD_SHOTS,
+	SCOREBOARD_CMD_FACEOFFS,
+	SCOREBOARD_CMD_FOULS,
+	SCOREBOARD_CMD_FOULS2,
+	SCOREBOARD_CMD_PENALTY_ADD,   /* a = team, b = player, c = seconds */
+	SCOREBOARD_CMD_PENALTY_CLEAR, /* a = team, b = slot */
+	SCOREBOARD_CMD_USER = 1024
+};
+
+struct scoreboard_command {
+	int32_t type;
+	int32_t a;
+	int32_t b;
+	int32_t c;
+};
+
+struct scoreboard_command_stats {
+	uint32_t posted;
+	uint32_t applied;
+	uint32_t dropped;
+};
+
+typedef void (*scoreboard_command_fn)(const struct scoreboard_command *cmd,
+				      void *data);
+
+bool scoreboard_command_post(const struct scoreboard_command *cmd);
+int scoreboard_command_drain(scoreboard_command_fn user_fn, void *data);
+/* Applies one built-in command right away, on the owner thread */
+void scoreboard_command_apply(const struct scoreboard_command *cmd);
+void scoreboard_command_get_stats(struct scoreboard_command_stats *out);
+void scoreboard_command_reset_stats(void);
+
+/* Command trace — while recording, every drained command is written with
+   the time it was applied, after a snapshot of the game it started from.
+   Any other change to the game (a button, a dialog, a reload, whatever a
+   USER command's callback did) is written as the state it changed, once
+   it reaches the output files or the next command. A replay loads the
+   snapshot and applies the commands and changes again with the clock
+   driven from the recorded times: at recorded speed (1.0), N times
+   faster, or as fast as possible (speed <= 0). USER types go to the
+   callback. Output files are written after each command or change when
+   an output directory is set. Only fails for a missing or damaged
+   trace. */
+struct scoreboard_replay_stats {
+	uint32_t commands;
+	uint32_t user_commands;
+	/* State words recorded outside any built-in command */
+	uint32_t changes;
+	/* Game time the trace covers, and wall time the replay took */
+	uint64_t trace_ns;
+	uint64_t elapsed_ns;
+	/* The trace ran to its end and the final outputs are the ones
+	   recorded when it stopped */
+	bool outputs_match;
+};
+
+bool scoreboard_trace_start(const char *path);
+/* Called by scoreboard_command_drain() before each command, and after a
+   built-in one: replaying it gives the state it left, so none of that is
+   written as a change. Both are no-ops unless recording this context. */
+void scoreboard_trace_record(const struct scoreboard_command *cmd);
+void scoreboard_trace_record_applied(void);
+bool scoreboard_trace_stop(void);
+bool scoreboard_trace_is_recording(void);
+bool scoreboard_trace_replay(const char *path, double speed,
+			     scoreboard_command_fn user_fn, void *data,
+			     struct scoreboard_replay_stats *out);
 
 /* File output */
 void scoreboard_set_output_directory(const char *path);
@@ -200,9 +471,102 @@ const char *scoreboard_get_output_directory(void);
 bool scoreboard_write_all_files(void);
 bool scoreboard_read_all_files(void);
 
-/* State persistence */
+/* Output mode — per-field text files, or the whole snapshot in one file.
+   Snapshot values are the exact text the per-field files would hold. */
+enum scoreboard_output_mode {
+	SCOREBOARD_OUTPUT_FILES = 0,
+	SCOREBOARD_OUTPUT_JSON,
+	SCOREBOARD_OUTPUT_KEY_VALUE,
+	SCOREBOARD_OUTPUT_MODE_COUNT
+};
+
+void scoreboard_set_output_mode(enum scoreboard_output_mode mode);
+enum scoreboard_output_mode scoreboard_get_output_mode(void);
+const char *scoreboard_output_mode_name(enum scoreboard_output_mode mode);
+enum scoreboard_output_mode scoreboard_output_mode_from_name(const char *name);
+const char *scoreboard_output_mode_filename(enum scoreboard_output_mode mode);
+size_t scoreboard_format_output_snapshot(enum scoreboard_output_mode mode,
+					 char *buf, size_t size);
+/* Same layout as the snapshot, restricted to the fields in the bitmask */
+size_t scoreboard_format_output_fields(enum scoreboard_output_mode mode,
+				       unsigned int fields, char *buf,
+				       size_t size);
+
+/* State persistence — the JSON state lives in two slot files, path.0 and
+   path.1, written alternately, each with a save generation and a CRC-32.
+   Loading takes the newest intact slot, or a plain file at path when
+   there is none, and fails without applying anything if only damaged
+   slots are left. */
 bool scoreboard_save_state(const char *path);
 bool scoreboard_load_state(const char *path);
+/* Advances with every change to the selected context's state */
+uint64_t scoreboard_state_generation(void);
+/* A copy of the state taken on the owning thread that any thread can then
+   save to the same slot files as scoreboard_save_state() */
+struct scoreboard_saved_state;
+size_t scoreboard_saved_state_size(void);
+void scoreboard_capture_state(struct scoreboard_saved_state *out);
+bool scoreboard_save_captured_state(const struct scoreboard_saved_state *in,
+				    const char *path);
+
+/* Autosave — scoreboard_autosave() is meant for a periodic timer on the
+   owning thread. When the state generation has moved since the last save
+   it copies the selected context's state and hands it to a worker thread
+   that serializes and writes it; otherwise it returns false at once. A
+   copy still waiting is replaced by the newer one. If the worker can't
+   start, saves happen on the calling thread. */
+struct scoreboard_autosave_stats {
+	unsigned long long queued;
+	unsigned long long saved;
+	unsigned long long unchanged;
+	unsigned long long coalesced;
+	unsigned long long errors;
+	struct scoreboard_perf_stats save; /* per save, on the thread */
+};
+
+bool scoreboard_autosave_start(const char *path);
+void scoreboard_autosave_stop(void);
+bool scoreboard_autosave_is_running(void);
+bool scoreboard_autosave(void);
+void scoreboard_autosave_flush(void);
+void scoreboard_autosave_get_stats(struct scoreboard_autosave_stats *out);
+
+/* Binary state snapshot — the same state as the JSON form in a versioned,
+   checksummed file of fixed-offset sections, loaded straight from a
+   read-only mapping. A damaged or foreign file is rejected whole. The
+   converters leave the live state untouched. */
+bool scoreboard_save_state_binary(const char *path);
+bool scoreboard_load_state_binary(const char *path);
+bool scoreboard_convert_state_to_binary(const char *json_path,
+					const char *binary_path);
+bool scoreboard_convert_state_to_json(const char *binary_path,
+				      const char *json_path);
+
+/* State journal — crash recovery from a binary snapshot plus an append-only
+   journal of fixed-size records, one per changed snapshot word.
+   scoreboard_journal_open() first replays whatever snapshot and journal
+   the paths hold into the live state, then checkpoints. While open, each
+   scoreboard_write_all_files() appends the changes since the last one
+   (scoreboard_journal_sync()), and a checkpoint rewrites the snapshot and
+   truncates the journal once it grows long. Closing checkpoints and marks
+   the journal closed cleanly; the next open then replays nothing, so
+   after a normal shutdown the output files stay the source of truth. A
+   crash replay leaves the clock stopped. The journal belongs to the
+   context it was opened in. */
+enum scoreboard_journal_recovery {
+	SCOREBOARD_JOURNAL_EMPTY,     /* no usable snapshot at the path */
+	SCOREBOARD_JOURNAL_CLEAN,     /* closed cleanly; nothing replayed */
+	SCOREBOARD_JOURNAL_RECOVERED, /* crashed; everything replayed */
+};
+
+bool scoreboard_journal_open(const char *snapshot_path,
+			     const char *journal_path);
+void scoreboard_journal_close(void);
+bool scoreboard_journal_is_open(void);
+/* What the last scoreboard_journal_open() found */
+enum scoreboard_journal_recovery scoreboard_journal_get_recovery(void);
+bool scoreboard_journal_sync(void);
+bool scoreboard_journal_checkpoint(void);
 
 /* Game management */
 void scoreboard_new_game(void);
@@ -233,18 +597,105 @@ const char *scoreboard_get_score_label(void);
 void scoreboard_add_action_log(const char *message);
 size_t scoreboard_copy_action_logs(char *buffer, size_t buffer_size);
 
-/* Game event log — append-only timestamped events for YouTube chapters */
-#define SCOREBOARD_MAX_EVENTS 256
+/* Timeline — the stream's and the recording's start, stop, pause and
+   resume marks on the monotonic clock (the time source set with
+   scoreboard_set_time_source()). Events keep the time they were logged,
+   and their offsets into the stream or recording are worked out from the
+   marks only when asked for, so one event gets an exact offset in both,
+   however often the recording was paused. Offsets are into the latest
+   stream or recording, and -1 for a time outside it; a time inside a
+   pause is where the pause began. The timeline is shared by all
+   contexts. scoreboard_timeline_mark() returns false for a move OBS
+   can't make, such as a pause while stopped. */
+enum scoreboard_timeline {
+	SCOREBOARD_TIMELINE_STREAM = 0,
+	SCOREBOARD_TIMELINE_RECORDING,
+	SCOREBOARD_TIMELINE_COUNT,
+};
+
+enum scoreboard_timeline_mark {
+	SCOREBOARD_MARK_START = 0,
+	SCOREBOARD_MARK_STOP,
+	SCOREBOARD_MARK_PAUSE,
+	SCOREBOARD_MARK_RESUME,
+};
+
+uint64_t scoreboard_timeline_now(void);
+bool scoreboard_timeline_mark(enum scoreboard_timeline tl,
+			      enum scoreboard_timeline_mark mark,
+			      uint64_t time_ns);
+/* Started and not stopped; a paused recording is still active */
+bool scoreboard_timeline_is_active(enum scoreboard_timeline tl);
+bool scoreboard_timeline_is_paused(enum scoreboard_timeline tl);
+int64_t scoreboard_timeline_offset_ns(enum scoreboard_timeline tl,
+				      uint64_t time_ns);
+/* Up to its stop, or up to now while it runs; -1 if it never started */
+int64_t scoreboard_timeline_length_ns(enum scoreboard_timeline tl);
+void scoreboard_timeline_reset(void);
+
+/* Game event log — append-only timestamped events for YouTube chapters.
+   The log has no fixed size: entries live in chunks added as it grows,
+   so adding never copies or moves the entries already there.
+   scoreboard_event_log_add() returns -1 only for a NULL label or when
+   memory runs out.
+
+   Events also carry what they are: a kind, the team (scorer or penalized
+   side) and player, plus the period and clock when they were added.
+   scoreboard_event_log_last_of() and scoreboard_event_log_remove_last_of()
+   find the newest live event of a kind and team without scanning labels,
+   so renaming a team mid-game doesn't lose its goals; a player_number of
+   0 matches any player. Removing an event only marks it, whatever its
+   position. Plain scoreboard_event_log_add() and events read back from a
+   file are SCOREBOARD_EVENT_OTHER with no team.
+
+   scoreboard_event_log_add_timed() logs an event at a timeline time
+   instead of a fixed offset, delay_ms before it when the operator
+   reacts late (a goal). Its offset_seconds is its stream offset, -1
+   when it was logged outside the stream: such events, for a recording
+   only, stay out of the timestamps file. */
 #define SCOREBOARD_EVENT_LABEL_SIZE 128
 
+enum scoreboard_event_kind {
+	SCOREBOARD_EVENT_OTHER = 0,
+	SCOREBOARD_EVENT_GOAL,
+	SCOREBOARD_EVENT_PENALTY,
+	SCOREBOARD_EVENT_PERIOD_START,
+	SCOREBOARD_EVENT_PERIOD_END,
+	SCOREBOARD_EVENT_GAME_END,
+	SCOREBOARD_EVENT_KIND_COUNT,
+};
+
 struct scoreboard_game_event {
 	int offset_seconds;
 	char label[SCOREBOARD_EVENT_LABEL_SIZE];
+	enum scoreboard_event_kind kind;
+	enum scoreboard_team team;
+	int player_number;
+	int period;
+	int clock_tenths;
+	/* Timeline time it was logged at, 0 for a fixed offset */
+	uint64_t time_ns;
+	int delay_ms;
 };
 
 void scoreboard_event_log_clear(void);
 int scoreboard_event_log_add(int offset_seconds, const char *label);
+int scoreboard_event_log_add_typed(int offset_seconds, const char *label,
+				   enum scoreboard_event_kind kind,
+				   enum scoreboard_team team,
+				   int player_number);
+int scoreboard_event_log_add_timed(uint64_t time_ns, int delay_ms,
+				   const char *label,
+				   enum scoreboard_event_kind kind,
+				   enum scoreboard_team team,
+				   int player_number);
 bool scoreboard_event_log_remove(int index);
+const struct scoreboard_game_event *
+scoreboard_event_log_last_of(enum scoreboard_event_kind kind,
+			     enum scoreboard_team team, int player_number);
+bool scoreboard_event_log_remove_last_of(enum scoreboard_event_kind kind,
+					 enum scoreboard_team team,
+					 int player_number);
 int scoreboard_event_log_find_last(const char *prefix);
 int scoreboard_event_log_count(void);
 const struct scoreboard_game_event *scoreboard_event_log_get(int index);
@@ -252,6 +703,81 @@ bool scoreboard_event_log_write(const char *path);
 bool scoreboard_event_log_file_has_content(const char *path);
 int scoreboard_event_log_read(const char *path);
 
+/* Append-mode timestamps file. scoreboard_event_log_open() writes the log
+   to path in the clean "H:MM:SS label" form and keeps the file open:
+   from then on each add appends its line and each removal appends a
+   tombstone, "- H:MM:SS label", so an event costs one short write however
+   long the log is. Clearing the log and undoing a removal rewrite the
+   file clean, as do scoreboard_event_log_compact() and closing.
+   scoreboard_event_log_read() applies tombstones, so read a file before
+   opening it. The file belongs to the context it was opened in. */
+bool scoreboard_event_log_open(const char *path);
+bool scoreboard_event_log_compact(void);
+void scoreboard_event_log_close(void);
+bool scoreboard_event_log_is_open(void);
+
+/* Chapter export — one pass over a list of chapters renders any set of
+   formats into memory, and finishing writes each file with one write:
+   <base>.txt "H:MM:SS label" (YouTube), <base>.ffmetadata (FFmpeg
+   metadata, millisecond timebase), <base>.vtt (WebVTT), <base>.edl
+   (CMX 3600 at 30 fps, one event per chapter) and <base>.json. Chapters
+   are added in order; each ends where the next starts and the last at
+   the end time given to scoreboard_chapters_finish(), which also frees
+   the writer. */
+enum scoreboard_chapter_format {
+	SCOREBOARD_CHAPTERS_YOUTUBE = 1 << 0,
+	SCOREBOARD_CHAPTERS_FFMETADATA = 1 << 1,
+	SCOREBOARD_CHAPTERS_WEBVTT = 1 << 2,
+	SCOREBOARD_CHAPTERS_EDL = 1 << 3,
+	SCOREBOARD_CHAPTERS_JSON = 1 << 4,
+};
+
+#define SCOREBOARD_CHAPTER_FORMAT_COUNT 5
+#define SCOREBOARD_CHAPTERS_ALL ((1u << SCOREBOARD_CHAPTER_FORMAT_COUNT) - 1)
+
+struct scoreboard_chapter_writer;
+
+struct scoreboard_chapter_writer *
+scoreboard_chapters_begin(const char *base_path, unsigned int formats,
+			  const char *title);
+void scoreboard_chapters_add(struct scoreboard_chapter_writer *w,
+			     int64_t start_ms, const char *label);
+bool scoreboard_chapters_finish(struct scoreboard_chapter_writer *w,
+				int64_t end_ms);
+/* The file one format is written to */
+bool scoreboard_chapters_path(const char *base_path,
+			      enum scoreboard_chapter_format format,
+			      char *buf, size_t size);
+
+/* Exports the event log as chapters of the latest stream or recording in
+   the same pass, with millisecond offsets worked out from the timeline;
+   the last chapter ends with the stream or recording. A recording's
+   chapters start with "Recording Start" and only have timed events. If
+   the append-mode timestamps file is <base>.txt and the YouTube format
+   is selected, that write compacts it too. */
+bool scoreboard_event_log_export(enum scoreboard_timeline tl,
+				 const char *base_path, unsigned int formats);
+
+/* Undo/redo for operator actions. Everything between scoreboard_undo_begin()
+   and _end() (which may nest) becomes one step: the clock, period, score,
+   shot, faceoff and foul changes, the penalty slots it changed and the
+   event-log entries it added or removed. Undo and redo take the newest
+   step back or forward in constant time; values move by the recorded
+   amount, so unrelated changes made since are kept. An action that
+   changed nothing is not recorded and leaves the redo history alone. */
+#define SCOREBOARD_UNDO_DEPTH 32
+
+void scoreboard_undo_begin(void);
+void scoreboard_undo_end(const char *label);
+bool scoreboard_undo(void);
+bool scoreboard_redo(void);
+int scoreboard_undo_count(void);
+int scoreboard_redo_count(void);
+/* Label of the step undo / redo would take, or NULL */
+const char *scoreboard_undo_label(void);
+const char *scoreboard_redo_label(void);
+void scoreboard_undo_clear(void);
+
 #ifdef __cplusplus
 }
 #endif
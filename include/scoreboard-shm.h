@@ -0,0 +1,228 @@
+#ifndef SCOREBOARD_SHM_H
+#define SCOREBOARD_SHM_H
+
+/* Shared-memory snapshot of the scoreboard, for local tools that want to
+   poll state many times a second without touching the output files.
+
+   The plugin publishes a fixed-layout struct scoreboard_shm_segment into a
+   named segment ("/<name>" via shm_open on POSIX, "Local\<name>" file
+   mapping on Windows). Updates are guarded by a sequence lock: the writer
+   makes seq odd, copies the state, then makes seq even again. A reader
+   copies the state and retries if seq was odd or changed meanwhile, so it
+   never observes a torn snapshot and never blocks the writer.
+
+   This header is self-contained C; tools only need to include it. */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SCOREBOARD_SHM_DEFAULT_NAME
+#define SCOREBOARD_SHM_DEFAULT_NAME "streamn-scoreboard"
+#endif
+#define SCOREBOARD_SHM_MAGIC 0x48534253u /* "SBSH" */
+#define SCOREBOARD_SHM_VERSION 1u
+#define SCOREBOARD_SHM_NAME_SIZE 72
+#define SCOREBOARD_SHM_TEXT_SIZE 16
+#define SCOREBOARD_SHM_PENALTIES 8
+#define SCOREBOARD_SHM_READ_TRIES 1000
+
+struct scoreboard_shm_penalty {
+	int32_t player_number;
+	int32_t remaining_tenths;
+	int32_t phase2_tenths;
+	int32_t active;
+};
+
+/* Every field has a fixed width so tools built with any compiler agree on
+   the layout. Strings are always NUL-terminated. */
+struct scoreboard_shm_state {
+	uint32_t generation; /* bumped on every published change */
+
+	int32_t clock_tenths;
+	int32_t clock_running;
+	int32_t clock_direction;
+	int32_t period_length; /* seconds */
+	int32_t period;
+	int32_t sport;
+
+	int32_t home_score;
+	int32_t away_score;
+	int32_t home_shots;
+	int32_t away_shots;
+	int32_t home_faceoffs;
+	int32_t away_faceoffs;
+	int32_t home_fouls;
+	int32_t away_fouls;
+	int32_t home_fouls2;
+	int32_t away_fouls2;
+
+	char clock_text[SCOREBOARD_SHM_TEXT_SIZE];
+	char period_text[SCOREBOARD_SHM_TEXT_SIZE];
+	char sport_name[SCOREBOARD_SHM_TEXT_SIZE];
+	char home_name[SCOREBOARD_SHM_NAME_SIZE];
+	char away_name[SCOREBOARD_SHM_NAME_SIZE];
+
+	struct scoreboard_shm_penalty home_penalties[SCOREBOARD_SHM_PENALTIES];
+	struct scoreboard_shm_penalty away_penalties[SCOREBOARD_SHM_PENALTIES];
+};
+
+struct scoreboard_shm_segment {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t size; /* sizeof(struct scoreboard_shm_segment) */
+	volatile uint32_t seq;
+	struct scoreboard_shm_state state;
+};
+
+/* ---- sequence lock primitives ---- */
+
+static inline uint32_t scoreboard_shm_load_seq(const volatile uint32_t *seq)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	uint32_t value = *seq;
+	MemoryBarrier();
+	return value;
+#else
+	return __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static inline void scoreboard_shm_store_seq(volatile uint32_t *seq,
+					    uint32_t value)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	MemoryBarrier();
+	*seq = value;
+#else
+	__atomic_store_n(seq, value, __ATOMIC_RELEASE);
+#endif
+}
+
+static inline void scoreboard_shm_fence(void)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	MemoryBarrier();
+#else
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+#endif
+}
+
+/* Copy a consistent snapshot out of a mapped segment. Returns false if the
+   segment is not (yet) a compatible scoreboard segment, or if the writer
+   kept it busy for SCOREBOARD_SHM_READ_TRIES attempts. */
+static inline bool
+scoreboard_shm_read_state(const struct scoreboard_shm_segment *segment,
+			  struct scoreboard_shm_state *out)
+{
+	if (segment == NULL || out == NULL)
+		return false;
+	if (scoreboard_shm_load_seq(&segment->magic) != SCOREBOARD_SHM_MAGIC ||
+	    segment->version != SCOREBOARD_SHM_VERSION ||
+	    segment->size != sizeof(struct scoreboard_shm_segment))
+		return false;
+
+	for (int i = 0; i < SCOREBOARD_SHM_READ_TRIES; i++) {
+		uint32_t begin = scoreboard_shm_load_seq(&segment->seq);
+		if (begin & 1u)
+			continue;
+		memcpy(out, &segment->state, sizeof(*out));
+		scoreboard_shm_fence();
+		if (scoreboard_shm_load_seq(&segment->seq) == begin)
+			return true;
+	}
+	return false;
+}
+
+/* ---- reader ---- */
+
+struct scoreboard_shm_reader {
+	const struct scoreboard_shm_segment *segment;
+#ifdef _WIN32
+	HANDLE mapping;
+#endif
+};
+
+/* Map the segment published under name (no leading slash or prefix). */
+static inline bool scoreboard_shm_reader_open(struct scoreboard_shm_reader *r,
+					      const char *name)
+{
+	char os_name[256];
+	size_t size = sizeof(struct scoreboard_shm_segment);
+
+	if (r == NULL || name == NULL)
+		return false;
+	r->segment = NULL;
+#ifdef _WIN32
+	snprintf(os_name, sizeof(os_name), "Local\\%s", name);
+	r->mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, os_name);
+	if (r->mapping == NULL)
+		return false;
+	r->segment = (const struct scoreboard_shm_segment *)MapViewOfFile(
+		r->mapping, FILE_MAP_READ, 0, 0, size);
+	if (r->segment == NULL) {
+		CloseHandle(r->mapping);
+		r->mapping = NULL;
+		return false;
+	}
+#else
+	snprintf(os_name, sizeof(os_name), "/%s", name);
+	int fd = shm_open(os_name, O_RDONLY, 0);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size < size) {
+		close(fd);
+		return false;
+	}
+	void *addr = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED)
+		return false;
+	r->segment = (const struct scoreboard_shm_segment *)addr;
+#endif
+	return true;
+}
+
+static inline bool scoreboard_shm_reader_read(struct scoreboard_shm_reader *r,
+					      struct scoreboard_shm_state *out)
+{
+	return r != NULL && scoreboard_shm_read_state(r->segment, out);
+}
+
+static inline void scoreboard_shm_reader_close(struct scoreboard_shm_reader *r)
+{
+	if (r == NULL || r->segment == NULL)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile((LPCVOID)r->segment);
+	CloseHandle(r->mapping);
+	r->mapping = NULL;
+#else
+	munmap((void *)r->segment, sizeof(struct scoreboard_shm_segment));
+#endif
+	r->segment = NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
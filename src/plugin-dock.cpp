@@ -3,7 +3,9 @@
 #include "../data/streamn-dad-logo.h"
 
 #include <obs-frontend-api.h>
+#include <obs-module.h>
 #include <util/config-file.h>
+#include <util/platform.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -11,6 +13,9 @@
 #include <dlfcn.h>
 #endif
 
+#include <atomic>
+#include <cstring>
+
 #include <QtCore/QByteArray>
 #include <QtCore/QDir>
 #include <QtCore/QFile>
@@ -24,6 +29,7 @@
 #include <QtCore/QUrl>
 #include <QtGui/QClipboard>
 #include <QtGui/QDesktopServices>
+#include <QtGui/QFontDatabase>
 #include <QtGui/QGuiApplication>
 #include <QtGui/QPixmap>
 
@@ -58,10 +64,12 @@ const char *kDockTitle = "Streamn Scoreboard";
 
 const char *kConfigSection = "streamn-obs-scoreboard";
 const char *kOutputDirKey = "output_directory";
+const char *kOutputModeKey = "output_mode";
 const char *kCliExecutableKey = "cli_executable";
 const char *kCliExtraArgsKey = "cli_extra_args";
 const char *kEnvFileKey = "environment_file";
 const char *kRecordChaptersKey = "record_chapters";
+const char *kHttpPortKey = "http_port";
 
 struct process_job {
 	int id = 0;
@@ -124,10 +132,11 @@ QFrame *g_queue_separator = nullptr;
 QScrollArea *g_queue_scroll = nullptr;
 QPushButton *g_clock_btn = nullptr;
 QTimer *g_tick_timer = nullptr;
+QTimer *g_autosave_timer = nullptr;
+/* How often the full state is saved, if it changed */
+static const int kAutosaveIntervalMs = 5000;
 QFileSystemWatcher *g_file_watcher = nullptr;
 QElapsedTimer g_write_cooldown;
-QElapsedTimer g_clock_elapsed;
-qint64 g_clock_remainder_ms = 0;
 scoreboard_log_fn g_log_fn = nullptr;
 
 QVector<process_job *> g_jobs;
@@ -136,10 +145,11 @@ QString g_environment_file;
 QPushButton *g_highlights_btn = nullptr;
 QPushButton *g_period_adv_btn = nullptr;
 QCheckBox *g_game_finished = nullptr;
+QPushButton *g_undo_btn = nullptr;
+QPushButton *g_redo_btn = nullptr;
 
-/* Stream-relative event timestamps */
-QElapsedTimer g_stream_timer;
-bool g_stream_active = false;
+/* Event timestamps; offsets come from the core's stream and recording
+   timelines */
 int g_period_start_logged = -1; /* period number for which we already logged a start */
 QPushButton *g_copy_timestamps_btn = nullptr;
 
@@ -150,16 +160,9 @@ add_chapter_fn g_add_chapter = nullptr;
 get_last_recording_fn g_get_last_recording = nullptr;
 bool g_chapters_api_available = false;
 bool g_record_chapters_enabled = false;
-bool g_recording_active = false;
-QElapsedTimer g_recording_timer;
-
-struct recording_chapter {
-	int offset_seconds;
-	QString label;
-};
-QVector<recording_chapter> g_recording_chapters;
+int g_http_port = 0; /* overlay feed port; 0 = off */
 
-static const int kNumHotkeys = 45;
+static const int kNumHotkeys = 47;
 
 static const char *kHotkeyNames[kNumHotkeys] = {
 	"sb_clock_startstop",  "sb_clock_reset",
@@ -185,9 +188,15 @@ static const char *kHotkeyNames[kNumHotkeys] = {
 	"sb_home_2plus5_pen_add", "sb_away_2plus5_pen_add",
 	"sb_home_pen_edit1",   "sb_home_pen_edit2",
 	"sb_away_pen_edit1",   "sb_away_pen_edit2",
+	"sb_undo",             "sb_redo",
 };
 
 obs_hotkey_id g_hotkey_ids[kNumHotkeys];
+obs_hotkey_func g_hotkey_funcs[kNumHotkeys];
+/* Undo step labels: the description without the "Streamn: " prefix */
+const char *g_hotkey_labels[kNumHotkeys];
+/* Set while a drain of the command queue is queued on the dock */
+std::atomic<bool> g_drain_pending{false};
 
 void log_info(const QString &message)
 {
@@ -560,68 +569,37 @@ void clear_completed_jobs()
 /* ---- Event timestamp helpers ---- */
 
 void write_timestamps_file();
+void open_timestamps_file();
 void update_copy_timestamps_visibility();
 
 /* ---- Recording chapter helpers ---- */
 
+/* Embeds the chapter in MP4 via the OBS API (if available and
+   recording). It lands at the current PTS, so a goal's delay cannot be
+   applied here; the companion files get it from the event log. */
 void add_recording_chapter(const char *label)
 {
-	if (!g_record_chapters_enabled)
-		return;
-	/* Embed chapter in MP4 via OBS API (if available and recording) */
-	if (g_add_chapter)
+	if (g_record_chapters_enabled && g_add_chapter)
 		g_add_chapter(label);
-	/* Track for companion .chapters.txt (works for any format) */
-	if (g_recording_active) {
-		int offset = (int)(g_recording_timer.elapsed() / 1000);
-		g_recording_chapters.append({offset, QString::fromUtf8(label)});
-	}
 }
 
-void add_recording_chapter_delayed(const char *label, int delay_seconds)
+bool recording_chapters_active()
 {
-	if (!g_record_chapters_enabled)
-		return;
-	/* MP4 chapter is placed at current PTS (delay cannot be applied) */
-	if (g_add_chapter)
-		g_add_chapter(label);
-	/* Companion file uses the adjusted offset */
-	if (g_recording_active) {
-		int offset = (int)(g_recording_timer.elapsed() / 1000) -
-			     delay_seconds;
-		if (offset < 0)
-			offset = 0;
-		g_recording_chapters.append({offset, QString::fromUtf8(label)});
-	}
+	return g_record_chapters_enabled &&
+	       scoreboard_timeline_is_active(SCOREBOARD_TIMELINE_RECORDING);
 }
 
+/* <recording>.chapters.txt plus the FFmpeg metadata, WebVTT, EDL and
+   JSON chapter files beside it, from one pass over the event log */
 void write_recording_chapters_file(const char *recording_path)
 {
-	if (g_recording_chapters.isEmpty())
-		return;
-	QString chapters_path =
-		QString::fromUtf8(recording_path) + ".chapters.txt";
-	QFile file(chapters_path);
-	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
-		return;
-	QTextStream out(&file);
-	for (const recording_chapter &ch : g_recording_chapters) {
-		int hours = ch.offset_seconds / 3600;
-		int minutes = (ch.offset_seconds % 3600) / 60;
-		int seconds = ch.offset_seconds % 60;
-		out << QString::asprintf("%d:%02d:%02d %s\n", hours, minutes,
-					seconds,
-					ch.label.toUtf8().constData());
-	}
-	log_info("[streamn-obs-scoreboard] wrote " +
-		chapters_path);
-}
-
-int stream_offset_seconds()
-{
-	if (!g_stream_active)
-		return -1;
-	return (int)(g_stream_timer.elapsed() / 1000);
+	QByteArray base =
+		(QString::fromUtf8(recording_path) + ".chapters").toUtf8();
+	if (scoreboard_event_log_export(SCOREBOARD_TIMELINE_RECORDING,
+					base.constData(),
+					SCOREBOARD_CHAPTERS_ALL))
+		log_info("[streamn-obs-scoreboard] wrote chapters for " +
+			 QString::fromUtf8(recording_path));
 }
 
 /* Default seconds to subtract from goal timestamps to account for
@@ -629,35 +607,31 @@ int stream_offset_seconds()
    the button.  Clamped so it never goes below 0:00:00. */
 static const int kGoalDelaySeconds = 10;
 
-void log_event(const char *label)
+/* One event serves the stream and the recording: it keeps the moment
+   it was logged, and each export works out its own offset */
+void log_event(const char *label,
+	       enum scoreboard_event_kind kind = SCOREBOARD_EVENT_OTHER,
+	       enum scoreboard_team team = SCOREBOARD_TEAM_NONE,
+	       int player_number = 0, int delay_seconds = 0)
 {
-	int offset = stream_offset_seconds();
-	if (offset < 0)
+	if (!scoreboard_timeline_is_active(SCOREBOARD_TIMELINE_STREAM) &&
+	    !recording_chapters_active())
 		return;
-	scoreboard_event_log_add(offset, label);
-	write_timestamps_file();
+	scoreboard_event_log_add_timed(scoreboard_timeline_now(),
+				       delay_seconds * 1000, label, kind,
+				       team, player_number);
 	update_copy_timestamps_visibility();
 }
 
-void log_event_with_offset(const char *label, int offset)
+/* By what the event is, not its label, so renaming a team mid-game
+   still finds its goals and penalties */
+void remove_last_event(enum scoreboard_event_kind kind, bool home,
+		       int player_number = 0)
 {
-	if (!g_stream_active)
-		return;
-	if (offset < 0)
-		offset = 0;
-	scoreboard_event_log_add(offset, label);
-	write_timestamps_file();
-	update_copy_timestamps_visibility();
-}
-
-void remove_last_event(const char *prefix)
-{
-	int idx = scoreboard_event_log_find_last(prefix);
-	if (idx >= 0) {
-		scoreboard_event_log_remove(idx);
-		write_timestamps_file();
+	if (scoreboard_event_log_remove_last_of(
+		    kind, home ? SCOREBOARD_TEAM_HOME : SCOREBOARD_TEAM_AWAY,
+		    player_number))
 		update_copy_timestamps_visibility();
-	}
 }
 
 void log_period_start_event()
@@ -672,7 +646,7 @@ void log_period_start_event()
 	scoreboard_format_period(period_buf, sizeof(period_buf));
 	snprintf(buf, sizeof(buf), "%s %s Start",
 		 scoreboard_get_segment_name(), period_buf);
-	log_event(buf);
+	log_event(buf, SCOREBOARD_EVENT_PERIOD_START);
 	add_recording_chapter(buf);
 }
 
@@ -683,7 +657,7 @@ void log_period_end_event()
 	scoreboard_format_period(period_buf, sizeof(period_buf));
 	snprintf(buf, sizeof(buf), "%s %s End",
 		 scoreboard_get_segment_name(), period_buf);
-	log_event(buf);
+	log_event(buf, SCOREBOARD_EVENT_PERIOD_END);
 	add_recording_chapter(buf);
 }
 
@@ -704,22 +678,17 @@ void log_goal_event(bool home)
 		 scoreboard_get_home_score(),
 		 scoreboard_get_away_score());
 
-	int offset = stream_offset_seconds();
-	if (offset >= 0)
-		log_event_with_offset(buf, offset - kGoalDelaySeconds);
-	add_recording_chapter_delayed(buf, kGoalDelaySeconds);
+	log_event(buf, SCOREBOARD_EVENT_GOAL,
+		  home ? SCOREBOARD_TEAM_HOME : SCOREBOARD_TEAM_AWAY, 0,
+		  kGoalDelaySeconds);
+	add_recording_chapter(buf);
 }
 
 void remove_goal_event(bool home)
 {
 	if (!scoreboard_get_log_scores())
 		return;
-	const char *label = scoreboard_get_score_label();
-	char prefix[SCOREBOARD_EVENT_LABEL_SIZE];
-	snprintf(prefix, sizeof(prefix), "%s: %s", label,
-		 home ? scoreboard_get_home_name()
-		      : scoreboard_get_away_name());
-	remove_last_event(prefix);
+	remove_last_event(SCOREBOARD_EVENT_GOAL, home);
 }
 
 void log_penalty_event(bool home, int player_number)
@@ -734,23 +703,16 @@ void log_penalty_event(bool home, int player_number)
 		snprintf(buf, sizeof(buf), "Power Play: %s",
 			 home ? scoreboard_get_away_name()
 			      : scoreboard_get_home_name());
-	log_event(buf);
+	/* The team is the one penalized, not the one on the power play */
+	log_event(buf, SCOREBOARD_EVENT_PENALTY,
+		  home ? SCOREBOARD_TEAM_HOME : SCOREBOARD_TEAM_AWAY,
+		  player_number);
 	add_recording_chapter(buf);
 }
 
 void remove_penalty_event(bool home, int player_number)
 {
-	char prefix[SCOREBOARD_EVENT_LABEL_SIZE];
-	if (player_number > 0)
-		snprintf(prefix, sizeof(prefix), "Power Play: %s #%d",
-			 home ? scoreboard_get_away_name()
-			      : scoreboard_get_home_name(),
-			 player_number);
-	else
-		snprintf(prefix, sizeof(prefix), "Power Play: %s",
-			 home ? scoreboard_get_away_name()
-			      : scoreboard_get_home_name());
-	remove_last_event(prefix);
+	remove_last_event(SCOREBOARD_EVENT_PENALTY, home, player_number);
 }
 
 void log_game_end_event()
@@ -759,27 +721,70 @@ void log_game_end_event()
 	snprintf(buf, sizeof(buf), "Game End \xe2\x80\x94 %s %d, %s %d",
 		 scoreboard_get_home_name(), scoreboard_get_home_score(),
 		 scoreboard_get_away_name(), scoreboard_get_away_score());
-	log_event(buf);
+	log_event(buf, SCOREBOARD_EVENT_GAME_END);
 	add_recording_chapter(buf);
 }
 
-bool timestamps_file_path(char *buf, size_t size)
+/* timestamps.txt and the other chapter formats share this base */
+bool timestamps_base_path(char *buf, size_t size)
 {
 	const char *dir = scoreboard_get_output_directory();
 	if (dir[0] == '\0')
 		return false;
-	snprintf(buf, size, "%s/timestamps.txt", dir);
+	snprintf(buf, size, "%s/timestamps", dir);
 	return true;
 }
 
+bool timestamps_file_path(char *buf, size_t size)
+{
+	char base[544];
+	return timestamps_base_path(base, sizeof(base)) &&
+	       scoreboard_chapters_path(base, SCOREBOARD_CHAPTERS_YOUTUBE, buf,
+					size);
+}
+
+/* Every chapter format at once. While streaming this also compacts the
+   open timestamps.txt, so closing it afterwards has nothing to do. */
+void export_timestamps_files()
+{
+	char base[544];
+	if (timestamps_base_path(base, sizeof(base)))
+		scoreboard_event_log_export(SCOREBOARD_TIMELINE_STREAM, base,
+					    SCOREBOARD_CHAPTERS_ALL);
+}
+
+/* Rewrites timestamps.txt in its clean form. While streaming the core
+   holds it open and appends each event (and a tombstone for each
+   removal), so this compacts it instead. */
 void write_timestamps_file()
 {
+	if (scoreboard_event_log_is_open()) {
+		scoreboard_event_log_compact();
+		return;
+	}
 	char path[544]; /* 512 (max output dir) + 32 (filename) */
 	if (!timestamps_file_path(path, sizeof(path)))
 		return;
 	scoreboard_event_log_write(path);
 }
 
+/* Keeps timestamps.txt open for appends until the stream stops */
+void open_timestamps_file()
+{
+	char path[544];
+	if (timestamps_file_path(path, sizeof(path)))
+		scoreboard_event_log_open(path);
+}
+
+/* A fresh stream starts an empty log, unless a recording is still
+   running and needs its events. Those from before the stream started
+   stay out of its files either way. */
+void clear_stream_events()
+{
+	if (!scoreboard_timeline_is_active(SCOREBOARD_TIMELINE_RECORDING))
+		scoreboard_event_log_clear();
+}
+
 void update_copy_timestamps_visibility()
 {
 	if (!g_copy_timestamps_btn)
@@ -840,12 +845,14 @@ void run_reeln_highlights_command()
 }
 
 void write_files_now();
+void on_tick();
 void open_edit_penalty_dialog(QWidget *parent, bool home, int slot);
 
 /* ---- UI update ---- */
 
 void update_all_labels()
 {
+	uint64_t perf_start = scoreboard_perf_now();
 	char buf[64];
 	if (g_clock_label) {
 		scoreboard_clock_format(buf, sizeof(buf));
@@ -872,6 +879,16 @@ void update_all_labels()
 			g_clock_btn->setStyleSheet("");
 		}
 	}
+	if (g_undo_btn && g_redo_btn) {
+		const char *undo = scoreboard_undo_label();
+		const char *redo = scoreboard_redo_label();
+		g_undo_btn->setEnabled(undo != nullptr);
+		g_redo_btn->setEnabled(redo != nullptr);
+		g_undo_btn->setToolTip(undo ? "Undo " + QString::fromUtf8(undo)
+					    : QString());
+		g_redo_btn->setToolTip(redo ? "Redo " + QString::fromUtf8(redo)
+					    : QString());
+	}
 	if (g_highlights_btn && g_highlights_btn->isVisible()) {
 		if (g_game_finished && g_game_finished->isChecked()) {
 			g_highlights_btn->setText(
@@ -1085,6 +1102,7 @@ void update_all_labels()
 						: scoreboard_get_away_penalty(captured_slot);
 					if (!p || !p->active)
 						return;
+					scoreboard_undo_begin();
 					/* Compound phase 1: transition to
 					   phase 2. Otherwise: full clear. */
 					if (p->phase2_tenths > 0) {
@@ -1106,8 +1124,12 @@ void update_all_labels()
 								captured_slot);
 						scoreboard_penalty_compact();
 					}
+					scoreboard_undo_end(
+						captured_home
+							? "Home Penalty Clear"
+							: "Away Penalty Clear");
 					write_files_now();
-					update_all_labels();
+					on_tick();
 				});
 
 			hl->addWidget(pw->label, 1);
@@ -1122,24 +1144,9 @@ void update_all_labels()
 
 	update_pen_rows(g_home_pen_layout, g_home_pen_rows, true);
 	update_pen_rows(g_away_pen_layout, g_away_pen_rows, false);
+	scoreboard_perf_record(SCOREBOARD_PERF_UPDATE_LABELS, perf_start, 0);
 }
 
-const char *kWatchedFiles[] = {
-	"home_name.txt",	  "away_name.txt",
-	"home_score.txt",	  "away_score.txt",
-	"clock.txt",		  "period.txt",
-	"home_shots.txt",	  "away_shots.txt",
-	"home_faceoffs.txt",	  "away_faceoffs.txt",
-	"home_penalty_numbers.txt", "home_penalty_times.txt",
-	"away_penalty_numbers.txt", "away_penalty_times.txt",
-	"home_fouls.txt",	    "away_fouls.txt",
-	"home_fouls2.txt",	    "away_fouls2.txt",
-	"sport.txt",
-	"default_penalty_duration.txt",
-	"default_major_penalty_duration.txt",
-	"period_labels.txt",
-};
-const int kWatchedFileCount = sizeof(kWatchedFiles) / sizeof(kWatchedFiles[0]);
 const qint64 kWriteCooldownMs = 500;
 
 void rebuild_file_watcher()
@@ -1156,8 +1163,20 @@ void rebuild_file_watcher()
 		return;
 
 	QString base = QString::fromUtf8(dir);
-	for (int i = 0; i < kWatchedFileCount; i++) {
-		QString path = base + "/" + kWatchedFiles[i];
+	enum scoreboard_output_mode mode = scoreboard_get_output_mode();
+	if (mode != SCOREBOARD_OUTPUT_FILES) {
+		/* Consolidated output: the whole state lives in one file */
+		QString path = base + "/" +
+			       scoreboard_output_mode_filename(mode);
+		if (QFile::exists(path))
+			g_file_watcher->addPath(path);
+		return;
+	}
+	/* The core's field registry names every file it reads back */
+	for (int i = 0; i < SCOREBOARD_FIELD_COUNT; i++) {
+		QString path = base + "/" +
+			       scoreboard_output_field_filename(
+				       (enum scoreboard_output_field)i);
 		if (QFile::exists(path))
 			g_file_watcher->addPath(path);
 	}
@@ -1165,47 +1184,71 @@ void rebuild_file_watcher()
 
 void on_file_changed(const QString &path)
 {
+	/* Re-add the path — some platforms remove it after a change event,
+	   and every publish by the output writer replaces the file via
+	   rename, so this must happen even for our own writes. */
+	if (g_file_watcher && QFile::exists(path) &&
+	    !g_file_watcher->files().contains(path))
+		g_file_watcher->addPath(path);
+
 	if (g_write_cooldown.isValid() &&
 	    g_write_cooldown.elapsed() < kWriteCooldownMs)
 		return;
 
 	scoreboard_read_all_files();
-	update_all_labels();
-
-	/* Re-add the path — some platforms remove it after a change event */
-	if (g_file_watcher && QFile::exists(path) &&
-	    !g_file_watcher->files().contains(path))
-		g_file_watcher->addPath(path);
+	on_tick();
 }
 
+/* The dock's game is the default context; its tick and writes name it
+   so they never follow another context's selection */
 void write_files_now()
 {
-	scoreboard_write_all_files();
+	scoreboard_write_all_files_ctx(scoreboard_ctx_default());
+	scoreboard_shm_publish();
+	scoreboard_http_publish();
 	g_write_cooldown.restart();
 }
 
+/* Sleep until the next tenth at which a displayed clock or penalty time
+   changes instead of polling; a stopped clock needs no timer at all */
+void schedule_next_tick()
+{
+	if (!g_tick_timer)
+		return;
+	int64_t due_ns =
+		scoreboard_ns_until_display_change_ctx(scoreboard_ctx_default());
+	if (due_ns < 0) {
+		g_tick_timer->stop();
+		return;
+	}
+	/* Round up: waking a hair early would render nothing new */
+	g_tick_timer->start((int)((due_ns + 999999) / 1000000));
+}
+
 void on_tick()
 {
+	uint64_t perf_start = scoreboard_perf_now();
+	struct scoreboard_write_stats before;
+	scoreboard_get_write_stats(&before);
 	bool was_running = scoreboard_clock_is_running();
 
-	if (was_running) {
-		qint64 elapsed_ms = g_clock_elapsed.restart();
-		elapsed_ms += g_clock_remainder_ms;
-		int elapsed_tenths = (int)(elapsed_ms / 100);
-		g_clock_remainder_ms = elapsed_ms % 100;
-		if (elapsed_tenths > 0)
-			scoreboard_clock_tick(elapsed_tenths);
-	} else {
-		g_clock_elapsed.restart();
-		g_clock_remainder_ms = 0;
-	}
-
+	scoreboard_clock_sync_ctx(scoreboard_ctx_default());
 	bool is_running = scoreboard_clock_is_running();
-	if (scoreboard_is_dirty())
+	if (scoreboard_is_dirty_ctx(scoreboard_ctx_default()))
 		write_files_now();
+	/* Shared-memory readers also see tenths that don't change any file */
+	scoreboard_shm_publish();
+	scoreboard_http_publish();
 	update_all_labels();
 	if (was_running && !is_running && g_clock_btn)
 		g_clock_btn->repaint();
+
+	struct scoreboard_write_stats after;
+	scoreboard_get_write_stats(&after);
+	scoreboard_perf_record(SCOREBOARD_PERF_TICK, perf_start,
+			       (unsigned int)(after.files_written -
+					      before.files_written));
+	schedule_next_tick();
 }
 
 /* ---- Profile paths ---- */
@@ -1214,6 +1257,7 @@ void load_profile_paths()
 {
 	config_t *profile_cfg = obs_frontend_get_profile_config();
 	const char *output_dir = nullptr;
+	const char *output_mode = nullptr;
 	const char *cli_exe = nullptr;
 	const char *cli_args = nullptr;
 	const char *env_file = nullptr;
@@ -1221,6 +1265,8 @@ void load_profile_paths()
 	if (profile_cfg != nullptr) {
 		output_dir = config_get_string(profile_cfg, kConfigSection,
 					       kOutputDirKey);
+		output_mode = config_get_string(profile_cfg, kConfigSection,
+						kOutputModeKey);
 		cli_exe = config_get_string(profile_cfg, kConfigSection,
 					    kCliExecutableKey);
 		cli_args = config_get_string(profile_cfg, kConfigSection,
@@ -1229,9 +1275,13 @@ void load_profile_paths()
 					     kEnvFileKey);
 		g_record_chapters_enabled = config_get_bool(
 			profile_cfg, kConfigSection, kRecordChaptersKey);
+		g_http_port = (int)config_get_int(profile_cfg, kConfigSection,
+						  kHttpPortKey);
 	}
 
 	scoreboard_set_output_directory(output_dir);
+	scoreboard_set_output_mode(
+		scoreboard_output_mode_from_name(output_mode));
 	scoreboard_set_cli_executable(cli_exe);
 	scoreboard_set_cli_extra_args(cli_args);
 	g_environment_file =
@@ -1245,6 +1295,9 @@ void save_profile_paths()
 		return;
 	config_set_string(profile_cfg, kConfigSection, kOutputDirKey,
 			  scoreboard_get_output_directory());
+	config_set_string(
+		profile_cfg, kConfigSection, kOutputModeKey,
+		scoreboard_output_mode_name(scoreboard_get_output_mode()));
 	config_set_string(profile_cfg, kConfigSection, kCliExecutableKey,
 			  scoreboard_get_cli_executable());
 	config_set_string(profile_cfg, kConfigSection, kCliExtraArgsKey,
@@ -1253,9 +1306,98 @@ void save_profile_paths()
 			  g_environment_file.toUtf8().constData());
 	config_set_bool(profile_cfg, kConfigSection, kRecordChaptersKey,
 			g_record_chapters_enabled);
+	config_set_int(profile_cfg, kConfigSection, kHttpPortKey, g_http_port);
 	config_save_safe(profile_cfg, "tmp", nullptr);
 }
 
+/* Crash recovery: after a crash the snapshot and journal in the plugin
+   config directory replay over whatever the output files held. After a
+   normal shutdown they replay nothing and the files stand. */
+void open_state_journal()
+{
+	char *dir = obs_module_config_path("");
+	char *snapshot = obs_module_config_path("state.bin");
+	char *journal = obs_module_config_path("state.journal");
+	if (dir && snapshot && journal) {
+		os_mkdirs(dir);
+		if (!scoreboard_journal_open(snapshot, journal))
+			log_info("[streamn-obs-scoreboard] state journal "
+				 "unavailable, crash recovery disabled");
+	}
+	bfree(dir);
+	bfree(snapshot);
+	bfree(journal);
+}
+
+/* The periodic autosave of the full state file, with the compound
+   penalty and overtime settings the output files can't hold. The journal
+   records every change, so it is never older than the autosave and
+   decides alone whether the last session crashed; the autosave only
+   stands in when the journal had no usable snapshot. */
+void restore_autosave()
+{
+	if (scoreboard_journal_get_recovery() != SCOREBOARD_JOURNAL_EMPTY)
+		return;
+	char *path = obs_module_config_path("autosave.json");
+	if (path && scoreboard_load_state(path)) {
+		/* A clock saved running would count from the moment OBS
+		   came back */
+		if (scoreboard_clock_is_running())
+			scoreboard_clock_stop();
+		log_info("[streamn-obs-scoreboard] restored autosaved state");
+	}
+	bfree(path);
+}
+
+void start_autosave()
+{
+	char *dir = obs_module_config_path("");
+	char *path = obs_module_config_path("autosave.json");
+	if (dir && path) {
+		os_mkdirs(dir);
+		if (!scoreboard_autosave_start(path))
+			log_info("[streamn-obs-scoreboard] autosave worker "
+				 "unavailable, saving on the UI thread");
+	}
+	bfree(dir);
+	bfree(path);
+}
+
+/* Each session's changes go to a trace that can be replayed with
+   scoreboard_core_replay. The previous session's trace is kept as
+   last-session.sbtrace.1 rather than overwritten. */
+void open_session_trace()
+{
+	char *trace = obs_module_config_path("last-session.sbtrace");
+	char *previous = obs_module_config_path("last-session.sbtrace.1");
+	if (trace && previous) {
+		QFile::remove(QString::fromUtf8(previous));
+		QFile::rename(QString::fromUtf8(trace),
+			      QString::fromUtf8(previous));
+	}
+	if (trace && !scoreboard_trace_start(trace))
+		log_info("[streamn-obs-scoreboard] could not record the "
+			 "session trace");
+	bfree(previous);
+	bfree(trace);
+}
+
+/* (Re)start the browser-source feed on the configured port */
+void apply_http_port()
+{
+	scoreboard_http_stop();
+	if (g_http_port <= 0 || g_http_port > 65535)
+		return;
+	if (scoreboard_http_start((unsigned short)g_http_port))
+		log_info(QString("[streamn-obs-scoreboard] overlay feed at "
+				 "http://127.0.0.1:%1/state")
+				 .arg(g_http_port));
+	else
+		log_info(QString("[streamn-obs-scoreboard] overlay feed could "
+				 "not listen on port %1")
+				 .arg(g_http_port));
+}
+
 void update_highlights_button_visibility()
 {
 	const QString cli_path =
@@ -1379,6 +1521,7 @@ void open_add_penalty_dialog(QWidget *parent, bool home,
 			selected_phase2 = 600;
 
 		int slot;
+		scoreboard_undo_begin();
 		if (selected_phase2 > 0) {
 			if (home)
 				slot = scoreboard_home_penalty_add_compound(
@@ -1400,7 +1543,8 @@ void open_add_penalty_dialog(QWidget *parent, bool home,
 			log_penalty_event(home, player_num);
 		else
 			log_info("[streamn-obs-scoreboard] penalty slots full");
-		update_all_labels();
+		scoreboard_undo_end(home ? "Home Penalty" : "Away Penalty");
+		on_tick();
 	}
 }
 
@@ -1440,14 +1584,17 @@ void open_edit_penalty_dialog(QWidget *parent, bool home, int slot)
 	layout->addWidget(buttons);
 
 	if (dialog.exec() == QDialog::Accepted) {
+		scoreboard_undo_begin();
 		if (home)
 			scoreboard_home_penalty_set_time(slot,
 							 dur_spin->value());
 		else
 			scoreboard_away_penalty_set_time(slot,
 							 dur_spin->value());
+		scoreboard_undo_end(home ? "Home Penalty Edit"
+					 : "Away Penalty Edit");
 		write_files_now();
-		update_all_labels();
+		on_tick();
 	}
 }
 
@@ -1465,9 +1612,32 @@ void open_configure_dialog(QWidget *parent)
 	out_input->setText(
 		QString::fromUtf8(scoreboard_get_output_directory()));
 
+	QLabel *http_label = new QLabel("Overlay feed port", &dialog);
+	QSpinBox *http_spin = new QSpinBox(&dialog);
+	http_spin->setRange(0, 65535);
+	http_spin->setSpecialValueText("Off");
+	http_spin->setValue(g_http_port);
+	http_spin->setToolTip("Serves the scoreboard as JSON at "
+			      "http://127.0.0.1:<port>/state and as live "
+			      "updates at /events for browser sources");
+
+	QLabel *mode_label = new QLabel("Output format", &dialog);
+	QComboBox *mode_combo = new QComboBox(&dialog);
+	mode_combo->addItem("Separate text files", SCOREBOARD_OUTPUT_FILES);
+	mode_combo->addItem("Single JSON file (scoreboard.json)",
+			    SCOREBOARD_OUTPUT_JSON);
+	mode_combo->addItem("Single key=value file (scoreboard.txt)",
+			    SCOREBOARD_OUTPUT_KEY_VALUE);
+	mode_combo->setCurrentIndex(
+		mode_combo->findData((int)scoreboard_get_output_mode()));
+
 	grid->addWidget(out_label, 0, 0);
 	grid->addWidget(out_input, 0, 1);
 	grid->addWidget(out_browse, 0, 2);
+	grid->addWidget(mode_label, 1, 0);
+	grid->addWidget(mode_combo, 1, 1, 1, 2);
+	grid->addWidget(http_label, 2, 0);
+	grid->addWidget(http_spin, 2, 1, 1, 2);
 	root->addLayout(grid);
 
 	QDialogButtonBox *button_box = new QDialogButtonBox(
@@ -1492,6 +1662,16 @@ void open_configure_dialog(QWidget *parent)
 	if (dialog.exec() == QDialog::Accepted) {
 		scoreboard_set_output_directory(
 			out_input->text().trimmed().toUtf8().constData());
+		scoreboard_set_output_mode((enum scoreboard_output_mode)
+						   mode_combo->currentData()
+							   .toInt());
+		/* Publish now so the watcher can pick up a newly created file */
+		write_files_now();
+		scoreboard_writer_flush();
+		if (http_spin->value() != g_http_port) {
+			g_http_port = http_spin->value();
+			apply_http_port();
+		}
 		save_profile_paths();
 		rebuild_file_watcher();
 		update_all_labels();
@@ -1762,7 +1942,7 @@ void open_clock_settings_dialog(QWidget *parent)
 		g_record_chapters_enabled = chapters_check->isChecked();
 		save_profile_paths();
 		scoreboard_clock_reset();
-		update_all_labels();
+		on_tick();
 		update_highlights_button_visibility();
 	}
 }
@@ -1771,7 +1951,7 @@ void open_about_dialog(QWidget *parent)
 {
 	QDialog dialog(parent);
 	dialog.setWindowTitle("About Streamn Scoreboard");
-	dialog.setFixedWidth(360);
+	dialog.setFixedWidth(480);
 	QVBoxLayout *layout = new QVBoxLayout(&dialog);
 
 	QLabel *title_label = new QLabel(
@@ -1823,6 +2003,46 @@ void open_about_dialog(QWidget *parent)
 
 	layout->addSpacing(8);
 
+	/* Timing counters, to tell disk stalls from a busy event loop */
+	layout->addWidget(new QLabel("Performance:", &dialog));
+	QPlainTextEdit *perf_text = new QPlainTextEdit(&dialog);
+	perf_text->setReadOnly(true);
+	perf_text->setLineWrapMode(QPlainTextEdit::NoWrap);
+	perf_text->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+	perf_text->setFixedHeight(120);
+	auto refresh_perf = [perf_text]() {
+		char report[4096];
+		scoreboard_format_perf_stats(report, sizeof(report));
+		perf_text->setPlainText(QString::fromUtf8(report));
+	};
+	refresh_perf();
+	layout->addWidget(perf_text);
+
+	QHBoxLayout *perf_row = new QHBoxLayout();
+	QPushButton *perf_save_btn = new QPushButton("Save Stats...", &dialog);
+	QPushButton *perf_reset_btn = new QPushButton("Reset", &dialog);
+	perf_row->addWidget(perf_save_btn);
+	perf_row->addWidget(perf_reset_btn);
+	perf_row->addStretch();
+	layout->addLayout(perf_row);
+	QObject::connect(perf_save_btn, &QPushButton::clicked, [&dialog]() {
+		QString path = QFileDialog::getSaveFileName(
+			&dialog, "Save Performance Stats", "perf_stats.txt",
+			"Text Files (*.txt)");
+		if (path.isEmpty())
+			return;
+		if (!scoreboard_write_perf_stats(path.toUtf8().constData()))
+			log_info("[streamn-obs-scoreboard] could not write " +
+				 path);
+	});
+	QObject::connect(perf_reset_btn, &QPushButton::clicked,
+			 [refresh_perf]() {
+				 scoreboard_reset_perf_stats();
+				 refresh_perf();
+			 });
+
+	layout->addSpacing(8);
+
 	QDialogButtonBox *buttons =
 		new QDialogButtonBox(QDialogButtonBox::Close, &dialog);
 	QObject::connect(buttons, &QDialogButtonBox::rejected, &dialog,
@@ -2187,6 +2407,33 @@ void hk_away_pen_edit2(void *, obs_hotkey_id, obs_hotkey_t *, bool pressed)
 		Qt::QueuedConnection);
 }
 
+/* Takes the last operator action back, or forward again, together with
+   the timestamp it logged */
+void undo_action(bool redo)
+{
+	scoreboard_clock_sync();
+	if (!(redo ? scoreboard_redo() : scoreboard_undo()))
+		return;
+	/* The open timestamps file follows the log on its own */
+	if (!scoreboard_event_log_is_open())
+		write_timestamps_file();
+	update_copy_timestamps_visibility();
+	write_files_now();
+	on_tick();
+}
+
+void hk_undo(void *, obs_hotkey_id, obs_hotkey_t *, bool pressed)
+{
+	if (pressed)
+		undo_action(false);
+}
+
+void hk_redo(void *, obs_hotkey_id, obs_hotkey_t *, bool pressed)
+{
+	if (pressed)
+		undo_action(true);
+}
+
 void hk_generate_highlights(void *, obs_hotkey_id, obs_hotkey_t *,
 			     bool pressed)
 {
@@ -2293,155 +2540,208 @@ void save_hotkeys(obs_data_t *save_data, bool saving, void *private_data)
 	}
 }
 
+/* Hotkeys that do nothing beyond one core call are posted as built-in
+   commands, so a recorded trace replays them without the dock */
+struct hotkey_command {
+	obs_hotkey_func fn;
+	int32_t type;
+	int32_t a;
+	int32_t b;
+};
+
+const hotkey_command kHotkeyCommands[] = {
+	{hk_clock_startstop, SCOREBOARD_CMD_CLOCK_TOGGLE, 0, 0},
+	{hk_clock_reset, SCOREBOARD_CMD_CLOCK_RESET, 0, 0},
+	{hk_clock_plus1min, SCOREBOARD_CMD_CLOCK_ADJUST_SECONDS, 60, 0},
+	{hk_clock_minus1min, SCOREBOARD_CMD_CLOCK_ADJUST_SECONDS, -60, 0},
+	{hk_clock_plus1sec, SCOREBOARD_CMD_CLOCK_ADJUST_SECONDS, 1, 0},
+	{hk_clock_minus1sec, SCOREBOARD_CMD_CLOCK_ADJUST_SECONDS, -1, 0},
+	{hk_home_shot_plus, SCOREBOARD_CMD_SHOTS, SCOREBOARD_TEAM_HOME, 1},
+	{hk_home_shot_minus, SCOREBOARD_CMD_SHOTS, SCOREBOARD_TEAM_HOME, -1},
+	{hk_away_shot_plus, SCOREBOARD_CMD_SHOTS, SCOREBOARD_TEAM_AWAY, 1},
+	{hk_away_shot_minus, SCOREBOARD_CMD_SHOTS, SCOREBOARD_TEAM_AWAY, -1},
+	{hk_home_fo_plus, SCOREBOARD_CMD_FACEOFFS, SCOREBOARD_TEAM_HOME, 1},
+	{hk_home_fo_minus, SCOREBOARD_CMD_FACEOFFS, SCOREBOARD_TEAM_HOME, -1},
+	{hk_away_fo_plus, SCOREBOARD_CMD_FACEOFFS, SCOREBOARD_TEAM_AWAY, 1},
+	{hk_away_fo_minus, SCOREBOARD_CMD_FACEOFFS, SCOREBOARD_TEAM_AWAY, -1},
+	{hk_period_rewind, SCOREBOARD_CMD_PERIOD_REWIND, 0, 0},
+};
+
+scoreboard_command hotkey_to_command(intptr_t idx)
+{
+	scoreboard_command cmd = {};
+	cmd.type = SCOREBOARD_CMD_USER + (int32_t)idx;
+	for (const hotkey_command &h : kHotkeyCommands) {
+		if (h.fn == g_hotkey_funcs[idx]) {
+			cmd.type = h.type;
+			cmd.a = h.a;
+			cmd.b = h.b;
+			break;
+		}
+	}
+	return cmd;
+}
+
+void run_hotkey_command(const scoreboard_command *cmd, void *)
+{
+	int idx = cmd->type - SCOREBOARD_CMD_USER;
+	if (idx < 0 || idx >= kNumHotkeys)
+		return;
+	obs_hotkey_func fn = g_hotkey_funcs[idx];
+	/* Undo and redo aren't edits to take back themselves */
+	bool undoable = fn != hk_undo && fn != hk_redo;
+	if (undoable)
+		scoreboard_undo_begin();
+	fn(nullptr, g_hotkey_ids[idx], nullptr, true);
+	if (undoable)
+		scoreboard_undo_end(g_hotkey_labels[idx]);
+}
+
+/* Applies the queued presses between a clock sync and an immediate
+   tick, so the change is written and shown right away rather than at
+   the next scheduled tick */
+void drain_commands()
+{
+	g_drain_pending.store(false);
+	scoreboard_clock_sync();
+	if (scoreboard_command_drain(run_hotkey_command, nullptr) > 0) {
+		/* A toggle that started the clock opens the period */
+		if (scoreboard_clock_is_running())
+			log_period_start_event();
+		on_tick();
+	}
+}
+
+/* Hotkeys fire on the OBS hotkey thread. Presses go through the command
+   queue and the dock applies them in one batch on its own thread, so a
+   burst of presses costs a single queued call and a single tick. */
+void hk_dispatch(void *data, obs_hotkey_id id, obs_hotkey_t *, bool pressed)
+{
+	if (!pressed)
+		return;
+	intptr_t idx = (intptr_t)data;
+	if (!g_dock_widget) {
+		g_hotkey_funcs[idx](nullptr, id, nullptr, pressed);
+		return;
+	}
+	scoreboard_command cmd = hotkey_to_command(idx);
+	if (!scoreboard_command_post(&cmd)) {
+		log_info("[streamn-obs-scoreboard] command queue full, "
+			 "hotkey dropped");
+		return;
+	}
+	if (!g_drain_pending.exchange(true))
+		QMetaObject::invokeMethod(g_dock_widget, drain_commands,
+					  Qt::QueuedConnection);
+}
+
+void register_hotkey(int &idx, const char *name, const char *description,
+		     obs_hotkey_func fn)
+{
+	g_hotkey_funcs[idx] = fn;
+	g_hotkey_labels[idx] = strncmp(description, "Streamn: ", 9) == 0
+				       ? description + 9
+				       : description;
+	g_hotkey_ids[idx] = obs_hotkey_register_frontend(
+		name, description, hk_dispatch, (void *)(intptr_t)idx);
+	idx++;
+}
+
 void register_hotkeys()
 {
 	int idx = 0;
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_clock_startstop", "Streamn: Clock Start/Stop",
-		hk_clock_startstop, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_clock_reset", "Streamn: Clock Reset", hk_clock_reset,
-		nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_clock_plus1min", "Streamn: Clock +1 Min",
-		hk_clock_plus1min, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_clock_minus1min", "Streamn: Clock -1 Min",
-		hk_clock_minus1min, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_clock_plus1sec", "Streamn: Clock +1 Sec",
-		hk_clock_plus1sec, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_clock_minus1sec", "Streamn: Clock -1 Sec",
-		hk_clock_minus1sec, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_home_goal_plus", "Streamn: Home Goal +",
-		hk_home_goal_plus, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_home_goal_minus", "Streamn: Home Goal -",
-		hk_home_goal_minus, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_home_shot_plus", "Streamn: Home Shot +",
-		hk_home_shot_plus, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_home_shot_minus", "Streamn: Home Shot -",
-		hk_home_shot_minus, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_away_goal_plus", "Streamn: Away Goal +",
-		hk_away_goal_plus, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_away_goal_minus", "Streamn: Away Goal -",
-		hk_away_goal_minus, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_away_shot_plus", "Streamn: Away Shot +",
-		hk_away_shot_plus, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_away_shot_minus", "Streamn: Away Shot -",
-		hk_away_shot_minus, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_period_advance", "Streamn: Period Advance",
-		hk_period_advance, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_period_rewind", "Streamn: Period Rewind",
-		hk_period_rewind, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_home_pen_add", "Streamn: Home Penalty Add",
-		hk_home_pen_add, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_home_pen_clear1", "Streamn: Home Penalty Clear 1",
-		hk_home_pen_clear1, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_home_pen_clear2", "Streamn: Home Penalty Clear 2",
-		hk_home_pen_clear2, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_away_pen_add", "Streamn: Away Penalty Add",
-		hk_away_pen_add, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_away_pen_clear1", "Streamn: Away Penalty Clear 1",
-		hk_away_pen_clear1, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_away_pen_clear2", "Streamn: Away Penalty Clear 2",
-		hk_away_pen_clear2, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_generate_highlights",
-		"Streamn: Generate Period Highlights",
-		hk_generate_highlights, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_home_foul_plus", "Streamn: Home Foul +",
-		hk_home_foul_plus, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_home_foul_minus", "Streamn: Home Foul -",
-		hk_home_foul_minus, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_away_foul_plus", "Streamn: Away Foul +",
-		hk_away_foul_plus, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_away_foul_minus", "Streamn: Away Foul -",
-		hk_away_foul_minus, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_home_foul2_plus", "Streamn: Home Foul2 +",
-		hk_home_foul2_plus, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_home_foul2_minus", "Streamn: Home Foul2 -",
-		hk_home_foul2_minus, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_away_foul2_plus", "Streamn: Away Foul2 +",
-		hk_away_foul2_plus, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_away_foul2_minus", "Streamn: Away Foul2 -",
-		hk_away_foul2_minus, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_home_major_pen_add",
-		"Streamn: Home Major Penalty Add",
-		hk_home_major_pen_add, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_away_major_pen_add",
-		"Streamn: Away Major Penalty Add",
-		hk_away_major_pen_add, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_home_fo_plus", "Streamn: Home Faceoff +",
-		hk_home_fo_plus, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_home_fo_minus", "Streamn: Home Faceoff -",
-		hk_home_fo_minus, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_away_fo_plus", "Streamn: Away Faceoff +",
-		hk_away_fo_plus, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_away_fo_minus", "Streamn: Away Faceoff -",
-		hk_away_fo_minus, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_home_2plus2_pen_add",
-		"Streamn: Home 2+2 Penalty Add",
-		hk_home_2plus2_pen_add, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_away_2plus2_pen_add",
-		"Streamn: Away 2+2 Penalty Add",
-		hk_away_2plus2_pen_add, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_home_2plus5_pen_add",
-		"Streamn: Home 2+5 Penalty Add",
-		hk_home_2plus5_pen_add, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_away_2plus5_pen_add",
-		"Streamn: Away 2+5 Penalty Add",
-		hk_away_2plus5_pen_add, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_home_pen_edit1",
-		"Streamn: Home Penalty Edit 1",
-		hk_home_pen_edit1, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_home_pen_edit2",
-		"Streamn: Home Penalty Edit 2",
-		hk_home_pen_edit2, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_away_pen_edit1",
-		"Streamn: Away Penalty Edit 1",
-		hk_away_pen_edit1, nullptr);
-	g_hotkey_ids[idx++] = obs_hotkey_register_frontend(
-		"sb_away_pen_edit2",
-		"Streamn: Away Penalty Edit 2",
-		hk_away_pen_edit2, nullptr);
+	register_hotkey(idx, "sb_clock_startstop", "Streamn: Clock Start/Stop",
+			hk_clock_startstop);
+	register_hotkey(idx, "sb_clock_reset", "Streamn: Clock Reset",
+			hk_clock_reset);
+	register_hotkey(idx, "sb_clock_plus1min", "Streamn: Clock +1 Min",
+			hk_clock_plus1min);
+	register_hotkey(idx, "sb_clock_minus1min", "Streamn: Clock -1 Min",
+			hk_clock_minus1min);
+	register_hotkey(idx, "sb_clock_plus1sec", "Streamn: Clock +1 Sec",
+			hk_clock_plus1sec);
+	register_hotkey(idx, "sb_clock_minus1sec", "Streamn: Clock -1 Sec",
+			hk_clock_minus1sec);
+	register_hotkey(idx, "sb_home_goal_plus", "Streamn: Home Goal +",
+			hk_home_goal_plus);
+	register_hotkey(idx, "sb_home_goal_minus", "Streamn: Home Goal -",
+			hk_home_goal_minus);
+	register_hotkey(idx, "sb_home_shot_plus", "Streamn: Home Shot +",
+			hk_home_shot_plus);
+	register_hotkey(idx, "sb_home_shot_minus", "Streamn: Home Shot -",
+			hk_home_shot_minus);
+	register_hotkey(idx, "sb_away_goal_plus", "Streamn: Away Goal +",
+			hk_away_goal_plus);
+	register_hotkey(idx, "sb_away_goal_minus", "Streamn: Away Goal -",
+			hk_away_goal_minus);
+	register_hotkey(idx, "sb_away_shot_plus", "Streamn: Away Shot +",
+			hk_away_shot_plus);
+	register_hotkey(idx, "sb_away_shot_minus", "Streamn: Away Shot -",
+			hk_away_shot_minus);
+	register_hotkey(idx, "sb_period_advance", "Streamn: Period Advance",
+			hk_period_advance);
+	register_hotkey(idx, "sb_period_rewind", "Streamn: Period Rewind",
+			hk_period_rewind);
+	register_hotkey(idx, "sb_home_pen_add", "Streamn: Home Penalty Add",
+			hk_home_pen_add);
+	register_hotkey(idx, "sb_home_pen_clear1",
+			"Streamn: Home Penalty Clear 1", hk_home_pen_clear1);
+	register_hotkey(idx, "sb_home_pen_clear2",
+			"Streamn: Home Penalty Clear 2", hk_home_pen_clear2);
+	register_hotkey(idx, "sb_away_pen_add", "Streamn: Away Penalty Add",
+			hk_away_pen_add);
+	register_hotkey(idx, "sb_away_pen_clear1",
+			"Streamn: Away Penalty Clear 1", hk_away_pen_clear1);
+	register_hotkey(idx, "sb_away_pen_clear2",
+			"Streamn: Away Penalty Clear 2", hk_away_pen_clear2);
+	register_hotkey(idx, "sb_generate_highlights",
+			"Streamn: Generate Period Highlights", hk_generate_highlights);
+	register_hotkey(idx, "sb_home_foul_plus", "Streamn: Home Foul +",
+			hk_home_foul_plus);
+	register_hotkey(idx, "sb_home_foul_minus", "Streamn: Home Foul -",
+			hk_home_foul_minus);
+	register_hotkey(idx, "sb_away_foul_plus", "Streamn: Away Foul +",
+			hk_away_foul_plus);
+	register_hotkey(idx, "sb_away_foul_minus", "Streamn: Away Foul -",
+			hk_away_foul_minus);
+	register_hotkey(idx, "sb_home_foul2_plus", "Streamn: Home Foul2 +",
+			hk_home_foul2_plus);
+	register_hotkey(idx, "sb_home_foul2_minus", "Streamn: Home Foul2 -",
+			hk_home_foul2_minus);
+	register_hotkey(idx, "sb_away_foul2_plus", "Streamn: Away Foul2 +",
+			hk_away_foul2_plus);
+	register_hotkey(idx, "sb_away_foul2_minus", "Streamn: Away Foul2 -",
+			hk_away_foul2_minus);
+	register_hotkey(idx, "sb_home_major_pen_add",
+			"Streamn: Home Major Penalty Add", hk_home_major_pen_add);
+	register_hotkey(idx, "sb_away_major_pen_add",
+			"Streamn: Away Major Penalty Add", hk_away_major_pen_add);
+	register_hotkey(idx, "sb_home_fo_plus", "Streamn: Home Faceoff +",
+			hk_home_fo_plus);
+	register_hotkey(idx, "sb_home_fo_minus", "Streamn: Home Faceoff -",
+			hk_home_fo_minus);
+	register_hotkey(idx, "sb_away_fo_plus", "Streamn: Away Faceoff +",
+			hk_away_fo_plus);
+	register_hotkey(idx, "sb_away_fo_minus", "Streamn: Away Faceoff -",
+			hk_away_fo_minus);
+	register_hotkey(idx, "sb_home_2plus2_pen_add",
+			"Streamn: Home 2+2 Penalty Add", hk_home_2plus2_pen_add);
+	register_hotkey(idx, "sb_away_2plus2_pen_add",
+			"Streamn: Away 2+2 Penalty Add", hk_away_2plus2_pen_add);
+	register_hotkey(idx, "sb_home_2plus5_pen_add",
+			"Streamn: Home 2+5 Penalty Add", hk_home_2plus5_pen_add);
+	register_hotkey(idx, "sb_away_2plus5_pen_add",
+			"Streamn: Away 2+5 Penalty Add", hk_away_2plus5_pen_add);
+	register_hotkey(idx, "sb_home_pen_edit1",
+			"Streamn: Home Penalty Edit 1", hk_home_pen_edit1);
+	register_hotkey(idx, "sb_home_pen_edit2",
+			"Streamn: Home Penalty Edit 2", hk_home_pen_edit2);
+	register_hotkey(idx, "sb_away_pen_edit1",
+			"Streamn: Away Penalty Edit 1", hk_away_pen_edit1);
+	register_hotkey(idx, "sb_away_pen_edit2",
+			"Streamn: Away Penalty Edit 2", hk_away_pen_edit2);
+	register_hotkey(idx, "sb_undo", "Streamn: Undo", hk_undo);
+	register_hotkey(idx, "sb_redo", "Streamn: Redo", hk_redo);
 
 	/* Register save/load callbacks to persist hotkey bindings */
 	obs_frontend_add_save_callback(save_hotkeys, nullptr);
@@ -2459,11 +2759,12 @@ void on_frontend_event(enum obs_frontend_event event, void *private_data)
 		update_copy_timestamps_visibility();
 	}
 	/* OBS frontend events and Qt button/hotkey callbacks all run on the
-	   main (Qt) thread, so g_stream_active and g_stream_timer are safe
+	   main (Qt) thread, so the timelines and the event log are safe
 	   to access without additional synchronization. */
 	if (event == OBS_FRONTEND_EVENT_STREAMING_STARTED) {
-		g_stream_timer.start();
-		g_stream_active = true;
+		scoreboard_timeline_mark(SCOREBOARD_TIMELINE_STREAM,
+					 SCOREBOARD_MARK_START,
+					 scoreboard_timeline_now());
 		g_period_start_logged = -1;
 
 		char ts_path[544];
@@ -2490,17 +2791,22 @@ void on_frontend_event(enum obs_frontend_event event, void *private_data)
 				box.exec();
 
 				if (box.clickedButton() == fresh) {
-					scoreboard_event_log_clear();
+					clear_stream_events();
+					open_timestamps_file();
 					log_event("Stream Start");
 				} else {
+					/* Applies any tombstones left by
+					   a crash, then opening compacts */
 					scoreboard_event_log_read(
 						saved_path.toUtf8()
 							.constData());
+					open_timestamps_file();
 				}
 				update_copy_timestamps_visibility();
 			});
 		} else {
-			scoreboard_event_log_clear();
+			clear_stream_events();
+			open_timestamps_file();
 			log_event("Stream Start");
 			update_copy_timestamps_visibility();
 		}
@@ -2509,22 +2815,38 @@ void on_frontend_event(enum obs_frontend_event event, void *private_data)
 			 "event timestamps enabled");
 	}
 	if (event == OBS_FRONTEND_EVENT_STREAMING_STOPPED) {
-		g_stream_active = false;
-		write_timestamps_file();
+		scoreboard_timeline_mark(SCOREBOARD_TIMELINE_STREAM,
+					 SCOREBOARD_MARK_STOP,
+					 scoreboard_timeline_now());
+		/* Writes timestamps.txt as the clean chapter list, with the
+		   other chapter formats beside it */
+		export_timestamps_files();
+		scoreboard_event_log_close();
 		update_copy_timestamps_visibility();
 		log_info("[streamn-obs-scoreboard] streaming stopped — "
 			 "timestamps written");
 	}
 	if (event == OBS_FRONTEND_EVENT_RECORDING_STARTED) {
-		g_recording_active = true;
-		g_recording_timer.start();
-		g_recording_chapters.clear();
+		scoreboard_timeline_mark(SCOREBOARD_TIMELINE_RECORDING,
+					 SCOREBOARD_MARK_START,
+					 scoreboard_timeline_now());
 		add_recording_chapter("Recording Start");
 		log_info("[streamn-obs-scoreboard] recording started — "
 			 "chapter tracking enabled");
 	}
+	/* Paused time is left out of the recording's chapter offsets */
+	if (event == OBS_FRONTEND_EVENT_RECORDING_PAUSED)
+		scoreboard_timeline_mark(SCOREBOARD_TIMELINE_RECORDING,
+					 SCOREBOARD_MARK_PAUSE,
+					 scoreboard_timeline_now());
+	if (event == OBS_FRONTEND_EVENT_RECORDING_UNPAUSED)
+		scoreboard_timeline_mark(SCOREBOARD_TIMELINE_RECORDING,
+					 SCOREBOARD_MARK_RESUME,
+					 scoreboard_timeline_now());
 	if (event == OBS_FRONTEND_EVENT_RECORDING_STOPPED) {
-		g_recording_active = false;
+		scoreboard_timeline_mark(SCOREBOARD_TIMELINE_RECORDING,
+					 SCOREBOARD_MARK_STOP,
+					 scoreboard_timeline_now());
 		if (g_record_chapters_enabled && g_get_last_recording) {
 			char *path = g_get_last_recording();
 			if (path) {
@@ -2532,7 +2854,6 @@ void on_frontend_event(enum obs_frontend_event event, void *private_data)
 				bfree(path);
 			}
 		}
-		g_recording_chapters.clear();
 	}
 }
 } // namespace
@@ -2544,8 +2865,23 @@ bool scoreboard_dock_init(scoreboard_log_fn log_fn)
 
 	g_log_fn = log_fn;
 	scoreboard_reset_state_for_tests();
+	/* The reset freezes time for tests; the dock runs on the real clock */
+	scoreboard_set_time_source(nullptr);
 	load_profile_paths();
 	scoreboard_read_all_files();
+	open_state_journal();
+	restore_autosave();
+	open_session_trace();
+	start_autosave();
+
+	/* Output files are published off the UI thread from here on */
+	if (!scoreboard_writer_start())
+		log_info("[streamn-obs-scoreboard] background writer "
+			 "unavailable, writing files on the UI thread");
+	if (!scoreboard_shm_open(SCOREBOARD_SHM_DEFAULT_NAME))
+		log_info("[streamn-obs-scoreboard] shared-memory snapshot "
+			 "unavailable");
+	apply_http_port();
 
 	/* Detect OBS 32+ recording chapter API at runtime for backwards
 	   compatibility.  These symbols only exist in obs-frontend-api 32+. */
@@ -3036,6 +3372,18 @@ bool scoreboard_dock_init(scoreboard_log_fn log_fn)
 
 	add_separator();
 
+	/* Undo / Redo the last operator action */
+	QHBoxLayout *undo_row = new QHBoxLayout();
+	undo_row->setContentsMargins(0, 0, 0, 0);
+	undo_row->setSpacing(6);
+	g_undo_btn = new QPushButton("Undo", widget);
+	g_redo_btn = new QPushButton("Redo", widget);
+	g_undo_btn->setEnabled(false);
+	g_redo_btn->setEnabled(false);
+	undo_row->addWidget(g_undo_btn, 1);
+	undo_row->addWidget(g_redo_btn, 1);
+	root->addLayout(undo_row);
+
 	/* Highlights generation row: [Generate {Segment} Highlights] [Game Finished] */
 	QHBoxLayout *highlights_row = new QHBoxLayout();
 	highlights_row->setContentsMargins(0, 0, 0, 0);
@@ -3099,24 +3447,32 @@ bool scoreboard_dock_init(scoreboard_log_fn log_fn)
 
 	/* Connect signals */
 	QObject::connect(clock_minus_min, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_clock_adjust_minutes(-1);
+		scoreboard_undo_end("Clock -1 Min");
 		write_files_now();
-		update_all_labels();
+		on_tick();
 	});
 	QObject::connect(clock_minus_sec, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_clock_adjust_seconds(-1);
+		scoreboard_undo_end("Clock -1 Sec");
 		write_files_now();
-		update_all_labels();
+		on_tick();
 	});
 	QObject::connect(clock_plus_sec, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_clock_adjust_seconds(1);
+		scoreboard_undo_end("Clock +1 Sec");
 		write_files_now();
-		update_all_labels();
+		on_tick();
 	});
 	QObject::connect(clock_plus_min, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_clock_adjust_minutes(1);
+		scoreboard_undo_end("Clock +1 Min");
 		write_files_now();
-		update_all_labels();
+		on_tick();
 	});
 	QObject::connect(g_clock_btn, &QPushButton::clicked, []() {
 		if (scoreboard_clock_is_running()) {
@@ -3125,112 +3481,160 @@ bool scoreboard_dock_init(scoreboard_log_fn log_fn)
 			scoreboard_clock_start();
 			log_period_start_event();
 		}
-		update_all_labels();
+		on_tick();
 	});
 	QObject::connect(g_period_adv_btn, &QPushButton::clicked, []() {
 		if (!confirm_mid_period_action(g_dock_widget,
 					       "advance the period"))
 			return;
+		scoreboard_undo_begin();
 		log_period_end_event();
 		scoreboard_period_advance();
-		update_all_labels();
+		scoreboard_undo_end("Period Advance");
+		on_tick();
 	});
 	QObject::connect(period_rew_btn, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_period_rewind();
-		update_all_labels();
+		scoreboard_undo_end("Period Rewind");
+		on_tick();
 	});
 	QObject::connect(home_goal_plus, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_increment_home_score();
 		log_goal_event(true);
-		update_all_labels();
+		scoreboard_undo_end("Home Goal +");
+		on_tick();
 	});
 	QObject::connect(home_goal_minus, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		remove_goal_event(true);
 		scoreboard_decrement_home_score();
-		update_all_labels();
+		scoreboard_undo_end("Home Goal -");
+		on_tick();
 	});
 	QObject::connect(away_goal_plus, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_increment_away_score();
 		log_goal_event(false);
-		update_all_labels();
+		scoreboard_undo_end("Away Goal +");
+		on_tick();
 	});
 	QObject::connect(away_goal_minus, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		remove_goal_event(false);
 		scoreboard_decrement_away_score();
-		update_all_labels();
+		scoreboard_undo_end("Away Goal -");
+		on_tick();
 	});
 	QObject::connect(home_shot_plus, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_increment_home_shots();
-		update_all_labels();
+		scoreboard_undo_end("Home Shot +");
+		on_tick();
 	});
 	QObject::connect(home_shot_minus, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_decrement_home_shots();
-		update_all_labels();
+		scoreboard_undo_end("Home Shot -");
+		on_tick();
 	});
 	QObject::connect(away_shot_plus, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_increment_away_shots();
-		update_all_labels();
+		scoreboard_undo_end("Away Shot +");
+		on_tick();
 	});
 	QObject::connect(away_shot_minus, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_decrement_away_shots();
-		update_all_labels();
+		scoreboard_undo_end("Away Shot -");
+		on_tick();
 	});
 	QObject::connect(home_fo_plus, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_increment_home_faceoffs();
-		update_all_labels();
+		scoreboard_undo_end("Home Faceoff +");
+		on_tick();
 	});
 	QObject::connect(home_fo_minus, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_decrement_home_faceoffs();
-		update_all_labels();
+		scoreboard_undo_end("Home Faceoff -");
+		on_tick();
 	});
 	QObject::connect(away_fo_plus, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_increment_away_faceoffs();
-		update_all_labels();
+		scoreboard_undo_end("Away Faceoff +");
+		on_tick();
 	});
 	QObject::connect(away_fo_minus, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_decrement_away_faceoffs();
-		update_all_labels();
+		scoreboard_undo_end("Away Faceoff -");
+		on_tick();
 	});
 	QObject::connect(home_foul_plus, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_increment_home_fouls();
+		scoreboard_undo_end("Home Foul +");
 		write_files_now();
-		update_all_labels();
+		on_tick();
 	});
 	QObject::connect(home_foul_minus, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_decrement_home_fouls();
+		scoreboard_undo_end("Home Foul -");
 		write_files_now();
-		update_all_labels();
+		on_tick();
 	});
 	QObject::connect(away_foul_plus, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_increment_away_fouls();
+		scoreboard_undo_end("Away Foul +");
 		write_files_now();
-		update_all_labels();
+		on_tick();
 	});
 	QObject::connect(away_foul_minus, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_decrement_away_fouls();
+		scoreboard_undo_end("Away Foul -");
 		write_files_now();
-		update_all_labels();
+		on_tick();
 	});
 	QObject::connect(home_foul2_plus, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_increment_home_fouls2();
+		scoreboard_undo_end("Home Foul 2 +");
 		write_files_now();
-		update_all_labels();
+		on_tick();
 	});
 	QObject::connect(home_foul2_minus, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_decrement_home_fouls2();
+		scoreboard_undo_end("Home Foul 2 -");
 		write_files_now();
-		update_all_labels();
+		on_tick();
 	});
 	QObject::connect(away_foul2_plus, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_increment_away_fouls2();
+		scoreboard_undo_end("Away Foul 2 +");
 		write_files_now();
-		update_all_labels();
+		on_tick();
 	});
 	QObject::connect(away_foul2_minus, &QPushButton::clicked, []() {
+		scoreboard_undo_begin();
 		scoreboard_decrement_away_fouls2();
+		scoreboard_undo_end("Away Foul 2 -");
 		write_files_now();
-		update_all_labels();
+		on_tick();
 	});
+	QObject::connect(g_undo_btn, &QPushButton::clicked,
+			 []() { undo_action(false); });
+	QObject::connect(g_redo_btn, &QPushButton::clicked,
+			 []() { undo_action(true); });
 	QObject::connect(g_home_name_edit, &QLineEdit::editingFinished, []() {
 		scoreboard_set_home_name(
 			g_home_name_edit->text().trimmed().toUtf8().constData());
@@ -3281,7 +3685,8 @@ bool scoreboard_dock_init(scoreboard_log_fn log_fn)
 			for (int i = 0; i < count; i++) {
 				const struct scoreboard_game_event *ev =
 					scoreboard_event_log_get(i);
-				if (!ev)
+				/* Logged only for a recording */
+				if (!ev || ev->offset_seconds < 0)
 					continue;
 				int total = ev->offset_seconds;
 				int hours = total / 3600;
@@ -3305,6 +3710,9 @@ bool scoreboard_dock_init(scoreboard_log_fn log_fn)
 						       .trimmed();
 			}
 		}
+		/* Leave the file on disk matching what was copied */
+		if (scoreboard_event_log_is_open())
+			scoreboard_event_log_compact();
 		if (!text.isEmpty()) {
 			QGuiApplication::clipboard()->setText(text);
 			log_info("[streamn-obs-scoreboard] timestamps "
@@ -3324,21 +3732,34 @@ bool scoreboard_dock_init(scoreboard_log_fn log_fn)
 		scoreboard_event_log_clear();
 		write_timestamps_file();
 		update_copy_timestamps_visibility();
-		update_all_labels();
+		on_tick();
 	});
 	QObject::connect(refresh_action, &QAction::triggered, []() {
+		scoreboard_writer_flush();
 		scoreboard_read_all_files();
-		update_all_labels();
+		on_tick();
 	});
 	QObject::connect(about_action, &QAction::triggered,
 			 [widget]() { open_about_dialog(widget); });
 
-	/* Timer — uses wall-clock elapsed time for accurate ticking */
+	/* Timer — single-shot, re-armed by every tick for the next display
+	   change. It only decides when to render: the core derives running
+	   time from the monotonic clock, so a late tick loses nothing. */
 	g_tick_timer = new QTimer(widget);
-	g_tick_timer->setInterval(100);
-	g_clock_elapsed.start();
+	g_tick_timer->setSingleShot(true);
+	g_tick_timer->setTimerType(Qt::PreciseTimer);
 	QObject::connect(g_tick_timer, &QTimer::timeout, on_tick);
-	g_tick_timer->start();
+
+	/* Autosave — cheap when nothing changed, and the file itself is
+	   written on the autosave worker. It also retries output files the
+	   writer thread failed to publish while the clock isn't ticking. */
+	g_autosave_timer = new QTimer(widget);
+	QObject::connect(g_autosave_timer, &QTimer::timeout, []() {
+		scoreboard_autosave();
+		if (scoreboard_is_dirty())
+			on_tick();
+	});
+	g_autosave_timer->start(kAutosaveIntervalMs);
 
 	/* File watcher for external changes */
 	g_file_watcher = new QFileSystemWatcher(widget);
@@ -3361,7 +3782,7 @@ bool scoreboard_dock_init(scoreboard_log_fn log_fn)
 	register_hotkeys();
 
 	obs_frontend_add_event_callback(on_frontend_event, nullptr);
-	update_all_labels();
+	on_tick();
 	update_highlights_button_visibility();
 	log_info("[streamn-obs-scoreboard] dock initialized");
 	return true;
@@ -3379,17 +3800,32 @@ void scoreboard_dock_shutdown(void)
 		g_tick_timer->stop();
 		g_tick_timer = nullptr;
 	}
+	if (g_autosave_timer) {
+		g_autosave_timer->stop();
+		g_autosave_timer = nullptr;
+	}
+
+	/* Publish the final state, then let the writer drain and exit */
+	scoreboard_write_all_files();
+	scoreboard_journal_close();
+	scoreboard_event_log_close();
+	scoreboard_autosave();
+	scoreboard_autosave_stop();
+	scoreboard_trace_stop();
+	scoreboard_writer_stop();
+	scoreboard_shm_close();
+	scoreboard_http_stop();
 
 	g_file_watcher = nullptr;
 
 	g_highlights_btn = nullptr;
 	g_period_adv_btn = nullptr;
+	g_undo_btn = nullptr;
+	g_redo_btn = nullptr;
 	g_game_finished = nullptr;
 	g_copy_timestamps_btn = nullptr;
-	g_stream_active = false;
 	g_period_start_logged = -1;
-	g_recording_active = false;
-	g_recording_chapters.clear();
+	scoreboard_timeline_reset();
 
 	for (process_job *job : g_jobs) {
 		if (!job)
@@ -0,0 +1,52 @@
+#include "scoreboard-arena.h"
+
+#include <stdlib.h>
+
+void scoreboard_arena_init(struct scoreboard_arena *arena, size_t item_size,
+			   int chunk_items)
+{
+	arena->item_size = item_size;
+	arena->chunk_items = chunk_items;
+	arena->chunks = NULL;
+	arena->chunk_count = 0;
+	arena->chunk_capacity = 0;
+}
+
+void scoreboard_arena_free(struct scoreboard_arena *arena)
+{
+	for (int i = 0; i < arena->chunk_count; i++)
+		free(arena->chunks[i]);
+	free(arena->chunks);
+	arena->chunks = NULL;
+	arena->chunk_count = 0;
+	arena->chunk_capacity = 0;
+}
+
+/* Doubles the directory, so adding chunks is amortized O(1) */
+static bool grow_directory(struct scoreboard_arena *arena)
+{
+	int capacity = arena->chunk_capacity > 0 ? arena->chunk_capacity * 2
+						 : 4;
+	char **chunks = (char **)realloc(arena->chunks,
+					 (size_t)capacity * sizeof(*chunks));
+	if (chunks == NULL)
+		return false;
+	arena->chunks = chunks;
+	arena->chunk_capacity = capacity;
+	return true;
+}
+
+bool scoreboard_arena_reserve(struct scoreboard_arena *arena, int count)
+{
+	while (arena->chunk_count * arena->chunk_items < count) {
+		if (arena->chunk_count == arena->chunk_capacity &&
+		    !grow_directory(arena))
+			return false;
+		char *chunk = (char *)malloc((size_t)arena->chunk_items *
+					     arena->item_size);
+		if (chunk == NULL)
+			return false;
+		arena->chunks[arena->chunk_count++] = chunk;
+	}
+	return true;
+}
@@ -0,0 +1,38 @@
+#ifndef SCOREBOARD_ARENA_H
+#define SCOREBOARD_ARENA_H
+
+/* Internal growable array for the core library, stored in fixed-size
+   chunks that never move once allocated: growing adds a chunk and never
+   copies an item, so pointers to items stay valid until the arena is
+   freed. Not part of the public API. */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct scoreboard_arena {
+	size_t item_size;
+	int chunk_items;
+	/* Chunk directory; only the pointers move when it grows */
+	char **chunks;
+	int chunk_count;
+	int chunk_capacity;
+};
+
+/* Sets up an empty arena; an arena that held chunks must be freed first */
+void scoreboard_arena_init(struct scoreboard_arena *arena, size_t item_size,
+			   int chunk_items);
+void scoreboard_arena_free(struct scoreboard_arena *arena);
+
+/* Makes room for items 0..count-1, keeping chunks already allocated.
+   False if memory ran out; the items already there are untouched. */
+bool scoreboard_arena_reserve(struct scoreboard_arena *arena, int count);
+
+/* Item index of a reserved arena */
+static inline void *scoreboard_arena_at(const struct scoreboard_arena *arena,
+					int index)
+{
+	return arena->chunks[index / arena->chunk_items] +
+	       (size_t)(index % arena->chunk_items) * arena->item_size;
+}
+
+#endif
@@ -0,0 +1,215 @@
+#include "scoreboard-core.h"
+#include "scoreboard-platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define AUTOSAVE_MAX_PATH 1024
+
+/* Two state copies: the owner fills "queued" under the lock, the worker
+   swaps it with "writing" and serializes that one without the lock, so a
+   slow disk never holds up the owner thread. */
+static struct {
+	scoreboard_mutex_t lock;
+	scoreboard_cond_t wake;
+	scoreboard_cond_t idle;
+	scoreboard_thread_t thread;
+	bool running;
+	bool stopping;
+	bool pending;
+	bool busy;
+	/* The last save failed; the next call saves even without changes */
+	bool failed;
+	char path[AUTOSAVE_MAX_PATH];
+	struct scoreboard_saved_state *queued;
+	struct scoreboard_saved_state *writing;
+	uint64_t saved_generation;
+	struct scoreboard_autosave_stats stats;
+} g_autosave;
+
+/* Called with the lock held while the worker runs */
+static void record_save(uint64_t elapsed, bool ok)
+{
+	scoreboard_perf_add(&g_autosave.stats.save, elapsed, 1);
+	if (ok) {
+		g_autosave.stats.saved++;
+	} else {
+		g_autosave.stats.errors++;
+		g_autosave.failed = true;
+	}
+}
+
+static bool save_copy(const struct scoreboard_saved_state *copy,
+		      uint64_t *elapsed)
+{
+	uint64_t start = scoreboard_perf_now();
+	bool ok = scoreboard_save_captured_state(copy, g_autosave.path);
+	*elapsed = scoreboard_perf_now() - start;
+	return ok;
+}
+
+static void autosave_main(void *arg)
+{
+	(void)arg;
+	scoreboard_mutex_lock(&g_autosave.lock);
+	for (;;) {
+		if (!g_autosave.pending) {
+			scoreboard_cond_broadcast(&g_autosave.idle);
+			if (g_autosave.stopping)
+				break;
+			scoreboard_cond_wait(&g_autosave.wake,
+					     &g_autosave.lock);
+			continue;
+		}
+
+		struct scoreboard_saved_state *copy = g_autosave.queued;
+		g_autosave.queued = g_autosave.writing;
+		g_autosave.writing = copy;
+		g_autosave.pending = false;
+		g_autosave.busy = true;
+		scoreboard_mutex_unlock(&g_autosave.lock);
+
+		uint64_t elapsed;
+		bool ok = save_copy(copy, &elapsed);
+
+		scoreboard_mutex_lock(&g_autosave.lock);
+		record_save(elapsed, ok);
+		g_autosave.busy = false;
+	}
+	scoreboard_mutex_unlock(&g_autosave.lock);
+}
+
+static void free_copies(void)
+{
+	free(g_autosave.queued);
+	free(g_autosave.writing);
+	g_autosave.queued = NULL;
+	g_autosave.writing = NULL;
+	g_autosave.path[0] = '\0';
+}
+
+bool scoreboard_autosave_start(const char *path)
+{
+	if (path == NULL || path[0] == '\0' ||
+	    strlen(path) >= AUTOSAVE_MAX_PATH)
+		return false;
+	scoreboard_autosave_stop();
+
+	g_autosave.queued = (struct scoreboard_saved_state *)malloc(
+		scoreboard_saved_state_size());
+	g_autosave.writing = (struct scoreboard_saved_state *)malloc(
+		scoreboard_saved_state_size());
+	if (g_autosave.queued == NULL || g_autosave.writing == NULL) {
+		free_copies();
+		return false;
+	}
+	snprintf(g_autosave.path, sizeof(g_autosave.path), "%s", path);
+	/* Whatever the state holds now was just loaded or is a fresh game */
+	g_autosave.saved_generation = scoreboard_state_generation();
+	memset(&g_autosave.stats, 0, sizeof(g_autosave.stats));
+	g_autosave.stopping = false;
+	g_autosave.pending = false;
+	g_autosave.busy = false;
+	g_autosave.failed = false;
+
+	scoreboard_mutex_init(&g_autosave.lock);
+	scoreboard_cond_init(&g_autosave.wake);
+	scoreboard_cond_init(&g_autosave.idle);
+	if (!scoreboard_thread_create(&g_autosave.thread, autosave_main,
+				      NULL)) {
+		scoreboard_cond_destroy(&g_autosave.idle);
+		scoreboard_cond_destroy(&g_autosave.wake);
+		scoreboard_mutex_destroy(&g_autosave.lock);
+		return false;
+	}
+	g_autosave.running = true;
+	return true;
+}
+
+void scoreboard_autosave_stop(void)
+{
+	if (g_autosave.running) {
+		/* The worker saves a copy still queued before it exits */
+		scoreboard_mutex_lock(&g_autosave.lock);
+		g_autosave.stopping = true;
+		scoreboard_cond_broadcast(&g_autosave.wake);
+		scoreboard_mutex_unlock(&g_autosave.lock);
+		scoreboard_thread_join(g_autosave.thread);
+
+		g_autosave.running = false;
+		scoreboard_cond_destroy(&g_autosave.idle);
+		scoreboard_cond_destroy(&g_autosave.wake);
+		scoreboard_mutex_destroy(&g_autosave.lock);
+	}
+	free_copies();
+}
+
+bool scoreboard_autosave_is_running(void)
+{
+	return g_autosave.running;
+}
+
+bool scoreboard_autosave(void)
+{
+	if (g_autosave.path[0] == '\0')
+		return false;
+	uint64_t generation = scoreboard_state_generation();
+
+	if (!g_autosave.running) {
+		if (generation == g_autosave.saved_generation &&
+		    !g_autosave.failed) {
+			g_autosave.stats.unchanged++;
+			return false;
+		}
+		g_autosave.saved_generation = generation;
+		g_autosave.failed = false;
+		g_autosave.stats.queued++;
+		scoreboard_capture_state(g_autosave.queued);
+		uint64_t elapsed;
+		bool ok = save_copy(g_autosave.queued, &elapsed);
+		record_save(elapsed, ok);
+		return ok;
+	}
+
+	scoreboard_mutex_lock(&g_autosave.lock);
+	if (generation == g_autosave.saved_generation && !g_autosave.failed) {
+		g_autosave.stats.unchanged++;
+		scoreboard_mutex_unlock(&g_autosave.lock);
+		return false;
+	}
+	g_autosave.saved_generation = generation;
+	g_autosave.failed = false;
+	if (g_autosave.pending)
+		g_autosave.stats.coalesced++;
+	/* A plain struct copy; the serializing happens on the worker */
+	scoreboard_capture_state(g_autosave.queued);
+	g_autosave.pending = true;
+	g_autosave.stats.queued++;
+	scoreboard_cond_broadcast(&g_autosave.wake);
+	scoreboard_mutex_unlock(&g_autosave.lock);
+	return true;
+}
+
+void scoreboard_autosave_flush(void)
+{
+	if (!g_autosave.running)
+		return;
+	scoreboard_mutex_lock(&g_autosave.lock);
+	while (g_autosave.pending || g_autosave.busy)
+		scoreboard_cond_wait(&g_autosave.idle, &g_autosave.lock);
+	scoreboard_mutex_unlock(&g_autosave.lock);
+}
+
+void scoreboard_autosave_get_stats(struct scoreboard_autosave_stats *out)
+{
+	if (out == NULL)
+		return;
+	if (!g_autosave.running) {
+		*out = g_autosave.stats;
+		return;
+	}
+	scoreboard_mutex_lock(&g_autosave.lock);
+	*out = g_autosave.stats;
+	scoreboard_mutex_unlock(&g_autosave.lock);
+}
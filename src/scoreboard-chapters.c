@@ -0,0 +1,365 @@
+#include "scoreboard-core.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHAPTER_MAX_PATH 1024
+/* Timecode rate for the EDL; NLEs conform a marker list to the timeline */
+#define CHAPTER_EDL_FPS 30
+
+/* Each chapter ends where the next one starts, so the writer holds one
+   chapter back until it sees the next start (or the end time) and then
+   renders it into every selected format's buffer. Files are written
+   only at the end, each with a single write. */
+
+struct chapter_buffer {
+	char *data;
+	size_t len;
+	size_t cap;
+	bool failed;
+};
+
+struct scoreboard_chapter_writer {
+	char base_path[CHAPTER_MAX_PATH];
+	unsigned int formats;
+	char title[SCOREBOARD_EVENT_LABEL_SIZE];
+	int count;
+	bool pending;
+	int64_t pending_ms;
+	char pending_label[SCOREBOARD_EVENT_LABEL_SIZE];
+	struct chapter_buffer out[SCOREBOARD_CHAPTER_FORMAT_COUNT];
+};
+
+/* ---- buffers ---- */
+
+static void buffer_append(struct chapter_buffer *b, const char *text,
+			  size_t len)
+{
+	if (b->failed)
+		return;
+	if (b->len + len + 1 > b->cap) {
+		size_t cap = b->cap ? b->cap : 4096;
+		while (b->len + len + 1 > cap)
+			cap *= 2;
+		char *data = (char *)realloc(b->data, cap);
+		if (data == NULL) {
+			b->failed = true;
+			return;
+		}
+		b->data = data;
+		b->cap = cap;
+	}
+	memcpy(b->data + b->len, text, len);
+	b->len += len;
+	b->data[b->len] = '\0';
+}
+
+static void buffer_puts(struct chapter_buffer *b, const char *text)
+{
+	buffer_append(b, text, strlen(text));
+}
+
+static void buffer_printf(struct chapter_buffer *b, const char *fmt, ...)
+{
+	char text[512];
+	va_list args;
+	va_start(args, fmt);
+	int n = vsnprintf(text, sizeof(text), fmt, args);
+	va_end(args);
+	if (n > 0)
+		buffer_append(b, text, (size_t)n < sizeof(text)
+					       ? (size_t)n
+					       : sizeof(text) - 1);
+}
+
+/* Backslash before each character in special, and newlines as \n */
+static void buffer_escaped(struct chapter_buffer *b, const char *text,
+			   const char *special)
+{
+	for (const char *p = text; *p != '\0'; p++) {
+		if (*p == '\n') {
+			buffer_puts(b, "\\n");
+			continue;
+		}
+		if (strchr(special, *p) != NULL)
+			buffer_puts(b, "\\");
+		buffer_append(b, p, 1);
+	}
+}
+
+static void buffer_json_string(struct chapter_buffer *b, const char *text)
+{
+	buffer_puts(b, "\"");
+	for (const char *p = text; *p != '\0'; p++) {
+		if (*p == '"' || *p == '\\')
+			buffer_printf(b, "\\%c", *p);
+		else if ((unsigned char)*p < 0x20)
+			buffer_printf(b, "\\u%04x", (unsigned char)*p);
+		else
+			buffer_append(b, p, 1);
+	}
+	buffer_puts(b, "\"");
+}
+
+/* ---- formats ---- */
+
+struct chapter {
+	int index;
+	int64_t start_ms;
+	int64_t end_ms;
+	const char *label;
+};
+
+static void hms(int64_t ms, int *hours, int *minutes, int *seconds)
+{
+	int64_t total = ms / 1000;
+	*hours = (int)(total / 3600);
+	*minutes = (int)(total % 3600 / 60);
+	*seconds = (int)(total % 60);
+}
+
+static void youtube_chapter(struct chapter_buffer *b, const char *title,
+			    const struct chapter *ch)
+{
+	(void)title;
+	int h, m, s;
+	hms(ch->start_ms, &h, &m, &s);
+	buffer_printf(b, "%d:%02d:%02d ", h, m, s);
+	buffer_puts(b, ch->label);
+	buffer_puts(b, "\n");
+}
+
+static void ffmetadata_header(struct chapter_buffer *b, const char *title)
+{
+	buffer_puts(b, ";FFMETADATA1\n");
+	if (title[0] != '\0') {
+		buffer_puts(b, "title=");
+		buffer_escaped(b, title, "=;#\\");
+		buffer_puts(b, "\n");
+	}
+}
+
+static void ffmetadata_chapter(struct chapter_buffer *b, const char *title,
+			       const struct chapter *ch)
+{
+	(void)title;
+	buffer_printf(b,
+		      "\n[CHAPTER]\nTIMEBASE=1/1000\nSTART=%lld\nEND=%lld\n"
+		      "title=",
+		      (long long)ch->start_ms, (long long)ch->end_ms);
+	buffer_escaped(b, ch->label, "=;#\\");
+	buffer_puts(b, "\n");
+}
+
+static void webvtt_header(struct chapter_buffer *b, const char *title)
+{
+	(void)title;
+	buffer_puts(b, "WEBVTT\n");
+}
+
+static void webvtt_time(struct chapter_buffer *b, int64_t ms)
+{
+	int h, m, s;
+	hms(ms, &h, &m, &s);
+	buffer_printf(b, "%02d:%02d:%02d.%03d", h, m, s, (int)(ms % 1000));
+}
+
+static void webvtt_chapter(struct chapter_buffer *b, const char *title,
+			   const struct chapter *ch)
+{
+	(void)title;
+	buffer_printf(b, "\n%d\n", ch->index + 1);
+	webvtt_time(b, ch->start_ms);
+	buffer_puts(b, " --> ");
+	webvtt_time(b, ch->end_ms);
+	buffer_puts(b, "\n");
+	buffer_puts(b, ch->label);
+	buffer_puts(b, "\n");
+}
+
+static void edl_header(struct chapter_buffer *b, const char *title)
+{
+	buffer_puts(b, "TITLE: ");
+	buffer_puts(b, title[0] != '\0' ? title : "Chapters");
+	buffer_puts(b, "\nFCM: NON-DROP FRAME\n");
+}
+
+static void edl_timecode(struct chapter_buffer *b, int64_t ms)
+{
+	int h, m, s;
+	hms(ms, &h, &m, &s);
+	int frame = (int)(ms % 1000 * CHAPTER_EDL_FPS / 1000);
+	buffer_printf(b, " %02d:%02d:%02d:%02d", h, m, s, frame);
+}
+
+/* One CMX 3600 event per chapter, source and record times the same, with
+   the label as the clip name the NLE turns into a marker */
+static void edl_chapter(struct chapter_buffer *b, const char *title,
+			const struct chapter *ch)
+{
+	(void)title;
+	buffer_printf(b, "\n%03d  AX       V     C       ",
+		      (ch->index + 1) % 1000);
+	for (int i = 0; i < 2; i++) {
+		edl_timecode(b, ch->start_ms);
+		edl_timecode(b, ch->end_ms);
+	}
+	buffer_puts(b, "\n* FROM CLIP NAME: ");
+	buffer_puts(b, ch->label);
+	buffer_puts(b, "\n");
+}
+
+static void json_header(struct chapter_buffer *b, const char *title)
+{
+	buffer_puts(b, "{\n  \"title\": ");
+	buffer_json_string(b, title);
+	buffer_puts(b, ",\n  \"chapters\": [");
+}
+
+static void json_chapter(struct chapter_buffer *b, const char *title,
+			 const struct chapter *ch)
+{
+	(void)title;
+	buffer_printf(b,
+		      "%s\n    {\"start_ms\": %lld, \"end_ms\": %lld, "
+		      "\"title\": ",
+		      ch->index > 0 ? "," : "", (long long)ch->start_ms,
+		      (long long)ch->end_ms);
+	buffer_json_string(b, ch->label);
+	buffer_puts(b, "}");
+}
+
+static void json_footer(struct chapter_buffer *b, int count)
+{
+	buffer_puts(b, count > 0 ? "\n  ]\n}\n" : "]\n}\n");
+}
+
+/* Indexed by format bit */
+static const struct {
+	const char *extension;
+	void (*header)(struct chapter_buffer *b, const char *title);
+	void (*chapter)(struct chapter_buffer *b, const char *title,
+			const struct chapter *ch);
+	void (*footer)(struct chapter_buffer *b, int count);
+} k_chapter_formats[SCOREBOARD_CHAPTER_FORMAT_COUNT] = {
+	{".txt", NULL, youtube_chapter, NULL},
+	{".ffmetadata", ffmetadata_header, ffmetadata_chapter, NULL},
+	{".vtt", webvtt_header, webvtt_chapter, NULL},
+	{".edl", edl_header, edl_chapter, NULL},
+	{".json", json_header, json_chapter, json_footer},
+};
+
+bool scoreboard_chapters_path(const char *base_path,
+			      enum scoreboard_chapter_format format,
+			      char *buf, size_t size)
+{
+	int i = 0;
+	while (i < SCOREBOARD_CHAPTER_FORMAT_COUNT &&
+	       (unsigned int)format != 1u << i)
+		i++;
+	if (base_path == NULL || buf == NULL || size == 0 ||
+	    i == SCOREBOARD_CHAPTER_FORMAT_COUNT)
+		return false;
+	int n = snprintf(buf, size, "%s%s", base_path,
+			 k_chapter_formats[i].extension);
+	return n > 0 && (size_t)n < size;
+}
+
+/* ---- writer ---- */
+
+struct scoreboard_chapter_writer *
+scoreboard_chapters_begin(const char *base_path, unsigned int formats,
+			  const char *title)
+{
+	formats &= SCOREBOARD_CHAPTERS_ALL;
+	if (base_path == NULL || base_path[0] == '\0' || formats == 0 ||
+	    strlen(base_path) + 16 >= CHAPTER_MAX_PATH)
+		return NULL;
+	struct scoreboard_chapter_writer *w =
+		(struct scoreboard_chapter_writer *)calloc(1, sizeof(*w));
+	if (w == NULL)
+		return NULL;
+	snprintf(w->base_path, sizeof(w->base_path), "%s", base_path);
+	snprintf(w->title, sizeof(w->title), "%s", title ? title : "");
+	w->formats = formats;
+	for (int i = 0; i < SCOREBOARD_CHAPTER_FORMAT_COUNT; i++) {
+		if ((formats & (1u << i)) && k_chapter_formats[i].header)
+			k_chapter_formats[i].header(&w->out[i], w->title);
+	}
+	return w;
+}
+
+/* Renders the chapter held back, now that its end is known */
+static void flush_pending(struct scoreboard_chapter_writer *w,
+			  int64_t end_ms)
+{
+	if (!w->pending)
+		return;
+	struct chapter ch;
+	ch.index = w->count++;
+	ch.start_ms = w->pending_ms;
+	/* A goal logged with its delay can start before the chapter ahead
+	   of it; that chapter is then empty rather than negative */
+	ch.end_ms = end_ms > w->pending_ms ? end_ms : w->pending_ms;
+	ch.label = w->pending_label;
+	for (int i = 0; i < SCOREBOARD_CHAPTER_FORMAT_COUNT; i++) {
+		if (w->formats & (1u << i))
+			k_chapter_formats[i].chapter(&w->out[i], w->title,
+						     &ch);
+	}
+	w->pending = false;
+}
+
+void scoreboard_chapters_add(struct scoreboard_chapter_writer *w,
+			     int64_t start_ms, const char *label)
+{
+	if (w == NULL || label == NULL)
+		return;
+	if (start_ms < 0)
+		start_ms = 0;
+	flush_pending(w, start_ms);
+	w->pending = true;
+	w->pending_ms = start_ms;
+	snprintf(w->pending_label, sizeof(w->pending_label), "%s", label);
+}
+
+static bool write_buffer(const char *path, const struct chapter_buffer *b)
+{
+	FILE *f = fopen(path, "wb");
+	if (f == NULL)
+		return false;
+	/* Unbuffered, so the whole file goes out in the one fwrite */
+	setvbuf(f, NULL, _IONBF, 0);
+	bool ok = fwrite(b->data, 1, b->len, f) == b->len;
+	return fclose(f) == 0 && ok;
+}
+
+bool scoreboard_chapters_finish(struct scoreboard_chapter_writer *w,
+				int64_t end_ms)
+{
+	if (w == NULL)
+		return false;
+	flush_pending(w, end_ms);
+	bool ok = true;
+	for (int i = 0; i < SCOREBOARD_CHAPTER_FORMAT_COUNT; i++) {
+		struct chapter_buffer *b = &w->out[i];
+		if ((w->formats & (1u << i)) == 0)
+			continue;
+		if (k_chapter_formats[i].footer)
+			k_chapter_formats[i].footer(b, w->count);
+		/* An empty YouTube list is still a file, just an empty one */
+		buffer_append(b, "", 0);
+		enum scoreboard_chapter_format format =
+			(enum scoreboard_chapter_format)(1u << i);
+		char path[CHAPTER_MAX_PATH];
+		scoreboard_chapters_path(w->base_path, format, path,
+					 sizeof(path));
+		if (b->failed || !write_buffer(path, b))
+			ok = false;
+		free(b->data);
+	}
+	free(w);
+	return ok;
+}
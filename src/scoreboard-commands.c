@@ -0,0 +1,223 @@
+#include "scoreboard-core.h"
+#include "scoreboard-platform.h"
+
+#include <string.h>
+
+/* Bounded multi-producer, single-consumer ring (after Vyukov's bounded
+   queue). Each slot carries a turn counter: producers claim a position
+   with one compare-and-swap on the head, fill the slot and publish it by
+   advancing its turn; the consumer takes slots in order and hands them
+   back a lap later. Turns are stored relative to the slot index so the
+   zero-initialized ring is already valid. */
+struct command_slot {
+	volatile uint32_t turn;
+	struct scoreboard_command cmd;
+};
+
+static struct command_slot g_ring[SCOREBOARD_COMMAND_CAPACITY];
+static volatile uint32_t g_head;
+static uint32_t g_tail;
+
+static volatile uint32_t g_posted;
+static volatile uint32_t g_dropped;
+static uint32_t g_applied;
+
+static uint32_t slot_turn(uint32_t pos)
+{
+	uint32_t index = pos % SCOREBOARD_COMMAND_CAPACITY;
+	return scoreboard_atomic_load(&g_ring[index].turn) + index;
+}
+
+static void set_slot_turn(uint32_t pos, uint32_t turn)
+{
+	uint32_t index = pos % SCOREBOARD_COMMAND_CAPACITY;
+	scoreboard_atomic_store(&g_ring[index].turn, turn - index);
+}
+
+bool scoreboard_command_post(const struct scoreboard_command *cmd)
+{
+	if (cmd == NULL)
+		return false;
+	uint32_t pos = scoreboard_atomic_load(&g_head);
+	for (;;) {
+		int32_t lag = (int32_t)(slot_turn(pos) - pos);
+		if (lag == 0) {
+			if (scoreboard_atomic_cas(&g_head, pos, pos + 1))
+				break;
+		} else if (lag < 0) {
+			/* The consumer hasn't freed this slot yet: full */
+			scoreboard_atomic_add(&g_dropped, 1);
+			return false;
+		}
+		pos = scoreboard_atomic_load(&g_head);
+	}
+	g_ring[pos % SCOREBOARD_COMMAND_CAPACITY].cmd = *cmd;
+	set_slot_turn(pos, pos + 1);
+	scoreboard_atomic_add(&g_posted, 1);
+	return true;
+}
+
+static void apply_team(int team, void (*home)(void), void (*away)(void))
+{
+	if (team == SCOREBOARD_TEAM_HOME)
+		home();
+	else if (team == SCOREBOARD_TEAM_AWAY)
+		away();
+}
+
+static void apply_counter(const struct scoreboard_command *cmd,
+			  void (*home_up)(void), void (*home_down)(void),
+			  void (*away_up)(void), void (*away_down)(void))
+{
+	if (cmd->b > 0)
+		apply_team(cmd->a, home_up, away_up);
+	else if (cmd->b < 0)
+		apply_team(cmd->a, home_down, away_down);
+}
+
+/* Undo labels by command type */
+static const char *const k_command_labels[] = {
+	"",
+	"Clock start",
+	"Clock stop",
+	"Clock start/stop",
+	"Clock reset",
+	"Clock adjust",
+	"Period advance",
+	"Period rewind",
+	"Score",
+	"Shots",
+	"Faceoffs",
+	"Fouls",
+	"Fouls",
+	"Penalty",
+	"Penalty clear",
+};
+
+static const char *command_label(int type)
+{
+	int count = (int)(sizeof(k_command_labels) /
+			  sizeof(k_command_labels[0]));
+	return type >= 0 && type < count ? k_command_labels[type] : "";
+}
+
+void scoreboard_command_apply(const struct scoreboard_command *cmd)
+{
+	switch (cmd->type) {
+	case SCOREBOARD_CMD_CLOCK_START:
+		scoreboard_clock_start();
+		break;
+	case SCOREBOARD_CMD_CLOCK_STOP:
+		scoreboard_clock_stop();
+		break;
+	case SCOREBOARD_CMD_CLOCK_TOGGLE:
+		if (scoreboard_clock_is_running())
+			scoreboard_clock_stop();
+		else
+			scoreboard_clock_start();
+		break;
+	case SCOREBOARD_CMD_CLOCK_RESET:
+		scoreboard_clock_reset();
+		break;
+	case SCOREBOARD_CMD_CLOCK_ADJUST_SECONDS:
+		scoreboard_clock_adjust_seconds(cmd->a);
+		break;
+	case SCOREBOARD_CMD_PERIOD_ADVANCE:
+		scoreboard_period_advance();
+		break;
+	case SCOREBOARD_CMD_PERIOD_REWIND:
+		scoreboard_period_rewind();
+		break;
+	case SCOREBOARD_CMD_SCORE:
+		apply_counter(cmd, scoreboard_increment_home_score,
+			      scoreboard_decrement_home_score,
+			      scoreboard_increment_away_score,
+			      scoreboard_decrement_away_score);
+		break;
+	case SCOREBOARD_CMD_SHOTS:
+		apply_counter(cmd, scoreboard_increment_home_shots,
+			      scoreboard_decrement_home_shots,
+			      scoreboard_increment_away_shots,
+			      scoreboard_decrement_away_shots);
+		break;
+	case SCOREBOARD_CMD_FACEOFFS:
+		apply_counter(cmd, scoreboard_increment_home_faceoffs,
+			      scoreboard_decrement_home_faceoffs,
+			      scoreboard_increment_away_faceoffs,
+			      scoreboard_decrement_away_faceoffs);
+		break;
+	case SCOREBOARD_CMD_FOULS:
+		apply_counter(cmd, scoreboard_increment_home_fouls,
+			      scoreboard_decrement_home_fouls,
+			      scoreboard_increment_away_fouls,
+			      scoreboard_decrement_away_fouls);
+		break;
+	case SCOREBOARD_CMD_FOULS2:
+		apply_counter(cmd, scoreboard_increment_home_fouls2,
+			      scoreboard_decrement_home_fouls2,
+			      scoreboard_increment_away_fouls2,
+			      scoreboard_decrement_away_fouls2);
+		break;
+	case SCOREBOARD_CMD_PENALTY_ADD:
+		if (cmd->a == SCOREBOARD_TEAM_HOME)
+			scoreboard_home_penalty_add(cmd->b, cmd->c);
+		else if (cmd->a == SCOREBOARD_TEAM_AWAY)
+			scoreboard_away_penalty_add(cmd->b, cmd->c);
+		break;
+	case SCOREBOARD_CMD_PENALTY_CLEAR:
+		if (cmd->a == SCOREBOARD_TEAM_HOME)
+			scoreboard_home_penalty_clear(cmd->b);
+		else if (cmd->a == SCOREBOARD_TEAM_AWAY)
+			scoreboard_away_penalty_clear(cmd->b);
+		break;
+	default:
+		break;
+	}
+}
+
+int scoreboard_command_drain(scoreboard_command_fn user_fn, void *data)
+{
+	/* At most one lap per call, so producers that keep posting can't
+	   hold the owner thread here */
+	int count = 0;
+	while (count < SCOREBOARD_COMMAND_CAPACITY) {
+		uint32_t pos = g_tail;
+		if (slot_turn(pos) != pos + 1)
+			break;
+		struct scoreboard_command cmd =
+			g_ring[pos % SCOREBOARD_COMMAND_CAPACITY].cmd;
+		set_slot_turn(pos, pos + SCOREBOARD_COMMAND_CAPACITY);
+		g_tail = pos + 1;
+
+		scoreboard_trace_record(&cmd);
+		if (cmd.type >= SCOREBOARD_CMD_USER) {
+			if (user_fn != NULL)
+				user_fn(&cmd, data);
+		} else {
+			/* Each built-in command is one undo step */
+			scoreboard_undo_begin();
+			scoreboard_command_apply(&cmd);
+			scoreboard_undo_end(command_label(cmd.type));
+			scoreboard_trace_record_applied();
+		}
+		count++;
+	}
+	g_applied += (uint32_t)count;
+	return count;
+}
+
+void scoreboard_command_get_stats(struct scoreboard_command_stats *out)
+{
+	if (out == NULL)
+		return;
+	out->posted = scoreboard_atomic_load(&g_posted);
+	out->applied = g_applied;
+	out->dropped = scoreboard_atomic_load(&g_dropped);
+}
+
+void scoreboard_command_reset_stats(void)
+{
+	scoreboard_atomic_store(&g_posted, 0);
+	scoreboard_atomic_store(&g_dropped, 0);
+	g_applied = 0;
+}
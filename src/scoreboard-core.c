@@ -1,5 +1,8 @@
 #include "scoreboard-core.h"
+#include "scoreboard-arena.h"
+#include "scoreboard-platform.h"
 
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -13,6 +16,9 @@
 #define SCOREBOARD_DEFAULT_MAJOR_PENALTY_DURATION 300
 #define SCOREBOARD_PENALTY_SLOTS SCOREBOARD_MAX_PENALTIES
 #define SCOREBOARD_SEGMENT_NAME_SIZE 16
+#define SCOREBOARD_SNAPSHOT_SIZE 8192
+#define SCOREBOARD_MAX_STATE_FILE 65536
+#define NS_PER_TENTH 100000000ll
 
 static const struct scoreboard_sport_preset k_sport_presets[SCOREBOARD_SPORT_COUNT] = {
 	/* sport, segment_name, segment_count, duration_seconds, ot_max, has_shots, has_faceoffs, has_penalties, default_direction, has_fouls, foul_label, foul_label2, log_scores, score_label, default_penalty_secs, default_major_penalty_secs */
@@ -25,9 +31,14 @@ static const struct scoreboard_sport_preset k_sport_presets[SCOREBOARD_SPORT_COU
 	{SCOREBOARD_SPORT_GENERIC,    "Segment", 1, 0,    0, false, false, false, SCOREBOARD_CLOCK_COUNT_UP,   false, "",      "", true,  "Score", 120, 300},
 };
 
-static struct {
+struct core_state {
 	int clock_tenths;
 	bool clock_running;
+	/* Time source reading when the clock last started, and how many
+	   whole tenths since then are already applied to clock_tenths and
+	   the penalties */
+	uint64_t clock_started_ns;
+	int64_t clock_synced_tenths;
 	enum scoreboard_clock_direction clock_direction;
 	int period_length;
 
@@ -71,6 +82,12 @@ static struct {
 	struct scoreboard_penalty away_penalties[SCOREBOARD_PENALTY_SLOTS];
 
 	char output_directory[SCOREBOARD_MAX_PATH];
+	enum scoreboard_output_mode output_mode;
+
+	/* Last text written for the fields that change on every tick */
+	char rendered_clock[16];
+	char rendered_home_penalty_times[512];
+	char rendered_away_penalty_times[512];
 
 	char cli_executable[SCOREBOARD_MAX_PATH];
 	char cli_extra_args[SCOREBOARD_MAX_PATH];
@@ -81,30 +98,336 @@ static struct {
 			[SCOREBOARD_ACTION_LOG_ENTRY_SIZE];
 	int action_log_head;
 	int action_log_count;
-} g_state;
+};
+
+/* One bit per output file, plus DIRTY_STATE for changes that have no file
+   of their own (clock running, direction, period length). */
+#define FIELD(name) SCOREBOARD_FIELD_BIT(SCOREBOARD_FIELD_##name)
+#define DIRTY_STATE (1u << SCOREBOARD_FIELD_COUNT)
+#define HOME_PENALTY_FIELDS \
+	(FIELD(HOME_PENALTY_NUMBERS) | FIELD(HOME_PENALTY_TIMES))
+#define AWAY_PENALTY_FIELDS \
+	(FIELD(AWAY_PENALTY_NUMBERS) | FIELD(AWAY_PENALTY_TIMES))
+
+/* An undo step: how far each tracked value moved, each team's penalties
+   before and after, and the event-log entries it added or removed */
+#define UNDO_VALUE_COUNT 12
+#define UNDO_MAX_EVENT_OPS 2
+#define UNDO_LABEL_SIZE 32
+
+struct undo_event_op {
+	bool added;
+	/* Where the entry sits in the event log's slots */
+	int slot;
+	struct scoreboard_game_event event;
+};
 
-static bool g_dirty;
+struct undo_step {
+	char label[UNDO_LABEL_SIZE];
+	int deltas[UNDO_VALUE_COUNT];
+	/* Whether that team's penalties changed; 0 home, 1 away */
+	bool penalties_changed[2];
+	struct scoreboard_penalty before[2][SCOREBOARD_PENALTY_SLOTS];
+	struct scoreboard_penalty after[2][SCOREBOARD_PENALTY_SLOTS];
+	int event_op_count;
+	struct undo_event_op event_ops[UNDO_MAX_EVENT_OPS];
+};
+
+struct undo_history {
+	/* A ring holding count undoable steps from first, then redo_count
+	   redoable ones above them */
+	struct undo_step steps[SCOREBOARD_UNDO_DEPTH];
+	int first;
+	int count;
+	int redo_count;
+	/* The step being recorded while depth > 0 */
+	int depth;
+	struct undo_step pending;
+	int values_before[UNDO_VALUE_COUNT];
+};
+
+/* Everything one game owns. Contexts sit side by side in a static pool;
+   slot 0 is the default context. */
+struct scoreboard_ctx {
+	struct core_state state;
+	unsigned int dirty;
+	struct scoreboard_write_stats write_stats;
+	/* Game events, in chunks that stay put as the log grows. A removed
+	   event keeps its slot, marked, until the log is cleared or the
+	   slots after it are gone too. */
+	struct scoreboard_arena event_log;
+	int event_count;
+	int events_removed;
+	/* Per kind and team (team + 1): the newest live slot, where lookups
+	   start, and the newest slot of all, which the next one links to */
+	int event_heads[SCOREBOARD_EVENT_KIND_COUNT][3];
+	int event_newest[SCOREBOARD_EVENT_KIND_COUNT][3];
+	struct undo_history undo;
+	/* Advances with every change to the state, never goes back */
+	uint64_t generation;
+	bool in_use;
+};
+
+static struct scoreboard_ctx g_contexts[SCOREBOARD_MAX_CONTEXTS];
+/* The context every scoreboard_* call acts on */
+static struct scoreboard_ctx *g_ctx = &g_contexts[0];
+
+/* The current context's members under their old names */
+#define g_state (g_ctx->state)
+#define g_dirty (g_ctx->dirty)
+#define g_write_stats (g_ctx->write_stats)
+#define g_event_log (g_ctx->event_log)
+#define g_event_count (g_ctx->event_count)
+#define g_events_removed (g_ctx->events_removed)
+#define g_undo (g_ctx->undo)
+
+/* Acts on ctx until context_leave(), whatever the caller selected */
+static struct scoreboard_ctx *context_enter(struct scoreboard_ctx *ctx)
+{
+	struct scoreboard_ctx *previous = g_ctx;
+	g_ctx = ctx;
+	return previous;
+}
+
+static void context_leave(struct scoreboard_ctx *previous)
+{
+	g_ctx = previous;
+}
+
+static bool context_usable(const struct scoreboard_ctx *ctx)
+{
+	return ctx != NULL && ctx->in_use;
+}
+
+#define EVENT_CHUNK_EVENTS 64
+
+struct event_slot {
+	struct scoreboard_game_event event;
+	/* The slot before it with the same kind and team, or -1 */
+	int prev;
+	bool removed;
+};
+
+static struct event_slot *slot_at(int slot)
+{
+	return (struct event_slot *)scoreboard_arena_at(&g_event_log, slot);
+}
+
+static scoreboard_time_fn g_time_fn;
+
+/* ---- field registry ---- */
+
+/* One row per output field: its file and, for plain values, where the
+   value lives in the state. Writing, reading, the snapshot formats and
+   the dock's file watcher (through scoreboard_output_field_filename())
+   all walk this table, so a new field is its enum entry plus one row. */
+enum output_value {
+	OUTPUT_VALUE_INT,    /* int member; read back clamped at zero */
+	OUTPUT_VALUE_TEXT,   /* char array member */
+	OUTPUT_VALUE_CUSTOM, /* the row's own format and read */
+};
+
+struct snapshot_file;
+typedef bool (*output_read_fn)(const struct snapshot_file *snapshot,
+			       enum scoreboard_output_field field);
+
+struct output_field_desc {
+	const char *filename;
+	/* The field's name in the JSON and key=value snapshots */
+	const char *key;
+	enum output_value type;
+	size_t offset;
+	size_t size;
+	/* A missing file doesn't fail scoreboard_read_all_files() */
+	bool optional;
+	/* Replace the type's formatting or reading when set; read returns
+	   whether the field was there to read */
+	void (*format)(char *buf, size_t size);
+	output_read_fn read;
+};
+
+#define STATE_MEMBER_SIZE(member) sizeof(((struct core_state *)0)->member)
+#define OUTPUT_ROW(name) [SCOREBOARD_FIELD_##name]
+/* Each field is written to key.txt, or under key in a snapshot */
+#define INT_FIELD(key, member, optional)    \
+	{key ".txt", key, OUTPUT_VALUE_INT, \
+	 offsetof(struct core_state, member), 0, optional, NULL, NULL}
+#define TEXT_FIELD(key, member)                                          \
+	{key ".txt", key, OUTPUT_VALUE_TEXT,                             \
+	 offsetof(struct core_state, member), STATE_MEMBER_SIZE(member), \
+	 false, NULL, NULL}
+#define CUSTOM_FIELD(key, optional, format, read) \
+	{key ".txt", key, OUTPUT_VALUE_CUSTOM, 0, 0, optional, format, read}
+/* Written as plain ints; only a positive value is read back */
+#define DURATION_FIELD(key, member)         \
+	{key ".txt", key, OUTPUT_VALUE_INT, \
+	 offsetof(struct core_state, member), 0, true, NULL, read_duration}
+
+static void format_home_penalty_numbers(char *buf, size_t size);
+static void format_away_penalty_numbers(char *buf, size_t size);
+static void format_home_penalty_times(char *buf, size_t size);
+static void format_away_penalty_times(char *buf, size_t size);
+static void format_sport(char *buf, size_t size);
+static bool read_clock(const struct snapshot_file *snapshot,
+		       enum scoreboard_output_field field);
+static bool read_period(const struct snapshot_file *snapshot,
+			enum scoreboard_output_field field);
+static bool read_penalties(const struct snapshot_file *snapshot,
+			   enum scoreboard_output_field field);
+static bool read_with_numbers(const struct snapshot_file *snapshot,
+			      enum scoreboard_output_field field);
+static bool read_sport(const struct snapshot_file *snapshot,
+		       enum scoreboard_output_field field);
+static bool read_duration(const struct snapshot_file *snapshot,
+			  enum scoreboard_output_field field);
+static bool read_period_labels(const struct snapshot_file *snapshot,
+			       enum scoreboard_output_field field);
+
+static const struct output_field_desc
+	k_output_fields[SCOREBOARD_FIELD_COUNT] = {
+	OUTPUT_ROW(CLOCK) = CUSTOM_FIELD("clock", false,
+					 scoreboard_clock_format, read_clock),
+	OUTPUT_ROW(PERIOD) = CUSTOM_FIELD("period", false,
+					  scoreboard_format_period,
+					  read_period),
+	OUTPUT_ROW(HOME_NAME) = TEXT_FIELD("home_name", home_name),
+	OUTPUT_ROW(AWAY_NAME) = TEXT_FIELD("away_name", away_name),
+	OUTPUT_ROW(HOME_SCORE) = INT_FIELD("home_score", home_score, false),
+	OUTPUT_ROW(AWAY_SCORE) = INT_FIELD("away_score", away_score, false),
+	OUTPUT_ROW(HOME_SHOTS) = INT_FIELD("home_shots", home_shots, false),
+	OUTPUT_ROW(AWAY_SHOTS) = INT_FIELD("away_shots", away_shots, false),
+	OUTPUT_ROW(HOME_FACEOFFS) = INT_FIELD("home_faceoffs",
+					      home_faceoffs, true),
+	OUTPUT_ROW(AWAY_FACEOFFS) = INT_FIELD("away_faceoffs",
+					      away_faceoffs, true),
+	OUTPUT_ROW(HOME_FOULS) = INT_FIELD("home_fouls", home_fouls, true),
+	OUTPUT_ROW(AWAY_FOULS) = INT_FIELD("away_fouls", away_fouls, true),
+	OUTPUT_ROW(HOME_FOULS2) = INT_FIELD("home_fouls2", home_fouls2, true),
+	OUTPUT_ROW(AWAY_FOULS2) = INT_FIELD("away_fouls2", away_fouls2, true),
+	OUTPUT_ROW(HOME_PENALTY_NUMBERS) =
+		CUSTOM_FIELD("home_penalty_numbers", false,
+			     format_home_penalty_numbers, read_penalties),
+	OUTPUT_ROW(HOME_PENALTY_TIMES) =
+		CUSTOM_FIELD("home_penalty_times", false,
+			     format_home_penalty_times, read_with_numbers),
+	OUTPUT_ROW(AWAY_PENALTY_NUMBERS) =
+		CUSTOM_FIELD("away_penalty_numbers", false,
+			     format_away_penalty_numbers, read_penalties),
+	OUTPUT_ROW(AWAY_PENALTY_TIMES) =
+		CUSTOM_FIELD("away_penalty_times", false,
+			     format_away_penalty_times, read_with_numbers),
+	OUTPUT_ROW(SPORT) = CUSTOM_FIELD("sport", true, format_sport,
+					 read_sport),
+	OUTPUT_ROW(DEFAULT_PENALTY_DURATION) =
+		DURATION_FIELD("default_penalty_duration",
+			       default_penalty_duration),
+	OUTPUT_ROW(DEFAULT_MAJOR_PENALTY_DURATION) =
+		DURATION_FIELD("default_major_penalty_duration",
+			       default_major_penalty_duration),
+	OUTPUT_ROW(PERIOD_LABELS) =
+		CUSTOM_FIELD("period_labels", true,
+			     scoreboard_get_period_labels,
+			     read_period_labels),
+};
 
-/* ---- game event log ---- */
-static struct scoreboard_game_event
-	g_event_log[SCOREBOARD_MAX_EVENTS];
-static int g_event_count;
 
 /* ---- helpers ---- */
 
-static void mark_dirty(void)
+static void reclaim_failed_writes(void);
+
+/* Set by every change to a game, so a command trace knows when there may
+   be something to record beyond the commands it was given */
+static bool g_trace_touched;
+
+static void mark_dirty(unsigned int fields)
 {
-	g_dirty = true;
+	g_dirty |= fields;
+	g_ctx->generation++;
+	g_trace_touched = true;
 }
 
 bool scoreboard_is_dirty(void)
 {
-	return g_dirty;
+	reclaim_failed_writes();
+	return g_dirty != 0;
+}
+
+bool scoreboard_is_dirty_ctx(struct scoreboard_ctx *ctx)
+{
+	if (!context_usable(ctx))
+		return false;
+	struct scoreboard_ctx *previous = context_enter(ctx);
+	bool dirty = scoreboard_is_dirty();
+	context_leave(previous);
+	return dirty;
 }
 
 void scoreboard_mark_dirty(void)
 {
-	g_dirty = true;
+	mark_dirty(SCOREBOARD_FIELDS_ALL | DIRTY_STATE);
+}
+
+uint64_t scoreboard_state_generation(void)
+{
+	return g_ctx->generation;
+}
+
+unsigned int scoreboard_get_dirty_fields(void)
+{
+	return g_dirty & SCOREBOARD_FIELDS_ALL;
+}
+
+const char *scoreboard_output_field_filename(enum scoreboard_output_field field)
+{
+	if (field < 0 || field >= SCOREBOARD_FIELD_COUNT)
+		return "";
+	return k_output_fields[field].filename;
+}
+
+static void format_output_field(enum scoreboard_output_field field, char *buf,
+				size_t size);
+
+static char *rendered_text(enum scoreboard_output_field field, size_t *size)
+{
+	switch (field) {
+	case SCOREBOARD_FIELD_CLOCK:
+		*size = sizeof(g_state.rendered_clock);
+		return g_state.rendered_clock;
+	case SCOREBOARD_FIELD_HOME_PENALTY_TIMES:
+		*size = sizeof(g_state.rendered_home_penalty_times);
+		return g_state.rendered_home_penalty_times;
+	case SCOREBOARD_FIELD_AWAY_PENALTY_TIMES:
+		*size = sizeof(g_state.rendered_away_penalty_times);
+		return g_state.rendered_away_penalty_times;
+	default:
+		return NULL;
+	}
+}
+
+/* Ticks run ten times a second but the clock and penalty times only show
+   whole seconds, so a tick marks its field dirty only when the visible text
+   differs from what was last written. */
+static void mark_if_rendered_changed(enum scoreboard_output_field field)
+{
+	unsigned int bit = SCOREBOARD_FIELD_BIT(field);
+	if (g_dirty & bit)
+		return;
+	char buf[512];
+	size_t size;
+	format_output_field(field, buf, sizeof(buf));
+	if (strcmp(buf, rendered_text(field, &size)) != 0)
+		mark_dirty(bit);
+}
+
+void scoreboard_get_write_stats(struct scoreboard_write_stats *out)
+{
+	if (out != NULL)
+		*out = g_write_stats;
+}
+
+void scoreboard_reset_write_stats(void)
+{
+	memset(&g_write_stats, 0, sizeof(g_write_stats));
 }
 
 static void safe_copy(char *dst, const char *src, size_t dst_size)
@@ -120,6 +443,15 @@ static void safe_copy(char *dst, const char *src, size_t dst_size)
 	dst[len] = '\0';
 }
 
+static void remember_rendered(enum scoreboard_output_field field,
+			      const char *text)
+{
+	size_t size;
+	char *rendered = rendered_text(field, &size);
+	if (rendered != NULL)
+		safe_copy(rendered, text, size);
+}
+
 static void log_message(enum scoreboard_log_level level, const char *msg)
 {
 	if (g_state.log_fn != NULL)
@@ -127,6 +459,13 @@ static void log_message(enum scoreboard_log_level level, const char *msg)
 }
 
 static void generate_default_period_labels(void);
+static void journal_release(struct scoreboard_ctx *ctx);
+static void event_file_release(struct scoreboard_ctx *ctx);
+static void journal_sync_current(void);
+static void trace_sync_current(void);
+static void trace_release(struct scoreboard_ctx *ctx);
+static void undo_note_event(bool added, int slot);
+static void reset_event_slots(void);
 
 static bool read_text_file(const char *dir, const char *filename, char *buf,
 			   size_t buf_size)
@@ -147,6 +486,44 @@ static bool read_text_file(const char *dir, const char *filename, char *buf,
 	return true;
 }
 
+/* Reads a small text file into a malloc'd buffer. Returns NULL if the file
+   is missing, empty or larger than SCOREBOARD_MAX_STATE_FILE. */
+static char *read_whole_file(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	if (f == NULL)
+		return NULL;
+
+	fseek(f, 0, SEEK_END);
+	long file_size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	if (file_size <= 0 || file_size > SCOREBOARD_MAX_STATE_FILE) {
+		fclose(f);
+		return NULL;
+	}
+
+	char *text = (char *)malloc((size_t)file_size + 1);
+	size_t read_size = fread(text, 1, (size_t)file_size, f);
+	fclose(f);
+	text[read_size] = '\0';
+	return text;
+}
+
+static char unescape_char(char c)
+{
+	switch (c) {
+	case 'n':
+		return '\n';
+	case 'r':
+		return '\r';
+	case 't':
+		return '\t';
+	default:
+		return c;
+	}
+}
+
 static int parse_clock_text(const char *text)
 {
 	int minutes = 0, seconds = 0;
@@ -260,29 +637,162 @@ static bool write_text_file(const char *dir, const char *filename,
 {
 	char path[1024];
 	snprintf(path, sizeof(path), "%s/%s", dir, filename);
-	FILE *f = fopen(path, "w");
-	if (f == NULL)
-		return false;
-	fprintf(f, "%s", content);
-	fclose(f);
-	return true;
+	return scoreboard_writer_submit(path, content);
 }
 
-static const char *find_json_value(const char *json, const char *key)
+/* ---- JSON reading ----
+   The state and snapshot files are one flat object. A single pass records
+   where each top-level member's key and value start and hashes the key,
+   so every field lookup afterwards is O(1) instead of a scan of the whole
+   document per key. Values are left in place and parsed on lookup. */
+
+#define JSON_MAX_MEMBERS 256
+#define JSON_HASH_SIZE 512 /* power of two, at least twice the members */
+
+struct json_member {
+	const char *key;
+	size_t key_len;
+	const char *value;
+};
+
+struct json_index {
+	struct json_member members[JSON_MAX_MEMBERS];
+	int count;
+	/* Member index + 1 per slot; 0 marks an empty slot */
+	short slots[JSON_HASH_SIZE];
+};
+
+static unsigned int json_hash(const char *key, size_t len)
 {
-	char pattern[256];
-	snprintf(pattern, sizeof(pattern), "\"%s\"", key);
-	const char *pos = strstr(json, pattern);
-	if (pos == NULL)
-		return NULL;
-	pos += strlen(pattern);
-	while (*pos == ' ' || *pos == '\t' || *pos == '\n' || *pos == '\r' ||
-	       *pos == ':')
-		pos++;
-	return pos;
+	unsigned int hash = 2166136261u;
+	for (size_t i = 0; i < len; i++) {
+		hash ^= (unsigned char)key[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static const char *json_skip_space(const char *p)
+{
+	while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+		p++;
+	return p;
+}
+
+/* Returns the character after the closing quote of the string at p, or
+   NULL if the document ends first */
+static const char *json_skip_string(const char *p)
+{
+	for (p++; *p != '"'; p++) {
+		if (*p == '\0')
+			return NULL;
+		if (*p == '\\' && *(p + 1) != '\0')
+			p++;
+	}
+	return p + 1;
+}
+
+/* Skips one value of any type, including nested objects and arrays */
+static const char *json_skip_value(const char *p)
+{
+	int depth = 0;
+	while (*p != '\0') {
+		if (*p == '"') {
+			p = json_skip_string(p);
+			if (p == NULL)
+				return NULL;
+			if (depth == 0)
+				return p;
+			continue;
+		}
+		if (*p == '{' || *p == '[') {
+			depth++;
+		} else if (*p == '}' || *p == ']') {
+			if (depth == 0)
+				return p;
+			if (--depth == 0)
+				return p + 1;
+		} else if (depth == 0 && (*p == ',' || *p == ' ' ||
+					  *p == '\t' || *p == '\n' ||
+					  *p == '\r')) {
+			return p;
+		}
+		p++;
+	}
+	return depth == 0 ? p : NULL;
+}
+
+static void json_index_add(struct json_index *index, const char *key,
+			   size_t key_len, const char *value)
+{
+	unsigned int slot = json_hash(key, key_len) & (JSON_HASH_SIZE - 1);
+	while (index->slots[slot] != 0) {
+		const struct json_member *m =
+			&index->members[index->slots[slot] - 1];
+		/* The first occurrence wins, as it always has */
+		if (m->key_len == key_len && memcmp(m->key, key, key_len) == 0)
+			return;
+		slot = (slot + 1) & (JSON_HASH_SIZE - 1);
+	}
+	struct json_member *m = &index->members[index->count];
+	m->key = key;
+	m->key_len = key_len;
+	m->value = value;
+	index->slots[slot] = (short)++index->count;
+}
+
+/* Indexes the members of the top-level object. A malformed or truncated
+   document keeps every member read before the damage. */
+static void json_index_build(struct json_index *index, const char *json)
+{
+	index->count = 0;
+	memset(index->slots, 0, sizeof(index->slots));
+
+	const char *p = json_skip_space(json);
+	if (*p != '{')
+		return;
+	p++;
+	while (index->count < JSON_MAX_MEMBERS) {
+		p = json_skip_space(p);
+		if (*p == ',') {
+			p++;
+			continue;
+		}
+		if (*p != '"')
+			return;
+		const char *key = p + 1;
+		const char *end = json_skip_string(p);
+		if (end == NULL)
+			return;
+		size_t key_len = (size_t)(end - 1 - key);
+		p = json_skip_space(end);
+		if (*p != ':')
+			return;
+		const char *value = json_skip_space(p + 1);
+		p = json_skip_value(value);
+		if (p == NULL)
+			return;
+		json_index_add(index, key, key_len, value);
+	}
 }
 
-static int parse_json_int(const char *json, const char *key, int default_val)
+static const char *find_json_value(const struct json_index *index,
+				   const char *key)
+{
+	size_t key_len = strlen(key);
+	unsigned int slot = json_hash(key, key_len) & (JSON_HASH_SIZE - 1);
+	while (index->slots[slot] != 0) {
+		const struct json_member *m =
+			&index->members[index->slots[slot] - 1];
+		if (m->key_len == key_len && memcmp(m->key, key, key_len) == 0)
+			return m->value;
+		slot = (slot + 1) & (JSON_HASH_SIZE - 1);
+	}
+	return NULL;
+}
+
+static int parse_json_int(const struct json_index *json, const char *key,
+			  int default_val)
 {
 	const char *val = find_json_value(json, key);
 	if (val == NULL)
@@ -290,7 +800,8 @@ static int parse_json_int(const char *json, const char *key, int default_val)
 	return atoi(val);
 }
 
-static bool parse_json_bool(const char *json, const char *key, bool default_val)
+static bool parse_json_bool(const struct json_index *json, const char *key,
+			    bool default_val)
 {
 	const char *val = find_json_value(json, key);
 	if (val == NULL)
@@ -302,8 +813,46 @@ static bool parse_json_bool(const char *json, const char *key, bool default_val)
 	return default_val;
 }
 
-static void parse_json_string(const char *json, const char *key, char *out,
-			      size_t out_size)
+static int hex_digit(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+/* The UTF-8 bytes a \uXXXX escape stands for, or 0 if it is malformed */
+static size_t unescape_unicode(const char *hex, char *utf8)
+{
+	unsigned int code = 0;
+	for (int i = 0; i < 4; i++) {
+		int digit = hex_digit(hex[i]);
+		if (digit < 0)
+			return 0;
+		code = code << 4 | (unsigned int)digit;
+	}
+	if (code == 0)
+		return 0;
+	if (code < 0x80) {
+		utf8[0] = (char)code;
+		return 1;
+	}
+	if (code < 0x800) {
+		utf8[0] = (char)(0xc0 | code >> 6);
+		utf8[1] = (char)(0x80 | (code & 0x3f));
+		return 2;
+	}
+	utf8[0] = (char)(0xe0 | code >> 12);
+	utf8[1] = (char)(0x80 | (code >> 6 & 0x3f));
+	utf8[2] = (char)(0x80 | (code & 0x3f));
+	return 3;
+}
+
+static void parse_json_string(const struct json_index *json, const char *key,
+			      char *out, size_t out_size)
 {
 	const char *val = find_json_value(json, key);
 	if (val == NULL || *val != '"') {
@@ -313,25 +862,29 @@ static void parse_json_string(const char *json, const char *key, char *out,
 	val++;
 	size_t i = 0;
 	while (*val != '\0' && *val != '"' && i < out_size - 1) {
-		if (*val == '\\' && *(val + 1) != '\0')
+		/* The snapshot writer escapes control characters this way */
+		char utf8[3];
+		size_t len = 0;
+		if (*val == '\\' && val[1] == 'u')
+			len = unescape_unicode(val + 2, utf8);
+		if (len > 0) {
+			if (i + len >= out_size)
+				break;
+			memcpy(out + i, utf8, len);
+			i += len;
+			val += 6;
+			continue;
+		}
+		if (*val == '\\' && *(val + 1) != '\0') {
 			val++;
+			out[i++] = unescape_char(*val++);
+			continue;
+		}
 		out[i++] = *val++;
 	}
 	out[i] = '\0';
 }
 
-static void write_json_string(FILE *f, const char *key, const char *value,
-			      bool last)
-{
-	fprintf(f, "  \"%s\": \"", key);
-	for (const char *p = value; *p != '\0'; p++) {
-		if (*p == '"' || *p == '\\')
-			fputc('\\', f);
-		fputc(*p, f);
-	}
-	fprintf(f, last ? "\"\n" : "\",\n");
-}
-
 /* ---- lifecycle ---- */
 
 const char *scoreboard_description(void)
@@ -355,12 +908,23 @@ void scoreboard_on_unload(scoreboard_log_fn log_fn)
 	g_state.log_fn = NULL;
 }
 
-void scoreboard_reset_state_for_tests(void)
+static uint64_t frozen_time_ns(void)
+{
+	return 0;
+}
+
+/* Puts the current context back to a fresh game */
+static void init_context(void)
 {
 	memset(&g_state, 0, sizeof(g_state));
-	g_dirty = false;
-	g_event_count = 0;
-	memset(g_event_log, 0, sizeof(g_event_log));
+	g_dirty = 0;
+	memset(&g_write_stats, 0, sizeof(g_write_stats));
+	scoreboard_arena_free(&g_event_log);
+	scoreboard_arena_init(&g_event_log, sizeof(struct event_slot),
+			      EVENT_CHUNK_EVENTS);
+	reset_event_slots();
+	memset(&g_undo, 0, sizeof(g_undo));
+	g_ctx->generation++;
 	g_state.period = 1;
 	g_state.period_length = SCOREBOARD_DEFAULT_PERIOD_LENGTH;
 	g_state.clock_direction = SCOREBOARD_CLOCK_COUNT_DOWN;
@@ -389,18 +953,104 @@ void scoreboard_reset_state_for_tests(void)
 	generate_default_period_labels();
 }
 
+void scoreboard_reset_state_for_tests(void)
+{
+	for (int i = 1; i < SCOREBOARD_MAX_CONTEXTS; i++)
+		scoreboard_ctx_destroy(&g_contexts[i]);
+	g_ctx = &g_contexts[0];
+	g_ctx->in_use = true;
+	init_context();
+	g_time_fn = frozen_time_ns;
+	scoreboard_timeline_reset();
+	scoreboard_reset_perf_stats();
+}
+
+/* ---- contexts ---- */
+
+struct scoreboard_ctx *scoreboard_ctx_default(void)
+{
+	return &g_contexts[0];
+}
+
+struct scoreboard_ctx *scoreboard_ctx_current(void)
+{
+	return g_ctx;
+}
+
+struct scoreboard_ctx *scoreboard_ctx_select(struct scoreboard_ctx *ctx)
+{
+	struct scoreboard_ctx *previous = g_ctx;
+	if (context_usable(ctx))
+		g_ctx = ctx;
+	return previous;
+}
+
+struct scoreboard_ctx *scoreboard_ctx_create(void)
+{
+	for (int i = 1; i < SCOREBOARD_MAX_CONTEXTS; i++) {
+		struct scoreboard_ctx *ctx = &g_contexts[i];
+		if (ctx->in_use)
+			continue;
+		scoreboard_log_fn log_fn = g_contexts[0].state.log_fn;
+		ctx->in_use = true;
+		struct scoreboard_ctx *previous = context_enter(ctx);
+		init_context();
+		g_state.log_fn = log_fn;
+		context_leave(previous);
+		return ctx;
+	}
+	return NULL;
+}
+
+void scoreboard_ctx_destroy(struct scoreboard_ctx *ctx)
+{
+	/* The default context lives as long as the process */
+	if (ctx == NULL || ctx == &g_contexts[0] || !ctx->in_use)
+		return;
+	journal_release(ctx);
+	trace_release(ctx);
+	event_file_release(ctx);
+	scoreboard_arena_free(&ctx->event_log);
+	ctx->event_count = 0;
+	if (g_ctx == ctx)
+		g_ctx = &g_contexts[0];
+	ctx->in_use = false;
+}
+
 /* ---- clock ---- */
 
+static uint64_t now_ns(void)
+{
+	return g_time_fn != NULL ? g_time_fn() : scoreboard_monotonic_ns();
+}
+
+static void anchor_clock(void)
+{
+	g_state.clock_started_ns = now_ns();
+	g_state.clock_synced_tenths = 0;
+}
+
+void scoreboard_set_time_source(scoreboard_time_fn fn)
+{
+	g_time_fn = fn;
+	/* Readings from different sources can't be compared */
+	anchor_clock();
+}
+
 void scoreboard_clock_start(void)
 {
+	/* Restarting a running clock would drop its partial tenth */
+	if (!g_state.clock_running)
+		anchor_clock();
 	g_state.clock_running = true;
-	mark_dirty();
+	mark_dirty(DIRTY_STATE);
 }
 
 void scoreboard_clock_stop(void)
 {
+	scoreboard_clock_sync();
 	g_state.clock_running = false;
-	mark_dirty();
+	mark_dirty(DIRTY_STATE);
 }
 
 bool scoreboard_clock_is_running(void)
@@ -415,13 +1065,15 @@ void scoreboard_clock_reset(void)
 		g_state.clock_tenths = g_state.period_length * 10;
 	else
 		g_state.clock_tenths = 0;
-	mark_dirty();
+	mark_dirty(FIELD(CLOCK) | DIRTY_STATE);
 }
 
-void scoreboard_clock_tick(int elapsed_tenths)
+static void clock_advance(int elapsed_tenths)
 {
 	if (!g_state.clock_running)
 		return;
+	/* A replay runs the clock from the recorded times by itself */
+	bool touched = g_trace_touched;
 
 	if (g_state.clock_direction == SCOREBOARD_CLOCK_COUNT_DOWN) {
 		g_state.clock_tenths -= elapsed_tenths;
@@ -438,31 +1090,158 @@ void scoreboard_clock_tick(int elapsed_tenths)
 		}
 	}
 
-	mark_dirty();
+	if (!g_state.clock_running)
+		mark_dirty(DIRTY_STATE);
+	mark_if_rendered_changed(SCOREBOARD_FIELD_CLOCK);
 	if (g_state.clock_running)
 		scoreboard_penalty_tick(elapsed_tenths);
+	g_trace_touched = touched;
+}
+
+void scoreboard_clock_tick(int elapsed_tenths)
+{
+	/* A clock measured from its start already counts this time */
+	if (g_time_fn == frozen_time_ns)
+		clock_advance(elapsed_tenths);
+}
+
+/* Whole tenths run since the last sync and not yet applied */
+static int64_t clock_pending_tenths(void)
+{
+	if (!g_state.clock_running)
+		return 0;
+	int64_t ran = (int64_t)((now_ns() - g_state.clock_started_ns) /
+				(uint64_t)NS_PER_TENTH);
+	return ran - g_state.clock_synced_tenths;
+}
+
+/* The clock as a sync would leave it, without applying anything */
+static int running_clock_tenths(void)
+{
+	int64_t pending = clock_pending_tenths();
+	if (pending <= 0)
+		return g_state.clock_tenths;
+	if (g_state.clock_direction == SCOREBOARD_CLOCK_COUNT_DOWN)
+		return pending >= g_state.clock_tenths
+			       ? 0
+			       : g_state.clock_tenths - (int)pending;
+	int64_t max_tenths = g_state.period_length * 10;
+	int64_t tenths = g_state.clock_tenths + pending;
+	return (int)(tenths < max_tenths ? tenths : max_tenths);
+}
+
+void scoreboard_clock_sync(void)
+{
+	if (!g_state.clock_running)
+		return;
+	int64_t due = clock_pending_tenths();
+	if (due <= 0)
+		return;
+	g_state.clock_synced_tenths += due;
+	clock_advance((int)due);
+}
+
+void scoreboard_clock_sync_ctx(struct scoreboard_ctx *ctx)
+{
+	if (!context_usable(ctx))
+		return;
+	struct scoreboard_ctx *previous = context_enter(ctx);
+	scoreboard_clock_sync();
+	context_leave(previous);
+}
+
+/* Clock and penalty text show whole seconds */
+#define DISPLAY_STEP_TENTHS 10
+
+/* A countdown drops a displayed second as soon as it crosses below a
+   multiple of the display step, and ends when it reaches zero */
+static int tenths_until_countdown_change(int remaining)
+{
+	int next = remaining % DISPLAY_STEP_TENTHS + 1;
+	return next < remaining ? next : remaining;
+}
+
+static int tenths_until_penalty_change(
+	const struct scoreboard_penalty *penalties, int next)
+{
+	int running = 0;
+	for (int i = 0; i < SCOREBOARD_PENALTY_SLOTS &&
+			running < SCOREBOARD_MAX_RUNNING_PENALTIES;
+	     i++) {
+		if (!penalties[i].active)
+			continue;
+		running++;
+		int left = penalties[i].remaining_tenths;
+		int change = tenths_until_countdown_change(left);
+		if (change < next)
+			next = change;
+	}
+	return next;
+}
+
+int scoreboard_tenths_until_display_change(void)
+{
+	if (!g_state.clock_running)
+		return -1;
+
+	int tenths = g_state.clock_tenths;
+	int next;
+	if (g_state.clock_direction == SCOREBOARD_CLOCK_COUNT_DOWN) {
+		next = tenths_until_countdown_change(tenths);
+	} else {
+		/* The cap is a whole number of seconds, so it always falls on
+		   one of these boundaries */
+		next = DISPLAY_STEP_TENTHS - tenths % DISPLAY_STEP_TENTHS;
+	}
+	next = tenths_until_penalty_change(g_state.home_penalties, next);
+	next = tenths_until_penalty_change(g_state.away_penalties, next);
+	return next < 1 ? 1 : next;
+}
+
+int64_t scoreboard_ns_until_display_change(void)
+{
+	int tenths = scoreboard_tenths_until_display_change();
+	if (tenths < 0)
+		return -1;
+	int64_t ran = (int64_t)(now_ns() - g_state.clock_started_ns);
+	int64_t due = (g_state.clock_synced_tenths + tenths) * NS_PER_TENTH -
+		      ran;
+	return due < 0 ? 0 : due;
+}
+
+int64_t scoreboard_ns_until_display_change_ctx(struct scoreboard_ctx *ctx)
+{
+	if (!context_usable(ctx))
+		return -1;
+	struct scoreboard_ctx *previous = context_enter(ctx);
+	int64_t ns = scoreboard_ns_until_display_change();
+	context_leave(previous);
+	return ns;
 }
 
 int scoreboard_clock_get_tenths(void)
 {
-	return g_state.clock_tenths;
+	return running_clock_tenths();
 }
 
 void scoreboard_clock_set_tenths(int tenths)
 {
+	/* Tenths run before the edit must not land on the new value */
+	scoreboard_clock_sync();
 	if (tenths < 0)
 		tenths = 0;
 	g_state.clock_tenths = tenths;
-	mark_dirty();
+	mark_dirty(FIELD(CLOCK));
 }
 
 void scoreboard_clock_adjust_seconds(int delta)
 {
+	scoreboard_clock_sync();
 	int before = g_state.clock_tenths;
 	g_state.clock_tenths += delta * 10;
 	if (g_state.clock_tenths < 0)
 		g_state.clock_tenths = 0;
-	mark_dirty();
+	mark_dirty(FIELD(CLOCK));
 	int actual_delta = g_state.clock_tenths - before;
 	if (actual_delta != 0)
 		scoreboard_penalty_adjust(actual_delta);
@@ -470,11 +1249,12 @@ void scoreboard_clock_adjust_seconds(int delta)
 
 void scoreboard_clock_adjust_minutes(int delta)
 {
+	scoreboard_clock_sync();
 	int before = g_state.clock_tenths;
 	g_state.clock_tenths += delta * 600;
 	if (g_state.clock_tenths < 0)
 		g_state.clock_tenths = 0;
-	mark_dirty();
+	mark_dirty(FIELD(CLOCK));
 	int actual_delta = g_state.clock_tenths - before;
 	if (actual_delta != 0)
 		scoreboard_penalty_adjust(actual_delta);
@@ -484,7 +1264,7 @@ void scoreboard_clock_format(char *buf, size_t size)
 {
 	if (buf == NULL || size == 0)
 		return;
-	int total_seconds = g_state.clock_tenths / 10;
+	int total_seconds = running_clock_tenths() / 10;
 	int minutes = total_seconds / 60;
 	int seconds = total_seconds % 60;
 	snprintf(buf, size, "%d:%02d", minutes, seconds);
@@ -493,7 +1273,7 @@ void scoreboard_clock_format(char *buf, size_t size)
 void scoreboard_set_clock_direction(enum scoreboard_clock_direction dir)
 {
 	g_state.clock_direction = dir;
-	mark_dirty();
+	mark_dirty(DIRTY_STATE);
 }
 
 enum scoreboard_clock_direction scoreboard_get_clock_direction(void)
@@ -506,7 +1286,7 @@ void scoreboard_set_period_length(int seconds)
 	if (seconds < 1)
 		seconds = 1;
 	g_state.period_length = seconds;
-	mark_dirty();
+	mark_dirty(DIRTY_STATE);
 }
 
 int scoreboard_get_period_length(void)
@@ -528,7 +1308,7 @@ void scoreboard_set_period(int period)
 	if (period > g_state.period_label_count)
 		period = g_state.period_label_count;
 	g_state.period = period;
-	mark_dirty();
+	mark_dirty(FIELD(PERIOD));
 }
 
 void scoreboard_period_advance(void)
@@ -536,7 +1316,7 @@ void scoreboard_period_advance(void)
 	if (g_state.period < g_state.period_label_count) {
 		g_state.period++;
 		scoreboard_clock_reset();
-		mark_dirty();
+		mark_dirty(FIELD(PERIOD));
 	}
 }
 
@@ -545,7 +1325,7 @@ void scoreboard_period_rewind(void)
 	if (g_state.period > 1) {
 		g_state.period--;
 		scoreboard_clock_reset();
-		mark_dirty();
+		mark_dirty(FIELD(PERIOD));
 	}
 }
 
@@ -568,7 +1348,7 @@ void scoreboard_set_overtime_enabled(bool enabled)
 	generate_default_period_labels();
 	if (g_state.period > g_state.period_label_count)
 		g_state.period = g_state.period_label_count;
-	mark_dirty();
+	mark_dirty(FIELD(PERIOD) | FIELD(PERIOD_LABELS));
 }
 
 bool scoreboard_get_overtime_enabled(void)
@@ -632,7 +1412,7 @@ void scoreboard_set_period_labels(const char *labels)
 		/* Clamp current period to new label count */
 		if (g_state.period > count)
 			g_state.period = count;
-		mark_dirty();
+		mark_dirty(FIELD(PERIOD) | FIELD(PERIOD_LABELS));
 	}
 }
 
@@ -671,6 +1451,7 @@ void scoreboard_set_default_penalty_duration(int seconds)
 	if (seconds < 1)
 		seconds = 1;
 	g_state.default_penalty_duration = seconds;
+	mark_dirty(FIELD(DEFAULT_PENALTY_DURATION));
 }
 
 int scoreboard_get_default_penalty_duration(void)
@@ -683,6 +1464,7 @@ void scoreboard_set_default_major_penalty_duration(int seconds)
 	if (seconds < 1)
 		seconds = 1;
 	g_state.default_major_penalty_duration = seconds;
+	mark_dirty(FIELD(DEFAULT_MAJOR_PENALTY_DURATION));
 }
 
 int scoreboard_get_default_major_penalty_duration(void)
@@ -695,7 +1477,7 @@ int scoreboard_get_default_major_penalty_duration(void)
 void scoreboard_set_home_name(const char *name)
 {
 	safe_copy(g_state.home_name, name, sizeof(g_state.home_name));
-	mark_dirty();
+	mark_dirty(FIELD(HOME_NAME));
 }
 
 const char *scoreboard_get_home_name(void)
@@ -706,7 +1488,7 @@ const char *scoreboard_get_home_name(void)
 void scoreboard_set_away_name(const char *name)
 {
 	safe_copy(g_state.away_name, name, sizeof(g_state.away_name));
-	mark_dirty();
+	mark_dirty(FIELD(AWAY_NAME));
 }
 
 const char *scoreboard_get_away_name(void)
@@ -724,20 +1506,20 @@ int scoreboard_get_home_score(void)
 void scoreboard_set_home_score(int score)
 {
 	g_state.home_score = score < 0 ? 0 : score;
-	mark_dirty();
+	mark_dirty(FIELD(HOME_SCORE));
 }
 
 void scoreboard_increment_home_score(void)
 {
 	g_state.home_score++;
-	mark_dirty();
+	mark_dirty(FIELD(HOME_SCORE));
 }
 
 void scoreboard_decrement_home_score(void)
 {
 	if (g_state.home_score > 0)
 		g_state.home_score--;
-	mark_dirty();
+	mark_dirty(FIELD(HOME_SCORE));
 }
 
 int scoreboard_get_away_score(void)
@@ -748,20 +1530,20 @@ int scoreboard_get_away_score(void)
 void scoreboard_set_away_score(int score)
 {
 	g_state.away_score = score < 0 ? 0 : score;
-	mark_dirty();
+	mark_dirty(FIELD(AWAY_SCORE));
 }
 
 void scoreboard_increment_away_score(void)
 {
 	g_state.away_score++;
-	mark_dirty();
+	mark_dirty(FIELD(AWAY_SCORE));
 }
 
 void scoreboard_decrement_away_score(void)
 {
 	if (g_state.away_score > 0)
 		g_state.away_score--;
-	mark_dirty();
+	mark_dirty(FIELD(AWAY_SCORE));
 }
 
 /* ---- shots ---- */
@@ -774,20 +1556,20 @@ int scoreboard_get_home_shots(void)
 void scoreboard_set_home_shots(int shots)
 {
 	g_state.home_shots = shots < 0 ? 0 : shots;
-	mark_dirty();
+	mark_dirty(FIELD(HOME_SHOTS));
 }
 
 void scoreboard_increment_home_shots(void)
 {
 	g_state.home_shots++;
-	mark_dirty();
+	mark_dirty(FIELD(HOME_SHOTS));
 }
 
 void scoreboard_decrement_home_shots(void)
 {
 	if (g_state.home_shots > 0)
 		g_state.home_shots--;
-	mark_dirty();
+	mark_dirty(FIELD(HOME_SHOTS));
 }
 
 int scoreboard_get_away_shots(void)
@@ -798,20 +1580,20 @@ int scoreboard_get_away_shots(void)
 void scoreboard_set_away_shots(int shots)
 {
 	g_state.away_shots = shots < 0 ? 0 : shots;
-	mark_dirty();
+	mark_dirty(FIELD(AWAY_SHOTS));
 }
 
 void scoreboard_increment_away_shots(void)
 {
 	g_state.away_shots++;
-	mark_dirty();
+	mark_dirty(FIELD(AWAY_SHOTS));
 }
 
 void scoreboard_decrement_away_shots(void)
 {
 	if (g_state.away_shots > 0)
 		g_state.away_shots--;
-	mark_dirty();
+	mark_dirty(FIELD(AWAY_SHOTS));
 }
 
 /* ---- faceoffs ---- */
@@ -824,20 +1606,20 @@ int scoreboard_get_home_faceoffs(void)
 void scoreboard_set_home_faceoffs(int faceoffs)
 {
 	g_state.home_faceoffs = faceoffs < 0 ? 0 : faceoffs;
-	mark_dirty();
+	mark_dirty(FIELD(HOME_FACEOFFS));
 }
 
 void scoreboard_increment_home_faceoffs(void)
 {
 	g_state.home_faceoffs++;
-	mark_dirty();
+	mark_dirty(FIELD(HOME_FACEOFFS));
 }
 
 void scoreboard_decrement_home_faceoffs(void)
 {
 	if (g_state.home_faceoffs > 0)
 		g_state.home_faceoffs--;
-	mark_dirty();
+	mark_dirty(FIELD(HOME_FACEOFFS));
 }
 
 int scoreboard_get_away_faceoffs(void)
@@ -848,20 +1630,20 @@ int scoreboard_get_away_faceoffs(void)
 void scoreboard_set_away_faceoffs(int faceoffs)
 {
 	g_state.away_faceoffs = faceoffs < 0 ? 0 : faceoffs;
-	mark_dirty();
+	mark_dirty(FIELD(AWAY_FACEOFFS));
 }
 
 void scoreboard_increment_away_faceoffs(void)
 {
 	g_state.away_faceoffs++;
-	mark_dirty();
+	mark_dirty(FIELD(AWAY_FACEOFFS));
 }
 
 void scoreboard_decrement_away_faceoffs(void)
 {
 	if (g_state.away_faceoffs > 0)
 		g_state.away_faceoffs--;
-	mark_dirty();
+	mark_dirty(FIELD(AWAY_FACEOFFS));
 }
 
 bool scoreboard_get_has_faceoffs(void)
@@ -879,20 +1661,20 @@ int scoreboard_get_home_fouls(void)
 void scoreboard_set_home_fouls(int fouls)
 {
 	g_state.home_fouls = fouls < 0 ? 0 : fouls;
-	mark_dirty();
+	mark_dirty(FIELD(HOME_FOULS));
 }
 
 void scoreboard_increment_home_fouls(void)
 {
 	g_state.home_fouls++;
-	mark_dirty();
+	mark_dirty(FIELD(HOME_FOULS));
 }
 
 void scoreboard_decrement_home_fouls(void)
 {
 	if (g_state.home_fouls > 0)
 		g_state.home_fouls--;
-	mark_dirty();
+	mark_dirty(FIELD(HOME_FOULS));
 }
 
 int scoreboard_get_away_fouls(void)
@@ -903,20 +1685,20 @@ int scoreboard_get_away_fouls(void)
 void scoreboard_set_away_fouls(int fouls)
 {
 	g_state.away_fouls = fouls < 0 ? 0 : fouls;
-	mark_dirty();
+	mark_dirty(FIELD(AWAY_FOULS));
 }
 
 void scoreboard_increment_away_fouls(void)
 {
 	g_state.away_fouls++;
-	mark_dirty();
+	mark_dirty(FIELD(AWAY_FOULS));
 }
 
 void scoreboard_decrement_away_fouls(void)
 {
 	if (g_state.away_fouls > 0)
 		g_state.away_fouls--;
-	mark_dirty();
+	mark_dirty(FIELD(AWAY_FOULS));
 }
 
 /* ---- fouls2 ---- */
@@ -929,20 +1711,20 @@ int scoreboard_get_home_fouls2(void)
 void scoreboard_set_home_fouls2(int fouls)
 {
 	g_state.home_fouls2 = fouls < 0 ? 0 : fouls;
-	mark_dirty();
+	mark_dirty(FIELD(HOME_FOULS2));
 }
 
 void scoreboard_increment_home_fouls2(void)
 {
 	g_state.home_fouls2++;
-	mark_dirty();
+	mark_dirty(FIELD(HOME_FOULS2));
 }
 
 void scoreboard_decrement_home_fouls2(void)
 {
 	if (g_state.home_fouls2 > 0)
 		g_state.home_fouls2--;
-	mark_dirty();
+	mark_dirty(FIELD(HOME_FOULS2));
 }
 
 int scoreboard_get_away_fouls2(void)
@@ -953,20 +1735,20 @@ int scoreboard_get_away_fouls2(void)
 void scoreboard_set_away_fouls2(int fouls)
 {
 	g_state.away_fouls2 = fouls < 0 ? 0 : fouls;
-	mark_dirty();
+	mark_dirty(FIELD(AWAY_FOULS2));
 }
 
 void scoreboard_increment_away_fouls2(void)
 {
 	g_state.away_fouls2++;
-	mark_dirty();
+	mark_dirty(FIELD(AWAY_FOULS2));
 }
 
 void scoreboard_decrement_away_fouls2(void)
 {
 	if (g_state.away_fouls2 > 0)
 		g_state.away_fouls2--;
-	mark_dirty();
+	mark_dirty(FIELD(AWAY_FOULS2));
 }
 
 /* ---- penalties ---- */
@@ -979,7 +1761,7 @@ int scoreboard_home_penalty_add(int player_number, int duration_secs)
 			g_state.home_penalties[i].remaining_tenths =
 				duration_secs * 10;
 			g_state.home_penalties[i].active = true;
-			mark_dirty();
+			mark_dirty(HOME_PENALTY_FIELDS);
 			return i;
 		}
 	}
@@ -997,7 +1779,7 @@ int scoreboard_home_penalty_add_compound(int player_number, int phase1_secs,
 			g_state.home_penalties[i].phase2_tenths =
 				phase2_secs * 10;
 			g_state.home_penalties[i].active = true;
-			mark_dirty();
+			mark_dirty(HOME_PENALTY_FIELDS);
 			return i;
 		}
 	}
@@ -1011,7 +1793,7 @@ void scoreboard_home_penalty_clear(int slot)
 		g_state.home_penalties[slot].player_number = 0;
 		g_state.home_penalties[slot].remaining_tenths = 0;
 		g_state.home_penalties[slot].phase2_tenths = 0;
-		mark_dirty();
+		mark_dirty(HOME_PENALTY_FIELDS);
 	}
 }
 
@@ -1035,7 +1817,7 @@ void scoreboard_home_penalty_set_time(int slot, int duration_secs)
 		g_state.home_penalties[slot].remaining_tenths =
 			duration_secs * 10;
 	}
-	mark_dirty();
+	mark_dirty(HOME_PENALTY_FIELDS);
 }
 
 const struct scoreboard_penalty *scoreboard_get_home_penalty(int slot)
@@ -1053,7 +1835,7 @@ int scoreboard_away_penalty_add(int player_number, int duration_secs)
 			g_state.away_penalties[i].remaining_tenths =
 				duration_secs * 10;
 			g_state.away_penalties[i].active = true;
-			mark_dirty();
+			mark_dirty(AWAY_PENALTY_FIELDS);
 			return i;
 		}
 	}
@@ -1071,7 +1853,7 @@ int scoreboard_away_penalty_add_compound(int player_number, int phase1_secs,
 			g_state.away_penalties[i].phase2_tenths =
 				phase2_secs * 10;
 			g_state.away_penalties[i].active = true;
-			mark_dirty();
+			mark_dirty(AWAY_PENALTY_FIELDS);
 			return i;
 		}
 	}
@@ -1085,7 +1867,7 @@ void scoreboard_away_penalty_clear(int slot)
 		g_state.away_penalties[slot].player_number = 0;
 		g_state.away_penalties[slot].remaining_tenths = 0;
 		g_state.away_penalties[slot].phase2_tenths = 0;
-		mark_dirty();
+		mark_dirty(AWAY_PENALTY_FIELDS);
 	}
 }
 
@@ -1109,7 +1891,7 @@ void scoreboard_away_penalty_set_time(int slot, int duration_secs)
 		g_state.away_penalties[slot].remaining_tenths =
 			duration_secs * 10;
 	}
-	mark_dirty();
+	mark_dirty(AWAY_PENALTY_FIELDS);
 }
 
 const struct scoreboard_penalty *scoreboard_get_away_penalty(int slot)
@@ -1141,7 +1923,7 @@ int scoreboard_get_away_penalty_count(void)
 
 void scoreboard_penalty_tick(int elapsed_tenths)
 {
-	bool ticked = false;
+	unsigned int ticked = 0;
 	bool cleared = false;
 	int home_running = 0;
 	int away_running = 0;
@@ -1151,7 +1933,7 @@ void scoreboard_penalty_tick(int elapsed_tenths)
 			g_state.home_penalties[i].remaining_tenths -=
 				elapsed_tenths;
 			home_running++;
-			ticked = true;
+			ticked |= FIELD(HOME_PENALTY_TIMES);
 			if (g_state.home_penalties[i].remaining_tenths <= 0) {
 				if (g_state.home_penalties[i].phase2_tenths >
 				    0) {
@@ -1172,7 +1954,7 @@ void scoreboard_penalty_tick(int elapsed_tenths)
 			g_state.away_penalties[i].remaining_tenths -=
 				elapsed_tenths;
 			away_running++;
-			ticked = true;
+			ticked |= FIELD(AWAY_PENALTY_TIMES);
 			if (g_state.away_penalties[i].remaining_tenths <= 0) {
 				if (g_state.away_penalties[i].phase2_tenths >
 				    0) {
@@ -1191,13 +1973,15 @@ void scoreboard_penalty_tick(int elapsed_tenths)
 	}
 	if (cleared)
 		scoreboard_penalty_compact();
-	if (ticked)
-		mark_dirty();
+	if (ticked & FIELD(HOME_PENALTY_TIMES))
+		mark_if_rendered_changed(SCOREBOARD_FIELD_HOME_PENALTY_TIMES);
+	if (ticked & FIELD(AWAY_PENALTY_TIMES))
+		mark_if_rendered_changed(SCOREBOARD_FIELD_AWAY_PENALTY_TIMES);
 }
 
 void scoreboard_penalty_adjust(int delta_tenths)
 {
-	bool adjusted = false;
+	unsigned int adjusted = 0;
 	bool cleared = false;
 	int home_running = 0;
 	int away_running = 0;
@@ -1207,7 +1991,7 @@ void scoreboard_penalty_adjust(int delta_tenths)
 			g_state.home_penalties[i].remaining_tenths +=
 				delta_tenths;
 			home_running++;
-			adjusted = true;
+			adjusted |= HOME_PENALTY_FIELDS;
 			if (g_state.home_penalties[i].remaining_tenths <= 0) {
 				if (g_state.home_penalties[i].phase2_tenths >
 				    0) {
@@ -1228,7 +2012,7 @@ void scoreboard_penalty_adjust(int delta_tenths)
 			g_state.away_penalties[i].remaining_tenths +=
 				delta_tenths;
 			away_running++;
-			adjusted = true;
+			adjusted |= AWAY_PENALTY_FIELDS;
 			if (g_state.away_penalties[i].remaining_tenths <= 0) {
 				if (g_state.away_penalties[i].phase2_tenths >
 				    0) {
@@ -1248,7 +2032,7 @@ void scoreboard_penalty_adjust(int delta_tenths)
 	if (cleared)
 		scoreboard_penalty_compact();
 	if (adjusted)
-		mark_dirty();
+		mark_dirty(adjusted);
 }
 
 static void compact_penalties(struct scoreboard_penalty *penalties)
@@ -1381,8 +2165,13 @@ void scoreboard_format_all_penalty_times(bool home, char *buf, size_t size)
 
 void scoreboard_set_output_directory(const char *path)
 {
+	char previous[SCOREBOARD_MAX_PATH];
+	memcpy(previous, g_state.output_directory, sizeof(previous));
 	safe_copy(g_state.output_directory, path,
 		  sizeof(g_state.output_directory));
+	/* A new directory has none of the files yet — write them all */
+	if (strcmp(previous, g_state.output_directory) != 0)
+		mark_dirty(SCOREBOARD_FIELDS_ALL);
 }
 
 const char *scoreboard_get_output_directory(void)
@@ -1390,404 +2179,1851 @@ const char *scoreboard_get_output_directory(void)
 	return g_state.output_directory;
 }
 
-bool scoreboard_write_all_files(void)
+static void format_output_field(enum scoreboard_output_field field, char *buf,
+				size_t size)
+{
+	const struct output_field_desc *desc = &k_output_fields[field];
+	const char *value = (const char *)&g_state + desc->offset;
+	if (desc->format != NULL)
+		desc->format(buf, size);
+	else if (desc->type == OUTPUT_VALUE_INT)
+		snprintf(buf, size, "%d", *(const int *)value);
+	else
+		snprintf(buf, size, "%s", value);
+}
+
+static void format_home_penalty_numbers(char *buf, size_t size)
+{
+	scoreboard_format_all_penalty_numbers(true, buf, size);
+}
+
+static void format_away_penalty_numbers(char *buf, size_t size)
+{
+	scoreboard_format_all_penalty_numbers(false, buf, size);
+}
+
+static void format_home_penalty_times(char *buf, size_t size)
+{
+	scoreboard_format_all_penalty_times(true, buf, size);
+}
+
+static void format_away_penalty_times(char *buf, size_t size)
+{
+	scoreboard_format_all_penalty_times(false, buf, size);
+}
+
+static void format_sport(char *buf, size_t size)
+{
+	snprintf(buf, size, "%s", scoreboard_sport_name(g_state.sport));
+}
+
+void scoreboard_format_output_field(enum scoreboard_output_field field,
+				    char *buf, size_t size)
+{
+	if (buf == NULL || size == 0)
+		return;
+	if (field < 0 || field >= SCOREBOARD_FIELD_COUNT) {
+		buf[0] = '\0';
+		return;
+	}
+	format_output_field(field, buf, size);
+}
+
+/* ---- consolidated output ---- */
+
+static const char *k_output_mode_names[SCOREBOARD_OUTPUT_MODE_COUNT] = {
+	"files",
+	"json",
+	"keyvalue",
+};
+
+static const char *k_output_mode_filenames[SCOREBOARD_OUTPUT_MODE_COUNT] = {
+	"",
+	"scoreboard.json",
+	"scoreboard.txt",
+};
+
+void scoreboard_set_output_mode(enum scoreboard_output_mode mode)
+{
+	if (mode < 0 || mode >= SCOREBOARD_OUTPUT_MODE_COUNT)
+		mode = SCOREBOARD_OUTPUT_FILES;
+	if (mode == g_state.output_mode)
+		return;
+	g_state.output_mode = mode;
+	mark_dirty(SCOREBOARD_FIELDS_ALL);
+}
+
+enum scoreboard_output_mode scoreboard_get_output_mode(void)
+{
+	return g_state.output_mode;
+}
+
+const char *scoreboard_output_mode_name(enum scoreboard_output_mode mode)
+{
+	if (mode < 0 || mode >= SCOREBOARD_OUTPUT_MODE_COUNT)
+		return k_output_mode_names[SCOREBOARD_OUTPUT_FILES];
+	return k_output_mode_names[mode];
+}
+
+enum scoreboard_output_mode scoreboard_output_mode_from_name(const char *name)
+{
+	if (name == NULL)
+		return SCOREBOARD_OUTPUT_FILES;
+	for (int i = 0; i < SCOREBOARD_OUTPUT_MODE_COUNT; i++) {
+		if (strcmp(name, k_output_mode_names[i]) == 0)
+			return (enum scoreboard_output_mode)i;
+	}
+	return SCOREBOARD_OUTPUT_FILES;
+}
+
+const char *scoreboard_output_mode_filename(enum scoreboard_output_mode mode)
+{
+	if (mode < 0 || mode >= SCOREBOARD_OUTPUT_MODE_COUNT)
+		return "";
+	return k_output_mode_filenames[mode];
+}
+
+/* Snapshot keys are the per-field file names without ".txt" */
+static void append_text(char *buf, size_t size, size_t *offset,
+			const char *text)
+{
+	size_t len = strlen(text);
+	if (*offset + len >= size)
+		len = size - 1 - *offset;
+	memcpy(buf + *offset, text, len);
+	*offset += len;
+	buf[*offset] = '\0';
+}
+
+static void append_escaped(char *buf, size_t size, size_t *offset,
+			   const char *text, bool json)
+{
+	for (const char *p = text; *p != '\0'; p++) {
+		char esc[8];
+		if (*p == '\n')
+			snprintf(esc, sizeof(esc), "\\n");
+		else if (*p == '\r')
+			snprintf(esc, sizeof(esc), "\\r");
+		else if (*p == '\t')
+			snprintf(esc, sizeof(esc), "\\t");
+		else if (*p == '\\' || (json && *p == '"'))
+			snprintf(esc, sizeof(esc), "\\%c", *p);
+		else if (json && (unsigned char)*p < 0x20)
+			snprintf(esc, sizeof(esc), "\\u%04x",
+				 (unsigned char)*p);
+		else
+			snprintf(esc, sizeof(esc), "%c", *p);
+		append_text(buf, size, offset, esc);
+	}
+}
+
+/* Renders every output field into one buffer. When remember is set the
+   text is being written out, so the per-tick rendered caches follow it. */
+static size_t build_snapshot(enum scoreboard_output_mode mode,
+			     unsigned int fields, char *buf, size_t size,
+			     bool remember)
+{
+	bool json = mode == SCOREBOARD_OUTPUT_JSON;
+	bool first = true;
+	size_t offset = 0;
+	char value[512];
+
+	buf[0] = '\0';
+	if (json)
+		append_text(buf, size, &offset, "{");
+	for (int i = 0; i < SCOREBOARD_FIELD_COUNT; i++) {
+		enum scoreboard_output_field field =
+			(enum scoreboard_output_field)i;
+		if ((fields & SCOREBOARD_FIELD_BIT(field)) == 0)
+			continue;
+		format_output_field(field, value, sizeof(value));
+		if (remember)
+			remember_rendered(field, value);
+		if (json)
+			append_text(buf, size, &offset,
+				    first ? "\n  \"" : ",\n  \"");
+		append_text(buf, size, &offset, k_output_fields[field].key);
+		append_text(buf, size, &offset, json ? "\": \"" : "=");
+		append_escaped(buf, size, &offset, value, json);
+		append_text(buf, size, &offset, json ? "\"" : "\n");
+		first = false;
+	}
+	if (json)
+		append_text(buf, size, &offset, first ? "}\n" : "\n}\n");
+	return offset;
+}
+
+size_t scoreboard_format_output_fields(enum scoreboard_output_mode mode,
+				       unsigned int fields, char *buf,
+				       size_t size)
+{
+	if (buf == NULL || size == 0)
+		return 0;
+	if (mode != SCOREBOARD_OUTPUT_JSON &&
+	    mode != SCOREBOARD_OUTPUT_KEY_VALUE) {
+		buf[0] = '\0';
+		return 0;
+	}
+	return build_snapshot(mode, fields, buf, size, false);
+}
+
+size_t scoreboard_format_output_snapshot(enum scoreboard_output_mode mode,
+					 char *buf, size_t size)
+{
+	return scoreboard_format_output_fields(mode, SCOREBOARD_FIELDS_ALL,
+					       buf, size);
+}
+
+/* A file the writer thread failed to publish is dirty again, so the next
+   write retries it just as it would after a failed direct write */
+static bool reclaim_failed_write(const char *path, void *data)
+{
+	(void)data;
+	const char *dir = g_state.output_directory;
+	size_t len = strlen(dir);
+	if (len == 0 || strncmp(path, dir, len) != 0 || path[len] != '/')
+		return false;
+	const char *name = path + len + 1;
+	unsigned int fields = 0;
+	if (strcmp(name, k_output_mode_filenames[g_state.output_mode]) == 0)
+		fields = SCOREBOARD_FIELDS_ALL;
+	for (int i = 0; i < SCOREBOARD_FIELD_COUNT; i++) {
+		if (strcmp(name, k_output_fields[i].filename) == 0)
+			fields = SCOREBOARD_FIELD_BIT(i);
+	}
+	if (fields == 0)
+		return false;
+	g_write_stats.write_errors++;
+	g_dirty |= fields;
+	return true;
+}
+
+static void reclaim_failed_writes(void)
+{
+	scoreboard_writer_take_failed(reclaim_failed_write, NULL);
+}
+
+static bool write_snapshot_file(const char *dir)
+{
+	char snapshot[SCOREBOARD_SNAPSHOT_SIZE];
+	build_snapshot(g_state.output_mode, SCOREBOARD_FIELDS_ALL, snapshot,
+		       sizeof(snapshot), true);
+
+	g_write_stats.writes++;
+	if (!write_text_file(dir, k_output_mode_filenames[g_state.output_mode],
+			     snapshot)) {
+		/* Leave every field dirty so the next write retries */
+		g_write_stats.write_errors++;
+		return false;
+	}
+	g_write_stats.files_written++;
+	g_dirty = 0;
+	return true;
+}
+
+static bool find_key_value(const char *text, const char *key, char *out,
+			   size_t out_size)
+{
+	size_t key_len = strlen(key);
+	const char *line = text;
+	while (line != NULL) {
+		if (strncmp(line, key, key_len) == 0 && line[key_len] == '=') {
+			const char *val = line + key_len + 1;
+			size_t i = 0;
+			while (*val != '\0' && *val != '\n' && *val != '\r' &&
+			       i < out_size - 1) {
+				if (*val == '\\' && *(val + 1) != '\0') {
+					val++;
+					out[i++] = unescape_char(*val++);
+					continue;
+				}
+				out[i++] = *val++;
+			}
+			out[i] = '\0';
+			return true;
+		}
+		line = strchr(line, '\n');
+		if (line != NULL)
+			line++;
+	}
+	return false;
+}
+
+/* A single-file snapshot loaded into memory, indexed once if it is JSON */
+struct snapshot_file {
+	const char *text;
+	struct json_index json;
+};
+
+/* Field text for scoreboard_read_all_files(): from the per-field file, or
+   from the snapshot file already loaded into memory. */
+static bool read_output_field(const struct snapshot_file *snapshot,
+			      enum scoreboard_output_field field, char *buf,
+			      size_t size)
+{
+	if (snapshot == NULL)
+		return read_text_file(g_state.output_directory,
+				      k_output_fields[field].filename, buf,
+				      size);
+
+	const char *key = k_output_fields[field].key;
+	if (g_state.output_mode == SCOREBOARD_OUTPUT_JSON) {
+		if (find_json_value(&snapshot->json, key) == NULL)
+			return false;
+		parse_json_string(&snapshot->json, key, buf, size);
+		return true;
+	}
+	return find_key_value(snapshot->text, key, buf, size);
+}
+
+static bool read_field(const struct snapshot_file *snapshot,
+		       enum scoreboard_output_field field)
+{
+	const struct output_field_desc *desc = &k_output_fields[field];
+	if (desc->read != NULL)
+		return desc->read(snapshot, field);
+	char buf[512];
+	if (!read_output_field(snapshot, field, buf, sizeof(buf)))
+		return false;
+	char *value = (char *)&g_state + desc->offset;
+	if (desc->type == OUTPUT_VALUE_INT) {
+		int n = atoi(buf);
+		*(int *)value = n < 0 ? 0 : n;
+	} else {
+		safe_copy(value, buf, desc->size);
+	}
+	mark_dirty(SCOREBOARD_FIELD_BIT(field));
+	return true;
+}
+
+static bool read_clock(const struct snapshot_file *snapshot,
+		       enum scoreboard_output_field field)
+{
+	char buf[512];
+	if (!read_output_field(snapshot, field, buf, sizeof(buf)))
+		return false;
+	int tenths = parse_clock_text(buf);
+	if (tenths >= 0)
+		g_state.clock_tenths = tenths;
+	return true;
+}
+
+static bool read_period(const struct snapshot_file *snapshot,
+			enum scoreboard_output_field field)
+{
+	char buf[512];
+	if (!read_output_field(snapshot, field, buf, sizeof(buf)))
+		return false;
+	int p = parse_period_text(buf);
+	if (p > 0)
+		scoreboard_set_period(p);
+	return true;
+}
+
+/* Numbers and times only make sense together; both are read here */
+static bool read_penalties(const struct snapshot_file *snapshot,
+			   enum scoreboard_output_field field)
+{
+	bool home = field == SCOREBOARD_FIELD_HOME_PENALTY_NUMBERS;
+	enum scoreboard_output_field times_field =
+		home ? SCOREBOARD_FIELD_HOME_PENALTY_TIMES
+		     : SCOREBOARD_FIELD_AWAY_PENALTY_TIMES;
+	char numbers[512], times[512];
+	bool has_numbers =
+		read_output_field(snapshot, field, numbers, sizeof(numbers));
+	bool has_times =
+		read_output_field(snapshot, times_field, times, sizeof(times));
+	if (!has_numbers || !has_times)
+		return false;
+	parse_penalty_files(numbers, times, home);
+	return true;
+}
+
+static bool read_with_numbers(const struct snapshot_file *snapshot,
+			      enum scoreboard_output_field field)
 {
-	if (!g_dirty)
+	(void)snapshot;
+	(void)field;
+	return true;
+}
+
+static bool read_sport(const struct snapshot_file *snapshot,
+		       enum scoreboard_output_field field)
+{
+	char buf[512];
+	if (!read_output_field(snapshot, field, buf, sizeof(buf)))
+		return false;
+	enum scoreboard_sport sport = scoreboard_sport_from_name(buf);
+	if (sport != g_state.sport)
+		scoreboard_set_sport(sport);
+	return true;
+}
+
+static bool read_duration(const struct snapshot_file *snapshot,
+			  enum scoreboard_output_field field)
+{
+	char buf[512];
+	if (!read_output_field(snapshot, field, buf, sizeof(buf)))
+		return false;
+	int value = atoi(buf);
+	if (value > 0)
+		*(int *)((char *)&g_state + k_output_fields[field].offset) =
+			value;
+	return true;
+}
+
+static bool read_period_labels(const struct snapshot_file *snapshot,
+			       enum scoreboard_output_field field)
+{
+	char buf[512];
+	if (!read_output_field(snapshot, field, buf, sizeof(buf)))
+		return false;
+	scoreboard_set_period_labels(buf);
+	return true;
+}
+
+static bool write_all_files(void)
+{
+	reclaim_failed_writes();
+	if (g_dirty == 0)
 		return true;
 
 	const char *dir = g_state.output_directory;
 	if (dir[0] == '\0')
 		return false;
 
-	char buf[64];
+	if (g_state.output_mode != SCOREBOARD_OUTPUT_FILES)
+		return write_snapshot_file(dir);
+
+	char buf[512];
 	bool ok = true;
+	unsigned int failed = 0;
+
+	g_write_stats.writes++;
+	for (int i = 0; i < SCOREBOARD_FIELD_COUNT; i++) {
+		unsigned int bit = SCOREBOARD_FIELD_BIT(i);
+		if ((g_dirty & bit) == 0) {
+			g_write_stats.files_skipped++;
+			continue;
+		}
+		enum scoreboard_output_field field =
+			(enum scoreboard_output_field)i;
+		format_output_field(field, buf, sizeof(buf));
+		remember_rendered(field, buf);
+		if (write_text_file(dir, k_output_fields[i].filename, buf)) {
+			g_write_stats.files_written++;
+		} else {
+			/* Keep the bit so the next write retries this file */
+			g_write_stats.write_errors++;
+			failed |= bit;
+			ok = false;
+		}
+	}
+
+	g_dirty = failed;
+	return ok;
+}
+
+bool scoreboard_write_all_files(void)
+{
+	/* Every action that reaches the output files reaches the journal
+	   and the trace */
+	journal_sync_current();
+	trace_sync_current();
+	uint64_t start = scoreboard_perf_now();
+	unsigned long long before = g_write_stats.files_written;
+	bool ok = write_all_files();
+	scoreboard_perf_record(SCOREBOARD_PERF_WRITE_FILES, start,
+			       (unsigned int)(g_write_stats.files_written -
+					      before));
+	return ok;
+}
+
+bool scoreboard_write_all_files_ctx(struct scoreboard_ctx *ctx)
+{
+	if (!context_usable(ctx))
+		return false;
+	struct scoreboard_ctx *previous = context_enter(ctx);
+	bool ok = scoreboard_write_all_files();
+	context_leave(previous);
+	return ok;
+}
+
+static bool read_all_files(void)
+{
+	const char *dir = g_state.output_directory;
+	if (dir[0] == '\0')
+		return false;
+	/* The clock and penalty times read below replace everything run
+	   so far, so nothing unsynced may be applied on top of them */
+	scoreboard_clock_sync();
+
+	struct snapshot_file file;
+	struct snapshot_file *snapshot = NULL;
+	char *text = NULL;
+	if (g_state.output_mode != SCOREBOARD_OUTPUT_FILES) {
+		char path[1024];
+		snprintf(path, sizeof(path), "%s/%s", dir,
+			 k_output_mode_filenames[g_state.output_mode]);
+		text = read_whole_file(path);
+		if (text == NULL)
+			return false;
+		file.text = text;
+		if (g_state.output_mode == SCOREBOARD_OUTPUT_JSON)
+			json_index_build(&file.json, text);
+		snapshot = &file;
+	}
+
+	bool ok = true;
+	for (int i = 0; i < SCOREBOARD_FIELD_COUNT; i++) {
+		enum scoreboard_output_field field =
+			(enum scoreboard_output_field)i;
+		if (!read_field(snapshot, field) && !k_output_fields[i].optional)
+			ok = false;
+	}
+
+	free(text);
+	g_dirty = 0;
+	return ok;
+}
+
+bool scoreboard_read_all_files(void)
+{
+	uint64_t start = scoreboard_perf_now();
+	bool ok = read_all_files();
+	scoreboard_perf_record(SCOREBOARD_PERF_READ_FILES, start, 0);
+	/* A reload leaves nothing dirty to write, so it is traced here */
+	trace_sync_current();
+	return ok;
+}
+
+/* ---- state persistence ---- */
+
+/* A copy of the state, so it can be saved from another thread */
+struct scoreboard_saved_state {
+	struct core_state state;
+};
+
+/* The JSON state file is a pair of slots, path.0 and path.1. Each save
+   goes to the slot not holding the newest intact save, with a generation
+   one higher, and ends with a CRC-32 of everything before it. A save cut
+   short by a crash only ever damages the older slot, so loading the
+   newest slot whose checksum holds needs no fsync or rename. */
+#define STATE_SLOTS 2
+#define STATE_TEXT_SIZE 16384
+#define STATE_TRAILER ",\n  \"checksum\": \"%08x\"\n}\n"
+#define STATE_TRAILER_SIZE (sizeof(",\n  \"checksum\": \"00000000\"\n}\n") - 1)
+
+static uint32_t crc32_update(uint32_t crc, const void *data, size_t size);
+
+static void append_format(char *buf, size_t size, size_t *offset,
+			  const char *fmt, ...)
+{
+	size_t room = size - *offset;
+	va_list args;
+	va_start(args, fmt);
+	int n = vsnprintf(buf + *offset, room, fmt, args);
+	va_end(args);
+	*offset += (size_t)n < room ? (size_t)n : room - 1;
+}
+
+static void append_state_int(char *buf, size_t size, size_t *offset,
+			     const char *key, int value)
+{
+	append_format(buf, size, offset, ",\n  \"%s\": %d", key, value);
+}
+
+static void append_state_bool(char *buf, size_t size, size_t *offset,
+			      const char *key, bool value)
+{
+	append_format(buf, size, offset, ",\n  \"%s\": %s", key,
+		      value ? "true" : "false");
+}
+
+static void append_state_string(char *buf, size_t size, size_t *offset,
+				const char *key, const char *value)
+{
+	append_format(buf, size, offset, ",\n  \"%s\": \"", key);
+	for (const char *p = value; *p != '\0'; p++) {
+		if (*p == '"' || *p == '\\')
+			append_text(buf, size, offset, "\\");
+		append_format(buf, size, offset, "%c", *p);
+	}
+	append_text(buf, size, offset, "\"");
+}
+
+/* One row per member of the JSON state file, in file order. Keys are
+   spelled out here, penalty and label slots included, so neither saving
+   nor loading builds a key at run time. */
+enum state_value {
+	STATE_INT,
+	STATE_BOOL,
+	STATE_TEXT,
+	/* Saved by name and loaded before everything else, since
+	   scoreboard_set_sport() applies the preset the other rows override */
+	STATE_SPORT,
+	STATE_LABEL_COUNT,
+	/* Only the first period_label_count labels are saved and loaded */
+	STATE_LABEL,
+};
+
+struct state_field_desc {
+	const char *key;
+	enum state_value type;
+	size_t offset;
+	size_t size;
+	int index;
+};
+
+_Static_assert(sizeof(enum scoreboard_clock_direction) == sizeof(int),
+	       "clock_direction is saved as an int");
+_Static_assert(SCOREBOARD_PENALTY_SLOTS == 8,
+	       "k_state_fields lists eight penalty slots per team");
+_Static_assert(SCOREBOARD_MAX_PERIOD_LABELS == 16,
+	       "k_state_fields lists sixteen period labels");
+
+#define STATE_ROW(key, type, member)                           \
+	{key, type, offsetof(struct core_state, member),       \
+	 STATE_MEMBER_SIZE(member), 0}
+#define STATE_PENALTY(team, i)                                          \
+	STATE_ROW(#team "_penalty" #i "_number", STATE_INT,             \
+		  team##_penalties[i].player_number),                   \
+	STATE_ROW(#team "_penalty" #i "_tenths", STATE_INT,             \
+		  team##_penalties[i].remaining_tenths),                \
+	STATE_ROW(#team "_penalty" #i "_active", STATE_BOOL,            \
+		  team##_penalties[i].active),                          \
+	STATE_ROW(#team "_penalty" #i "_phase2_tenths", STATE_INT,      \
+		  team##_penalties[i].phase2_tenths)
+#define STATE_PENALTIES(team)                                           \
+	STATE_PENALTY(team, 0), STATE_PENALTY(team, 1),                 \
+	STATE_PENALTY(team, 2), STATE_PENALTY(team, 3),                 \
+	STATE_PENALTY(team, 4), STATE_PENALTY(team, 5),                 \
+	STATE_PENALTY(team, 6), STATE_PENALTY(team, 7)
+#define STATE_LABEL(i)                                                  \
+	{"period_label" #i, STATE_LABEL,                                \
+	 offsetof(struct core_state, period_labels[i]),                 \
+	 SCOREBOARD_PERIOD_LABEL_SIZE, i}
+
+static const struct state_field_desc k_state_fields[] = {
+	STATE_ROW("clock_tenths", STATE_INT, clock_tenths),
+	STATE_ROW("clock_running", STATE_BOOL, clock_running),
+	STATE_ROW("clock_direction", STATE_INT, clock_direction),
+	STATE_ROW("period_length", STATE_INT, period_length),
+	STATE_ROW("period", STATE_INT, period),
+	STATE_ROW("overtime_enabled", STATE_BOOL, overtime_enabled),
+	STATE_ROW("home_name", STATE_TEXT, home_name),
+	STATE_ROW("away_name", STATE_TEXT, away_name),
+	STATE_ROW("home_score", STATE_INT, home_score),
+	STATE_ROW("away_score", STATE_INT, away_score),
+	STATE_ROW("home_shots", STATE_INT, home_shots),
+	STATE_ROW("away_shots", STATE_INT, away_shots),
+	STATE_ROW("home_faceoffs", STATE_INT, home_faceoffs),
+	STATE_ROW("away_faceoffs", STATE_INT, away_faceoffs),
+	STATE_ROW("home_fouls", STATE_INT, home_fouls),
+	STATE_ROW("away_fouls", STATE_INT, away_fouls),
+	STATE_ROW("home_fouls2", STATE_INT, home_fouls2),
+	STATE_ROW("away_fouls2", STATE_INT, away_fouls2),
+	STATE_ROW("sport", STATE_SPORT, sport),
+	STATE_PENALTIES(home),
+	STATE_PENALTIES(away),
+	STATE_ROW("period_label_count", STATE_LABEL_COUNT,
+		  period_label_count),
+	STATE_LABEL(0), STATE_LABEL(1), STATE_LABEL(2), STATE_LABEL(3),
+	STATE_LABEL(4), STATE_LABEL(5), STATE_LABEL(6), STATE_LABEL(7),
+	STATE_LABEL(8), STATE_LABEL(9), STATE_LABEL(10), STATE_LABEL(11),
+	STATE_LABEL(12), STATE_LABEL(13), STATE_LABEL(14), STATE_LABEL(15),
+};
+
+#define STATE_FIELD_COUNT \
+	((int)(sizeof(k_state_fields) / sizeof(k_state_fields[0])))
+
+static void append_state_field(char *buf, size_t size, size_t *offset,
+			       const struct core_state *s,
+			       const struct state_field_desc *desc)
+{
+	const char *value = (const char *)s + desc->offset;
+	switch (desc->type) {
+	case STATE_INT:
+	case STATE_LABEL_COUNT:
+		append_state_int(buf, size, offset, desc->key,
+				 *(const int *)value);
+		break;
+	case STATE_BOOL:
+		append_state_bool(buf, size, offset, desc->key,
+				  *(const bool *)value);
+		break;
+	case STATE_SPORT:
+		append_state_string(buf, size, offset, desc->key,
+				    scoreboard_sport_name(s->sport));
+		break;
+	case STATE_LABEL:
+		if (desc->index >= s->period_label_count)
+			break;
+		/* fall through */
+	case STATE_TEXT:
+		append_state_string(buf, size, offset, desc->key, value);
+		break;
+	}
+}
+
+/* Every field fits well inside STATE_TEXT_SIZE */
+static size_t format_state_json(const struct core_state *s,
+				unsigned long long generation, char *buf,
+				size_t size)
+{
+	size_t len = 0;
+	append_format(buf, size, &len, "{\n  \"save_generation\": %llu",
+		      generation);
+	for (int i = 0; i < STATE_FIELD_COUNT; i++)
+		append_state_field(buf, size, &len, s, &k_state_fields[i]);
+
+	uint32_t crc = crc32_update(0, buf, len);
+	append_format(buf, size, &len, STATE_TRAILER, (unsigned int)crc);
+	return len;
+}
+
+static void state_slot_path(const char *path, int slot, char *out,
+			    size_t size)
+{
+	snprintf(out, size, "%s.%d", path, slot);
+}
+
+/* The slot's text and save generation, or NULL if it is missing or its
+   checksum doesn't hold */
+static char *read_state_slot(const char *path, int slot,
+			     unsigned long long *generation)
+{
+	char slot_path[1040];
+	state_slot_path(path, slot, slot_path, sizeof(slot_path));
+	char *text = read_whole_file(slot_path);
+	if (text == NULL)
+		return NULL;
+
+	size_t len = strlen(text);
+	char trailer[STATE_TRAILER_SIZE + 1];
+	bool ok = len > STATE_TRAILER_SIZE;
+	if (ok) {
+		size_t body = len - STATE_TRAILER_SIZE;
+		snprintf(trailer, sizeof(trailer), STATE_TRAILER,
+			 (unsigned int)crc32_update(0, text, body));
+		ok = memcmp(text + body, trailer, STATE_TRAILER_SIZE) == 0 &&
+		     sscanf(text, "{\n  \"save_generation\": %llu",
+			    generation) == 1;
+	}
+	if (!ok) {
+		free(text);
+		return NULL;
+	}
+	return text;
+}
+
+/* Index of the newest intact slot, or -1; its text goes to *text */
+static int newest_state_slot(const char *path, char **text,
+			     unsigned long long *generation)
+{
+	int newest = -1;
+	*text = NULL;
+	*generation = 0;
+	for (int slot = 0; slot < STATE_SLOTS; slot++) {
+		unsigned long long slot_generation;
+		char *slot_text = read_state_slot(path, slot, &slot_generation);
+		if (slot_text == NULL)
+			continue;
+		if (newest >= 0 && slot_generation <= *generation) {
+			free(slot_text);
+			continue;
+		}
+		free(*text);
+		*text = slot_text;
+		*generation = slot_generation;
+		newest = slot;
+	}
+	return newest;
+}
+
+static bool save_state_slots(const struct core_state *s, const char *path)
+{
+	char *newest_text;
+	unsigned long long generation;
+	int newest = newest_state_slot(path, &newest_text, &generation);
+	free(newest_text);
+
+	char text[STATE_TEXT_SIZE];
+	size_t len = format_state_json(s, generation + 1, text, sizeof(text));
+	char slot_path[1040];
+	state_slot_path(path, newest == 0 ? 1 : 0, slot_path,
+			sizeof(slot_path));
+	FILE *f = fopen(slot_path, "wb");
+	if (f == NULL)
+		return false;
+	bool ok = fwrite(text, 1, len, f) == len;
+	return fclose(f) == 0 && ok;
+}
+
+bool scoreboard_save_state(const char *path)
+{
+	if (path == NULL)
+		return false;
+	return save_state_slots(&g_state, path);
+}
+
+size_t scoreboard_saved_state_size(void)
+{
+	return sizeof(struct scoreboard_saved_state);
+}
+
+void scoreboard_capture_state(struct scoreboard_saved_state *out)
+{
+	out->state = g_state;
+}
+
+bool scoreboard_save_captured_state(const struct scoreboard_saved_state *in,
+				    const char *path)
+{
+	if (in == NULL || path == NULL)
+		return false;
+	return save_state_slots(&in->state, path);
+}
+
+/* label_count is how many labels the file holds, once its count row
+   has been loaded */
+static void load_state_field(const struct json_index *json,
+			     const struct state_field_desc *desc,
+			     int *label_count)
+{
+	char *value = (char *)&g_state + desc->offset;
+	switch (desc->type) {
+	case STATE_INT:
+		*(int *)value = parse_json_int(json, desc->key, *(int *)value);
+		break;
+	case STATE_BOOL:
+		*(bool *)value =
+			parse_json_bool(json, desc->key, *(bool *)value);
+		break;
+	case STATE_SPORT: {
+		char name[32];
+		parse_json_string(json, desc->key, name, sizeof(name));
+		if (name[0] != '\0')
+			scoreboard_set_sport(scoreboard_sport_from_name(name));
+		break;
+	}
+	case STATE_LABEL_COUNT: {
+		/* Without a count the sport's labels stay */
+		int count = parse_json_int(json, desc->key, -1);
+		if (count > SCOREBOARD_MAX_PERIOD_LABELS)
+			count = SCOREBOARD_MAX_PERIOD_LABELS;
+		if (count > 0)
+			g_state.period_label_count = count;
+		*label_count = count;
+		break;
+	}
+	case STATE_LABEL:
+		if (desc->index >= *label_count)
+			break;
+		/* fall through */
+	case STATE_TEXT:
+		parse_json_string(json, desc->key, value, desc->size);
+		break;
+	}
+}
+
+bool scoreboard_load_state(const char *path)
+{
+	if (path == NULL)
+		return false;
+	/* A file written whole by something else is read as it is */
+	char *text;
+	unsigned long long generation;
+	if (newest_state_slot(path, &text, &generation) < 0)
+		text = read_whole_file(path);
+	if (text == NULL)
+		return false;
+	struct json_index index;
+	json_index_build(&index, text);
+	const struct json_index *json = &index;
+
+	/* Sport first: set_sport() applies preset defaults for direction,
+	   period_length, etc., which the other rows override */
+	int label_count = 0;
+	for (int i = 0; i < STATE_FIELD_COUNT; i++) {
+		if (k_state_fields[i].type == STATE_SPORT)
+			load_state_field(json, &k_state_fields[i],
+					 &label_count);
+	}
+	for (int i = 0; i < STATE_FIELD_COUNT; i++) {
+		if (k_state_fields[i].type != STATE_SPORT)
+			load_state_field(json, &k_state_fields[i],
+					 &label_count);
+	}
+	if (g_state.clock_running)
+		anchor_clock();
+
+	free(text);
+	mark_dirty(SCOREBOARD_FIELDS_ALL | DIRTY_STATE);
+	return true;
+}
+
+/* ---- binary state snapshot ---- */
+
+/* Host byte order, fixed-width fields and 8-byte aligned sections at fixed
+   offsets, so loading is a checksum and a copy out of the mapped file.
+   Readers take sections by table entry and accept sections larger than
+   they know, so later versions can append fields and whole sections. */
+#define STATE_BINARY_MAGIC "SBSTATE"
+#define STATE_BINARY_VERSION 1
+#define STATE_BINARY_BYTE_ORDER 0x01020304u
+
+enum state_binary_section {
+	STATE_SECTION_GAME,
+	STATE_SECTION_NAMES,
+	STATE_SECTION_PENALTIES,
+	STATE_SECTION_PERIOD_LABELS,
+	STATE_SECTION_COUNT
+};
+
+struct state_binary_entry {
+	uint32_t offset;
+	uint32_t size;
+};
+
+struct state_binary_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint32_t file_size;
+	/* CRC-32 of everything after the header */
+	uint32_t crc;
+	uint32_t section_count;
+	uint32_t reserved;
+	struct state_binary_entry sections[STATE_SECTION_COUNT];
+};
+
+struct state_binary_game {
+	int32_t sport;
+	int32_t clock_tenths;
+	int32_t clock_running;
+	int32_t clock_direction;
+	int32_t period_length;
+	int32_t period;
+	int32_t overtime_enabled;
+	int32_t home_score;
+	int32_t away_score;
+	int32_t home_shots;
+	int32_t away_shots;
+	int32_t home_faceoffs;
+	int32_t away_faceoffs;
+	int32_t home_fouls;
+	int32_t away_fouls;
+	int32_t home_fouls2;
+	int32_t away_fouls2;
+	int32_t reserved;
+};
+
+struct state_binary_names {
+	char home[72];
+	char away[72];
+};
+
+struct state_binary_penalty {
+	int32_t player_number;
+	int32_t remaining_tenths;
+	int32_t phase2_tenths;
+	int32_t active;
+};
+
+struct state_binary_penalties {
+	struct state_binary_penalty home[SCOREBOARD_PENALTY_SLOTS];
+	struct state_binary_penalty away[SCOREBOARD_PENALTY_SLOTS];
+};
+
+struct state_binary_period_labels {
+	int32_t count;
+	int32_t reserved;
+	char labels[SCOREBOARD_MAX_PERIOD_LABELS][SCOREBOARD_PERIOD_LABEL_SIZE];
+};
+
+/* The file as this version writes it; every member is a multiple of 8
+   bytes, so there is no padding between sections */
+struct state_binary_file {
+	struct state_binary_header header;
+	struct state_binary_game game;
+	struct state_binary_names names;
+	struct state_binary_penalties penalties;
+	struct state_binary_period_labels period_labels;
+};
+
+/* CRC-32 (IEEE), a nibble at a time */
+static uint32_t crc32_update(uint32_t crc, const void *data, size_t size)
+{
+	static const uint32_t k_table[16] = {
+		0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+		0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+		0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+		0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+	};
+	const unsigned char *p = (const unsigned char *)data;
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++) {
+		crc = k_table[(crc ^ p[i]) & 0x0f] ^ (crc >> 4);
+		crc = k_table[(crc ^ (p[i] >> 4)) & 0x0f] ^ (crc >> 4);
+	}
+	return ~crc;
+}
 
-	scoreboard_clock_format(buf, sizeof(buf));
-	ok = write_text_file(dir, "clock.txt", buf) && ok;
+static void copy_penalty_out(struct state_binary_penalty *dst,
+			     const struct scoreboard_penalty *src)
+{
+	dst->player_number = src->player_number;
+	dst->remaining_tenths = src->remaining_tenths;
+	dst->phase2_tenths = src->phase2_tenths;
+	dst->active = src->active ? 1 : 0;
+}
+
+static void copy_penalty_in(struct scoreboard_penalty *dst,
+			    const struct state_binary_penalty *src)
+{
+	dst->player_number = src->player_number;
+	dst->remaining_tenths = src->remaining_tenths;
+	dst->phase2_tenths = src->phase2_tenths;
+	dst->active = src->active != 0;
+}
+
+/* Copies a fixed-size text field that may lack its terminator */
+static void copy_fixed_text(char *dst, size_t dst_size, const char *src,
+			    size_t src_size)
+{
+	size_t len = 0;
+	while (len < src_size && len < dst_size - 1 && src[len] != '\0')
+		len++;
+	memcpy(dst, src, len);
+	dst[len] = '\0';
+}
+
+/* Fills in everything but the checksum */
+static void state_binary_capture(struct state_binary_file *file)
+{
+	memset(file, 0, sizeof(*file));
+
+	struct state_binary_header *h = &file->header;
+	memcpy(h->magic, STATE_BINARY_MAGIC, sizeof(STATE_BINARY_MAGIC));
+	h->version = STATE_BINARY_VERSION;
+	h->byte_order = STATE_BINARY_BYTE_ORDER;
+	h->file_size = (uint32_t)sizeof(*file);
+	h->section_count = STATE_SECTION_COUNT;
+	h->sections[STATE_SECTION_GAME].offset =
+		(uint32_t)offsetof(struct state_binary_file, game);
+	h->sections[STATE_SECTION_GAME].size = (uint32_t)sizeof(file->game);
+	h->sections[STATE_SECTION_NAMES].offset =
+		(uint32_t)offsetof(struct state_binary_file, names);
+	h->sections[STATE_SECTION_NAMES].size = (uint32_t)sizeof(file->names);
+	h->sections[STATE_SECTION_PENALTIES].offset =
+		(uint32_t)offsetof(struct state_binary_file, penalties);
+	h->sections[STATE_SECTION_PENALTIES].size =
+		(uint32_t)sizeof(file->penalties);
+	h->sections[STATE_SECTION_PERIOD_LABELS].offset =
+		(uint32_t)offsetof(struct state_binary_file, period_labels);
+	h->sections[STATE_SECTION_PERIOD_LABELS].size =
+		(uint32_t)sizeof(file->period_labels);
+
+	struct state_binary_game *g = &file->game;
+	g->sport = (int32_t)g_state.sport;
+	g->clock_tenths = g_state.clock_tenths;
+	g->clock_running = g_state.clock_running ? 1 : 0;
+	g->clock_direction = (int32_t)g_state.clock_direction;
+	g->period_length = g_state.period_length;
+	g->period = g_state.period;
+	g->overtime_enabled = g_state.overtime_enabled ? 1 : 0;
+	g->home_score = g_state.home_score;
+	g->away_score = g_state.away_score;
+	g->home_shots = g_state.home_shots;
+	g->away_shots = g_state.away_shots;
+	g->home_faceoffs = g_state.home_faceoffs;
+	g->away_faceoffs = g_state.away_faceoffs;
+	g->home_fouls = g_state.home_fouls;
+	g->away_fouls = g_state.away_fouls;
+	g->home_fouls2 = g_state.home_fouls2;
+	g->away_fouls2 = g_state.away_fouls2;
+
+	snprintf(file->names.home, sizeof(file->names.home), "%s",
+		 g_state.home_name);
+	snprintf(file->names.away, sizeof(file->names.away), "%s",
+		 g_state.away_name);
+
+	for (int i = 0; i < SCOREBOARD_PENALTY_SLOTS; i++) {
+		copy_penalty_out(&file->penalties.home[i],
+				 &g_state.home_penalties[i]);
+		copy_penalty_out(&file->penalties.away[i],
+				 &g_state.away_penalties[i]);
+	}
+
+	file->period_labels.count = g_state.period_label_count;
+	memcpy(file->period_labels.labels, g_state.period_labels,
+	       sizeof(file->period_labels.labels));
+
+}
+
+static uint32_t state_binary_crc(const struct state_binary_file *file)
+{
+	return crc32_update(0, (const char *)file + sizeof(file->header),
+			    sizeof(*file) - sizeof(file->header));
+}
+
+bool scoreboard_save_state_binary(const char *path)
+{
+	static struct state_binary_file file;
+	if (path == NULL)
+		return false;
+	state_binary_capture(&file);
+	file.header.crc = state_binary_crc(&file);
+	return scoreboard_replace_file_data(path, &file, sizeof(file));
+}
+
+/* Returns the section if the table entry lies inside the file and holds
+   at least what this version reads */
+static const void *state_binary_section(const struct scoreboard_file_map *map,
+					enum state_binary_section section,
+					size_t min_size)
+{
+	const struct state_binary_header *h =
+		(const struct state_binary_header *)map->data;
+	const struct state_binary_entry *e = &h->sections[section];
+	if (e->offset % 8 != 0 || e->offset < sizeof(*h) ||
+	    e->size < min_size || e->offset > map->size ||
+	    e->size > map->size - e->offset)
+		return NULL;
+	return (const char *)map->data + e->offset;
+}
 
-	scoreboard_format_period(buf, sizeof(buf));
-	ok = write_text_file(dir, "period.txt", buf) && ok;
+static bool state_binary_valid(const struct scoreboard_file_map *map)
+{
+	const struct state_binary_header *h =
+		(const struct state_binary_header *)map->data;
+	if (map->size < sizeof(*h) ||
+	    memcmp(h->magic, STATE_BINARY_MAGIC, sizeof(h->magic)) != 0 ||
+	    h->version != STATE_BINARY_VERSION ||
+	    h->byte_order != STATE_BINARY_BYTE_ORDER ||
+	    h->file_size != map->size ||
+	    h->section_count < STATE_SECTION_COUNT)
+		return false;
+	return crc32_update(0, (const char *)map->data + sizeof(*h),
+			    map->size - sizeof(*h)) == h->crc;
+}
 
-	ok = write_text_file(dir, "home_name.txt", g_state.home_name) && ok;
-	ok = write_text_file(dir, "away_name.txt", g_state.away_name) && ok;
+static void state_binary_apply(const struct state_binary_game *g,
+			       const struct state_binary_names *names,
+			       const struct state_binary_penalties *penalties,
+			       const struct state_binary_period_labels *labels)
+{
+	/* Sport first, as in scoreboard_load_state(): the preset defaults
+	   it applies are then overridden by the saved fields */
+	scoreboard_set_sport((enum scoreboard_sport)g->sport);
+	g_state.clock_tenths = g->clock_tenths;
+	g_state.clock_running = g->clock_running != 0;
+	if (g_state.clock_running)
+		anchor_clock();
+	g_state.clock_direction =
+		(enum scoreboard_clock_direction)g->clock_direction;
+	g_state.period_length = g->period_length;
+	g_state.period = g->period;
+	g_state.overtime_enabled = g->overtime_enabled != 0;
+	g_state.home_score = g->home_score;
+	g_state.away_score = g->away_score;
+	g_state.home_shots = g->home_shots;
+	g_state.away_shots = g->away_shots;
+	g_state.home_faceoffs = g->home_faceoffs;
+	g_state.away_faceoffs = g->away_faceoffs;
+	g_state.home_fouls = g->home_fouls;
+	g_state.away_fouls = g->away_fouls;
+	g_state.home_fouls2 = g->home_fouls2;
+	g_state.away_fouls2 = g->away_fouls2;
+
+	copy_fixed_text(g_state.home_name, sizeof(g_state.home_name),
+			names->home, sizeof(names->home));
+	copy_fixed_text(g_state.away_name, sizeof(g_state.away_name),
+			names->away, sizeof(names->away));
 
-	snprintf(buf, sizeof(buf), "%d", g_state.home_score);
-	ok = write_text_file(dir, "home_score.txt", buf) && ok;
+	for (int i = 0; i < SCOREBOARD_PENALTY_SLOTS; i++) {
+		copy_penalty_in(&g_state.home_penalties[i],
+				&penalties->home[i]);
+		copy_penalty_in(&g_state.away_penalties[i],
+				&penalties->away[i]);
+	}
 
-	snprintf(buf, sizeof(buf), "%d", g_state.away_score);
-	ok = write_text_file(dir, "away_score.txt", buf) && ok;
+	if (labels->count > 0) {
+		int count = labels->count;
+		if (count > SCOREBOARD_MAX_PERIOD_LABELS)
+			count = SCOREBOARD_MAX_PERIOD_LABELS;
+		g_state.period_label_count = count;
+		for (int i = 0; i < count; i++)
+			copy_fixed_text(g_state.period_labels[i],
+					SCOREBOARD_PERIOD_LABEL_SIZE,
+					labels->labels[i],
+					SCOREBOARD_PERIOD_LABEL_SIZE);
+	}
 
-	snprintf(buf, sizeof(buf), "%d", g_state.home_shots);
-	ok = write_text_file(dir, "home_shots.txt", buf) && ok;
+	mark_dirty(SCOREBOARD_FIELDS_ALL | DIRTY_STATE);
+}
 
-	snprintf(buf, sizeof(buf), "%d", g_state.away_shots);
-	ok = write_text_file(dir, "away_shots.txt", buf) && ok;
+bool scoreboard_load_state_binary(const char *path)
+{
+	if (path == NULL)
+		return false;
+	struct scoreboard_file_map map;
+	if (!scoreboard_map_file(path, &map))
+		return false;
+
+	const struct state_binary_game *g = NULL;
+	const struct state_binary_names *names = NULL;
+	const struct state_binary_penalties *penalties = NULL;
+	const struct state_binary_period_labels *labels = NULL;
+	if (state_binary_valid(&map)) {
+		g = state_binary_section(&map, STATE_SECTION_GAME, sizeof(*g));
+		names = state_binary_section(&map, STATE_SECTION_NAMES,
+					     sizeof(*names));
+		penalties = state_binary_section(&map, STATE_SECTION_PENALTIES,
+						 sizeof(*penalties));
+		labels = state_binary_section(&map, STATE_SECTION_PERIOD_LABELS,
+					      sizeof(*labels));
+	}
+	bool ok = g != NULL && names != NULL && penalties != NULL &&
+		  labels != NULL;
+	if (ok)
+		state_binary_apply(g, names, penalties, labels);
+	scoreboard_unmap_file(&map);
+	return ok;
+}
 
-	snprintf(buf, sizeof(buf), "%d", g_state.home_faceoffs);
-	ok = write_text_file(dir, "home_faceoffs.txt", buf) && ok;
+/* Converts by loading into the live state and saving from it, then puts
+   the live state back untouched */
+static bool convert_state_file(const char *src, const char *dst,
+			       bool (*load)(const char *),
+			       bool (*save)(const char *))
+{
+	static struct core_state saved;
+	if (src == NULL || dst == NULL)
+		return false;
+	saved = g_state;
+	unsigned int saved_dirty = g_dirty;
+	bool ok = load(src) && save(dst);
+	g_state = saved;
+	g_dirty = saved_dirty;
+	return ok;
+}
 
-	snprintf(buf, sizeof(buf), "%d", g_state.away_faceoffs);
-	ok = write_text_file(dir, "away_faceoffs.txt", buf) && ok;
+bool scoreboard_convert_state_to_binary(const char *json_path,
+					const char *binary_path)
+{
+	return convert_state_file(json_path, binary_path,
+				  scoreboard_load_state,
+				  scoreboard_save_state_binary);
+}
+
+bool scoreboard_convert_state_to_json(const char *binary_path,
+				      const char *json_path)
+{
+	return convert_state_file(binary_path, json_path,
+				  scoreboard_load_state_binary,
+				  scoreboard_save_state);
+}
+
+/* ---- state journal ---- */
+
+/* The journal replays onto the binary snapshot it was started after. Its
+   first record names that snapshot by checksum; every later record sets
+   one 32-bit word of the snapshot payload. Replay stops at the first torn,
+   corrupt or out-of-sequence record. A clean close ends the journal with
+   a record that sets nothing, and a journal ending that way is not
+   replayed at all. */
+#define JOURNAL_CHECKPOINT_RECORDS 4096
+#define JOURNAL_HEAD_OFFSET 0xffffffffu
+#define JOURNAL_CLEAN_OFFSET 0xfffffffeu
+
+struct journal_record {
+	uint32_t seq;
+	uint32_t offset;
+	uint32_t value;
+	/* CRC-32 of the fields above */
+	uint32_t crc;
+};
+
+static struct {
+	FILE *file;
+	/* The context the journal was opened in; it follows that game
+	   whichever context is selected */
+	struct scoreboard_ctx *ctx;
+	char snapshot_path[SCOREBOARD_MAX_PATH];
+	char journal_path[SCOREBOARD_MAX_PATH];
+	/* The state as of the last record written */
+	struct state_binary_file image;
+	uint32_t seq;
+	uint32_t records;
+	enum scoreboard_journal_recovery recovery;
+} g_journal;
+
+static uint32_t journal_record_crc(const struct journal_record *r)
+{
+	return crc32_update(0, r, offsetof(struct journal_record, crc));
+}
+
+static bool journal_append(uint32_t offset, uint32_t value)
+{
+	struct journal_record r;
+	r.seq = g_journal.seq++;
+	r.offset = offset;
+	r.value = value;
+	r.crc = journal_record_crc(&r);
+	g_journal.records++;
+	return fwrite(&r, sizeof(r), 1, g_journal.file) == 1;
+}
+
+/* Snapshots the live state and starts an empty journal after it */
+static bool journal_restart(void)
+{
+	static struct state_binary_file next;
+	struct scoreboard_ctx *previous = context_enter(g_journal.ctx);
+	state_binary_capture(&next);
+	context_leave(previous);
+	next.header.crc = state_binary_crc(&next);
+	/* Until the new snapshot is in place the old journal still
+	   replays onto the old one */
+	if (!scoreboard_replace_file_data(g_journal.snapshot_path, &next,
+					  sizeof(next)))
+		return false;
+
+	g_journal.image = next;
+	g_journal.seq = 0;
+	g_journal.records = 0;
+	if (g_journal.file != NULL)
+		fclose(g_journal.file);
+	g_journal.file = fopen(g_journal.journal_path, "wb");
+	if (g_journal.file == NULL)
+		return false;
+	bool ok = journal_append(JOURNAL_HEAD_OFFSET, next.header.crc);
+	return fflush(g_journal.file) == 0 && ok;
+}
+
+bool scoreboard_journal_checkpoint(void)
+{
+	if (g_journal.file == NULL)
+		return false;
+	return journal_restart();
+}
+
+bool scoreboard_journal_sync(void)
+{
+	static struct state_binary_file now;
+	if (g_journal.file == NULL)
+		return false;
+	struct scoreboard_ctx *previous = context_enter(g_journal.ctx);
+	state_binary_capture(&now);
+	context_leave(previous);
+
+	bool ok = true;
+	unsigned char *old = (unsigned char *)&g_journal.image;
+	const unsigned char *cur = (const unsigned char *)&now;
+	uint32_t appended = 0;
+	for (size_t off = sizeof(now.header); off < sizeof(now); off += 4) {
+		if (memcmp(old + off, cur + off, 4) == 0)
+			continue;
+		uint32_t value;
+		memcpy(&value, cur + off, 4);
+		memcpy(old + off, &value, 4);
+		ok = journal_append((uint32_t)off, value) && ok;
+		appended++;
+	}
+	if (appended == 0)
+		return true;
+	ok = fflush(g_journal.file) == 0 && ok;
+	if (g_journal.records >= JOURNAL_CHECKPOINT_RECORDS)
+		ok = scoreboard_journal_checkpoint() && ok;
+	return ok;
+}
+
+/* Replays snapshot plus journal into the live state after a crash,
+   counting the journal records applied into *applied */
+static enum scoreboard_journal_recovery journal_recover(int *applied)
+{
+	struct state_binary_file *image = &g_journal.image;
+	struct scoreboard_file_map map;
+	*applied = 0;
+	if (!scoreboard_map_file(g_journal.snapshot_path, &map))
+		return SCOREBOARD_JOURNAL_EMPTY;
+	bool usable = state_binary_valid(&map) && map.size == sizeof(*image);
+	if (usable)
+		memcpy(image, map.data, sizeof(*image));
+	scoreboard_unmap_file(&map);
+	if (!usable)
+		return SCOREBOARD_JOURNAL_EMPTY;
+
+	bool clean = false;
+	FILE *f = fopen(g_journal.journal_path, "rb");
+	if (f != NULL) {
+		struct journal_record r;
+		uint32_t seq = 0;
+		unsigned char *words = (unsigned char *)image;
+		while (fread(&r, sizeof(r), 1, f) == 1) {
+			if (r.seq != seq++ || r.crc != journal_record_crc(&r))
+				break;
+			clean = r.offset == JOURNAL_CLEAN_OFFSET;
+			if (clean)
+				break;
+			if (r.seq == 0) {
+				/* A journal left over from an older
+				   snapshot must not replay onto this one */
+				if (r.offset != JOURNAL_HEAD_OFFSET ||
+				    r.value != image->header.crc)
+					break;
+				continue;
+			}
+			if (r.offset < sizeof(image->header) ||
+			    r.offset % 4 != 0 ||
+			    r.offset > sizeof(*image) - 4)
+				break;
+			memcpy(words + r.offset, &r.value, 4);
+			(*applied)++;
+		}
+		fclose(f);
+	}
+	/* The output files were written at the same close, and may have
+	   been edited since */
+	if (clean)
+		return SCOREBOARD_JOURNAL_CLEAN;
+
+	state_binary_apply(&image->game, &image->names, &image->penalties,
+			   &image->period_labels);
+	/* A clock left running by the crash would start counting the
+	   moment OBS comes back */
+	g_state.clock_running = false;
+	return SCOREBOARD_JOURNAL_RECOVERED;
+}
+
+bool scoreboard_journal_open(const char *snapshot_path,
+			     const char *journal_path)
+{
+	g_journal.recovery = SCOREBOARD_JOURNAL_EMPTY;
+	if (snapshot_path == NULL || snapshot_path[0] == '\0' ||
+	    journal_path == NULL || journal_path[0] == '\0')
+		return false;
+	scoreboard_journal_close();
+	g_journal.ctx = g_ctx;
+	safe_copy(g_journal.snapshot_path, snapshot_path,
+		  sizeof(g_journal.snapshot_path));
+	safe_copy(g_journal.journal_path, journal_path,
+		  sizeof(g_journal.journal_path));
+
+	int applied;
+	g_journal.recovery = journal_recover(&applied);
+	if (g_journal.recovery == SCOREBOARD_JOURNAL_RECOVERED) {
+		char msg[128];
+		snprintf(msg, sizeof(msg),
+			 "[streamn-obs-scoreboard] recovered state from "
+			 "snapshot and %d journal records",
+			 applied);
+		log_message(SCOREBOARD_LOG_INFO, msg);
+	}
+
+	/* Start over from a snapshot of what was just recovered */
+	if (journal_restart())
+		return true;
+	scoreboard_journal_close();
+	return false;
+}
+
+void scoreboard_journal_close(void)
+{
+	if (g_journal.file == NULL)
+		return;
+	if (scoreboard_journal_checkpoint())
+		journal_append(JOURNAL_CLEAN_OFFSET, 0);
+	if (g_journal.file != NULL)
+		fclose(g_journal.file);
+	g_journal.file = NULL;
+}
+
+bool scoreboard_journal_is_open(void)
+{
+	return g_journal.file != NULL;
+}
 
-	snprintf(buf, sizeof(buf), "%d", g_state.home_fouls);
-	ok = write_text_file(dir, "home_fouls.txt", buf) && ok;
+enum scoreboard_journal_recovery scoreboard_journal_get_recovery(void)
+{
+	return g_journal.recovery;
+}
 
-	snprintf(buf, sizeof(buf), "%d", g_state.away_fouls);
-	ok = write_text_file(dir, "away_fouls.txt", buf) && ok;
+/* Other contexts' writes have nothing for this journal */
+static void journal_sync_current(void)
+{
+	if (g_journal.ctx == g_ctx)
+		scoreboard_journal_sync();
+}
 
-	snprintf(buf, sizeof(buf), "%d", g_state.home_fouls2);
-	ok = write_text_file(dir, "home_fouls2.txt", buf) && ok;
+static void journal_release(struct scoreboard_ctx *ctx)
+{
+	if (g_journal.ctx == ctx)
+		scoreboard_journal_close();
+}
 
-	snprintf(buf, sizeof(buf), "%d", g_state.away_fouls2);
-	ok = write_text_file(dir, "away_fouls2.txt", buf) && ok;
+/* ---- command trace ---- */
 
-	char pen_buf[512];
+/* A trace is a header, the image of the game when recording started, then
+   fixed-size records stamped with nanoseconds since the start. Each
+   drained command is one record. Any other change to the game (a button,
+   a dialog, a reload, whatever a USER command's callback did) is recorded
+   as the image words it changed, once it reaches the output files or the
+   next command. Stopping appends an end record holding the CRC-32 of the
+   JSON output snapshot, which a replay must reproduce. */
+#define TRACE_MAGIC "SBTRACE"
+#define TRACE_VERSION 2
+#define TRACE_END_TYPE (-1)
+/* a = offset of the word in the image, b = its new value */
+#define TRACE_STATE_TYPE (-2)
 
-	scoreboard_format_all_penalty_numbers(true, pen_buf, sizeof(pen_buf));
-	ok = write_text_file(dir, "home_penalty_numbers.txt", pen_buf) && ok;
+struct trace_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint32_t record_size;
+	/* CRC-32 of the image's settings; its state carries its own */
+	uint32_t settings_crc;
+};
 
-	scoreboard_format_all_penalty_times(true, pen_buf, sizeof(pen_buf));
-	ok = write_text_file(dir, "home_penalty_times.txt", pen_buf) && ok;
+/* Output fields the binary state leaves out */
+struct trace_settings {
+	int32_t default_penalty_duration;
+	int32_t default_major_penalty_duration;
+};
 
-	scoreboard_format_all_penalty_numbers(false, pen_buf, sizeof(pen_buf));
-	ok = write_text_file(dir, "away_penalty_numbers.txt", pen_buf) && ok;
+struct trace_image {
+	struct state_binary_file state;
+	struct trace_settings settings;
+};
 
-	scoreboard_format_all_penalty_times(false, pen_buf, sizeof(pen_buf));
-	ok = write_text_file(dir, "away_penalty_times.txt", pen_buf) && ok;
+struct trace_record {
+	uint64_t t_ns;
+	struct scoreboard_command cmd;
+};
 
-	ok = write_text_file(dir, "sport.txt",
-			     scoreboard_sport_name(g_state.sport)) &&
-	     ok;
+static struct {
+	FILE *file;
+	struct scoreboard_ctx *ctx;
+	uint64_t start_ns;
+	uint32_t commands;
+	/* The game as replaying the trace so far would leave it */
+	struct trace_image image;
+} g_trace;
+
+static uint32_t output_snapshot_crc(void)
+{
+	char snapshot[SCOREBOARD_SNAPSHOT_SIZE];
+	size_t len = scoreboard_format_output_snapshot(SCOREBOARD_OUTPUT_JSON,
+						       snapshot,
+						       sizeof(snapshot));
+	return crc32_update(0, snapshot, len);
+}
+
+static void trace_image_capture(struct trace_image *image)
+{
+	state_binary_capture(&image->state);
+	image->state.header.crc = state_binary_crc(&image->state);
+	image->settings.default_penalty_duration =
+		g_state.default_penalty_duration;
+	image->settings.default_major_penalty_duration =
+		g_state.default_major_penalty_duration;
+}
+
+/* A clock that keeps running keeps counting from where it started:
+   anchoring it again at the record's time would drop the part of a tenth
+   it had already run */
+static void trace_image_apply(const struct trace_image *image)
+{
+	const struct state_binary_file *s = &image->state;
+	bool running = g_state.clock_running;
+	uint64_t started_ns = g_state.clock_started_ns;
+	int64_t synced_tenths = g_state.clock_synced_tenths;
+	state_binary_apply(&s->game, &s->names, &s->penalties,
+			   &s->period_labels);
+	if (running && g_state.clock_running) {
+		g_state.clock_started_ns = started_ns;
+		g_state.clock_synced_tenths = synced_tenths;
+	}
+	g_state.default_penalty_duration =
+		image->settings.default_penalty_duration;
+	g_state.default_major_penalty_duration =
+		image->settings.default_major_penalty_duration;
+}
 
-	snprintf(buf, sizeof(buf), "%d",
-		 g_state.default_penalty_duration);
-	ok = write_text_file(dir, "default_penalty_duration.txt", buf) && ok;
+/* Each record is flushed, so a crash loses no more than the one being
+   written */
+static bool trace_append(int32_t type, int32_t a, int32_t b, int32_t c)
+{
+	struct trace_record r;
+	r.t_ns = now_ns() - g_trace.start_ns;
+	r.cmd.type = type;
+	r.cmd.a = a;
+	r.cmd.b = b;
+	r.cmd.c = c;
+	return fwrite(&r, sizeof(r), 1, g_trace.file) == 1 &&
+	       fflush(g_trace.file) == 0;
+}
 
-	snprintf(buf, sizeof(buf), "%d",
-		 g_state.default_major_penalty_duration);
-	ok = write_text_file(dir, "default_major_penalty_duration.txt", buf) &&
-	     ok;
+/* Records the image words changed since the trace last caught up */
+static bool trace_sync(void)
+{
+	static struct trace_image now;
+	if (g_trace.file == NULL || !g_trace_touched)
+		return true;
+	struct scoreboard_ctx *previous = context_enter(g_trace.ctx);
+	/* The replayed clock will have run up to this time too */
+	scoreboard_clock_sync();
+	trace_image_capture(&now);
+	context_leave(previous);
+	g_trace_touched = false;
 
-	{
-		char labels_buf[512];
-		scoreboard_get_period_labels(labels_buf, sizeof(labels_buf));
-		ok = write_text_file(dir, "period_labels.txt", labels_buf) &&
+	bool ok = true;
+	unsigned char *old = (unsigned char *)&g_trace.image;
+	const unsigned char *cur = (const unsigned char *)&now;
+	for (size_t off = sizeof(now.state.header); off < sizeof(now);
+	     off += 4) {
+		if (memcmp(old + off, cur + off, 4) == 0)
+			continue;
+		int32_t value;
+		memcpy(&value, cur + off, 4);
+		memcpy(old + off, &value, 4);
+		ok = trace_append(TRACE_STATE_TYPE, (int32_t)off, value, 0) &&
 		     ok;
 	}
-
-	g_dirty = false;
 	return ok;
 }
 
-bool scoreboard_read_all_files(void)
+/* Other contexts' changes have nothing for this trace */
+static void trace_sync_current(void)
 {
-	const char *dir = g_state.output_directory;
-	if (dir[0] == '\0')
-		return false;
+	if (g_trace.ctx == g_ctx)
+		trace_sync();
+}
 
-	char buf[512];
-	bool ok = true;
+bool scoreboard_trace_start(const char *path)
+{
+	if (path == NULL || path[0] == '\0')
+		return false;
+	scoreboard_trace_stop();
+	g_trace.file = fopen(path, "wb");
+	if (g_trace.file == NULL)
+		return false;
 
-	if (read_text_file(dir, "clock.txt", buf, sizeof(buf))) {
-		int tenths = parse_clock_text(buf);
-		if (tenths >= 0)
-			g_state.clock_tenths = tenths;
-	} else {
-		ok = false;
+	/* Start at the last whole tenth the running clock has applied, so
+	   the replayed clock counts from the same point */
+	scoreboard_clock_sync();
+	g_trace.start_ns = now_ns();
+	if (g_state.clock_running)
+		g_trace.start_ns = g_state.clock_started_ns +
+				   (uint64_t)(g_state.clock_synced_tenths *
+					      NS_PER_TENTH);
+	g_trace.ctx = g_ctx;
+	g_trace.commands = 0;
+	trace_image_capture(&g_trace.image);
+	g_trace_touched = false;
+
+	struct trace_header h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+	h.version = TRACE_VERSION;
+	h.byte_order = STATE_BINARY_BYTE_ORDER;
+	h.record_size = (uint32_t)sizeof(struct trace_record);
+	h.settings_crc = crc32_update(0, &g_trace.image.settings,
+				      sizeof(g_trace.image.settings));
+	bool ok = fwrite(&h, sizeof(h), 1, g_trace.file) == 1 &&
+		  fwrite(&g_trace.image, sizeof(g_trace.image), 1,
+			 g_trace.file) == 1 &&
+		  fflush(g_trace.file) == 0;
+	if (!ok) {
+		fclose(g_trace.file);
+		g_trace.file = NULL;
+		g_trace.ctx = NULL;
 	}
+	return ok;
+}
 
-	if (read_text_file(dir, "period.txt", buf, sizeof(buf))) {
-		int p = parse_period_text(buf);
-		if (p > 0)
-			scoreboard_set_period(p);
-	} else {
-		ok = false;
-	}
+void scoreboard_trace_record(const struct scoreboard_command *cmd)
+{
+	if (g_trace.file == NULL || g_ctx != g_trace.ctx || cmd == NULL)
+		return;
+	/* Whatever changed the game before the command comes first */
+	trace_sync();
+	trace_append(cmd->type, cmd->a, cmd->b, cmd->c);
+	g_trace.commands++;
+}
 
-	if (read_text_file(dir, "home_name.txt", buf, sizeof(buf)))
-		scoreboard_set_home_name(buf);
-	else
-		ok = false;
+void scoreboard_trace_record_applied(void)
+{
+	if (g_trace.file == NULL || g_ctx != g_trace.ctx)
+		return;
+	trace_image_capture(&g_trace.image);
+	g_trace_touched = false;
+}
 
-	if (read_text_file(dir, "away_name.txt", buf, sizeof(buf)))
-		scoreboard_set_away_name(buf);
-	else
-		ok = false;
+bool scoreboard_trace_stop(void)
+{
+	if (g_trace.file == NULL)
+		return false;
+	struct scoreboard_ctx *previous = context_enter(g_trace.ctx);
+	bool ok = trace_sync();
+	scoreboard_clock_sync();
+	ok = trace_append(TRACE_END_TYPE, (int32_t)output_snapshot_crc(),
+			  (int32_t)g_trace.commands, 0) &&
+	     ok;
+	context_leave(previous);
+	ok = fclose(g_trace.file) == 0 && ok;
+	g_trace.file = NULL;
+	g_trace.ctx = NULL;
+	return ok;
+}
 
-	if (read_text_file(dir, "home_score.txt", buf, sizeof(buf)))
-		scoreboard_set_home_score(atoi(buf));
-	else
-		ok = false;
+bool scoreboard_trace_is_recording(void)
+{
+	return g_trace.file != NULL;
+}
 
-	if (read_text_file(dir, "away_score.txt", buf, sizeof(buf)))
-		scoreboard_set_away_score(atoi(buf));
-	else
-		ok = false;
+static void trace_release(struct scoreboard_ctx *ctx)
+{
+	if (g_trace.ctx == ctx)
+		scoreboard_trace_stop();
+}
 
-	if (read_text_file(dir, "home_shots.txt", buf, sizeof(buf)))
-		scoreboard_set_home_shots(atoi(buf));
-	else
-		ok = false;
+static uint64_t g_replay_now_ns;
 
-	if (read_text_file(dir, "away_shots.txt", buf, sizeof(buf)))
-		scoreboard_set_away_shots(atoi(buf));
-	else
-		ok = false;
-
-	/* Faceoff files are optional — missing doesn't fail the read */
-	if (read_text_file(dir, "home_faceoffs.txt", buf, sizeof(buf)))
-		scoreboard_set_home_faceoffs(atoi(buf));
-	if (read_text_file(dir, "away_faceoffs.txt", buf, sizeof(buf)))
-		scoreboard_set_away_faceoffs(atoi(buf));
-
-	/* Fouls files are optional — missing doesn't fail the read */
-	if (read_text_file(dir, "home_fouls.txt", buf, sizeof(buf)))
-		scoreboard_set_home_fouls(atoi(buf));
-	if (read_text_file(dir, "away_fouls.txt", buf, sizeof(buf)))
-		scoreboard_set_away_fouls(atoi(buf));
-	if (read_text_file(dir, "home_fouls2.txt", buf, sizeof(buf)))
-		scoreboard_set_home_fouls2(atoi(buf));
-	if (read_text_file(dir, "away_fouls2.txt", buf, sizeof(buf)))
-		scoreboard_set_away_fouls2(atoi(buf));
-
-	char nums_buf[512], times_buf[512];
-	bool hn = read_text_file(dir, "home_penalty_numbers.txt", nums_buf,
-				 sizeof(nums_buf));
-	bool ht = read_text_file(dir, "home_penalty_times.txt", times_buf,
-				 sizeof(times_buf));
-	if (hn && ht)
-		parse_penalty_files(nums_buf, times_buf, true);
-	else if (!hn || !ht)
-		ok = false;
-
-	bool an = read_text_file(dir, "away_penalty_numbers.txt", nums_buf,
-				 sizeof(nums_buf));
-	bool at = read_text_file(dir, "away_penalty_times.txt", times_buf,
-				 sizeof(times_buf));
-	if (an && at)
-		parse_penalty_files(nums_buf, times_buf, false);
-	else if (!an || !at)
-		ok = false;
-
-	/* Sport file is optional — missing doesn't fail the read */
-	if (read_text_file(dir, "sport.txt", buf, sizeof(buf))) {
-		enum scoreboard_sport s = scoreboard_sport_from_name(buf);
-		if (s != g_state.sport)
-			scoreboard_set_sport(s);
-	}
-
-	/* Penalty duration files are optional */
-	if (read_text_file(dir, "default_penalty_duration.txt", buf,
-			   sizeof(buf))) {
-		int val = atoi(buf);
-		if (val > 0)
-			g_state.default_penalty_duration = val;
-	}
-	if (read_text_file(dir, "default_major_penalty_duration.txt", buf,
-			   sizeof(buf))) {
-		int val = atoi(buf);
-		if (val > 0)
-			g_state.default_major_penalty_duration = val;
-	}
-
-	/* Period labels file is optional — overrides sport defaults */
-	if (read_text_file(dir, "period_labels.txt", buf, sizeof(buf)))
-		scoreboard_set_period_labels(buf);
-
-	g_dirty = false;
-	return ok;
+static uint64_t replay_time_ns(void)
+{
+	return g_replay_now_ns;
 }
 
-/* ---- state persistence ---- */
-
-bool scoreboard_save_state(const char *path)
+static bool trace_valid(const struct scoreboard_file_map *map)
 {
-	if (path == NULL)
+	const struct trace_header *h = (const struct trace_header *)map->data;
+	if (map->size < sizeof(*h) + sizeof(struct trace_image) ||
+	    memcmp(h->magic, TRACE_MAGIC, sizeof(h->magic)) != 0 ||
+	    h->version != TRACE_VERSION ||
+	    h->byte_order != STATE_BINARY_BYTE_ORDER ||
+	    h->record_size != sizeof(struct trace_record))
 		return false;
-	FILE *f = fopen(path, "w");
-	if (f == NULL)
+	const char *image = (const char *)map->data + sizeof(*h);
+	if (crc32_update(0, image + offsetof(struct trace_image, settings),
+			 sizeof(struct trace_settings)) != h->settings_crc)
 		return false;
+	struct scoreboard_file_map start;
+	memset(&start, 0, sizeof(start));
+	start.data = image;
+	start.size = sizeof(struct state_binary_file);
+	return state_binary_valid(&start);
+}
 
-	fprintf(f, "{\n");
-	fprintf(f, "  \"clock_tenths\": %d,\n", g_state.clock_tenths);
-	fprintf(f, "  \"clock_running\": %s,\n",
-		g_state.clock_running ? "true" : "false");
-	fprintf(f, "  \"clock_direction\": %d,\n",
-		(int)g_state.clock_direction);
-	fprintf(f, "  \"period_length\": %d,\n", g_state.period_length);
-	fprintf(f, "  \"period\": %d,\n", g_state.period);
-	fprintf(f, "  \"overtime_enabled\": %s,\n",
-		g_state.overtime_enabled ? "true" : "false");
-	write_json_string(f, "home_name", g_state.home_name, false);
-	write_json_string(f, "away_name", g_state.away_name, false);
-	fprintf(f, "  \"home_score\": %d,\n", g_state.home_score);
-	fprintf(f, "  \"away_score\": %d,\n", g_state.away_score);
-	fprintf(f, "  \"home_shots\": %d,\n", g_state.home_shots);
-	fprintf(f, "  \"away_shots\": %d,\n", g_state.away_shots);
-	fprintf(f, "  \"home_faceoffs\": %d,\n", g_state.home_faceoffs);
-	fprintf(f, "  \"away_faceoffs\": %d,\n", g_state.away_faceoffs);
-	fprintf(f, "  \"home_fouls\": %d,\n", g_state.home_fouls);
-	fprintf(f, "  \"away_fouls\": %d,\n", g_state.away_fouls);
-	fprintf(f, "  \"home_fouls2\": %d,\n", g_state.home_fouls2);
-	fprintf(f, "  \"away_fouls2\": %d,\n", g_state.away_fouls2);
-	write_json_string(f, "sport", scoreboard_sport_name(g_state.sport),
-			  false);
-
-	for (int i = 0; i < SCOREBOARD_PENALTY_SLOTS; i++) {
-		fprintf(f, "  \"home_penalty%d_number\": %d,\n", i,
-			g_state.home_penalties[i].player_number);
-		fprintf(f, "  \"home_penalty%d_tenths\": %d,\n", i,
-			g_state.home_penalties[i].remaining_tenths);
-		fprintf(f, "  \"home_penalty%d_active\": %s,\n", i,
-			g_state.home_penalties[i].active ? "true" : "false");
-		fprintf(f, "  \"home_penalty%d_phase2_tenths\": %d,\n", i,
-			g_state.home_penalties[i].phase2_tenths);
-	}
-	for (int i = 0; i < SCOREBOARD_PENALTY_SLOTS; i++) {
-		fprintf(f, "  \"away_penalty%d_number\": %d,\n", i,
-			g_state.away_penalties[i].player_number);
-		fprintf(f, "  \"away_penalty%d_tenths\": %d,\n", i,
-			g_state.away_penalties[i].remaining_tenths);
-		fprintf(f, "  \"away_penalty%d_active\": %s,\n", i,
-			g_state.away_penalties[i].active ? "true" : "false");
-		fprintf(f, "  \"away_penalty%d_phase2_tenths\": %d,\n", i,
-			g_state.away_penalties[i].phase2_tenths);
-	}
-
-	fprintf(f, "  \"period_label_count\": %d",
-		g_state.period_label_count);
-	for (int i = 0; i < g_state.period_label_count; i++) {
-		char key[32];
-		snprintf(key, sizeof(key), "period_label%d", i);
-		fprintf(f, ",\n");
-		bool last = (i == g_state.period_label_count - 1);
-		write_json_string(f, key, g_state.period_labels[i], last);
+/* Moves replay time to t, waiting for the wall clock when paced */
+static void replay_advance(uint64_t t_ns, double speed, uint64_t wall_start)
+{
+	if (speed > 0) {
+		uint64_t due = wall_start + (uint64_t)((double)t_ns / speed);
+		uint64_t now = scoreboard_monotonic_ns();
+		if (due > now)
+			scoreboard_sleep_ns(due - now);
 	}
+	g_replay_now_ns = t_ns;
+	scoreboard_clock_sync();
+}
 
-	fprintf(f, "}\n");
-	fclose(f);
-	return true;
+/* Only whole words past the state header; anything else is damage */
+static void replay_set_word(struct trace_image *image, int32_t offset,
+			    int32_t value)
+{
+	if (offset < (int32_t)sizeof(image->state.header) || offset % 4 != 0 ||
+	    (size_t)offset > sizeof(*image) - 4)
+		return;
+	memcpy((char *)image + offset, &value, 4);
 }
 
-bool scoreboard_load_state(const char *path)
+static void replay_write_outputs(void)
+{
+	if (g_state.output_directory[0] != '\0')
+		scoreboard_write_all_files();
+}
+
+bool scoreboard_trace_replay(const char *path, double speed,
+			     scoreboard_command_fn user_fn, void *data,
+			     struct scoreboard_replay_stats *out)
 {
+	static struct trace_image image;
+	struct scoreboard_replay_stats stats;
+	memset(&stats, 0, sizeof(stats));
+	if (out != NULL)
+		*out = stats;
 	if (path == NULL)
 		return false;
-	FILE *f = fopen(path, "r");
-	if (f == NULL)
+	struct scoreboard_file_map map;
+	if (!scoreboard_map_file(path, &map))
 		return false;
-
-	fseek(f, 0, SEEK_END);
-	long file_size = ftell(f);
-	fseek(f, 0, SEEK_SET);
-
-	if (file_size <= 0 || file_size > 65536) {
-		fclose(f);
+	if (!trace_valid(&map)) {
+		scoreboard_unmap_file(&map);
 		return false;
 	}
 
-	char *json = (char *)malloc((size_t)file_size + 1);
-	size_t read_size = fread(json, 1, (size_t)file_size, f);
-	fclose(f);
-	json[read_size] = '\0';
-
-	/* Load sport first — set_sport() applies preset defaults for
-	   direction, period_length, etc., which explicit fields override. */
-	{
-		char sport_str[32];
-		parse_json_string(json, "sport", sport_str,
-				  sizeof(sport_str));
-		if (sport_str[0] != '\0')
-			scoreboard_set_sport(
-				scoreboard_sport_from_name(sport_str));
-	}
-
-	g_state.clock_tenths =
-		parse_json_int(json, "clock_tenths", g_state.clock_tenths);
-	g_state.clock_running =
-		parse_json_bool(json, "clock_running", g_state.clock_running);
-	g_state.clock_direction = (enum scoreboard_clock_direction)parse_json_int(
-		json, "clock_direction", (int)g_state.clock_direction);
-	g_state.period_length =
-		parse_json_int(json, "period_length", g_state.period_length);
-	g_state.period = parse_json_int(json, "period", g_state.period);
-	g_state.overtime_enabled = parse_json_bool(json, "overtime_enabled",
-						   g_state.overtime_enabled);
-
-	parse_json_string(json, "home_name", g_state.home_name,
-			  sizeof(g_state.home_name));
-	parse_json_string(json, "away_name", g_state.away_name,
-			  sizeof(g_state.away_name));
-
-	g_state.home_score =
-		parse_json_int(json, "home_score", g_state.home_score);
-	g_state.away_score =
-		parse_json_int(json, "away_score", g_state.away_score);
-	g_state.home_shots =
-		parse_json_int(json, "home_shots", g_state.home_shots);
-	g_state.away_shots =
-		parse_json_int(json, "away_shots", g_state.away_shots);
-	g_state.home_faceoffs =
-		parse_json_int(json, "home_faceoffs", g_state.home_faceoffs);
-	g_state.away_faceoffs =
-		parse_json_int(json, "away_faceoffs", g_state.away_faceoffs);
-	g_state.home_fouls =
-		parse_json_int(json, "home_fouls", g_state.home_fouls);
-	g_state.away_fouls =
-		parse_json_int(json, "away_fouls", g_state.away_fouls);
-	g_state.home_fouls2 =
-		parse_json_int(json, "home_fouls2", g_state.home_fouls2);
-	g_state.away_fouls2 =
-		parse_json_int(json, "away_fouls2", g_state.away_fouls2);
-
-	for (int i = 0; i < SCOREBOARD_PENALTY_SLOTS; i++) {
-		char key[64];
-		snprintf(key, sizeof(key), "home_penalty%d_number", i);
-		g_state.home_penalties[i].player_number = parse_json_int(
-			json, key, g_state.home_penalties[i].player_number);
-		snprintf(key, sizeof(key), "home_penalty%d_tenths", i);
-		g_state.home_penalties[i].remaining_tenths = parse_json_int(
-			json, key, g_state.home_penalties[i].remaining_tenths);
-		snprintf(key, sizeof(key), "home_penalty%d_active", i);
-		g_state.home_penalties[i].active = parse_json_bool(
-			json, key, g_state.home_penalties[i].active);
-		snprintf(key, sizeof(key), "home_penalty%d_phase2_tenths", i);
-		g_state.home_penalties[i].phase2_tenths = parse_json_int(
-			json, key, g_state.home_penalties[i].phase2_tenths);
-
-		snprintf(key, sizeof(key), "away_penalty%d_number", i);
-		g_state.away_penalties[i].player_number = parse_json_int(
-			json, key, g_state.away_penalties[i].player_number);
-		snprintf(key, sizeof(key), "away_penalty%d_tenths", i);
-		g_state.away_penalties[i].remaining_tenths = parse_json_int(
-			json, key, g_state.away_penalties[i].remaining_tenths);
-		snprintf(key, sizeof(key), "away_penalty%d_active", i);
-		g_state.away_penalties[i].active = parse_json_bool(
-			json, key, g_state.away_penalties[i].active);
-		snprintf(key, sizeof(key), "away_penalty%d_phase2_tenths", i);
-		g_state.away_penalties[i].phase2_tenths = parse_json_int(
-			json, key, g_state.away_penalties[i].phase2_tenths);
-	}
-
-	{
-		int lcount = parse_json_int(json, "period_label_count", -1);
-		if (lcount > 0) {
-			if (lcount > SCOREBOARD_MAX_PERIOD_LABELS)
-				lcount = SCOREBOARD_MAX_PERIOD_LABELS;
-			g_state.period_label_count = lcount;
-			for (int i = 0; i < lcount; i++) {
-				char key[32];
-				snprintf(key, sizeof(key), "period_label%d",
-					 i);
-				parse_json_string(
-					json, key, g_state.period_labels[i],
-					SCOREBOARD_PERIOD_LABEL_SIZE);
-			}
+	scoreboard_time_fn saved_time_fn = g_time_fn;
+	g_time_fn = replay_time_ns;
+	g_replay_now_ns = 0;
+	memcpy(&image, (const char *)map.data + sizeof(struct trace_header),
+	       sizeof(image));
+	/* Whatever clock was running here, the recorded one counts from 0 */
+	g_state.clock_running = false;
+	trace_image_apply(&image);
+
+	/* Records are copied out: the mapping need not be aligned for them.
+	   A run of changed words is applied as one change, on the game as
+	   the commands before it left it. */
+	size_t offset = sizeof(struct trace_header) + sizeof(image);
+	uint64_t wall_start = scoreboard_monotonic_ns();
+	bool changing = false;
+	struct trace_record r;
+	for (; offset + sizeof(r) <= map.size; offset += sizeof(r)) {
+		memcpy(&r, (const char *)map.data + offset, sizeof(r));
+		replay_advance(r.t_ns, speed, wall_start);
+		stats.trace_ns = r.t_ns;
+		if (r.cmd.type == TRACE_STATE_TYPE) {
+			if (!changing)
+				trace_image_capture(&image);
+			changing = true;
+			replay_set_word(&image, r.cmd.a, r.cmd.b);
+			stats.changes++;
+			continue;
+		}
+		if (changing) {
+			trace_image_apply(&image);
+			replay_write_outputs();
+			changing = false;
+		}
+		if (r.cmd.type == TRACE_END_TYPE) {
+			stats.outputs_match =
+				(uint32_t)r.cmd.a == output_snapshot_crc() &&
+				(uint32_t)r.cmd.b == stats.commands;
+			break;
+		}
+		if (r.cmd.type >= SCOREBOARD_CMD_USER) {
+			if (user_fn != NULL)
+				user_fn(&r.cmd, data);
+			stats.user_commands++;
+		} else {
+			scoreboard_command_apply(&r.cmd);
 		}
+		stats.commands++;
+		replay_write_outputs();
 	}
-
-	free(json);
-	mark_dirty();
+	/* A trace cut short still ends on its last change */
+	if (changing)
+		trace_image_apply(&image);
+	stats.elapsed_ns = scoreboard_monotonic_ns() - wall_start;
+	scoreboard_unmap_file(&map);
+
+	/* Back on the real clock, carrying on from the replayed state */
+	scoreboard_set_time_source(saved_time_fn);
+	if (out != NULL)
+		*out = stats;
 	return true;
 }
 
@@ -1823,7 +4059,7 @@ void scoreboard_new_game(void)
 		g_state.clock_tenths = g_state.period_length * 10;
 	else
 		g_state.clock_tenths = 0;
-	mark_dirty();
+	mark_dirty(SCOREBOARD_FIELDS_ALL | DIRTY_STATE);
 }
 
 /* ---- CLI settings ---- */
@@ -1887,154 +4123,584 @@ void scoreboard_set_sport(enum scoreboard_sport sport)
 		g_state.default_major_penalty_duration =
 			p->default_major_penalty_secs;
 	generate_default_period_labels();
-	mark_dirty();
+	mark_dirty(SCOREBOARD_FIELDS_ALL | DIRTY_STATE);
+}
+
+enum scoreboard_sport scoreboard_get_sport(void)
+{
+	return g_state.sport;
+}
+
+const struct scoreboard_sport_preset *scoreboard_get_sport_preset(void)
+{
+	return &k_sport_presets[g_state.sport];
+}
+
+const char *scoreboard_sport_name(enum scoreboard_sport sport)
+{
+	if (sport < 0 || sport >= SCOREBOARD_SPORT_COUNT)
+		return k_sport_names[SCOREBOARD_SPORT_HOCKEY];
+	return k_sport_names[sport];
+}
+
+enum scoreboard_sport scoreboard_sport_from_name(const char *name)
+{
+	if (name == NULL)
+		return SCOREBOARD_SPORT_HOCKEY;
+	for (int i = 0; i < SCOREBOARD_SPORT_COUNT; i++) {
+		if (strcmp(name, k_sport_names[i]) == 0)
+			return (enum scoreboard_sport)i;
+	}
+	return SCOREBOARD_SPORT_HOCKEY;
+}
+
+const char *scoreboard_get_segment_name(void)
+{
+	return g_state.segment_name;
+}
+
+bool scoreboard_get_has_shots(void)
+{
+	return g_state.has_shots;
+}
+
+bool scoreboard_get_has_penalties(void)
+{
+	return g_state.has_penalties;
+}
+
+bool scoreboard_get_has_fouls(void)
+{
+	return g_state.has_fouls;
+}
+
+const char *scoreboard_get_foul_label(void)
+{
+	return g_state.foul_label;
+}
+
+bool scoreboard_get_has_fouls2(void)
+{
+	return g_state.foul_label2[0] != '\0';
+}
+
+const char *scoreboard_get_foul_label2(void)
+{
+	return g_state.foul_label2;
+}
+
+bool scoreboard_get_log_scores(void)
+{
+	return g_state.log_scores;
+}
+
+const char *scoreboard_get_score_label(void)
+{
+	return g_state.score_label;
+}
+
+/* ---- action log ---- */
+
+void scoreboard_add_action_log(const char *message)
+{
+	if (message == NULL)
+		return;
+	safe_copy(g_state.action_logs[g_state.action_log_head], message,
+		  SCOREBOARD_ACTION_LOG_ENTRY_SIZE);
+	g_state.action_log_head =
+		(g_state.action_log_head + 1) % SCOREBOARD_ACTION_LOG_CAPACITY;
+	if (g_state.action_log_count < SCOREBOARD_ACTION_LOG_CAPACITY)
+		g_state.action_log_count++;
+}
+
+size_t scoreboard_copy_action_logs(char *buffer, size_t buffer_size)
+{
+	if (buffer == NULL || buffer_size == 0)
+		return 0;
+	buffer[0] = '\0';
+
+	size_t written = 0;
+	int start;
+	if (g_state.action_log_count < SCOREBOARD_ACTION_LOG_CAPACITY)
+		start = 0;
+	else
+		start = g_state.action_log_head;
+
+	for (int i = 0; i < g_state.action_log_count; i++) {
+		int idx = (start + i) % SCOREBOARD_ACTION_LOG_CAPACITY;
+		size_t entry_len = strlen(g_state.action_logs[idx]);
+		if (written + entry_len + 2 > buffer_size)
+			break;
+		if (written > 0) {
+			buffer[written++] = '\n';
+		}
+		memcpy(buffer + written, g_state.action_logs[idx], entry_len);
+		written += entry_len;
+		buffer[written] = '\0';
+	}
+
+	return written;
+}
+
+/* ---- timeline ---- */
+
+/* Start, stop, pause and resume marks for the stream and the recording,
+   in the order they happened. Process-wide, like OBS's own outputs. */
+struct timeline_mark {
+	uint64_t time_ns;
+	enum scoreboard_timeline timeline;
+	enum scoreboard_timeline_mark mark;
+};
+
+#define TIMELINE_CHUNK_MARKS 32
+
+static struct {
+	struct scoreboard_arena marks;
+	int count;
+	/* Index of each timeline's latest start mark, or -1 */
+	int start[SCOREBOARD_TIMELINE_COUNT];
+	/* Its latest mark of any kind, which says what state it is in */
+	enum scoreboard_timeline_mark last[SCOREBOARD_TIMELINE_COUNT];
+} g_timeline = {
+	.marks = {.item_size = sizeof(struct timeline_mark),
+		  .chunk_items = TIMELINE_CHUNK_MARKS},
+	.start = {-1, -1},
+	.last = {SCOREBOARD_MARK_STOP, SCOREBOARD_MARK_STOP},
+};
+
+static const struct timeline_mark *timeline_mark_at(int index)
+{
+	return (const struct timeline_mark *)scoreboard_arena_at(
+		&g_timeline.marks, index);
+}
+
+static bool valid_timeline(enum scoreboard_timeline tl)
+{
+	return tl >= 0 && tl < SCOREBOARD_TIMELINE_COUNT;
+}
+
+uint64_t scoreboard_timeline_now(void)
+{
+	return now_ns();
+}
+
+bool scoreboard_timeline_is_active(enum scoreboard_timeline tl)
+{
+	return valid_timeline(tl) &&
+	       g_timeline.last[tl] != SCOREBOARD_MARK_STOP;
+}
+
+bool scoreboard_timeline_is_paused(enum scoreboard_timeline tl)
+{
+	return valid_timeline(tl) &&
+	       g_timeline.last[tl] == SCOREBOARD_MARK_PAUSE;
+}
+
+/* Only the moves OBS can make: a start from stopped, a pause while
+   running, a resume while paused, a stop from any of those */
+static bool mark_allowed(enum scoreboard_timeline_mark last,
+			 enum scoreboard_timeline_mark mark)
+{
+	switch (mark) {
+	case SCOREBOARD_MARK_START:
+		return last == SCOREBOARD_MARK_STOP;
+	case SCOREBOARD_MARK_PAUSE:
+		return last == SCOREBOARD_MARK_START ||
+		       last == SCOREBOARD_MARK_RESUME;
+	case SCOREBOARD_MARK_RESUME:
+		return last == SCOREBOARD_MARK_PAUSE;
+	case SCOREBOARD_MARK_STOP:
+		return last != SCOREBOARD_MARK_STOP;
+	default:
+		return false;
+	}
+}
+
+bool scoreboard_timeline_mark(enum scoreboard_timeline tl,
+			      enum scoreboard_timeline_mark mark,
+			      uint64_t time_ns)
+{
+	if (!valid_timeline(tl) || !mark_allowed(g_timeline.last[tl], mark) ||
+	    !scoreboard_arena_reserve(&g_timeline.marks,
+				      g_timeline.count + 1))
+		return false;
+	struct timeline_mark *m = (struct timeline_mark *)scoreboard_arena_at(
+		&g_timeline.marks, g_timeline.count);
+	m->time_ns = time_ns;
+	m->timeline = tl;
+	m->mark = mark;
+	if (mark == SCOREBOARD_MARK_START)
+		g_timeline.start[tl] = g_timeline.count;
+	g_timeline.last[tl] = mark;
+	g_timeline.count++;
+	return true;
+}
+
+int64_t scoreboard_timeline_offset_ns(enum scoreboard_timeline tl,
+				      uint64_t time_ns)
+{
+	if (!valid_timeline(tl) || g_timeline.start[tl] < 0)
+		return -1;
+	int first = g_timeline.start[tl];
+	uint64_t start = timeline_mark_at(first)->time_ns;
+	if (time_ns < start)
+		return -1;
+	/* Time spent paused before time_ns doesn't count, and a time inside
+	   a pause is where the pause began */
+	uint64_t paused = 0;
+	uint64_t paused_at = 0;
+	bool is_paused = false;
+	for (int i = first + 1; i < g_timeline.count; i++) {
+		const struct timeline_mark *m = timeline_mark_at(i);
+		if (m->timeline != tl)
+			continue;
+		if (m->time_ns > time_ns)
+			break;
+		if (m->mark == SCOREBOARD_MARK_STOP && m->time_ns < time_ns)
+			return -1;
+		if (m->mark == SCOREBOARD_MARK_PAUSE) {
+			paused_at = m->time_ns;
+			is_paused = true;
+		} else if (m->mark == SCOREBOARD_MARK_RESUME) {
+			paused += m->time_ns - paused_at;
+			is_paused = false;
+		}
+	}
+	uint64_t at = is_paused ? paused_at : time_ns;
+	return (int64_t)(at - start - paused);
 }
 
-enum scoreboard_sport scoreboard_get_sport(void)
+int64_t scoreboard_timeline_length_ns(enum scoreboard_timeline tl)
 {
-	return g_state.sport;
+	if (!valid_timeline(tl) || g_timeline.start[tl] < 0)
+		return -1;
+	/* The latest mark is the stop, once there is one */
+	uint64_t end = now_ns();
+	for (int i = g_timeline.count - 1; i > g_timeline.start[tl]; i--) {
+		const struct timeline_mark *m = timeline_mark_at(i);
+		if (m->timeline == tl && m->mark == SCOREBOARD_MARK_STOP) {
+			end = m->time_ns;
+			break;
+		}
+	}
+	return scoreboard_timeline_offset_ns(tl, end);
 }
 
-const struct scoreboard_sport_preset *scoreboard_get_sport_preset(void)
+void scoreboard_timeline_reset(void)
 {
-	return &k_sport_presets[g_state.sport];
+	scoreboard_arena_free(&g_timeline.marks);
+	scoreboard_arena_init(&g_timeline.marks, sizeof(struct timeline_mark),
+			      TIMELINE_CHUNK_MARKS);
+	g_timeline.count = 0;
+	for (int tl = 0; tl < SCOREBOARD_TIMELINE_COUNT; tl++) {
+		g_timeline.start[tl] = -1;
+		g_timeline.last[tl] = SCOREBOARD_MARK_STOP;
+	}
 }
 
-const char *scoreboard_sport_name(enum scoreboard_sport sport)
+/* ---- game event log ---- */
+
+/* The timestamps file open for appending, see scoreboard_event_log_open().
+   Adds append their line and removals a tombstone line, "- " followed by
+   the entry taken out; anything else rewrites the file clean. */
+#define EVENT_TOMBSTONE "- "
+
+static struct {
+	FILE *file;
+	/* The context whose log the file holds */
+	struct scoreboard_ctx *ctx;
+	char path[SCOREBOARD_MAX_PATH];
+	/* Lines were appended since it was last written clean */
+	bool appended;
+} g_event_file;
+
+static void write_event_line(FILE *f, const struct scoreboard_game_event *ev,
+			     bool tombstone)
+{
+	int total = ev->offset_seconds;
+	int hours = total / 3600;
+	int minutes = (total % 3600) / 60;
+	int seconds = total % 60;
+	fprintf(f, "%s%d:%02d:%02d %s\n", tombstone ? EVENT_TOMBSTONE : "",
+		hours, minutes, seconds, ev->label);
+}
+
+/* One line, flushed so readers of the file see it at once */
+static void event_file_append(const struct scoreboard_game_event *ev,
+			      bool tombstone)
+{
+	/* Events logged outside the stream aren't in the file */
+	if (g_event_file.file == NULL || g_ctx != g_event_file.ctx ||
+	    ev->offset_seconds < 0)
+		return;
+	write_event_line(g_event_file.file, ev, tombstone);
+	fflush(g_event_file.file);
+	g_event_file.appended = true;
+}
+
+/* Writes the log clean over the file and reopens it for appending */
+static bool event_file_rewrite(void)
 {
-	if (sport < 0 || sport >= SCOREBOARD_SPORT_COUNT)
-		return k_sport_names[SCOREBOARD_SPORT_HOCKEY];
-	return k_sport_names[sport];
+	if (g_event_file.file != NULL)
+		fclose(g_event_file.file);
+	struct scoreboard_ctx *previous = context_enter(g_event_file.ctx);
+	bool ok = scoreboard_event_log_write(g_event_file.path);
+	context_leave(previous);
+	g_event_file.file = ok ? fopen(g_event_file.path, "a") : NULL;
+	g_event_file.appended = false;
+	return g_event_file.file != NULL;
 }
 
-enum scoreboard_sport scoreboard_sport_from_name(const char *name)
+/* Changes the file can't express as an append */
+static void event_file_changed(void)
 {
-	if (name == NULL)
-		return SCOREBOARD_SPORT_HOCKEY;
-	for (int i = 0; i < SCOREBOARD_SPORT_COUNT; i++) {
-		if (strcmp(name, k_sport_names[i]) == 0)
-			return (enum scoreboard_sport)i;
-	}
-	return SCOREBOARD_SPORT_HOCKEY;
+	if (g_event_file.file != NULL && g_ctx == g_event_file.ctx)
+		event_file_rewrite();
 }
 
-const char *scoreboard_get_segment_name(void)
+static bool event_equal(const struct scoreboard_game_event *a,
+			const struct scoreboard_game_event *b)
 {
-	return g_state.segment_name;
+	return a->offset_seconds == b->offset_seconds &&
+	       strcmp(a->label, b->label) == 0;
 }
 
-bool scoreboard_get_has_shots(void)
+/* Slot of the latest live entry equal to ev, or -1 */
+static int event_find_exact(const struct scoreboard_game_event *ev)
 {
-	return g_state.has_shots;
+	int slot = g_event_count - 1;
+	while (slot >= 0 && (slot_at(slot)->removed ||
+			     !event_equal(&slot_at(slot)->event, ev)))
+		slot--;
+	return slot;
 }
 
-bool scoreboard_get_has_penalties(void)
+static int *event_head(const struct scoreboard_game_event *ev)
 {
-	return g_state.has_penalties;
+	return &g_ctx->event_heads[ev->kind][ev->team + 1];
 }
 
-bool scoreboard_get_has_fouls(void)
+static int *event_newest(const struct scoreboard_game_event *ev)
 {
-	return g_state.has_fouls;
+	return &g_ctx->event_newest[ev->kind][ev->team + 1];
 }
 
-const char *scoreboard_get_foul_label(void)
+/* Links every slot to the one before it of its kind and team */
+static void index_event_slots(void)
 {
-	return g_state.foul_label;
+	for (int k = 0; k < SCOREBOARD_EVENT_KIND_COUNT; k++) {
+		for (int t = 0; t < 3; t++) {
+			g_ctx->event_heads[k][t] = -1;
+			g_ctx->event_newest[k][t] = -1;
+		}
+	}
+	for (int slot = 0; slot < g_event_count; slot++) {
+		struct event_slot *s = slot_at(slot);
+		s->prev = *event_newest(&s->event);
+		*event_newest(&s->event) = slot;
+		if (!s->removed)
+			*event_head(&s->event) = slot;
+	}
 }
 
-bool scoreboard_get_has_fouls2(void)
+static void reset_event_slots(void)
 {
-	return g_state.foul_label2[0] != '\0';
+	g_event_count = 0;
+	g_events_removed = 0;
+	index_event_slots();
 }
 
-const char *scoreboard_get_foul_label2(void)
+/* Slot of the index-th live entry. Without removals they are the same;
+   with them, a walk. */
+static int slot_of_index(int index)
 {
-	return g_state.foul_label2;
+	if (g_events_removed == 0)
+		return index;
+	int slot = 0;
+	while (slot_at(slot)->removed || index-- > 0)
+		slot++;
+	return slot;
 }
 
-bool scoreboard_get_log_scores(void)
+static int index_of_slot(int slot)
 {
-	return g_state.log_scores;
+	int index = slot;
+	for (int i = 0; g_events_removed > 0 && i < slot; i++) {
+		if (slot_at(i)->removed)
+			index--;
+	}
+	return index;
+}
+
+/* O(1) whichever entry it is: the slot is only marked. Marked slots at
+   the end are dropped, so taking back the newest event, the usual case,
+   leaves no gap behind. */
+static void event_tombstone(int slot)
+{
+	struct event_slot *s = slot_at(slot);
+	event_file_append(&s->event, true);
+	s->removed = true;
+	g_events_removed++;
+	int *head = event_head(&s->event);
+	while (*head >= 0 && slot_at(*head)->removed)
+		*head = slot_at(*head)->prev;
+	while (g_event_count > 0 && slot_at(g_event_count - 1)->removed) {
+		struct event_slot *last = slot_at(--g_event_count);
+		*event_newest(&last->event) = last->prev;
+		g_events_removed--;
+	}
 }
 
-const char *scoreboard_get_score_label(void)
+static void event_revive(int slot)
 {
-	return g_state.score_label;
+	struct event_slot *s = slot_at(slot);
+	s->removed = false;
+	g_events_removed--;
+	int *head = event_head(&s->event);
+	if (*head < slot)
+		*head = slot;
+	/* It goes back between entries, which an append can't express */
+	event_file_changed();
 }
 
-/* ---- action log ---- */
+void scoreboard_event_log_clear(void)
+{
+	/* The chunks stay allocated for the next game */
+	reset_event_slots();
+	event_file_changed();
+}
 
-void scoreboard_add_action_log(const char *message)
+/* Offset into the latest stream or recording, -1 if it isn't in it. A
+   fixed-offset event belongs to the stream. */
+static int64_t event_offset_ms(const struct scoreboard_game_event *ev,
+			       enum scoreboard_timeline tl)
 {
-	if (message == NULL)
-		return;
-	safe_copy(g_state.action_logs[g_state.action_log_head], message,
-		  SCOREBOARD_ACTION_LOG_ENTRY_SIZE);
-	g_state.action_log_head =
-		(g_state.action_log_head + 1) % SCOREBOARD_ACTION_LOG_CAPACITY;
-	if (g_state.action_log_count < SCOREBOARD_ACTION_LOG_CAPACITY)
-		g_state.action_log_count++;
+	if (ev->time_ns == 0)
+		return tl == SCOREBOARD_TIMELINE_STREAM
+			       ? (int64_t)ev->offset_seconds * 1000
+			       : -1;
+	int64_t ns = scoreboard_timeline_offset_ns(tl, ev->time_ns);
+	if (ns < 0)
+		return -1;
+	int64_t ms = ns / 1000000 - ev->delay_ms;
+	return ms > 0 ? ms : 0;
 }
 
-size_t scoreboard_copy_action_logs(char *buffer, size_t buffer_size)
+/* Takes the offset and times from timing */
+static int event_add(const struct scoreboard_game_event *timing,
+		     const char *label, enum scoreboard_event_kind kind,
+		     enum scoreboard_team team, int player_number)
 {
-	if (buffer == NULL || buffer_size == 0)
-		return 0;
-	buffer[0] = '\0';
+	if (label == NULL ||
+	    !scoreboard_arena_reserve(&g_event_log, g_event_count + 1))
+		return -1;
+	int slot = g_event_count++;
+	struct event_slot *s = slot_at(slot);
+	struct scoreboard_game_event *ev = &s->event;
+	ev->offset_seconds = timing->offset_seconds;
+	ev->time_ns = timing->time_ns;
+	ev->delay_ms = timing->delay_ms;
+	safe_copy(ev->label, label, SCOREBOARD_EVENT_LABEL_SIZE);
+	bool known_kind = kind >= 0 && kind < SCOREBOARD_EVENT_KIND_COUNT;
+	ev->kind = known_kind ? kind : SCOREBOARD_EVENT_OTHER;
+	bool known_team =
+		team == SCOREBOARD_TEAM_HOME || team == SCOREBOARD_TEAM_AWAY;
+	ev->team = known_team ? team : SCOREBOARD_TEAM_NONE;
+	ev->player_number = player_number > 0 ? player_number : 0;
+	ev->period = g_state.period;
+	ev->clock_tenths = g_state.clock_tenths;
+
+	s->removed = false;
+	s->prev = *event_newest(ev);
+	*event_newest(ev) = slot;
+	*event_head(ev) = slot;
+	event_file_append(ev, false);
+	undo_note_event(true, slot);
+	return scoreboard_event_log_count() - 1;
+}
 
-	size_t written = 0;
-	int start;
-	if (g_state.action_log_count < SCOREBOARD_ACTION_LOG_CAPACITY)
-		start = 0;
-	else
-		start = g_state.action_log_head;
+int scoreboard_event_log_add(int offset_seconds, const char *label)
+{
+	return scoreboard_event_log_add_typed(offset_seconds, label,
+					      SCOREBOARD_EVENT_OTHER,
+					      SCOREBOARD_TEAM_NONE, 0);
+}
 
-	for (int i = 0; i < g_state.action_log_count; i++) {
-		int idx = (start + i) % SCOREBOARD_ACTION_LOG_CAPACITY;
-		size_t entry_len = strlen(g_state.action_logs[idx]);
-		if (written + entry_len + 2 > buffer_size)
-			break;
-		if (written > 0) {
-			buffer[written++] = '\n';
-		}
-		memcpy(buffer + written, g_state.action_logs[idx], entry_len);
-		written += entry_len;
-		buffer[written] = '\0';
-	}
+int scoreboard_event_log_add_typed(int offset_seconds, const char *label,
+				   enum scoreboard_event_kind kind,
+				   enum scoreboard_team team,
+				   int player_number)
+{
+	struct scoreboard_game_event ev;
+	ev.offset_seconds = offset_seconds < 0 ? 0 : offset_seconds;
+	ev.time_ns = 0;
+	ev.delay_ms = 0;
+	return event_add(&ev, label, kind, team, player_number);
+}
 
-	return written;
+int scoreboard_event_log_add_timed(uint64_t time_ns, int delay_ms,
+				   const char *label,
+				   enum scoreboard_event_kind kind,
+				   enum scoreboard_team team,
+				   int player_number)
+{
+	struct scoreboard_game_event ev;
+	/* Time 0 is how a fixed-offset event is told apart */
+	ev.time_ns = time_ns > 0 ? time_ns : 1;
+	ev.delay_ms = delay_ms > 0 ? delay_ms : 0;
+	int64_t ms = event_offset_ms(&ev, SCOREBOARD_TIMELINE_STREAM);
+	ev.offset_seconds = ms < 0 ? -1 : (int)(ms / 1000);
+	return event_add(&ev, label, kind, team, player_number);
 }
 
-/* ---- game event log ---- */
 
-void scoreboard_event_log_clear(void)
+bool scoreboard_event_log_remove(int index)
 {
-	g_event_count = 0;
+	if (index < 0 || index >= scoreboard_event_log_count())
+		return false;
+	int slot = slot_of_index(index);
+	undo_note_event(false, slot);
+	event_tombstone(slot);
+	return true;
 }
 
-int scoreboard_event_log_add(int offset_seconds, const char *label)
+/* Newest live slot of that kind and team for player_number (any when
+   0), or -1. The walk starts at the newest live entry, so "last goal for
+   home" is one step. */
+static int event_last_of(enum scoreboard_event_kind kind,
+			 enum scoreboard_team team, int player_number)
 {
-	if (g_event_count >= SCOREBOARD_MAX_EVENTS)
+	if (kind < 0 || kind >= SCOREBOARD_EVENT_KIND_COUNT ||
+	    team < SCOREBOARD_TEAM_NONE || team > SCOREBOARD_TEAM_AWAY)
 		return -1;
-	if (label == NULL)
-		return -1;
-	if (offset_seconds < 0)
-		offset_seconds = 0;
-	int idx = g_event_count;
-	g_event_log[idx].offset_seconds = offset_seconds;
-	safe_copy(g_event_log[idx].label, label, SCOREBOARD_EVENT_LABEL_SIZE);
-	g_event_count++;
-	return idx;
+	int slot = g_ctx->event_heads[kind][team + 1];
+	while (slot >= 0) {
+		const struct event_slot *s = slot_at(slot);
+		if (!s->removed && (player_number <= 0 ||
+				    s->event.player_number == player_number))
+			break;
+		slot = s->prev;
+	}
+	return slot;
 }
 
-bool scoreboard_event_log_remove(int index)
+const struct scoreboard_game_event *
+scoreboard_event_log_last_of(enum scoreboard_event_kind kind,
+			     enum scoreboard_team team, int player_number)
+{
+	int slot = event_last_of(kind, team, player_number);
+	return slot >= 0 ? &slot_at(slot)->event : NULL;
+}
+
+bool scoreboard_event_log_remove_last_of(enum scoreboard_event_kind kind,
+					 enum scoreboard_team team,
+					 int player_number)
 {
-	if (index < 0 || index >= g_event_count)
+	int slot = event_last_of(kind, team, player_number);
+	if (slot < 0)
 		return false;
-	for (int i = index; i < g_event_count - 1; i++)
-		g_event_log[i] = g_event_log[i + 1];
-	g_event_count--;
+	undo_note_event(false, slot);
+	event_tombstone(slot);
 	return true;
 }
 
@@ -2045,23 +4711,24 @@ int scoreboard_event_log_find_last(const char *prefix)
 	size_t len = strlen(prefix);
 	if (len == 0)
 		return -1;
-	for (int i = g_event_count - 1; i >= 0; i--) {
-		if (strncmp(g_event_log[i].label, prefix, len) == 0)
-			return i;
+	for (int slot = g_event_count - 1; slot >= 0; slot--) {
+		const struct event_slot *s = slot_at(slot);
+		if (!s->removed && strncmp(s->event.label, prefix, len) == 0)
+			return index_of_slot(slot);
 	}
 	return -1;
 }
 
 int scoreboard_event_log_count(void)
 {
-	return g_event_count;
+	return g_event_count - g_events_removed;
 }
 
 const struct scoreboard_game_event *scoreboard_event_log_get(int index)
 {
-	if (index < 0 || index >= g_event_count)
+	if (index < 0 || index >= scoreboard_event_log_count())
 		return NULL;
-	return &g_event_log[index];
+	return &slot_at(slot_of_index(index))->event;
 }
 
 bool scoreboard_event_log_write(const char *path)
@@ -2072,13 +4739,11 @@ bool scoreboard_event_log_write(const char *path)
 	if (f == NULL)
 		return false;
 
-	for (int i = 0; i < g_event_count; i++) {
-		int total = g_event_log[i].offset_seconds;
-		int hours = total / 3600;
-		int minutes = (total % 3600) / 60;
-		int seconds = total % 60;
-		fprintf(f, "%d:%02d:%02d %s\n", hours, minutes, seconds,
-			g_event_log[i].label);
+	for (int slot = 0; slot < g_event_count; slot++) {
+		const struct event_slot *s = slot_at(slot);
+		if (!s->removed &&
+		    event_offset_ms(&s->event, SCOREBOARD_TIMELINE_STREAM) >= 0)
+			write_event_line(f, &s->event, false);
 	}
 
 	fclose(f);
@@ -2114,25 +4779,446 @@ int scoreboard_event_log_read(const char *path)
 		if (len > 0 && line[len - 1] == '\n')
 			line[len - 1] = '\0';
 
-		/* Parse "H:MM:SS label" format */
+		/* Parse "H:MM:SS label", or a tombstone taking out the
+		   latest such entry */
+		size_t mark = strlen(EVENT_TOMBSTONE);
+		bool tombstone = strncmp(line, EVENT_TOMBSTONE, mark) == 0;
+		const char *entry = tombstone ? line + mark : line;
 		int hours = 0, minutes = 0, seconds = 0;
 		int consumed = 0;
-		if (sscanf(line, "%d:%d:%d %n", &hours, &minutes, &seconds,
+		if (sscanf(entry, "%d:%d:%d %n", &hours, &minutes, &seconds,
 			   &consumed) < 3 ||
 		    consumed == 0) {
 			continue; /* skip malformed lines */
 		}
 
-		const char *label = line + consumed;
+		const char *label = entry + consumed;
 		if (label[0] == '\0')
 			continue;
 
 		int offset = hours * 3600 + minutes * 60 + seconds;
-		if (scoreboard_event_log_add(offset, label) < 0)
-			break; /* capacity reached */
-		loaded++;
+		if (tombstone) {
+			struct scoreboard_game_event ev;
+			ev.offset_seconds = offset;
+			safe_copy(ev.label, label, sizeof(ev.label));
+			int slot = event_find_exact(&ev);
+			if (slot >= 0) {
+				undo_note_event(false, slot);
+				event_tombstone(slot);
+				loaded--;
+			}
+		} else if (scoreboard_event_log_add(offset, label) >= 0) {
+			loaded++;
+		}
 	}
 
 	fclose(f);
 	return loaded;
 }
+
+bool scoreboard_event_log_open(const char *path)
+{
+	if (path == NULL || path[0] == '\0' ||
+	    strlen(path) >= sizeof(g_event_file.path))
+		return false;
+	scoreboard_event_log_close();
+	g_event_file.ctx = g_ctx;
+	safe_copy(g_event_file.path, path, sizeof(g_event_file.path));
+	return event_file_rewrite();
+}
+
+bool scoreboard_event_log_compact(void)
+{
+	if (g_event_file.file == NULL)
+		return false;
+	return event_file_rewrite();
+}
+
+void scoreboard_event_log_close(void)
+{
+	if (g_event_file.file == NULL)
+		return;
+	if (g_event_file.appended)
+		event_file_rewrite();
+	if (g_event_file.file != NULL)
+		fclose(g_event_file.file);
+	g_event_file.file = NULL;
+}
+
+bool scoreboard_event_log_is_open(void)
+{
+	return g_event_file.file != NULL;
+}
+
+bool scoreboard_event_log_export(enum scoreboard_timeline tl,
+				 const char *base_path, unsigned int formats)
+{
+	struct scoreboard_chapter_writer *w =
+		valid_timeline(tl)
+			? scoreboard_chapters_begin(base_path, formats, NULL)
+			: NULL;
+	if (w == NULL)
+		return false;
+	if (tl == SCOREBOARD_TIMELINE_RECORDING)
+		scoreboard_chapters_add(w, 0, "Recording Start");
+	for (int slot = 0; slot < g_event_count; slot++) {
+		const struct event_slot *s = slot_at(slot);
+		int64_t ms = event_offset_ms(&s->event, tl);
+		if (!s->removed && ms >= 0)
+			scoreboard_chapters_add(w, ms, s->event.label);
+	}
+
+	/* Writing the open timestamps file clean is its compaction */
+	char path[SCOREBOARD_MAX_PATH];
+	bool takes_file =
+		g_event_file.file != NULL && g_ctx == g_event_file.ctx &&
+		scoreboard_chapters_path(base_path,
+					 SCOREBOARD_CHAPTERS_YOUTUBE, path,
+					 sizeof(path)) &&
+		(formats & SCOREBOARD_CHAPTERS_YOUTUBE) != 0 &&
+		strcmp(path, g_event_file.path) == 0;
+	if (takes_file)
+		fclose(g_event_file.file);
+	int64_t length = scoreboard_timeline_length_ns(tl);
+	bool ok = scoreboard_chapters_finish(w, length > 0 ? length / 1000000
+							   : 0);
+	if (takes_file) {
+		g_event_file.file = fopen(g_event_file.path, "a");
+		g_event_file.appended = false;
+	}
+	return ok;
+}
+
+static void event_file_release(struct scoreboard_ctx *ctx)
+{
+	if (g_event_file.ctx == ctx)
+		scoreboard_event_log_close();
+}
+
+/* ---- undo ---- */
+
+static const struct {
+	size_t offset;
+	unsigned int field;
+	int min;
+} k_undo_values[UNDO_VALUE_COUNT] = {
+	{offsetof(struct core_state, clock_tenths), FIELD(CLOCK), 0},
+	{offsetof(struct core_state, period), FIELD(PERIOD), 1},
+	{offsetof(struct core_state, home_score), FIELD(HOME_SCORE), 0},
+	{offsetof(struct core_state, away_score), FIELD(AWAY_SCORE), 0},
+	{offsetof(struct core_state, home_shots), FIELD(HOME_SHOTS), 0},
+	{offsetof(struct core_state, away_shots), FIELD(AWAY_SHOTS), 0},
+	{offsetof(struct core_state, home_faceoffs), FIELD(HOME_FACEOFFS), 0},
+	{offsetof(struct core_state, away_faceoffs), FIELD(AWAY_FACEOFFS), 0},
+	{offsetof(struct core_state, home_fouls), FIELD(HOME_FOULS), 0},
+	{offsetof(struct core_state, away_fouls), FIELD(AWAY_FOULS), 0},
+	{offsetof(struct core_state, home_fouls2), FIELD(HOME_FOULS2), 0},
+	{offsetof(struct core_state, away_fouls2), FIELD(AWAY_FOULS2), 0},
+};
+
+static int *undo_value(int i)
+{
+	return (int *)((char *)&g_state + k_undo_values[i].offset);
+}
+
+static struct scoreboard_penalty *team_penalties(int team)
+{
+	return team == 0 ? g_state.home_penalties : g_state.away_penalties;
+}
+
+static bool penalty_equal(const struct scoreboard_penalty *a,
+			  const struct scoreboard_penalty *b)
+{
+	return a->active == b->active &&
+	       a->player_number == b->player_number &&
+	       a->remaining_tenths == b->remaining_tenths &&
+	       a->phase2_tenths == b->phase2_tenths;
+}
+
+static void undo_note_event(bool added, int slot)
+{
+	struct undo_step *s = &g_undo.pending;
+	if (g_undo.depth == 0 || s->event_op_count >= UNDO_MAX_EVENT_OPS)
+		return;
+	struct undo_event_op *op = &s->event_ops[s->event_op_count++];
+	op->added = added;
+	op->slot = slot;
+	op->event = slot_at(slot)->event;
+}
+
+/* Puts back the entry the step recorded. Its old slot normally still
+   holds it, marked removed. If the log was cleared since, it goes in at
+   that position again, or last in a shorter log. */
+static void event_restore(int slot, const struct scoreboard_game_event *ev)
+{
+	if (slot < g_event_count && slot_at(slot)->removed &&
+	    event_equal(&slot_at(slot)->event, ev)) {
+		event_revive(slot);
+		return;
+	}
+	if (slot > g_event_count)
+		slot = g_event_count;
+	/* Out of memory leaves the entry out, like one that is gone */
+	if (scoreboard_arena_reserve(&g_event_log, g_event_count + 1)) {
+		for (int i = g_event_count; i > slot; i--)
+			*slot_at(i) = *slot_at(i - 1);
+		slot_at(slot)->event = *ev;
+		slot_at(slot)->removed = false;
+		g_event_count++;
+		index_event_slots();
+		event_file_changed();
+	}
+}
+
+/* Removes the entry the step recorded: in its slot, or else its latest
+   exact copy. A prefix match could take someone else's event. */
+static void event_remove_exact(int slot,
+			       const struct scoreboard_game_event *ev)
+{
+	if (slot >= g_event_count || slot_at(slot)->removed ||
+	    !event_equal(&slot_at(slot)->event, ev)) {
+		slot = event_find_exact(ev);
+		if (slot < 0)
+			return;
+	}
+	event_tombstone(slot);
+}
+
+/* A penalty is known by its player number and by how many earlier ones
+   in the list share that number. Compacting a cleared slot moves a
+   penalty but keeps both. */
+static int penalty_nth(const struct scoreboard_penalty *list, int slot)
+{
+	int nth = 0;
+	for (int i = 0; i < slot; i++) {
+		if (list[i].active &&
+		    list[i].player_number == list[slot].player_number)
+			nth++;
+	}
+	return nth;
+}
+
+static int penalty_find(const struct scoreboard_penalty *list,
+			int player_number, int nth)
+{
+	for (int i = 0; i < SCOREBOARD_PENALTY_SLOTS; i++) {
+		if (list[i].active && list[i].player_number == player_number &&
+		    nth-- == 0)
+			return i;
+	}
+	return -1;
+}
+
+/* A penalty that is still running keeps the time it has run since */
+static void penalty_move(struct scoreboard_penalty *cur,
+			 const struct scoreboard_penalty *from,
+			 const struct scoreboard_penalty *to)
+{
+	cur->remaining_tenths += to->remaining_tenths - from->remaining_tenths;
+	if (cur->remaining_tenths < 0)
+		cur->remaining_tenths = 0;
+	cur->phase2_tenths = to->phase2_tenths;
+}
+
+/* Puts a penalty back at the position it had, or last in a shorter list.
+   A full list leaves it out, like one that has expired. */
+static void penalty_insert(struct scoreboard_penalty *cur, int slot,
+			   const struct scoreboard_penalty *p)
+{
+	int count = 0;
+	while (count < SCOREBOARD_PENALTY_SLOTS && cur[count].active)
+		count++;
+	if (count == SCOREBOARD_PENALTY_SLOTS)
+		return;
+	if (slot > count)
+		slot = count;
+	for (int i = count; i > slot; i--)
+		cur[i] = cur[i - 1];
+	cur[slot] = *p;
+}
+
+/* Takes one team's penalties from what the step left to what it found,
+   or the other way, matching each penalty by who it is rather than by
+   its slot. Clock time and clears since the step may have moved them. */
+static void penalties_move(struct scoreboard_penalty *cur,
+			   const struct scoreboard_penalty *from,
+			   const struct scoreboard_penalty *to)
+{
+	unsigned int restore = 0;
+
+	/* Last first, so taking one out does not renumber the rest */
+	for (int slot = SCOREBOARD_PENALTY_SLOTS - 1; slot >= 0; slot--) {
+		int number = from[slot].player_number;
+		int nth = penalty_nth(from, slot);
+		if (!from[slot].active || penalty_find(to, number, nth) >= 0)
+			continue;
+		int c = penalty_find(cur, number, nth);
+		if (c >= 0)
+			cur[c].active = false;
+	}
+	compact_penalties(cur);
+
+	for (int slot = 0; slot < SCOREBOARD_PENALTY_SLOTS; slot++) {
+		if (!to[slot].active)
+			continue;
+		int number = to[slot].player_number;
+		int nth = penalty_nth(to, slot);
+		int f = penalty_find(from, number, nth);
+		if (f >= 0 && penalty_equal(&from[f], &to[slot]))
+			continue;
+		int c = penalty_find(cur, number, nth);
+		if (f >= 0 && c >= 0)
+			penalty_move(&cur[c], &from[f], &to[slot]);
+		else
+			restore |= 1u << slot;
+	}
+
+	for (int slot = 0; slot < SCOREBOARD_PENALTY_SLOTS; slot++) {
+		if (restore & (1u << slot))
+			penalty_insert(cur, slot, &to[slot]);
+	}
+}
+
+/* direction -1 takes the step back, +1 takes it again */
+static void undo_apply(const struct undo_step *s, int direction)
+{
+	for (int i = 0; i < UNDO_VALUE_COUNT; i++) {
+		if (s->deltas[i] == 0)
+			continue;
+		int *value = undo_value(i);
+		*value += direction * s->deltas[i];
+		if (*value < k_undo_values[i].min)
+			*value = k_undo_values[i].min;
+		mark_dirty(k_undo_values[i].field);
+	}
+
+	for (int team = 0; team < 2; team++) {
+		const struct scoreboard_penalty *from =
+			direction < 0 ? s->after[team] : s->before[team];
+		const struct scoreboard_penalty *to =
+			direction < 0 ? s->before[team] : s->after[team];
+		if (!s->penalties_changed[team])
+			continue;
+		penalties_move(team_penalties(team), from, to);
+		mark_dirty(team == 0 ? HOME_PENALTY_FIELDS
+				     : AWAY_PENALTY_FIELDS);
+	}
+
+	for (int n = 0; n < s->event_op_count; n++) {
+		const struct undo_event_op *op =
+			&s->event_ops[direction < 0 ? s->event_op_count - 1 - n
+						    : n];
+		if (op->added == (direction > 0))
+			event_restore(op->slot, &op->event);
+		else
+			event_remove_exact(op->slot, &op->event);
+	}
+}
+
+void scoreboard_undo_begin(void)
+{
+	if (g_undo.depth++ > 0)
+		return;
+	/* Time the clock has already run is not part of the action */
+	scoreboard_clock_sync();
+	memset(&g_undo.pending, 0, sizeof(g_undo.pending));
+	for (int i = 0; i < UNDO_VALUE_COUNT; i++)
+		g_undo.values_before[i] = *undo_value(i);
+	for (int team = 0; team < 2; team++)
+		memcpy(g_undo.pending.before[team], team_penalties(team),
+		       sizeof(g_undo.pending.before[team]));
+}
+
+void scoreboard_undo_end(const char *label)
+{
+	if (g_undo.depth == 0 || --g_undo.depth > 0)
+		return;
+	struct undo_step *s = &g_undo.pending;
+	bool changed = s->event_op_count > 0;
+	for (int i = 0; i < UNDO_VALUE_COUNT; i++) {
+		s->deltas[i] = *undo_value(i) - g_undo.values_before[i];
+		changed = changed || s->deltas[i] != 0;
+	}
+	for (int team = 0; team < 2; team++) {
+		memcpy(s->after[team], team_penalties(team),
+		       sizeof(s->after[team]));
+		for (int slot = 0; slot < SCOREBOARD_PENALTY_SLOTS; slot++) {
+			if (!penalty_equal(&s->before[team][slot],
+					   &s->after[team][slot]))
+				s->penalties_changed[team] = true;
+		}
+		changed = changed || s->penalties_changed[team];
+	}
+	/* Nothing to take back, and the redo history stays */
+	if (!changed)
+		return;
+
+	safe_copy(s->label, label != NULL ? label : "", sizeof(s->label));
+	g_undo.redo_count = 0;
+	if (g_undo.count == SCOREBOARD_UNDO_DEPTH) {
+		g_undo.first = (g_undo.first + 1) % SCOREBOARD_UNDO_DEPTH;
+		g_undo.count--;
+	}
+	g_undo.steps[(g_undo.first + g_undo.count) % SCOREBOARD_UNDO_DEPTH] =
+		*s;
+	g_undo.count++;
+}
+
+static struct undo_step *undo_top(void)
+{
+	return &g_undo.steps[(g_undo.first + g_undo.count - 1) %
+			     SCOREBOARD_UNDO_DEPTH];
+}
+
+bool scoreboard_undo(void)
+{
+	if (g_undo.depth > 0 || g_undo.count == 0)
+		return false;
+	scoreboard_clock_sync();
+	undo_apply(undo_top(), -1);
+	g_undo.count--;
+	g_undo.redo_count++;
+	return true;
+}
+
+bool scoreboard_redo(void)
+{
+	if (g_undo.depth > 0 || g_undo.redo_count == 0)
+		return false;
+	scoreboard_clock_sync();
+	g_undo.count++;
+	g_undo.redo_count--;
+	undo_apply(undo_top(), 1);
+	return true;
+}
+
+int scoreboard_undo_count(void)
+{
+	return g_undo.count;
+}
+
+int scoreboard_redo_count(void)
+{
+	return g_undo.redo_count;
+}
+
+const char *scoreboard_undo_label(void)
+{
+	return g_undo.count > 0 ? undo_top()->label : NULL;
+}
+
+const char *scoreboard_redo_label(void)
+{
+	if (g_undo.redo_count == 0)
+		return NULL;
+	return g_undo.steps[(g_undo.first + g_undo.count) %
+			    SCOREBOARD_UNDO_DEPTH]
+		.label;
+}
+
+void scoreboard_undo_clear(void)
+{
+	g_undo.first = 0;
+	g_undo.count = 0;
+	g_undo.redo_count = 0;
+}
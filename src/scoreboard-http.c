@@ -0,0 +1,592 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L /* sockets, select */
+#endif
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#endif
+
+#include "scoreboard-core.h"
+#include "scoreboard-platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+typedef SOCKET http_socket_t;
+#define HTTP_INVALID_SOCKET INVALID_SOCKET
+#define close_socket closesocket
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+typedef int http_socket_t;
+#define HTTP_INVALID_SOCKET (-1)
+#define close_socket close
+#endif
+
+#ifdef MSG_NOSIGNAL
+#define HTTP_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define HTTP_SEND_FLAGS 0
+#endif
+
+#define HTTP_MAX_CLIENTS 16
+#define HTTP_REQUEST_SIZE 2048
+#define HTTP_SNAPSHOT_SIZE 8192
+#define HTTP_FIELD_SIZE 512
+#define HTTP_DELTA_RING 32
+#define HTTP_POLL_MS 500
+/* Room for many full states; a stream further behind than this is not
+   being read */
+#define HTTP_SEND_BUFFER (64 * 1024)
+
+/* A connection is either waiting for its request line and headers, or has
+   been upgraded to an event stream that receives every published change. */
+struct http_client {
+	http_socket_t sock;
+	char request[HTTP_REQUEST_SIZE];
+	size_t request_len;
+	bool streaming;
+	bool needs_full;
+	unsigned long long version; /* last version sent to the stream */
+};
+
+struct http_buffer {
+	char *data;
+	size_t len;
+	size_t cap;
+};
+
+static struct {
+	scoreboard_mutex_t lock;
+	scoreboard_thread_t thread;
+	bool running;
+	unsigned short port;
+	http_socket_t listener;
+	http_socket_t wake_recv;
+	http_socket_t wake_send;
+	struct http_client clients[HTTP_MAX_CLIENTS];
+
+	/* Owner thread only: field text as of the last publish */
+	char fields[SCOREBOARD_FIELD_COUNT][HTTP_FIELD_SIZE];
+	bool published_once;
+
+	/* Shared with the server thread, guarded by lock */
+	bool stopping;
+	char *snapshot;
+	unsigned long long version;
+	char *deltas[HTTP_DELTA_RING]; /* indexed by version */
+} g_http;
+
+static char *copy_string(const char *src)
+{
+	size_t len = strlen(src);
+	char *dst = (char *)malloc(len + 1);
+	if (dst != NULL)
+		memcpy(dst, src, len + 1);
+	return dst;
+}
+
+/* ---- buffers ---- */
+
+static bool buffer_append(struct http_buffer *b, const char *text, size_t len)
+{
+	if (b->len + len + 1 > b->cap) {
+		size_t cap = b->cap ? b->cap : 1024;
+		while (b->len + len + 1 > cap)
+			cap *= 2;
+		char *data = (char *)realloc(b->data, cap);
+		if (data == NULL)
+			return false;
+		b->data = data;
+		b->cap = cap;
+	}
+	memcpy(b->data + b->len, text, len);
+	b->len += len;
+	b->data[b->len] = '\0';
+	return true;
+}
+
+static bool buffer_append_str(struct http_buffer *b, const char *text)
+{
+	return buffer_append(b, text, strlen(text));
+}
+
+/* One SSE event; every line of the JSON body gets its own data: prefix
+   so the browser rejoins them with newlines. */
+static bool append_event(struct http_buffer *b, const char *name,
+			 unsigned long long version, const char *json)
+{
+	char header[96];
+	snprintf(header, sizeof(header), "event: %s\nid: %llu\n", name,
+		 version);
+	bool ok = buffer_append_str(b, header);
+	const char *line = json;
+	while (ok && *line != '\0') {
+		const char *end = strchr(line, '\n');
+		size_t len = end ? (size_t)(end - line) : strlen(line);
+		ok = buffer_append_str(b, "data: ") &&
+		     buffer_append(b, line, len) && buffer_append_str(b, "\n");
+		line = end ? end + 1 : line + len;
+	}
+	return ok && buffer_append_str(b, "\n");
+}
+
+/* ---- sockets ---- */
+
+/* Client sockets never block the server thread: a browser source that
+   stops reading fills its send buffer, and the send that would then
+   wait fails instead, so the client is dropped rather than stalling
+   every other stream and scoreboard_http_stop(). An EventSource simply
+   reconnects and starts again from the full state. */
+static bool set_nonblocking(http_socket_t sock)
+{
+#ifdef _WIN32
+	u_long yes = 1;
+	return ioctlsocket(sock, FIONBIO, &yes) == 0;
+#else
+	int flags = fcntl(sock, F_GETFL, 0);
+	return flags >= 0 && fcntl(sock, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+static bool send_all(http_socket_t sock, const char *data, size_t len)
+{
+	while (len > 0) {
+		int n = (int)send(sock, data, (int)len, HTTP_SEND_FLAGS);
+		if (n <= 0)
+			return false;
+		data += n;
+		len -= (size_t)n;
+	}
+	return true;
+}
+
+static void drop_client(struct http_client *c)
+{
+	close_socket(c->sock);
+	c->sock = HTTP_INVALID_SOCKET;
+	c->request_len = 0;
+	c->streaming = false;
+}
+
+static http_socket_t open_loopback(int type, unsigned short port)
+{
+	http_socket_t sock = socket(AF_INET, type, 0);
+	if (sock == HTTP_INVALID_SOCKET)
+		return sock;
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(port);
+	if (type == SOCK_STREAM) {
+		int yes = 1;
+		setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char *)&yes,
+			   sizeof(yes));
+	}
+	if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+		close_socket(sock);
+		return HTTP_INVALID_SOCKET;
+	}
+	return sock;
+}
+
+static unsigned short bound_port(http_socket_t sock)
+{
+	struct sockaddr_in addr;
+	socklen_t len = sizeof(addr);
+	if (getsockname(sock, (struct sockaddr *)&addr, &len) != 0)
+		return 0;
+	return ntohs(addr.sin_port);
+}
+
+/* The publisher pokes a loopback datagram socket so select() returns the
+   moment there is something new to push */
+static bool open_wake_pair(void)
+{
+	g_http.wake_recv = open_loopback(SOCK_DGRAM, 0);
+	if (g_http.wake_recv == HTTP_INVALID_SOCKET)
+		return false;
+	g_http.wake_send = socket(AF_INET, SOCK_DGRAM, 0);
+	if (g_http.wake_send == HTTP_INVALID_SOCKET)
+		return false;
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(bound_port(g_http.wake_recv));
+	return connect(g_http.wake_send, (struct sockaddr *)&addr,
+		       sizeof(addr)) == 0;
+}
+
+static void wake_server(void)
+{
+	send(g_http.wake_send, "!", 1, HTTP_SEND_FLAGS);
+}
+
+static void close_all_sockets(void)
+{
+	if (g_http.listener != HTTP_INVALID_SOCKET)
+		close_socket(g_http.listener);
+	if (g_http.wake_recv != HTTP_INVALID_SOCKET)
+		close_socket(g_http.wake_recv);
+	if (g_http.wake_send != HTTP_INVALID_SOCKET)
+		close_socket(g_http.wake_send);
+	g_http.listener = HTTP_INVALID_SOCKET;
+	g_http.wake_recv = HTTP_INVALID_SOCKET;
+	g_http.wake_send = HTTP_INVALID_SOCKET;
+	for (int i = 0; i < HTTP_MAX_CLIENTS; i++) {
+		if (g_http.clients[i].sock != HTTP_INVALID_SOCKET)
+			drop_client(&g_http.clients[i]);
+	}
+}
+
+/* ---- requests ---- */
+
+static void send_response(struct http_client *c, const char *status,
+			  const char *type, const char *body)
+{
+	char header[256];
+	snprintf(header, sizeof(header),
+		 "HTTP/1.1 %s\r\n"
+		 "Content-Type: %s\r\n"
+		 "Content-Length: %zu\r\n"
+		 "Access-Control-Allow-Origin: *\r\n"
+		 "Cache-Control: no-cache\r\n"
+		 "Connection: close\r\n\r\n",
+		 status, type, strlen(body));
+	if (send_all(c->sock, header, strlen(header)))
+		send_all(c->sock, body, strlen(body));
+	drop_client(c);
+}
+
+static void handle_request(struct http_client *c)
+{
+	char method[16] = "";
+	char path[256] = "";
+	sscanf(c->request, "%15s %255s", method, path);
+	char *query = strchr(path, '?');
+	if (query != NULL)
+		*query = '\0';
+
+	if (strcmp(method, "GET") != 0) {
+		send_response(c, "405 Method Not Allowed", "text/plain",
+			      "Method Not Allowed\n");
+		return;
+	}
+
+	if (strcmp(path, "/events") == 0) {
+		static const char header[] =
+			"HTTP/1.1 200 OK\r\n"
+			"Content-Type: text/event-stream\r\n"
+			"Access-Control-Allow-Origin: *\r\n"
+			"Cache-Control: no-cache\r\n"
+			"Connection: keep-alive\r\n\r\n";
+		if (!send_all(c->sock, header, sizeof(header) - 1)) {
+			drop_client(c);
+			return;
+		}
+		c->streaming = true;
+		c->needs_full = true;
+		return;
+	}
+
+	if (strcmp(path, "/") == 0 || strcmp(path, "/state") == 0 ||
+	    strcmp(path, "/scoreboard.json") == 0) {
+		scoreboard_mutex_lock(&g_http.lock);
+		char *body = copy_string(g_http.snapshot);
+		scoreboard_mutex_unlock(&g_http.lock);
+		if (body == NULL) {
+			drop_client(c);
+			return;
+		}
+		send_response(c, "200 OK", "application/json", body);
+		free(body);
+		return;
+	}
+
+	send_response(c, "404 Not Found", "text/plain", "Not Found\n");
+}
+
+static void read_client(struct http_client *c)
+{
+	char discard[256];
+	if (c->streaming) {
+		/* Streams never send anything meaningful; a read only tells
+		   us the browser went away */
+		if (recv(c->sock, discard, sizeof(discard), 0) <= 0)
+			drop_client(c);
+		return;
+	}
+
+	size_t space = sizeof(c->request) - 1 - c->request_len;
+	int n = (int)recv(c->sock, c->request + c->request_len, (int)space,
+			  0);
+	if (n <= 0) {
+		drop_client(c);
+		return;
+	}
+	c->request_len += (size_t)n;
+	c->request[c->request_len] = '\0';
+	if (strstr(c->request, "\r\n\r\n") != NULL ||
+	    strstr(c->request, "\n\n") != NULL)
+		handle_request(c);
+	else if (c->request_len == sizeof(c->request) - 1)
+		send_response(c, "431 Request Header Fields Too Large",
+			      "text/plain", "Request Too Large\n");
+}
+
+static void accept_client(void)
+{
+	http_socket_t sock = accept(g_http.listener, NULL, NULL);
+	if (sock == HTTP_INVALID_SOCKET)
+		return;
+	if (!set_nonblocking(sock)) {
+		close_socket(sock);
+		return;
+	}
+	/* A fixed size, or the kernel keeps growing it for a stalled peer */
+	int send_buffer = HTTP_SEND_BUFFER;
+	setsockopt(sock, SOL_SOCKET, SO_SNDBUF, (const char *)&send_buffer,
+		   sizeof(send_buffer));
+#ifdef SO_NOSIGPIPE
+	/* No MSG_NOSIGNAL on macOS; a closed browser tab must not raise
+	   SIGPIPE inside OBS */
+	int yes = 1;
+	setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, &yes, sizeof(yes));
+#endif
+	for (int i = 0; i < HTTP_MAX_CLIENTS; i++) {
+		struct http_client *c = &g_http.clients[i];
+		if (c->sock == HTTP_INVALID_SOCKET) {
+			memset(c, 0, sizeof(*c));
+			c->sock = sock;
+			return;
+		}
+	}
+	close_socket(sock);
+}
+
+/* Build whatever a stream has not seen yet: the deltas it missed, or the
+   full state if it is new or fell further behind than the ring reaches. */
+static bool build_stream_update(struct http_client *c, struct http_buffer *b)
+{
+	unsigned long long latest = g_http.version;
+	if (!c->needs_full && c->version == latest)
+		return false;
+	if (c->needs_full || latest - c->version > HTTP_DELTA_RING) {
+		append_event(b, "state", latest, g_http.snapshot);
+	} else {
+		for (unsigned long long v = c->version + 1; v <= latest; v++)
+			append_event(b, "delta", v,
+				     g_http.deltas[v % HTTP_DELTA_RING]);
+	}
+	c->needs_full = false;
+	c->version = latest;
+	return true;
+}
+
+static void push_updates(void)
+{
+	for (int i = 0; i < HTTP_MAX_CLIENTS; i++) {
+		struct http_client *c = &g_http.clients[i];
+		if (c->sock == HTTP_INVALID_SOCKET || !c->streaming)
+			continue;
+		struct http_buffer b = {NULL, 0, 0};
+		scoreboard_mutex_lock(&g_http.lock);
+		bool pending = build_stream_update(c, &b);
+		scoreboard_mutex_unlock(&g_http.lock);
+		if (pending && (b.data == NULL || !send_all(c->sock, b.data,
+							    b.len)))
+			drop_client(c);
+		free(b.data);
+	}
+}
+
+static void server_main(void *arg)
+{
+	(void)arg;
+	char discard[64];
+
+	for (;;) {
+		scoreboard_mutex_lock(&g_http.lock);
+		bool stopping = g_http.stopping;
+		scoreboard_mutex_unlock(&g_http.lock);
+		if (stopping)
+			break;
+
+		fd_set readable;
+		FD_ZERO(&readable);
+		FD_SET(g_http.listener, &readable);
+		FD_SET(g_http.wake_recv, &readable);
+		http_socket_t max_sock = g_http.listener > g_http.wake_recv
+						 ? g_http.listener
+						 : g_http.wake_recv;
+		for (int i = 0; i < HTTP_MAX_CLIENTS; i++) {
+			http_socket_t sock = g_http.clients[i].sock;
+			if (sock == HTTP_INVALID_SOCKET)
+				continue;
+			FD_SET(sock, &readable);
+			if (sock > max_sock)
+				max_sock = sock;
+		}
+
+		struct timeval timeout = {0, HTTP_POLL_MS * 1000};
+		if (select((int)max_sock + 1, &readable, NULL, NULL,
+			   &timeout) < 0)
+			continue;
+
+		if (FD_ISSET(g_http.wake_recv, &readable))
+			recv(g_http.wake_recv, discard, sizeof(discard), 0);
+		for (int i = 0; i < HTTP_MAX_CLIENTS; i++) {
+			struct http_client *c = &g_http.clients[i];
+			if (c->sock != HTTP_INVALID_SOCKET &&
+			    FD_ISSET(c->sock, &readable))
+				read_client(c);
+		}
+		if (FD_ISSET(g_http.listener, &readable))
+			accept_client();
+		push_updates();
+	}
+}
+
+/* ---- public API ---- */
+
+static void free_published(void)
+{
+	free(g_http.snapshot);
+	g_http.snapshot = NULL;
+	for (int i = 0; i < HTTP_DELTA_RING; i++) {
+		free(g_http.deltas[i]);
+		g_http.deltas[i] = NULL;
+	}
+}
+
+bool scoreboard_http_start(unsigned short port)
+{
+	if (g_http.running)
+		return true;
+#ifdef _WIN32
+	WSADATA wsa;
+	if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0)
+		return false;
+#endif
+	g_http.listener = HTTP_INVALID_SOCKET;
+	g_http.wake_recv = HTTP_INVALID_SOCKET;
+	g_http.wake_send = HTTP_INVALID_SOCKET;
+	for (int i = 0; i < HTTP_MAX_CLIENTS; i++)
+		g_http.clients[i].sock = HTTP_INVALID_SOCKET;
+
+	g_http.listener = open_loopback(SOCK_STREAM, port);
+	if (g_http.listener == HTTP_INVALID_SOCKET ||
+	    listen(g_http.listener, HTTP_MAX_CLIENTS) != 0 ||
+	    !open_wake_pair())
+		goto fail;
+	g_http.port = bound_port(g_http.listener);
+
+	g_http.stopping = false;
+	g_http.published_once = false;
+	g_http.version = 0;
+	scoreboard_mutex_init(&g_http.lock);
+	/* Publish before the thread exists so no request sees an empty
+	   snapshot */
+	g_http.running = true;
+	scoreboard_http_publish();
+	if (!scoreboard_thread_create(&g_http.thread, server_main, NULL)) {
+		g_http.running = false;
+		free_published();
+		scoreboard_mutex_destroy(&g_http.lock);
+		goto fail;
+	}
+	return true;
+
+fail:
+	close_all_sockets();
+#ifdef _WIN32
+	WSACleanup();
+#endif
+	return false;
+}
+
+void scoreboard_http_stop(void)
+{
+	if (!g_http.running)
+		return;
+	scoreboard_mutex_lock(&g_http.lock);
+	g_http.stopping = true;
+	scoreboard_mutex_unlock(&g_http.lock);
+	wake_server();
+	scoreboard_thread_join(g_http.thread);
+
+	close_all_sockets();
+	scoreboard_mutex_destroy(&g_http.lock);
+	free_published();
+	g_http.port = 0;
+	g_http.running = false;
+#ifdef _WIN32
+	WSACleanup();
+#endif
+}
+
+bool scoreboard_http_is_running(void)
+{
+	return g_http.running;
+}
+
+unsigned short scoreboard_http_get_port(void)
+{
+	return g_http.port;
+}
+
+bool scoreboard_http_publish(void)
+{
+	if (!g_http.running)
+		return false;
+
+	unsigned int changed = 0;
+	char value[HTTP_FIELD_SIZE];
+	for (int i = 0; i < SCOREBOARD_FIELD_COUNT; i++) {
+		enum scoreboard_output_field field =
+			(enum scoreboard_output_field)i;
+		scoreboard_format_output_field(field, value, sizeof(value));
+		if (g_http.published_once &&
+		    strcmp(value, g_http.fields[i]) == 0)
+			continue;
+		memcpy(g_http.fields[i], value, strlen(value) + 1);
+		changed |= SCOREBOARD_FIELD_BIT(field);
+	}
+	if (changed == 0)
+		return false;
+	g_http.published_once = true;
+
+	char *snapshot = (char *)malloc(HTTP_SNAPSHOT_SIZE);
+	char *delta = (char *)malloc(HTTP_SNAPSHOT_SIZE);
+	if (snapshot == NULL || delta == NULL) {
+		free(snapshot);
+		free(delta);
+		return false;
+	}
+	scoreboard_format_output_snapshot(SCOREBOARD_OUTPUT_JSON, snapshot,
+					  HTTP_SNAPSHOT_SIZE);
+	scoreboard_format_output_fields(SCOREBOARD_OUTPUT_JSON, changed, delta,
+					HTTP_SNAPSHOT_SIZE);
+
+	scoreboard_mutex_lock(&g_http.lock);
+	free(g_http.snapshot);
+	g_http.snapshot = snapshot;
+	g_http.version++;
+	char **slot = &g_http.deltas[g_http.version % HTTP_DELTA_RING];
+	free(*slot);
+	*slot = delta;
+	scoreboard_mutex_unlock(&g_http.lock);
+
+	wake_server();
+	return true;
+}
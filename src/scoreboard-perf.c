@@ -0,0 +1,151 @@
+#include "scoreboard-core.h"
+#include "scoreboard-platform.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* Bucket edges chosen around what an operator notices: anything under
+   1 ms is noise, 16-50 ms costs a rendered frame, 100 ms+ is a visible
+   clock hiccup */
+static const uint64_t k_bucket_limits_ns[SCOREBOARD_PERF_BUCKETS] = {
+	10000ull,    100000ull,    1000000ull,   4000000ull,
+	16000000ull, 50000000ull, 100000000ull, 0,
+};
+
+static const char *k_path_names[SCOREBOARD_PERF_PATH_COUNT] = {
+	"write_all_files",
+	"read_all_files",
+	"update_all_labels",
+	"on_tick",
+};
+
+static struct scoreboard_perf_stats g_perf[SCOREBOARD_PERF_PATH_COUNT];
+
+uint64_t scoreboard_perf_now(void)
+{
+	return scoreboard_monotonic_ns();
+}
+
+uint64_t scoreboard_perf_bucket_limit_ns(int bucket)
+{
+	if (bucket < 0 || bucket >= SCOREBOARD_PERF_BUCKETS)
+		return 0;
+	return k_bucket_limits_ns[bucket];
+}
+
+const char *scoreboard_perf_path_name(enum scoreboard_perf_path path)
+{
+	if ((int)path < 0 || path >= SCOREBOARD_PERF_PATH_COUNT)
+		return "unknown";
+	return k_path_names[path];
+}
+
+void scoreboard_perf_add(struct scoreboard_perf_stats *stats, uint64_t ns,
+			 unsigned int items)
+{
+	int bucket = 0;
+	while (bucket < SCOREBOARD_PERF_BUCKETS - 1 &&
+	       ns >= k_bucket_limits_ns[bucket])
+		bucket++;
+	stats->calls++;
+	stats->items += items;
+	stats->total_ns += ns;
+	if (ns > stats->max_ns)
+		stats->max_ns = ns;
+	stats->buckets[bucket]++;
+}
+
+void scoreboard_perf_record(enum scoreboard_perf_path path, uint64_t start_ns,
+			    unsigned int items)
+{
+	if ((int)path < 0 || path >= SCOREBOARD_PERF_PATH_COUNT)
+		return;
+	scoreboard_perf_add(&g_perf[path], scoreboard_perf_now() - start_ns,
+			    items);
+}
+
+void scoreboard_get_perf_stats(enum scoreboard_perf_path path,
+			       struct scoreboard_perf_stats *out)
+{
+	if (out == NULL)
+		return;
+	if ((int)path < 0 || path >= SCOREBOARD_PERF_PATH_COUNT) {
+		memset(out, 0, sizeof(*out));
+		return;
+	}
+	*out = g_perf[path];
+}
+
+void scoreboard_reset_perf_stats(void)
+{
+	memset(g_perf, 0, sizeof(g_perf));
+}
+
+/* ---- report ---- */
+
+static void append_text(char *buf, size_t size, size_t *offset,
+			const char *text)
+{
+	size_t len = strlen(text);
+	if (*offset + len >= size)
+		len = size - 1 - *offset;
+	memcpy(buf + *offset, text, len);
+	*offset += len;
+	buf[*offset] = '\0';
+}
+
+static void append_path(char *buf, size_t size, size_t *offset,
+			const char *name,
+			const struct scoreboard_perf_stats *stats)
+{
+	char line[160];
+	unsigned long long avg =
+		stats->calls > 0 ? stats->total_ns / stats->calls : 0;
+	snprintf(line, sizeof(line),
+		 "%s: calls=%llu items=%llu avg_us=%llu max_us=%llu\n ",
+		 name, stats->calls, stats->items, avg / 1000,
+		 stats->max_ns / 1000);
+	append_text(buf, size, offset, line);
+
+	for (int i = 0; i < SCOREBOARD_PERF_BUCKETS; i++) {
+		/* The last bucket is open-ended above the one before it */
+		bool last = k_bucket_limits_ns[i] == 0;
+		uint64_t limit = k_bucket_limits_ns[last ? i - 1 : i];
+		const char *op = last ? ">=" : "<";
+		if (limit >= 1000000)
+			snprintf(line, sizeof(line), " %s%llums=%llu", op,
+				 (unsigned long long)(limit / 1000000),
+				 stats->buckets[i]);
+		else
+			snprintf(line, sizeof(line), " %s%lluus=%llu", op,
+				 (unsigned long long)(limit / 1000),
+				 stats->buckets[i]);
+		append_text(buf, size, offset, line);
+	}
+	append_text(buf, size, offset, "\n");
+}
+
+size_t scoreboard_format_perf_stats(char *buf, size_t size)
+{
+	if (buf == NULL || size == 0)
+		return 0;
+	buf[0] = '\0';
+
+	size_t len = 0;
+	for (int i = 0; i < SCOREBOARD_PERF_PATH_COUNT; i++)
+		append_path(buf, size, &len, k_path_names[i], &g_perf[i]);
+
+	struct scoreboard_writer_stats writer;
+	scoreboard_writer_get_stats(&writer);
+	append_path(buf, size, &len, "writer_replace_file", &writer.replace);
+	return len;
+}
+
+bool scoreboard_write_perf_stats(const char *path)
+{
+	char report[4096];
+	if (path == NULL || path[0] == '\0')
+		return false;
+	scoreboard_format_perf_stats(report, sizeof(report));
+	return scoreboard_replace_file(path, report);
+}
@@ -0,0 +1,344 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L /* clock_gettime, nanosleep, mmap */
+#endif
+
+#include "scoreboard-platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+/* ---- locks ---- */
+
+#ifdef _WIN32
+
+void scoreboard_mutex_init(scoreboard_mutex_t *mutex)
+{
+	InitializeSRWLock(mutex);
+}
+
+void scoreboard_mutex_destroy(scoreboard_mutex_t *mutex)
+{
+	(void)mutex;
+}
+
+void scoreboard_mutex_lock(scoreboard_mutex_t *mutex)
+{
+	AcquireSRWLockExclusive(mutex);
+}
+
+void scoreboard_mutex_unlock(scoreboard_mutex_t *mutex)
+{
+	ReleaseSRWLockExclusive(mutex);
+}
+
+void scoreboard_cond_init(scoreboard_cond_t *cond)
+{
+	InitializeConditionVariable(cond);
+}
+
+void scoreboard_cond_destroy(scoreboard_cond_t *cond)
+{
+	(void)cond;
+}
+
+void scoreboard_cond_wait(scoreboard_cond_t *cond, scoreboard_mutex_t *mutex)
+{
+	SleepConditionVariableSRW(cond, mutex, INFINITE, 0);
+}
+
+void scoreboard_cond_broadcast(scoreboard_cond_t *cond)
+{
+	WakeAllConditionVariable(cond);
+}
+
+#else
+
+void scoreboard_mutex_init(scoreboard_mutex_t *mutex)
+{
+	pthread_mutex_init(mutex, NULL);
+}
+
+void scoreboard_mutex_destroy(scoreboard_mutex_t *mutex)
+{
+	pthread_mutex_destroy(mutex);
+}
+
+void scoreboard_mutex_lock(scoreboard_mutex_t *mutex)
+{
+	pthread_mutex_lock(mutex);
+}
+
+void scoreboard_mutex_unlock(scoreboard_mutex_t *mutex)
+{
+	pthread_mutex_unlock(mutex);
+}
+
+void scoreboard_cond_init(scoreboard_cond_t *cond)
+{
+	pthread_cond_init(cond, NULL);
+}
+
+void scoreboard_cond_destroy(scoreboard_cond_t *cond)
+{
+	pthread_cond_destroy(cond);
+}
+
+void scoreboard_cond_wait(scoreboard_cond_t *cond, scoreboard_mutex_t *mutex)
+{
+	pthread_cond_wait(cond, mutex);
+}
+
+void scoreboard_cond_broadcast(scoreboard_cond_t *cond)
+{
+	pthread_cond_broadcast(cond);
+}
+
+#endif
+
+/* ---- time ---- */
+
+#ifdef _WIN32
+
+uint64_t scoreboard_monotonic_ns(void)
+{
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	if (frequency.QuadPart == 0)
+		QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	/* Split to keep counter * 1e9 from overflowing */
+	uint64_t secs = (uint64_t)(counter.QuadPart / frequency.QuadPart);
+	uint64_t rest = (uint64_t)(counter.QuadPart % frequency.QuadPart);
+	return secs * 1000000000ull +
+	       rest * 1000000000ull / (uint64_t)frequency.QuadPart;
+}
+
+void scoreboard_sleep_ns(uint64_t ns)
+{
+	Sleep((DWORD)((ns + 999999ull) / 1000000ull));
+}
+
+#else
+
+uint64_t scoreboard_monotonic_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void scoreboard_sleep_ns(uint64_t ns)
+{
+	struct timespec ts;
+	ts.tv_sec = (time_t)(ns / 1000000000ull);
+	ts.tv_nsec = (long)(ns % 1000000000ull);
+	while (nanosleep(&ts, &ts) != 0)
+		;
+}
+
+#endif
+
+/* ---- threads ---- */
+
+struct thread_start {
+	scoreboard_thread_fn fn;
+	void *arg;
+};
+
+#ifdef _WIN32
+
+static DWORD WINAPI thread_main(LPVOID param)
+{
+	struct thread_start start = *(struct thread_start *)param;
+	free(param);
+	start.fn(start.arg);
+	return 0;
+}
+
+bool scoreboard_thread_create(scoreboard_thread_t *thread,
+			      scoreboard_thread_fn fn, void *arg)
+{
+	struct thread_start *start =
+		(struct thread_start *)malloc(sizeof(*start));
+	if (start == NULL)
+		return false;
+	start->fn = fn;
+	start->arg = arg;
+	*thread = CreateThread(NULL, 0, thread_main, start, 0, NULL);
+	if (*thread == NULL) {
+		free(start);
+		return false;
+	}
+	return true;
+}
+
+void scoreboard_thread_join(scoreboard_thread_t thread)
+{
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+}
+
+#else
+
+static void *thread_main(void *param)
+{
+	struct thread_start start = *(struct thread_start *)param;
+	free(param);
+	start.fn(start.arg);
+	return NULL;
+}
+
+bool scoreboard_thread_create(scoreboard_thread_t *thread,
+			      scoreboard_thread_fn fn, void *arg)
+{
+	struct thread_start *start =
+		(struct thread_start *)malloc(sizeof(*start));
+	if (start == NULL)
+		return false;
+	start->fn = fn;
+	start->arg = arg;
+	if (pthread_create(thread, NULL, thread_main, start) != 0) {
+		free(start);
+		return false;
+	}
+	return true;
+}
+
+void scoreboard_thread_join(scoreboard_thread_t thread)
+{
+	pthread_join(thread, NULL);
+}
+
+#endif
+
+/* ---- files ---- */
+
+static bool write_whole_file(const char *path, const char *mode,
+			     const void *data, size_t size)
+{
+	FILE *f = fopen(path, mode);
+	if (f == NULL)
+		return false;
+	bool ok = fwrite(data, 1, size, f) == size;
+	ok = fclose(f) == 0 && ok;
+	return ok;
+}
+
+static bool replace_file(const char *path, const char *mode,
+			 const void *data, size_t size)
+{
+	char tmp_path[1040];
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	if (!write_whole_file(tmp_path, mode, data, size)) {
+		remove(tmp_path);
+		return false;
+	}
+#ifdef _WIN32
+	/* Replacing fails while another process holds the file open without
+	   delete sharing (some text sources do); fall back to an in-place
+	   write rather than dropping the update. */
+	if (MoveFileExA(tmp_path, path, MOVEFILE_REPLACE_EXISTING))
+		return true;
+	remove(tmp_path);
+	return write_whole_file(path, mode, data, size);
+#else
+	if (rename(tmp_path, path) == 0)
+		return true;
+	remove(tmp_path);
+	return false;
+#endif
+}
+
+bool scoreboard_replace_file(const char *path, const char *content)
+{
+	return replace_file(path, "w", content, strlen(content));
+}
+
+bool scoreboard_replace_file_data(const char *path, const void *data,
+				  size_t size)
+{
+	return replace_file(path, "wb", data, size);
+}
+
+#ifdef _WIN32
+
+bool scoreboard_map_file(const char *path, struct scoreboard_file_map *map)
+{
+	memset(map, 0, sizeof(*map));
+	map->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+				OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (map->file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(map->file, &size) || size.QuadPart <= 0 ||
+	    (unsigned long long)size.QuadPart > SIZE_MAX) {
+		CloseHandle(map->file);
+		return false;
+	}
+	map->mapping = CreateFileMappingA(map->file, NULL, PAGE_READONLY, 0, 0,
+					  NULL);
+	if (map->mapping == NULL) {
+		CloseHandle(map->file);
+		return false;
+	}
+	map->data = MapViewOfFile(map->mapping, FILE_MAP_READ, 0, 0, 0);
+	if (map->data == NULL) {
+		CloseHandle(map->mapping);
+		CloseHandle(map->file);
+		return false;
+	}
+	map->size = (size_t)size.QuadPart;
+	return true;
+}
+
+void scoreboard_unmap_file(struct scoreboard_file_map *map)
+{
+	if (map->data == NULL)
+		return;
+	UnmapViewOfFile(map->data);
+	CloseHandle(map->mapping);
+	CloseHandle(map->file);
+	memset(map, 0, sizeof(*map));
+}
+
+#else
+
+bool scoreboard_map_file(const char *path, struct scoreboard_file_map *map)
+{
+	memset(map, 0, sizeof(*map));
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+		close(fd);
+		return false;
+	}
+	void *data =
+		mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	/* The mapping stays valid after the descriptor is closed */
+	close(fd);
+	if (data == MAP_FAILED)
+		return false;
+	map->data = data;
+	map->size = (size_t)st.st_size;
+	return true;
+}
+
+void scoreboard_unmap_file(struct scoreboard_file_map *map)
+{
+	if (map->data == NULL)
+		return;
+	munmap((void *)map->data, map->size);
+	memset(map, 0, sizeof(*map));
+}
+
+#endif
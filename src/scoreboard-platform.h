@@ -0,0 +1,120 @@
+#ifndef SCOREBOARD_PLATFORM_H
+#define SCOREBOARD_PLATFORM_H
+
+/* Internal portability layer for the core library: threads, locks, the
+   monotonic clock and atomic file replacement. Not part of the public
+   API. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+typedef SRWLOCK scoreboard_mutex_t;
+typedef CONDITION_VARIABLE scoreboard_cond_t;
+typedef HANDLE scoreboard_thread_t;
+#else
+#include <pthread.h>
+typedef pthread_mutex_t scoreboard_mutex_t;
+typedef pthread_cond_t scoreboard_cond_t;
+typedef pthread_t scoreboard_thread_t;
+#endif
+
+typedef void (*scoreboard_thread_fn)(void *arg);
+
+void scoreboard_mutex_init(scoreboard_mutex_t *mutex);
+void scoreboard_mutex_destroy(scoreboard_mutex_t *mutex);
+void scoreboard_mutex_lock(scoreboard_mutex_t *mutex);
+void scoreboard_mutex_unlock(scoreboard_mutex_t *mutex);
+
+void scoreboard_cond_init(scoreboard_cond_t *cond);
+void scoreboard_cond_destroy(scoreboard_cond_t *cond);
+void scoreboard_cond_wait(scoreboard_cond_t *cond, scoreboard_mutex_t *mutex);
+void scoreboard_cond_broadcast(scoreboard_cond_t *cond);
+
+bool scoreboard_thread_create(scoreboard_thread_t *thread,
+			      scoreboard_thread_fn fn, void *arg);
+void scoreboard_thread_join(scoreboard_thread_t thread);
+
+/* 32-bit atomics: acquire loads, release stores and a full-barrier
+   compare-and-swap */
+static inline uint32_t scoreboard_atomic_load(const volatile uint32_t *p)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	uint32_t value = *p;
+	MemoryBarrier();
+	return value;
+#else
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static inline void scoreboard_atomic_store(volatile uint32_t *p,
+					   uint32_t value)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	MemoryBarrier();
+	*p = value;
+#else
+	__atomic_store_n(p, value, __ATOMIC_RELEASE);
+#endif
+}
+
+static inline bool scoreboard_atomic_cas(volatile uint32_t *p,
+					 uint32_t expected, uint32_t desired)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	return (uint32_t)InterlockedCompareExchange((volatile LONG *)p,
+						    (LONG)desired,
+						    (LONG)expected) ==
+	       expected;
+#else
+	return __atomic_compare_exchange_n(p, &expected, desired, false,
+					   __ATOMIC_SEQ_CST,
+					   __ATOMIC_SEQ_CST);
+#endif
+}
+
+static inline uint32_t scoreboard_atomic_add(volatile uint32_t *p,
+					     uint32_t delta)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	return (uint32_t)InterlockedExchangeAdd((volatile LONG *)p,
+						(LONG)delta) +
+	       delta;
+#else
+	return __atomic_add_fetch(p, delta, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/* Nanoseconds on a clock that never jumps with wall-clock changes */
+uint64_t scoreboard_monotonic_ns(void);
+/* Sleeps at least ns nanoseconds (Windows rounds up to milliseconds) */
+void scoreboard_sleep_ns(uint64_t ns);
+
+/* Write content to path via a sibling temp file and rename, so readers
+   never observe a truncated or half-written file. */
+bool scoreboard_replace_file(const char *path, const char *content);
+/* Same, for binary data */
+bool scoreboard_replace_file_data(const char *path, const void *data,
+				  size_t size);
+
+/* A whole file mapped read-only into memory */
+struct scoreboard_file_map {
+	const void *data;
+	size_t size;
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#endif
+};
+
+/* Fails for a missing or empty file */
+bool scoreboard_map_file(const char *path, struct scoreboard_file_map *map);
+void scoreboard_unmap_file(struct scoreboard_file_map *map);
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L /* ftruncate */
+#endif
+
+#include "scoreboard-core.h"
+#include "scoreboard-shm.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static struct {
+	struct scoreboard_shm_segment *segment;
+	char os_name[256];
+#ifdef _WIN32
+	HANDLE mapping;
+#endif
+	/* Last state copied into the segment; republishing an identical
+	   state would only make readers spin for nothing */
+	struct scoreboard_shm_state published;
+} g_shm;
+
+static void copy_text(char *dst, size_t size, const char *src)
+{
+	snprintf(dst, size, "%s", src != NULL ? src : "");
+}
+
+static void copy_penalties(struct scoreboard_shm_penalty *dst, bool home)
+{
+	for (int i = 0; i < SCOREBOARD_SHM_PENALTIES; i++) {
+		const struct scoreboard_penalty *p =
+			home ? scoreboard_get_home_penalty(i)
+			     : scoreboard_get_away_penalty(i);
+		dst[i].player_number = p->player_number;
+		dst[i].remaining_tenths = p->remaining_tenths;
+		dst[i].phase2_tenths = p->phase2_tenths;
+		dst[i].active = p->active ? 1 : 0;
+	}
+}
+
+static void capture_state(struct scoreboard_shm_state *s)
+{
+	memset(s, 0, sizeof(*s));
+	s->clock_tenths = scoreboard_clock_get_tenths();
+	s->clock_running = scoreboard_clock_is_running() ? 1 : 0;
+	s->clock_direction = (int32_t)scoreboard_get_clock_direction();
+	s->period_length = scoreboard_get_period_length();
+	s->period = scoreboard_get_period();
+	s->sport = (int32_t)scoreboard_get_sport();
+
+	s->home_score = scoreboard_get_home_score();
+	s->away_score = scoreboard_get_away_score();
+	s->home_shots = scoreboard_get_home_shots();
+	s->away_shots = scoreboard_get_away_shots();
+	s->home_faceoffs = scoreboard_get_home_faceoffs();
+	s->away_faceoffs = scoreboard_get_away_faceoffs();
+	s->home_fouls = scoreboard_get_home_fouls();
+	s->away_fouls = scoreboard_get_away_fouls();
+	s->home_fouls2 = scoreboard_get_home_fouls2();
+	s->away_fouls2 = scoreboard_get_away_fouls2();
+
+	scoreboard_clock_format(s->clock_text, sizeof(s->clock_text));
+	scoreboard_format_period(s->period_text, sizeof(s->period_text));
+	copy_text(s->sport_name, sizeof(s->sport_name),
+		  scoreboard_sport_name(scoreboard_get_sport()));
+	copy_text(s->home_name, sizeof(s->home_name),
+		  scoreboard_get_home_name());
+	copy_text(s->away_name, sizeof(s->away_name),
+		  scoreboard_get_away_name());
+
+	copy_penalties(s->home_penalties, true);
+	copy_penalties(s->away_penalties, false);
+}
+
+static void write_segment(const struct scoreboard_shm_state *s)
+{
+	struct scoreboard_shm_segment *seg = g_shm.segment;
+	uint32_t seq = seg->seq;
+
+	scoreboard_shm_store_seq(&seg->seq, seq + 1);
+	scoreboard_shm_fence();
+	memcpy(&seg->state, s, sizeof(*s));
+	scoreboard_shm_store_seq(&seg->seq, seq + 2);
+}
+
+static bool map_segment(const char *name)
+{
+	size_t size = sizeof(struct scoreboard_shm_segment);
+#ifdef _WIN32
+	snprintf(g_shm.os_name, sizeof(g_shm.os_name), "Local\\%s", name);
+	g_shm.mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL,
+					   PAGE_READWRITE, 0, (DWORD)size,
+					   g_shm.os_name);
+	if (g_shm.mapping == NULL)
+		return false;
+	g_shm.segment = (struct scoreboard_shm_segment *)MapViewOfFile(
+		g_shm.mapping, FILE_MAP_WRITE, 0, 0, size);
+	if (g_shm.segment == NULL) {
+		CloseHandle(g_shm.mapping);
+		g_shm.mapping = NULL;
+		return false;
+	}
+#else
+	snprintf(g_shm.os_name, sizeof(g_shm.os_name), "/%s", name);
+	int fd = shm_open(g_shm.os_name, O_RDWR | O_CREAT, 0644);
+	if (fd < 0)
+		return false;
+	if (ftruncate(fd, (off_t)size) != 0) {
+		close(fd);
+		shm_unlink(g_shm.os_name);
+		return false;
+	}
+	void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+			  0);
+	close(fd);
+	if (addr == MAP_FAILED) {
+		shm_unlink(g_shm.os_name);
+		return false;
+	}
+	g_shm.segment = (struct scoreboard_shm_segment *)addr;
+#endif
+	return true;
+}
+
+bool scoreboard_shm_open(const char *name)
+{
+	if (name == NULL || name[0] == '\0')
+		return false;
+	if (g_shm.segment != NULL)
+		scoreboard_shm_close();
+	if (!map_segment(name))
+		return false;
+
+	/* A segment left behind by a crashed session may hold any layout;
+	   readers ignore it until the magic is written last */
+	struct scoreboard_shm_segment *seg = g_shm.segment;
+	scoreboard_shm_store_seq(&seg->magic, 0);
+	seg->version = SCOREBOARD_SHM_VERSION;
+	seg->size = (uint32_t)sizeof(*seg);
+	seg->seq = 0;
+	memset(&g_shm.published, 0, sizeof(g_shm.published));
+	capture_state(&g_shm.published);
+	g_shm.published.generation = 1;
+	memcpy(&seg->state, &g_shm.published, sizeof(seg->state));
+	scoreboard_shm_store_seq(&seg->magic, SCOREBOARD_SHM_MAGIC);
+	return true;
+}
+
+void scoreboard_shm_close(void)
+{
+	if (g_shm.segment == NULL)
+		return;
+	/* Tell readers that still hold the mapping the data is gone */
+	scoreboard_shm_store_seq(&g_shm.segment->magic, 0);
+#ifdef _WIN32
+	UnmapViewOfFile(g_shm.segment);
+	CloseHandle(g_shm.mapping);
+	g_shm.mapping = NULL;
+#else
+	munmap(g_shm.segment, sizeof(struct scoreboard_shm_segment));
+	shm_unlink(g_shm.os_name);
+#endif
+	g_shm.segment = NULL;
+}
+
+bool scoreboard_shm_is_open(void)
+{
+	return g_shm.segment != NULL;
+}
+
+bool scoreboard_shm_publish(void)
+{
+	if (g_shm.segment == NULL)
+		return false;
+
+	struct scoreboard_shm_state next;
+	capture_state(&next);
+	next.generation = g_shm.published.generation;
+	if (memcmp(&next, &g_shm.published, sizeof(next)) == 0)
+		return false;
+
+	next.generation++;
+	write_segment(&next);
+	g_shm.published = next;
+	return true;
+}
@@ -0,0 +1,234 @@
+#include "scoreboard-core.h"
+#include "scoreboard-platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WRITER_MAX_PENDING 64
+#define WRITER_MAX_PATH 1024
+
+/* One slot per file path. A slot stays claimed while its file is queued or
+   being written so a newer value for the same path replaces the queued one
+   instead of lining up behind it. A slot whose last write failed stays
+   claimed until its owner takes the failure back. */
+struct pending_file {
+	char path[WRITER_MAX_PATH];
+	char *content;
+	bool in_use;
+	bool pending;
+	bool busy;
+	bool failed;
+};
+
+static struct {
+	scoreboard_mutex_t lock;
+	scoreboard_cond_t wake;
+	scoreboard_cond_t idle;
+	scoreboard_thread_t thread;
+	bool running;
+	bool stopping;
+	struct pending_file files[WRITER_MAX_PENDING];
+	struct scoreboard_writer_stats stats;
+} g_writer;
+
+static char *copy_string(const char *src)
+{
+	size_t len = strlen(src);
+	char *dst = (char *)malloc(len + 1);
+	if (dst != NULL)
+		memcpy(dst, src, len + 1);
+	return dst;
+}
+
+static struct pending_file *next_pending(void)
+{
+	for (int i = 0; i < WRITER_MAX_PENDING; i++) {
+		if (g_writer.files[i].pending)
+			return &g_writer.files[i];
+	}
+	return NULL;
+}
+
+static bool writer_has_work(void)
+{
+	for (int i = 0; i < WRITER_MAX_PENDING; i++) {
+		if (g_writer.files[i].pending || g_writer.files[i].busy)
+			return true;
+	}
+	return false;
+}
+
+static void writer_main(void *arg)
+{
+	(void)arg;
+	char path[WRITER_MAX_PATH];
+
+	scoreboard_mutex_lock(&g_writer.lock);
+	for (;;) {
+		struct pending_file *file = next_pending();
+		if (file == NULL) {
+			scoreboard_cond_broadcast(&g_writer.idle);
+			if (g_writer.stopping)
+				break;
+			scoreboard_cond_wait(&g_writer.wake, &g_writer.lock);
+			continue;
+		}
+
+		char *content = file->content;
+		file->content = NULL;
+		file->pending = false;
+		file->busy = true;
+		memcpy(path, file->path, sizeof(path));
+		scoreboard_mutex_unlock(&g_writer.lock);
+
+		uint64_t start = scoreboard_perf_now();
+		bool ok = scoreboard_replace_file(path, content);
+		uint64_t elapsed = scoreboard_perf_now() - start;
+		free(content);
+
+		scoreboard_mutex_lock(&g_writer.lock);
+		scoreboard_perf_add(&g_writer.stats.replace, elapsed, 1);
+		file->busy = false;
+		/* A newer value still queued reports for itself */
+		file->failed = !ok && !file->pending;
+		if (!file->pending && !file->failed)
+			file->in_use = false;
+		if (ok)
+			g_writer.stats.written++;
+		else
+			g_writer.stats.errors++;
+	}
+	scoreboard_mutex_unlock(&g_writer.lock);
+}
+
+bool scoreboard_writer_start(void)
+{
+	if (g_writer.running)
+		return true;
+	memset(g_writer.files, 0, sizeof(g_writer.files));
+	memset(&g_writer.stats, 0, sizeof(g_writer.stats));
+	g_writer.stopping = false;
+	scoreboard_mutex_init(&g_writer.lock);
+	scoreboard_cond_init(&g_writer.wake);
+	scoreboard_cond_init(&g_writer.idle);
+	if (!scoreboard_thread_create(&g_writer.thread, writer_main, NULL)) {
+		scoreboard_cond_destroy(&g_writer.idle);
+		scoreboard_cond_destroy(&g_writer.wake);
+		scoreboard_mutex_destroy(&g_writer.lock);
+		return false;
+	}
+	g_writer.running = true;
+	return true;
+}
+
+void scoreboard_writer_stop(void)
+{
+	if (!g_writer.running)
+		return;
+	/* The worker drains everything still queued before it exits */
+	scoreboard_mutex_lock(&g_writer.lock);
+	g_writer.stopping = true;
+	scoreboard_cond_broadcast(&g_writer.wake);
+	scoreboard_mutex_unlock(&g_writer.lock);
+	scoreboard_thread_join(g_writer.thread);
+
+	g_writer.running = false;
+	scoreboard_cond_destroy(&g_writer.idle);
+	scoreboard_cond_destroy(&g_writer.wake);
+	scoreboard_mutex_destroy(&g_writer.lock);
+}
+
+bool scoreboard_writer_is_running(void)
+{
+	return g_writer.running;
+}
+
+bool scoreboard_writer_submit(const char *path, const char *content)
+{
+	if (path == NULL || content == NULL)
+		return false;
+	if (!g_writer.running || strlen(path) >= WRITER_MAX_PATH)
+		return scoreboard_replace_file(path, content);
+
+	char *copy = copy_string(content);
+	if (copy == NULL)
+		return false;
+
+	scoreboard_mutex_lock(&g_writer.lock);
+	struct pending_file *slot = NULL;
+	struct pending_file *free_slot = NULL;
+	for (int i = 0; i < WRITER_MAX_PENDING; i++) {
+		struct pending_file *f = &g_writer.files[i];
+		if (f->in_use && strcmp(f->path, path) == 0) {
+			slot = f;
+			break;
+		}
+		if (!f->in_use && free_slot == NULL)
+			free_slot = f;
+	}
+	if (slot == NULL && free_slot == NULL) {
+		/* Every slot is taken by another file; write it here */
+		scoreboard_mutex_unlock(&g_writer.lock);
+		bool ok = scoreboard_replace_file(path, copy);
+		free(copy);
+		return ok;
+	}
+	if (slot == NULL) {
+		slot = free_slot;
+		snprintf(slot->path, sizeof(slot->path), "%s", path);
+		slot->in_use = true;
+	}
+	if (slot->pending) {
+		free(slot->content);
+		g_writer.stats.coalesced++;
+	}
+	slot->content = copy;
+	slot->pending = true;
+	slot->failed = false;
+	g_writer.stats.queued++;
+	scoreboard_cond_broadcast(&g_writer.wake);
+	scoreboard_mutex_unlock(&g_writer.lock);
+	return true;
+}
+
+void scoreboard_writer_flush(void)
+{
+	if (!g_writer.running)
+		return;
+	scoreboard_mutex_lock(&g_writer.lock);
+	while (writer_has_work())
+		scoreboard_cond_wait(&g_writer.idle, &g_writer.lock);
+	scoreboard_mutex_unlock(&g_writer.lock);
+}
+
+int scoreboard_writer_take_failed(scoreboard_writer_failed_fn fn, void *data)
+{
+	if (!g_writer.running || fn == NULL)
+		return 0;
+	int taken = 0;
+	scoreboard_mutex_lock(&g_writer.lock);
+	for (int i = 0; i < WRITER_MAX_PENDING; i++) {
+		struct pending_file *f = &g_writer.files[i];
+		if (!f->failed || !fn(f->path, data))
+			continue;
+		f->failed = false;
+		f->in_use = false;
+		taken++;
+	}
+	scoreboard_mutex_unlock(&g_writer.lock);
+	return taken;
+}
+
+void scoreboard_writer_get_stats(struct scoreboard_writer_stats *out)
+{
+	if (out == NULL)
+		return;
+	if (!g_writer.running) {
+		*out = g_writer.stats;
+		return;
+	}
+	scoreboard_mutex_lock(&g_writer.lock);
+	*out = g_writer.stats;
+	scoreboard_mutex_unlock(&g_writer.lock);
+}
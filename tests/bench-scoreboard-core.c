@@ -0,0 +1,347 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L /* getpid */
+#endif
+
+/* Microbenchmarks for the core hot paths. Not part of ctest: run
+   scoreboard_core_bench [dir...] (or make bench) and compare ns/op and
+   I/O syscalls/op before and after a change. Each directory gets its own
+   scratch subdirectory; the defaults are /dev/shm (tmpfs) and the
+   current directory (disk). */
+
+#include "scoreboard-core.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define getpid() _getpid()
+#define mkdir(path, mode) _mkdir(path)
+#else
+#include <unistd.h>
+#endif
+
+struct bench {
+	const char *name;
+	int ops;
+	void (*setup)(void);
+	void (*op)(int i);
+};
+
+/* A long game's worth of events; the log itself has no limit */
+#define BENCH_EVENTS 256
+
+static char g_dir[512];
+static char g_path[600];
+
+/* ---- syscall counting ---- */
+
+/* Read and write class syscalls from /proc/self/io; -1 where the
+   platform has no such counter. Opens, renames and closes are not
+   included, so treat the figure as a lower bound. */
+static long long syscall_count(void)
+{
+	FILE *f = fopen("/proc/self/io", "r");
+	if (f == NULL)
+		return -1;
+	char line[128];
+	long long total = 0;
+	while (fgets(line, sizeof(line), f) != NULL) {
+		long long value;
+		if (sscanf(line, "syscr: %lld", &value) == 1 ||
+		    sscanf(line, "syscw: %lld", &value) == 1)
+			total += value;
+	}
+	fclose(f);
+	return total;
+}
+
+/* ---- benchmarks ---- */
+
+static void setup_output(void)
+{
+	scoreboard_reset_state_for_tests();
+	scoreboard_set_output_directory(g_dir);
+	scoreboard_write_all_files();
+}
+
+static void setup_json_output(void)
+{
+	setup_output();
+	scoreboard_set_output_mode(SCOREBOARD_OUTPUT_JSON);
+	scoreboard_write_all_files();
+}
+
+static void op_write_all_dirty(int i)
+{
+	(void)i;
+	scoreboard_mark_dirty();
+	scoreboard_write_all_files();
+}
+
+static void op_write_one_field(int i)
+{
+	scoreboard_set_home_shots(i);
+	scoreboard_write_all_files();
+}
+
+static void op_read_all(int i)
+{
+	(void)i;
+	scoreboard_read_all_files();
+}
+
+static void setup_state_file(void)
+{
+	setup_output();
+	scoreboard_home_penalty_add(12, 120);
+	scoreboard_away_penalty_add(7, 300);
+	snprintf(g_path, sizeof(g_path), "%s/state.json", g_dir);
+	scoreboard_save_state(g_path);
+}
+
+static void op_save_state(int i)
+{
+	scoreboard_set_home_score(i);
+	scoreboard_save_state(g_path);
+}
+
+static void op_load_state(int i)
+{
+	(void)i;
+	scoreboard_load_state(g_path);
+}
+
+static void setup_binary_state_file(void)
+{
+	setup_state_file();
+	snprintf(g_path, sizeof(g_path), "%s/state.bin", g_dir);
+	scoreboard_save_state_binary(g_path);
+}
+
+static void op_save_state_binary(int i)
+{
+	scoreboard_set_home_score(i);
+	scoreboard_save_state_binary(g_path);
+}
+
+static void op_load_state_binary(int i)
+{
+	(void)i;
+	scoreboard_load_state_binary(g_path);
+}
+
+static void setup_journal(void)
+{
+	char snapshot[600];
+	setup_output();
+	snprintf(snapshot, sizeof(snapshot), "%s/state.bin", g_dir);
+	snprintf(g_path, sizeof(g_path), "%s/state.journal", g_dir);
+	scoreboard_journal_open(snapshot, g_path);
+}
+
+static void op_journal_sync(int i)
+{
+	scoreboard_set_home_shots(i);
+	scoreboard_journal_sync();
+}
+
+static void setup_penalties(void)
+{
+	scoreboard_reset_state_for_tests();
+	for (int i = 0; i < SCOREBOARD_MAX_PENALTIES; i++) {
+		scoreboard_home_penalty_add(i + 1, 120);
+		scoreboard_away_penalty_add(i + 1, 120);
+	}
+}
+
+static void op_penalty_tick(int i)
+{
+	(void)i;
+	scoreboard_penalty_tick(1);
+	/* Keep the slots full instead of measuring an empty board */
+	if (scoreboard_get_home_penalty_count() < SCOREBOARD_MAX_PENALTIES)
+		setup_penalties();
+}
+
+static void setup_events(void)
+{
+	scoreboard_reset_state_for_tests();
+	scoreboard_event_log_clear();
+}
+
+static void op_event_add(int i)
+{
+	/* Cleared now and then so the run measures appends, not memory */
+	if (scoreboard_event_log_count() >= BENCH_EVENTS * 16)
+		scoreboard_event_log_clear();
+	scoreboard_event_log_add(i, "Goal - Home #12");
+}
+
+static void setup_full_event_log(void)
+{
+	setup_events();
+	for (int i = 0; i < BENCH_EVENTS; i++)
+		scoreboard_event_log_add(i, i % 2 ? "Goal - Home" : "Shot");
+}
+
+static void setup_event_file(void)
+{
+	setup_full_event_log();
+	snprintf(g_path, sizeof(g_path), "%s/timestamps.txt", g_dir);
+	scoreboard_event_log_write(g_path);
+}
+
+static void setup_open_event_file(void)
+{
+	setup_full_event_log();
+	snprintf(g_path, sizeof(g_path), "%s/timestamps.txt", g_dir);
+	scoreboard_event_log_open(g_path);
+}
+
+static void op_event_find_last(int i)
+{
+	(void)i;
+	scoreboard_event_log_find_last("Goal");
+}
+
+static void op_event_write(int i)
+{
+	(void)i;
+	scoreboard_event_log_write(g_path);
+}
+
+/* Every chapter format from one pass over the log */
+static void op_event_export(int i)
+{
+	(void)i;
+	snprintf(g_path, sizeof(g_path), "%s/timestamps", g_dir);
+	scoreboard_event_log_export(
+		SCOREBOARD_TIMELINE_STREAM, g_path, SCOREBOARD_CHAPTERS_ALL);
+}
+
+static void op_event_read(int i)
+{
+	(void)i;
+	/* A restore into an empty log, as at startup */
+	scoreboard_event_log_clear();
+	scoreboard_event_log_read(g_path);
+}
+
+static void op_command_post_drain(int i)
+{
+	struct scoreboard_command cmd = {SCOREBOARD_CMD_SHOTS,
+					 SCOREBOARD_TEAM_HOME, 1, 0};
+	scoreboard_command_post(&cmd);
+	/* Drain in batches, the way the dock does */
+	if (i % 16 == 15)
+		scoreboard_command_drain(NULL, NULL);
+}
+
+static const struct bench k_file_benches[] = {
+	{"write_all_files (all dirty)", 2000, setup_output,
+	 op_write_all_dirty},
+	{"write_all_files (one field)", 20000, setup_output,
+	 op_write_one_field},
+	{"write_all_files (json)", 20000, setup_json_output,
+	 op_write_one_field},
+	{"read_all_files", 5000, setup_output, op_read_all},
+	{"save_state", 5000, setup_state_file, op_save_state},
+	{"load_state", 5000, setup_state_file, op_load_state},
+	{"save_state_binary", 5000, setup_binary_state_file,
+	 op_save_state_binary},
+	{"load_state_binary", 5000, setup_binary_state_file,
+	 op_load_state_binary},
+	{"event_log_write (full)", 2000, setup_event_file, op_event_write},
+	{"event_log_read (full)", 2000, setup_event_file, op_event_read},
+	{"event_log_export (all formats)", 2000, setup_full_event_log,
+	 op_event_export},
+	/* Last: the timestamps file and the journal stay open until the
+	   directory is done */
+	{"event_log_add (open file)", 20000, setup_open_event_file,
+	 op_event_add},
+	{"journal_sync (one field)", 20000, setup_journal, op_journal_sync},
+};
+
+static const struct bench k_memory_benches[] = {
+	{"penalty_tick", 1000000, setup_penalties, op_penalty_tick},
+	{"event_log_add", 1000000, setup_events, op_event_add},
+	{"event_log_find_last (full)", 200000, setup_full_event_log,
+	 op_event_find_last},
+	{"command_post+drain", 1000000, setup_events, op_command_post_drain},
+};
+
+/* ---- runner ---- */
+
+static void run_bench(const struct bench *b)
+{
+	b->setup();
+	long long sys_before = syscall_count();
+	uint64_t start = scoreboard_perf_now();
+	for (int i = 0; i < b->ops; i++)
+		b->op(i);
+	uint64_t elapsed = scoreboard_perf_now() - start;
+	long long sys_after = syscall_count();
+
+	double ns_per_op = (double)elapsed / b->ops;
+	if (sys_before < 0 || sys_after < 0)
+		printf("  %-30s %9d %12.0f %16s\n", b->name, b->ops,
+		       ns_per_op, "n/a");
+	else
+		printf("  %-30s %9d %12.0f %16.2f\n", b->name, b->ops,
+		       ns_per_op, (double)(sys_after - sys_before) / b->ops);
+}
+
+static void print_header(const char *label)
+{
+	printf("%s\n", label);
+	printf("  %-30s %9s %12s %16s\n", "benchmark", "ops", "ns/op",
+	       "io syscalls/op");
+}
+
+static void run_in_dir(const char *base)
+{
+	snprintf(g_dir, sizeof(g_dir), "%s/scoreboard-bench-%d", base,
+		 (int)getpid());
+	if (mkdir(g_dir, 0755) != 0) {
+		fprintf(stderr, "skipping %s: cannot create %s\n", base,
+			g_dir);
+		return;
+	}
+
+	print_header(base);
+	for (size_t i = 0; i < sizeof(k_file_benches) /
+				       sizeof(k_file_benches[0]);
+	     i++)
+		run_bench(&k_file_benches[i]);
+	scoreboard_event_log_close();
+	scoreboard_journal_close();
+
+	char cmd[600];
+	snprintf(cmd, sizeof(cmd), "rm -rf \"%s\"", g_dir);
+	if (system(cmd) != 0)
+		fprintf(stderr, "could not remove %s\n", g_dir);
+}
+
+int main(int argc, char **argv)
+{
+	const char *default_dirs[] = {"/dev/shm", "."};
+	const char **dirs = default_dirs;
+	int dir_count = 2;
+	if (argc > 1) {
+		dirs = (const char **)(argv + 1);
+		dir_count = argc - 1;
+	}
+
+	print_header("memory");
+	for (size_t i = 0; i < sizeof(k_memory_benches) /
+				       sizeof(k_memory_benches[0]);
+	     i++)
+		run_bench(&k_memory_benches[i]);
+
+	for (int i = 0; i < dir_count; i++)
+		run_in_dir(dirs[i]);
+	return 0;
+}
@@ -0,0 +1,47 @@
+/* Headless trace replayer. Not part of ctest: run
+   scoreboard_core_replay <trace> [speed] [output-dir] to feed a recorded
+   game back through the core. speed is 1 for real time, N for N times
+   faster and 0 (the default) for as fast as possible; with an output
+   directory every command's files are written there, which makes a trace
+   a realistic load for the output path. Exits non-zero unless the final
+   outputs match the recording. */
+
+#include "scoreboard-core.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char **argv)
+{
+	if (argc < 2 || argc > 4) {
+		fprintf(stderr, "usage: %s <trace> [speed] [output-dir]\n",
+			argv[0]);
+		return 2;
+	}
+	double speed = argc > 2 ? atof(argv[2]) : 0;
+	/* The same defaults the dock starts from */
+	scoreboard_reset_state_for_tests();
+	if (argc > 3)
+		scoreboard_set_output_directory(argv[3]);
+
+	struct scoreboard_replay_stats stats;
+	if (!scoreboard_trace_replay(argv[1], speed, NULL, NULL, &stats)) {
+		fprintf(stderr, "%s: not a readable trace\n", argv[1]);
+		return 2;
+	}
+
+	double trace_s = (double)stats.trace_ns / 1e9;
+	double elapsed_s = (double)stats.elapsed_ns / 1e9;
+	printf("commands       %u (%u user, not applied)\n", stats.commands,
+	       stats.user_commands);
+	/* What USER commands, buttons and dialogs did, as recorded */
+	printf("state changes  %u\n", stats.changes);
+	printf("game time      %.3f s\n", trace_s);
+	printf("replay time    %.3f s\n", elapsed_s);
+	if (elapsed_s > 0)
+		printf("throughput     %.0f commands/s, %.1fx real time\n",
+		       stats.commands / elapsed_s, trace_s / elapsed_s);
+	printf("outputs        %s\n",
+	       stats.outputs_match ? "match" : "DIFFER");
+	return stats.outputs_match ? 0 : 1;
+}
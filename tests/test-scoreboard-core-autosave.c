@@ -0,0 +1,228 @@
+#include "scoreboard-core.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define mkdir(path, mode) _mkdir(path)
+#define getpid() _getpid()
+#else
+#include <unistd.h>
+#endif
+
+static char g_tmp_dir[256];
+static char g_save_path[512];
+
+static void setup_tmp_dir(void)
+{
+#ifdef _WIN32
+	snprintf(g_tmp_dir, sizeof(g_tmp_dir), "%s\\scoreboard_autosave_%d",
+		 getenv("TEMP") ? getenv("TEMP") : ".", (int)getpid());
+#else
+	snprintf(g_tmp_dir, sizeof(g_tmp_dir), "/tmp/scoreboard_autosave_%d",
+		 (int)getpid());
+#endif
+	mkdir(g_tmp_dir, 0755);
+	snprintf(g_save_path, sizeof(g_save_path), "%s/autosave.json",
+		 g_tmp_dir);
+}
+
+static void cleanup_tmp_dir(void)
+{
+	char cmd[512];
+	snprintf(cmd, sizeof(cmd), "rm -rf %s", g_tmp_dir);
+	system(cmd);
+}
+
+static bool file_exists(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	if (f == NULL)
+		return false;
+	fclose(f);
+	return true;
+}
+
+static void test_generation(void)
+{
+	scoreboard_reset_state_for_tests();
+	uint64_t start = scoreboard_state_generation();
+
+	/* Reading doesn't count */
+	(void)scoreboard_get_home_score();
+	scoreboard_write_all_files();
+	assert(scoreboard_state_generation() == start);
+
+	scoreboard_increment_home_score();
+	uint64_t after_goal = scoreboard_state_generation();
+	assert(after_goal > start);
+	scoreboard_set_overtime_enabled(false);
+	assert(scoreboard_state_generation() > after_goal);
+
+	/* Each context counts its own changes */
+	struct scoreboard_ctx *other = scoreboard_ctx_create();
+	struct scoreboard_ctx *def = scoreboard_ctx_select(other);
+	uint64_t other_start = scoreboard_state_generation();
+	scoreboard_ctx_select(def);
+	scoreboard_increment_away_score();
+	scoreboard_ctx_select(other);
+	assert(scoreboard_state_generation() == other_start);
+	scoreboard_ctx_select(def);
+
+	/* A reset is a change too */
+	uint64_t before_reset = scoreboard_state_generation();
+	scoreboard_reset_state_for_tests();
+	assert(scoreboard_state_generation() > before_reset);
+}
+
+static void test_captured_state(void)
+{
+	setup_tmp_dir();
+	scoreboard_reset_state_for_tests();
+	struct scoreboard_saved_state *copy =
+		(struct scoreboard_saved_state *)malloc(
+			scoreboard_saved_state_size());
+	assert(copy != NULL);
+
+	scoreboard_set_home_name("Eagles");
+	scoreboard_set_home_score(2);
+	scoreboard_home_penalty_add_compound(12, 120, 300);
+	scoreboard_capture_state(copy);
+	/* Later changes don't reach the copy */
+	scoreboard_set_home_score(7);
+	scoreboard_set_overtime_enabled(false);
+
+	assert(scoreboard_save_captured_state(copy, g_save_path));
+
+	scoreboard_reset_state_for_tests();
+	assert(scoreboard_load_state(g_save_path));
+	assert(strcmp(scoreboard_get_home_name(), "Eagles") == 0);
+	assert(scoreboard_get_home_score() == 2);
+	assert(scoreboard_get_overtime_enabled());
+	assert(scoreboard_get_home_penalty(0)->phase2_tenths == 3000);
+
+	assert(!scoreboard_save_captured_state(NULL, g_save_path));
+	assert(!scoreboard_save_captured_state(copy, NULL));
+	assert(!scoreboard_save_captured_state(
+		copy, "/nonexistent/dir/autosave.json"));
+	free(copy);
+	cleanup_tmp_dir();
+}
+
+static void test_autosave_only_on_change(void)
+{
+	setup_tmp_dir();
+	scoreboard_reset_state_for_tests();
+	assert(scoreboard_autosave_start(g_save_path));
+	assert(scoreboard_autosave_is_running());
+
+	/* Nothing changed since the start */
+	assert(!scoreboard_autosave());
+	scoreboard_autosave_flush();
+	char slot_path[600];
+	snprintf(slot_path, sizeof(slot_path), "%s.0", g_save_path);
+	assert(!file_exists(slot_path));
+
+	scoreboard_set_away_name("Hawks");
+	scoreboard_increment_away_score();
+	assert(scoreboard_autosave());
+	assert(!scoreboard_autosave());
+	scoreboard_autosave_flush();
+	assert(file_exists(slot_path));
+
+	struct scoreboard_autosave_stats stats;
+	scoreboard_autosave_get_stats(&stats);
+	assert(stats.queued == 1);
+	assert(stats.saved == 1);
+	assert(stats.unchanged == 2);
+	assert(stats.errors == 0);
+	assert(stats.save.calls == 1);
+	scoreboard_autosave_get_stats(NULL);
+
+	/* Changes made after a save go out with the next one, including
+	   the last one before stopping */
+	for (int i = 0; i < 50; i++) {
+		scoreboard_increment_away_shots();
+		assert(scoreboard_autosave());
+	}
+	scoreboard_set_home_score(4);
+	assert(scoreboard_autosave());
+	scoreboard_autosave_stop();
+	assert(!scoreboard_autosave_is_running());
+	scoreboard_autosave_get_stats(&stats);
+	assert(stats.queued == 52);
+	assert(stats.saved + stats.coalesced == 52);
+
+	scoreboard_reset_state_for_tests();
+	assert(scoreboard_load_state(g_save_path));
+	assert(strcmp(scoreboard_get_away_name(), "Hawks") == 0);
+	assert(scoreboard_get_away_score() == 1);
+	assert(scoreboard_get_away_shots() == 50);
+	assert(scoreboard_get_home_score() == 4);
+
+	/* Stopped: nothing to do */
+	scoreboard_increment_home_score();
+	assert(!scoreboard_autosave());
+	scoreboard_autosave_flush();
+	scoreboard_autosave_stop();
+	cleanup_tmp_dir();
+}
+
+static void test_autosave_retries_failures(void)
+{
+	setup_tmp_dir();
+	scoreboard_reset_state_for_tests();
+	assert(!scoreboard_autosave_start(NULL));
+	assert(!scoreboard_autosave_start(""));
+	char long_path[2048];
+	memset(long_path, 'a', sizeof(long_path) - 1);
+	long_path[sizeof(long_path) - 1] = '\0';
+	assert(!scoreboard_autosave_start(long_path));
+	assert(!scoreboard_autosave_is_running());
+
+	char missing_dir[512], save_path[600];
+	snprintf(missing_dir, sizeof(missing_dir), "%s/later", g_tmp_dir);
+	snprintf(save_path, sizeof(save_path), "%s/autosave.json",
+		 missing_dir);
+	assert(scoreboard_autosave_start(save_path));
+	scoreboard_increment_home_score();
+	assert(scoreboard_autosave());
+	scoreboard_autosave_flush();
+
+	struct scoreboard_autosave_stats stats;
+	scoreboard_autosave_get_stats(&stats);
+	assert(stats.errors == 1);
+
+	/* The failed save is retried without a further change */
+	mkdir(missing_dir, 0755);
+	assert(scoreboard_autosave());
+	scoreboard_autosave_flush();
+	char slot_path[608]; /* save_path plus the slot suffix */
+	snprintf(slot_path, sizeof(slot_path), "%s.0", save_path);
+	assert(file_exists(slot_path));
+	scoreboard_autosave_get_stats(&stats);
+	assert(stats.saved == 1);
+	assert(!scoreboard_autosave());
+
+	/* Starting again moves to the new path and counts afresh */
+	assert(scoreboard_autosave_start(g_save_path));
+	scoreboard_autosave_get_stats(&stats);
+	assert(stats.queued == 0);
+	scoreboard_autosave_stop();
+	cleanup_tmp_dir();
+}
+
+int main(void)
+{
+	test_generation();
+	test_captured_state();
+	test_autosave_only_on_change();
+	test_autosave_retries_failures();
+
+	printf("All scoreboard-core autosave tests passed.\n");
+	return 0;
+}
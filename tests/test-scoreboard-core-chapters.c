@@ -0,0 +1,291 @@
+#include "scoreboard-core.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define mkdir(path, mode) _mkdir(path)
+#define getpid() _getpid()
+#else
+#include <unistd.h>
+#endif
+
+#define NS(seconds) ((uint64_t)(seconds) * 1000000000ull)
+
+static char g_tmp_dir[256];
+static char g_base[512];
+
+static void setup_tmp_dir(void)
+{
+#ifdef _WIN32
+	snprintf(g_tmp_dir, sizeof(g_tmp_dir), "%s\\scoreboard_chapters_%d",
+		 getenv("TEMP") ? getenv("TEMP") : ".", (int)getpid());
+#else
+	snprintf(g_tmp_dir, sizeof(g_tmp_dir), "/tmp/scoreboard_chapters_%d",
+		 (int)getpid());
+#endif
+	mkdir(g_tmp_dir, 0755);
+	snprintf(g_base, sizeof(g_base), "%s/game", g_tmp_dir);
+}
+
+static void cleanup_tmp_dir(void)
+{
+	char cmd[512];
+	snprintf(cmd, sizeof(cmd), "rm -rf %s", g_tmp_dir);
+	system(cmd);
+}
+
+/* Contents of one format's file, or NULL if it wasn't written */
+static char *read_format(enum scoreboard_chapter_format format)
+{
+	char path[600];
+	assert(scoreboard_chapters_path(g_base, format, path, sizeof(path)));
+	FILE *f = fopen(path, "rb");
+	if (f == NULL)
+		return NULL;
+	static char buf[8192];
+	size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+	buf[n] = '\0';
+	fclose(f);
+	return buf;
+}
+
+static void assert_format(enum scoreboard_chapter_format format,
+			  const char *expected)
+{
+	const char *content = read_format(format);
+	assert(content != NULL);
+	assert(strcmp(content, expected) == 0);
+}
+
+static void test_all_formats(void)
+{
+	setup_tmp_dir();
+	struct scoreboard_chapter_writer *w = scoreboard_chapters_begin(
+		g_base, SCOREBOARD_CHAPTERS_ALL, "Eagles vs Hawks");
+	assert(w != NULL);
+	scoreboard_chapters_add(w, 0, "Stream Start");
+	scoreboard_chapters_add(w, 75500, "Goal: Eagles (1-0)");
+	scoreboard_chapters_add(w, 3725250, "Power Play; \"Hawks\" #7");
+	assert(scoreboard_chapters_finish(w, 3800000));
+
+	assert_format(SCOREBOARD_CHAPTERS_YOUTUBE,
+		      "0:00:00 Stream Start\n"
+		      "0:01:15 Goal: Eagles (1-0)\n"
+		      "1:02:05 Power Play; \"Hawks\" #7\n");
+	assert_format(SCOREBOARD_CHAPTERS_FFMETADATA,
+		      ";FFMETADATA1\n"
+		      "title=Eagles vs Hawks\n"
+		      "\n[CHAPTER]\nTIMEBASE=1/1000\nSTART=0\nEND=75500\n"
+		      "title=Stream Start\n"
+		      "\n[CHAPTER]\nTIMEBASE=1/1000\nSTART=75500\n"
+		      "END=3725250\ntitle=Goal: Eagles (1-0)\n"
+		      "\n[CHAPTER]\nTIMEBASE=1/1000\nSTART=3725250\n"
+		      "END=3800000\ntitle=Power Play\\; \"Hawks\" \\#7\n");
+	assert_format(SCOREBOARD_CHAPTERS_WEBVTT,
+		      "WEBVTT\n"
+		      "\n1\n00:00:00.000 --> 00:01:15.500\nStream Start\n"
+		      "\n2\n00:01:15.500 --> 01:02:05.250\n"
+		      "Goal: Eagles (1-0)\n"
+		      "\n3\n01:02:05.250 --> 01:03:20.000\n"
+		      "Power Play; \"Hawks\" #7\n");
+	assert_format(SCOREBOARD_CHAPTERS_EDL,
+		      "TITLE: Eagles vs Hawks\nFCM: NON-DROP FRAME\n"
+		      "\n001  AX       V     C        00:00:00:00 00:01:15:15"
+		      " 00:00:00:00 00:01:15:15\n"
+		      "* FROM CLIP NAME: Stream Start\n"
+		      "\n002  AX       V     C        00:01:15:15 01:02:05:07"
+		      " 00:01:15:15 01:02:05:07\n"
+		      "* FROM CLIP NAME: Goal: Eagles (1-0)\n"
+		      "\n003  AX       V     C        01:02:05:07 01:03:20:00"
+		      " 01:02:05:07 01:03:20:00\n"
+		      "* FROM CLIP NAME: Power Play; \"Hawks\" #7\n");
+	assert_format(SCOREBOARD_CHAPTERS_JSON,
+		      "{\n  \"title\": \"Eagles vs Hawks\",\n"
+		      "  \"chapters\": [\n"
+		      "    {\"start_ms\": 0, \"end_ms\": 75500, "
+		      "\"title\": \"Stream Start\"},\n"
+		      "    {\"start_ms\": 75500, \"end_ms\": 3725250, "
+		      "\"title\": \"Goal: Eagles (1-0)\"},\n"
+		      "    {\"start_ms\": 3725250, \"end_ms\": 3800000, "
+		      "\"title\": \"Power Play; \\\"Hawks\\\" #7\"}\n"
+		      "  ]\n}\n");
+	cleanup_tmp_dir();
+}
+
+static void test_selected_formats(void)
+{
+	setup_tmp_dir();
+	struct scoreboard_chapter_writer *w = scoreboard_chapters_begin(
+		g_base, SCOREBOARD_CHAPTERS_WEBVTT | SCOREBOARD_CHAPTERS_JSON,
+		NULL);
+	/* Out of order starts give an empty chapter, never a negative one;
+	   a negative start is the start of the recording */
+	scoreboard_chapters_add(w, 20000, "Late\nline");
+	scoreboard_chapters_add(w, 10000, "Goal (delayed)");
+	scoreboard_chapters_add(w, -5, "Early");
+	scoreboard_chapters_add(w, 0, NULL);
+	scoreboard_chapters_add(NULL, 0, "Nobody");
+	assert(scoreboard_chapters_finish(w, 0));
+
+	assert(read_format(SCOREBOARD_CHAPTERS_YOUTUBE) == NULL);
+	assert(read_format(SCOREBOARD_CHAPTERS_EDL) == NULL);
+	assert_format(SCOREBOARD_CHAPTERS_WEBVTT,
+		      "WEBVTT\n"
+		      "\n1\n00:00:20.000 --> 00:00:20.000\nLate\nline\n"
+		      "\n2\n00:00:10.000 --> 00:00:10.000\nGoal (delayed)\n"
+		      "\n3\n00:00:00.000 --> 00:00:00.000\nEarly\n");
+	assert(strstr(read_format(SCOREBOARD_CHAPTERS_JSON),
+		      "\"title\": \"Late\\u000aline\"") != NULL);
+	cleanup_tmp_dir();
+}
+
+static void test_empty_and_bad_input(void)
+{
+	setup_tmp_dir();
+	unsigned int no_edl =
+		SCOREBOARD_CHAPTERS_ALL & ~(unsigned int)SCOREBOARD_CHAPTERS_EDL;
+	struct scoreboard_chapter_writer *w =
+		scoreboard_chapters_begin(g_base, no_edl, "A=B");
+	assert(scoreboard_chapters_finish(w, 1000));
+	assert_format(SCOREBOARD_CHAPTERS_YOUTUBE, "");
+	assert_format(SCOREBOARD_CHAPTERS_FFMETADATA,
+		      ";FFMETADATA1\ntitle=A\\=B\n");
+	assert_format(SCOREBOARD_CHAPTERS_WEBVTT, "WEBVTT\n");
+	assert_format(SCOREBOARD_CHAPTERS_JSON,
+		      "{\n  \"title\": \"A=B\",\n  \"chapters\": []\n}\n");
+
+	w = scoreboard_chapters_begin(g_base, SCOREBOARD_CHAPTERS_EDL, "");
+	assert(scoreboard_chapters_finish(w, 0));
+	assert_format(SCOREBOARD_CHAPTERS_EDL,
+		      "TITLE: Chapters\nFCM: NON-DROP FRAME\n");
+
+	assert(scoreboard_chapters_begin(NULL, SCOREBOARD_CHAPTERS_ALL,
+					 NULL) == NULL);
+	assert(scoreboard_chapters_begin("", SCOREBOARD_CHAPTERS_ALL, NULL) ==
+	       NULL);
+	assert(scoreboard_chapters_begin(g_base, 0, NULL) == NULL);
+	assert(scoreboard_chapters_begin(g_base, 1u << 7, NULL) == NULL);
+	char long_base[2048];
+	memset(long_base, 'a', sizeof(long_base) - 1);
+	long_base[sizeof(long_base) - 1] = '\0';
+	assert(scoreboard_chapters_begin(long_base, SCOREBOARD_CHAPTERS_ALL,
+					 NULL) == NULL);
+	assert(!scoreboard_chapters_finish(NULL, 0));
+
+	char path[32];
+	assert(!scoreboard_chapters_path(NULL, SCOREBOARD_CHAPTERS_EDL, path,
+					 sizeof(path)));
+	assert(!scoreboard_chapters_path(g_base, SCOREBOARD_CHAPTERS_EDL,
+					 NULL, 0));
+	assert(!scoreboard_chapters_path(
+		g_base, (enum scoreboard_chapter_format)3, path,
+		sizeof(path)));
+	assert(!scoreboard_chapters_path(long_base, SCOREBOARD_CHAPTERS_EDL,
+					 path, sizeof(path)));
+
+	/* A directory that isn't there fails the finish */
+	char missing[600];
+	snprintf(missing, sizeof(missing), "%s/none/game", g_tmp_dir);
+	w = scoreboard_chapters_begin(missing, SCOREBOARD_CHAPTERS_ALL, NULL);
+	scoreboard_chapters_add(w, 0, "Start");
+	assert(!scoreboard_chapters_finish(w, 0));
+	cleanup_tmp_dir();
+}
+
+static void test_event_log_export(void)
+{
+	setup_tmp_dir();
+	scoreboard_reset_state_for_tests();
+	scoreboard_event_log_add(0, "Stream Start");
+	scoreboard_event_log_add(60, "Goal: Eagles (1-0)");
+	scoreboard_event_log_add(90, "Called off");
+	scoreboard_event_log_add(120, "Period 1 End");
+	scoreboard_event_log_remove(2);
+	/* The last chapter ends with the stream */
+	assert(scoreboard_timeline_mark(SCOREBOARD_TIMELINE_STREAM,
+					SCOREBOARD_MARK_START, NS(1)));
+	assert(scoreboard_timeline_mark(SCOREBOARD_TIMELINE_STREAM,
+					SCOREBOARD_MARK_STOP, NS(151)));
+
+	assert(scoreboard_event_log_export(
+		SCOREBOARD_TIMELINE_STREAM, g_base, SCOREBOARD_CHAPTERS_ALL));
+	assert_format(SCOREBOARD_CHAPTERS_YOUTUBE,
+		      "0:00:00 Stream Start\n"
+		      "0:01:00 Goal: Eagles (1-0)\n"
+		      "0:02:00 Period 1 End\n");
+	assert(strstr(read_format(SCOREBOARD_CHAPTERS_FFMETADATA),
+		      "START=120000\nEND=150000\ntitle=Period 1 End\n") !=
+	       NULL);
+	assert(!scoreboard_event_log_export(
+		SCOREBOARD_TIMELINE_STREAM, NULL, SCOREBOARD_CHAPTERS_ALL));
+	cleanup_tmp_dir();
+}
+
+static void test_event_log_export_compacts(void)
+{
+	setup_tmp_dir();
+	scoreboard_reset_state_for_tests();
+	char txt[600];
+	assert(scoreboard_chapters_path(g_base, SCOREBOARD_CHAPTERS_YOUTUBE,
+					txt, sizeof(txt)));
+	assert(scoreboard_event_log_open(txt));
+	scoreboard_event_log_add(0, "Stream Start");
+	scoreboard_event_log_add(30, "Goal: Eagles (1-0)");
+	scoreboard_event_log_remove(1);
+	assert(strstr(read_format(SCOREBOARD_CHAPTERS_YOUTUBE), "- ") !=
+	       NULL);
+
+	/* The export writes the open file clean and keeps appending */
+	assert(scoreboard_event_log_export(
+		SCOREBOARD_TIMELINE_STREAM, g_base, SCOREBOARD_CHAPTERS_ALL));
+	assert(scoreboard_event_log_is_open());
+	assert_format(SCOREBOARD_CHAPTERS_YOUTUBE, "0:00:00 Stream Start\n");
+	scoreboard_event_log_add(35, "Goal: Hawks (0-1)");
+	assert_format(SCOREBOARD_CHAPTERS_YOUTUBE,
+		      "0:00:00 Stream Start\n0:00:35 Goal: Hawks (0-1)\n");
+
+	/* Other formats or another base leave the open file alone */
+	scoreboard_event_log_remove(1);
+	assert(scoreboard_event_log_export(
+		SCOREBOARD_TIMELINE_STREAM, g_base, SCOREBOARD_CHAPTERS_JSON));
+	char other[600];
+	snprintf(other, sizeof(other), "%s/other", g_tmp_dir);
+	assert(scoreboard_event_log_export(
+		SCOREBOARD_TIMELINE_STREAM, other, SCOREBOARD_CHAPTERS_ALL));
+	assert(strstr(read_format(SCOREBOARD_CHAPTERS_YOUTUBE), "- ") !=
+	       NULL);
+	scoreboard_event_log_close();
+	assert_format(SCOREBOARD_CHAPTERS_YOUTUBE, "0:00:00 Stream Start\n");
+
+	/* So does another context's export */
+	assert(scoreboard_event_log_open(txt));
+	scoreboard_event_log_add(50, "Shot");
+	struct scoreboard_ctx *ctx = scoreboard_ctx_create();
+	struct scoreboard_ctx *def = scoreboard_ctx_select(ctx);
+	assert(scoreboard_event_log_export(
+		SCOREBOARD_TIMELINE_STREAM, g_base, SCOREBOARD_CHAPTERS_JSON));
+	assert(scoreboard_event_log_export(
+		SCOREBOARD_TIMELINE_STREAM, g_base, SCOREBOARD_CHAPTERS_ALL));
+	scoreboard_ctx_select(def);
+	scoreboard_ctx_destroy(ctx);
+	assert(scoreboard_event_log_is_open());
+	scoreboard_event_log_close();
+	cleanup_tmp_dir();
+}
+
+int main(void)
+{
+	test_all_formats();
+	test_selected_formats();
+	test_empty_and_bad_input();
+	test_event_log_export();
+	test_event_log_export_compacts();
+
+	printf("All scoreboard-core chapters tests passed.\n");
+	return 0;
+}
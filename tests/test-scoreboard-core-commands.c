@@ -0,0 +1,225 @@
+#include "scoreboard-core.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#define PRODUCERS 4
+#define PER_PRODUCER 20000
+
+static struct scoreboard_command make(int type, int a, int b, int c)
+{
+	struct scoreboard_command cmd;
+	cmd.type = type;
+	cmd.a = a;
+	cmd.b = b;
+	cmd.c = c;
+	return cmd;
+}
+
+static void post(int type, int a, int b, int c)
+{
+	struct scoreboard_command cmd = make(type, a, b, c);
+	assert(scoreboard_command_post(&cmd));
+}
+
+static void test_builtin_commands(void)
+{
+	scoreboard_reset_state_for_tests();
+	scoreboard_command_reset_stats();
+	assert(!scoreboard_command_post(NULL));
+	assert(scoreboard_command_drain(NULL, NULL) == 0);
+
+	post(SCOREBOARD_CMD_SCORE, SCOREBOARD_TEAM_HOME, 1, 0);
+	post(SCOREBOARD_CMD_SCORE, SCOREBOARD_TEAM_HOME, 1, 0);
+	post(SCOREBOARD_CMD_SCORE, SCOREBOARD_TEAM_HOME, -1, 0);
+	post(SCOREBOARD_CMD_SCORE, SCOREBOARD_TEAM_AWAY, 1, 0);
+	post(SCOREBOARD_CMD_SHOTS, SCOREBOARD_TEAM_AWAY, 1, 0);
+	post(SCOREBOARD_CMD_FACEOFFS, SCOREBOARD_TEAM_HOME, 1, 0);
+	post(SCOREBOARD_CMD_FOULS, SCOREBOARD_TEAM_AWAY, 1, 0);
+	post(SCOREBOARD_CMD_FOULS2, SCOREBOARD_TEAM_HOME, 1, 0);
+	/* No delta, no team: nothing happens */
+	post(SCOREBOARD_CMD_SHOTS, SCOREBOARD_TEAM_HOME, 0, 0);
+	post(SCOREBOARD_CMD_SCORE, 7, 1, 0);
+	post(SCOREBOARD_CMD_PENALTY_ADD, SCOREBOARD_TEAM_HOME, 12, 120);
+	post(SCOREBOARD_CMD_PENALTY_ADD, SCOREBOARD_TEAM_AWAY, 4, 300);
+	post(SCOREBOARD_CMD_PENALTY_ADD, SCOREBOARD_TEAM_AWAY, 5, 120);
+	post(SCOREBOARD_CMD_PENALTY_CLEAR, SCOREBOARD_TEAM_AWAY, 0, 0);
+	post(SCOREBOARD_CMD_PERIOD_ADVANCE, 0, 0, 0);
+	post(SCOREBOARD_CMD_CLOCK_ADJUST_SECONDS, -30, 0, 0);
+	post(SCOREBOARD_CMD_CLOCK_TOGGLE, 0, 0, 0);
+	post(SCOREBOARD_CMD_NONE, 0, 0, 0);
+
+	/* Nothing happens until the owner drains */
+	assert(scoreboard_get_home_score() == 0);
+	assert(scoreboard_command_drain(NULL, NULL) == 18);
+
+	assert(scoreboard_get_home_score() == 1);
+	assert(scoreboard_get_away_score() == 1);
+	assert(scoreboard_get_home_shots() == 0);
+	assert(scoreboard_get_away_shots() == 1);
+	assert(scoreboard_get_home_faceoffs() == 1);
+	assert(scoreboard_get_away_fouls() == 1);
+	assert(scoreboard_get_home_fouls2() == 1);
+	assert(scoreboard_get_home_penalty(0)->player_number == 12);
+	assert(scoreboard_get_away_penalty_count() == 1);
+	assert(scoreboard_get_period() == 2);
+	assert(scoreboard_clock_is_running());
+
+	post(SCOREBOARD_CMD_CLOCK_TOGGLE, 0, 0, 0);
+	post(SCOREBOARD_CMD_CLOCK_START, 0, 0, 0);
+	post(SCOREBOARD_CMD_CLOCK_STOP, 0, 0, 0);
+	post(SCOREBOARD_CMD_PERIOD_REWIND, 0, 0, 0);
+	post(SCOREBOARD_CMD_CLOCK_RESET, 0, 0, 0);
+	post(SCOREBOARD_CMD_PENALTY_CLEAR, SCOREBOARD_TEAM_HOME, 0, 0);
+	post(SCOREBOARD_CMD_PENALTY_ADD, 9, 1, 60);
+	post(SCOREBOARD_CMD_PENALTY_CLEAR, 9, 0, 0);
+	assert(scoreboard_command_drain(NULL, NULL) == 8);
+	assert(!scoreboard_clock_is_running());
+	assert(scoreboard_get_period() == 1);
+	assert(scoreboard_get_home_penalty_count() == 0);
+
+	struct scoreboard_command_stats stats;
+	scoreboard_command_get_stats(&stats);
+	assert(stats.posted == 26);
+	assert(stats.applied == 26);
+	assert(stats.dropped == 0);
+	scoreboard_command_get_stats(NULL);
+}
+
+struct user_log {
+	int count;
+	int last_a;
+};
+
+static void record_user(const struct scoreboard_command *cmd, void *data)
+{
+	struct user_log *log = (struct user_log *)data;
+	assert(cmd->type == SCOREBOARD_CMD_USER + 3);
+	log->count++;
+	log->last_a = cmd->a;
+}
+
+static void test_user_commands(void)
+{
+	struct user_log log = {0, 0};
+	scoreboard_reset_state_for_tests();
+	post(SCOREBOARD_CMD_USER + 3, 41, 0, 0);
+	post(SCOREBOARD_CMD_SCORE, SCOREBOARD_TEAM_HOME, 1, 0);
+	post(SCOREBOARD_CMD_USER + 3, 42, 0, 0);
+	assert(scoreboard_command_drain(record_user, &log) == 3);
+	assert(log.count == 2);
+	assert(log.last_a == 42);
+	assert(scoreboard_get_home_score() == 1);
+
+	/* Without a callback they are dropped on the floor */
+	post(SCOREBOARD_CMD_USER + 3, 43, 0, 0);
+	assert(scoreboard_command_drain(NULL, NULL) == 1);
+	assert(log.count == 2);
+}
+
+static void test_full_ring(void)
+{
+	scoreboard_reset_state_for_tests();
+	scoreboard_command_reset_stats();
+	/* Several laps, so every slot is reused */
+	for (int lap = 0; lap < 3; lap++) {
+		for (int i = 0; i < SCOREBOARD_COMMAND_CAPACITY; i++)
+			post(SCOREBOARD_CMD_SHOTS, SCOREBOARD_TEAM_HOME, 1, 0);
+		struct scoreboard_command cmd =
+			make(SCOREBOARD_CMD_SHOTS, SCOREBOARD_TEAM_HOME, 1, 0);
+		assert(!scoreboard_command_post(&cmd));
+		assert(scoreboard_command_drain(NULL, NULL) ==
+		       SCOREBOARD_COMMAND_CAPACITY);
+		assert(scoreboard_command_drain(NULL, NULL) == 0);
+	}
+	assert(scoreboard_get_home_shots() == 3 * SCOREBOARD_COMMAND_CAPACITY);
+
+	struct scoreboard_command_stats stats;
+	scoreboard_command_get_stats(&stats);
+	assert(stats.posted == 3 * SCOREBOARD_COMMAND_CAPACITY);
+	assert(stats.dropped == 3);
+}
+
+/* ---- concurrent producers ---- */
+
+static int g_next_seq[PRODUCERS];
+static int g_received;
+
+static void check_order(const struct scoreboard_command *cmd, void *data)
+{
+	(void)data;
+	/* Each producer's commands arrive complete and in order */
+	assert(cmd->a >= 0 && cmd->a < PRODUCERS);
+	assert(cmd->b == g_next_seq[cmd->a]);
+	assert(cmd->c == cmd->a * 7 + cmd->b);
+	g_next_seq[cmd->a]++;
+	g_received++;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI producer_main(LPVOID param)
+#else
+static void *producer_main(void *param)
+#endif
+{
+	int id = (int)(intptr_t)param;
+	for (int i = 0; i < PER_PRODUCER; i++) {
+		struct scoreboard_command cmd =
+			make(SCOREBOARD_CMD_USER, id, i, id * 7 + i);
+		while (!scoreboard_command_post(&cmd))
+			;
+	}
+	return 0;
+}
+
+static void test_concurrent_producers(void)
+{
+	scoreboard_reset_state_for_tests();
+	memset(g_next_seq, 0, sizeof(g_next_seq));
+	g_received = 0;
+
+#ifdef _WIN32
+	HANDLE threads[PRODUCERS];
+	for (int i = 0; i < PRODUCERS; i++)
+		threads[i] = CreateThread(NULL, 0, producer_main,
+					  (LPVOID)(intptr_t)i, 0, NULL);
+#else
+	pthread_t threads[PRODUCERS];
+	for (int i = 0; i < PRODUCERS; i++)
+		assert(pthread_create(&threads[i], NULL, producer_main,
+				      (void *)(intptr_t)i) == 0);
+#endif
+
+	while (g_received < PRODUCERS * PER_PRODUCER)
+		scoreboard_command_drain(check_order, NULL);
+
+#ifdef _WIN32
+	WaitForMultipleObjects(PRODUCERS, threads, TRUE, INFINITE);
+	for (int i = 0; i < PRODUCERS; i++)
+		CloseHandle(threads[i]);
+#else
+	for (int i = 0; i < PRODUCERS; i++)
+		pthread_join(threads[i], NULL);
+#endif
+	assert(scoreboard_command_drain(check_order, NULL) == 0);
+	for (int i = 0; i < PRODUCERS; i++)
+		assert(g_next_seq[i] == PER_PRODUCER);
+}
+
+int main(void)
+{
+	test_builtin_commands();
+	test_user_commands();
+	test_full_ring();
+	test_concurrent_producers();
+
+	printf("All scoreboard-core commands tests passed.\n");
+	return 0;
+}
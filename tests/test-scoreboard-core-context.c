@@ -0,0 +1,282 @@
+#include "scoreboard-core.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define mkdir(path, mode) _mkdir(path)
+#define getpid() _getpid()
+#else
+#include <unistd.h>
+#endif
+
+static char g_tmp_dir[256];
+static uint64_t g_now_ns;
+
+static void setup_tmp_dir(void)
+{
+#ifdef _WIN32
+	snprintf(g_tmp_dir, sizeof(g_tmp_dir), "%s\\scoreboard_context_%d",
+		 getenv("TEMP") ? getenv("TEMP") : ".", (int)getpid());
+#else
+	snprintf(g_tmp_dir, sizeof(g_tmp_dir), "/tmp/scoreboard_context_%d",
+		 (int)getpid());
+#endif
+	mkdir(g_tmp_dir, 0755);
+}
+
+static void cleanup_tmp_dir(void)
+{
+	char cmd[512];
+	snprintf(cmd, sizeof(cmd), "rm -rf %s", g_tmp_dir);
+	system(cmd);
+}
+
+static uint64_t fake_now(void)
+{
+	return g_now_ns;
+}
+
+static void read_back(const char *dir, const char *name, char *buf,
+		      size_t size)
+{
+	char path[512];
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	FILE *f = fopen(path, "r");
+	assert(f != NULL);
+	size_t n = fread(buf, 1, size - 1, f);
+	buf[n] = '\0';
+	fclose(f);
+}
+
+static void test_default_context(void)
+{
+	scoreboard_reset_state_for_tests();
+	struct scoreboard_ctx *def = scoreboard_ctx_default();
+	assert(def != NULL);
+	assert(scoreboard_ctx_current() == def);
+	/* Nothing to select */
+	assert(scoreboard_ctx_select(NULL) == def);
+	assert(scoreboard_ctx_current() == def);
+	/* The default context is never destroyed */
+	scoreboard_ctx_destroy(def);
+	scoreboard_ctx_destroy(NULL);
+	assert(scoreboard_ctx_current() == def);
+	assert(scoreboard_get_home_score() == 0);
+}
+
+static void test_contexts_are_independent(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	char dir_a[512], dir_b[512];
+	snprintf(dir_a, sizeof(dir_a), "%s/rink-a", g_tmp_dir);
+	snprintf(dir_b, sizeof(dir_b), "%s/rink-b", g_tmp_dir);
+	mkdir(dir_a, 0755);
+	mkdir(dir_b, 0755);
+
+	struct scoreboard_ctx *def = scoreboard_ctx_default();
+	struct scoreboard_ctx *rink_b = scoreboard_ctx_create();
+	assert(rink_b != NULL && rink_b != def);
+	/* Creating does not change the selection */
+	assert(scoreboard_ctx_current() == def);
+
+	scoreboard_set_output_directory(dir_a);
+	scoreboard_set_home_name("Eagles");
+	scoreboard_set_home_score(3);
+	scoreboard_event_log_add(10, "Goal - Eagles");
+
+	assert(scoreboard_ctx_select(rink_b) == def);
+	/* A new context starts as a fresh game */
+	assert(strcmp(scoreboard_get_home_name(), "Home") == 0);
+	assert(scoreboard_get_home_score() == 0);
+	assert(scoreboard_event_log_count() == 0);
+	assert(scoreboard_get_output_directory()[0] == '\0');
+	scoreboard_set_output_directory(dir_b);
+	scoreboard_set_home_name("Hawks");
+	scoreboard_set_sport(SCOREBOARD_SPORT_BASKETBALL);
+	assert(scoreboard_write_all_files());
+
+	scoreboard_ctx_select(def);
+	assert(scoreboard_write_all_files());
+	assert(strcmp(scoreboard_get_home_name(), "Eagles") == 0);
+	assert(scoreboard_get_sport() == SCOREBOARD_SPORT_HOCKEY);
+	assert(scoreboard_event_log_count() == 1);
+
+	char buf[64];
+	read_back(dir_a, "home_name.txt", buf, sizeof(buf));
+	assert(strcmp(buf, "Eagles") == 0);
+	read_back(dir_a, "home_score.txt", buf, sizeof(buf));
+	assert(strcmp(buf, "3") == 0);
+	read_back(dir_b, "home_name.txt", buf, sizeof(buf));
+	assert(strcmp(buf, "Hawks") == 0);
+	read_back(dir_b, "sport.txt", buf, sizeof(buf));
+	assert(strcmp(buf, "basketball") == 0);
+
+	cleanup_tmp_dir();
+}
+
+static void test_contexts_keep_their_own_clock(void)
+{
+	scoreboard_reset_state_for_tests();
+	g_now_ns = 0;
+	scoreboard_set_time_source(fake_now);
+
+	struct scoreboard_ctx *rink_a = scoreboard_ctx_default();
+	struct scoreboard_ctx *rink_b = scoreboard_ctx_create();
+	scoreboard_clock_start();
+
+	g_now_ns = 30ull * 100000000ull;
+	scoreboard_ctx_select(rink_b);
+	scoreboard_clock_sync();
+	assert(!scoreboard_clock_is_running());
+	assert(scoreboard_clock_get_tenths() == 9000);
+	assert(scoreboard_ns_until_display_change() < 0);
+	/* Started three seconds later than rink A */
+	scoreboard_clock_start();
+
+	g_now_ns = 50ull * 100000000ull;
+	scoreboard_clock_sync();
+	assert(scoreboard_clock_get_tenths() == 9000 - 20);
+	scoreboard_ctx_select(rink_a);
+	scoreboard_clock_sync();
+	assert(scoreboard_clock_get_tenths() == 9000 - 50);
+}
+
+static void test_ctx_entry_points(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	g_now_ns = 0;
+	scoreboard_set_time_source(fake_now);
+	char dir_b[300];
+	snprintf(dir_b, sizeof(dir_b), "%s/b", g_tmp_dir);
+	mkdir(dir_b, 0755);
+
+	struct scoreboard_ctx *rink_a = scoreboard_ctx_default();
+	struct scoreboard_ctx *rink_b = scoreboard_ctx_create();
+	scoreboard_ctx_select(rink_b);
+	scoreboard_set_output_directory(dir_b);
+	scoreboard_set_home_score(3);
+	scoreboard_clock_start();
+	scoreboard_ctx_select(rink_a);
+	scoreboard_set_output_directory(g_tmp_dir);
+	scoreboard_write_all_files();
+
+	/* Driving rink B leaves rink A selected and untouched */
+	g_now_ns = 25ull * 100000000ull;
+	assert(scoreboard_ns_until_display_change_ctx(rink_a) < 0);
+	/* Unsynced, its next second is already due */
+	assert(scoreboard_ns_until_display_change_ctx(rink_b) == 0);
+	scoreboard_clock_sync_ctx(rink_b);
+	assert(scoreboard_ns_until_display_change_ctx(rink_b) ==
+	       6ll * 100000000ll);
+	assert(scoreboard_is_dirty_ctx(rink_b));
+	assert(!scoreboard_is_dirty_ctx(rink_a));
+	assert(scoreboard_write_all_files_ctx(rink_b));
+	assert(!scoreboard_is_dirty_ctx(rink_b));
+	assert(scoreboard_ctx_current() == rink_a);
+	assert(scoreboard_get_home_score() == 0);
+
+	char buf[64];
+	read_back(dir_b, "home_score.txt", buf, sizeof(buf));
+	assert(strcmp(buf, "3") == 0);
+	read_back(dir_b, "clock.txt", buf, sizeof(buf));
+	assert(strcmp(buf, "14:57") == 0);
+	read_back(g_tmp_dir, "home_score.txt", buf, sizeof(buf));
+	assert(strcmp(buf, "0") == 0);
+
+	scoreboard_ctx_destroy(rink_b);
+	scoreboard_clock_sync_ctx(rink_b);
+	assert(scoreboard_ns_until_display_change_ctx(rink_b) < 0);
+	assert(!scoreboard_is_dirty_ctx(rink_b));
+	assert(!scoreboard_write_all_files_ctx(rink_b));
+	assert(!scoreboard_write_all_files_ctx(NULL));
+
+	cleanup_tmp_dir();
+}
+
+static void test_context_pool(void)
+{
+	scoreboard_reset_state_for_tests();
+	struct scoreboard_ctx *made[SCOREBOARD_MAX_CONTEXTS];
+	for (int i = 1; i < SCOREBOARD_MAX_CONTEXTS; i++) {
+		made[i] = scoreboard_ctx_create();
+		assert(made[i] != NULL);
+	}
+	assert(scoreboard_ctx_create() == NULL);
+
+	/* Destroying the selected context falls back to the default, and a
+	   destroyed context can't be selected */
+	scoreboard_ctx_select(made[1]);
+	scoreboard_set_home_score(9);
+	scoreboard_ctx_destroy(made[1]);
+	assert(scoreboard_ctx_current() == scoreboard_ctx_default());
+	scoreboard_ctx_select(made[1]);
+	assert(scoreboard_ctx_current() == scoreboard_ctx_default());
+	scoreboard_ctx_destroy(made[1]);
+
+	/* Its slot is reused as a fresh game */
+	struct scoreboard_ctx *again = scoreboard_ctx_create();
+	assert(again == made[1]);
+	scoreboard_ctx_select(again);
+	assert(scoreboard_get_home_score() == 0);
+
+	/* Test resets release every extra context */
+	scoreboard_reset_state_for_tests();
+	assert(scoreboard_ctx_current() == scoreboard_ctx_default());
+	assert(scoreboard_ctx_create() == made[1]);
+}
+
+static void test_journal_follows_its_context(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	char snapshot[512], journal[512];
+	snprintf(snapshot, sizeof(snapshot), "%s/state.bin", g_tmp_dir);
+	snprintf(journal, sizeof(journal), "%s/state.journal", g_tmp_dir);
+
+	struct scoreboard_ctx *def = scoreboard_ctx_default();
+	struct scoreboard_ctx *rink_b = scoreboard_ctx_create();
+	scoreboard_ctx_select(rink_b);
+	scoreboard_set_home_score(4);
+	assert(scoreboard_journal_open(snapshot, journal));
+
+	/* Changes in another context don't reach this journal, even when
+	   it is synced from there */
+	scoreboard_ctx_select(def);
+	scoreboard_set_home_score(8);
+	scoreboard_write_all_files();
+	assert(scoreboard_journal_sync());
+	assert(scoreboard_journal_checkpoint());
+	scoreboard_ctx_select(rink_b);
+	scoreboard_set_away_score(2);
+	scoreboard_write_all_files();
+
+	/* Dropping the context closes its journal with a checkpoint */
+	scoreboard_ctx_destroy(rink_b);
+	assert(!scoreboard_journal_is_open());
+	assert(scoreboard_get_home_score() == 8);
+	assert(scoreboard_load_state_binary(snapshot));
+	assert(scoreboard_get_home_score() == 4);
+	assert(scoreboard_get_away_score() == 2);
+
+	cleanup_tmp_dir();
+}
+
+int main(void)
+{
+	test_default_context();
+	test_contexts_are_independent();
+	test_contexts_keep_their_own_clock();
+	test_ctx_entry_points();
+	test_context_pool();
+	test_journal_follows_its_context();
+
+	printf("All scoreboard-core context tests passed.\n");
+	return 0;
+}
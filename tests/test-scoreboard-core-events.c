@@ -137,23 +137,42 @@ static void test_event_log_negative_offset(void)
 	assert(ev->offset_seconds == 0);
 }
 
-static void test_event_log_capacity(void)
+static void test_event_log_grows(void)
 {
 	scoreboard_reset_state_for_tests();
 
-	for (int i = 0; i < SCOREBOARD_MAX_EVENTS; i++) {
+	/* Well past the 256 entries the log used to be limited to */
+	const struct scoreboard_game_event *first = NULL;
+	for (int i = 0; i < 1000; i++) {
 		char label[32];
 		snprintf(label, sizeof(label), "Event %d", i);
 		int idx = scoreboard_event_log_add(i * 10, label);
 		assert(idx == i);
+		if (i == 0)
+			first = scoreboard_event_log_get(0);
 	}
-
-	assert(scoreboard_event_log_count() == SCOREBOARD_MAX_EVENTS);
-
-	/* Adding beyond capacity returns -1 */
-	int idx = scoreboard_event_log_add(99999, "Overflow");
-	assert(idx == -1);
-	assert(scoreboard_event_log_count() == SCOREBOARD_MAX_EVENTS);
+	assert(scoreboard_event_log_count() == 1000);
+
+	/* Growing never moved the entries already there */
+	assert(scoreboard_event_log_get(0) == first);
+	assert(strcmp(first->label, "Event 0") == 0);
+	const struct scoreboard_game_event *last =
+		scoreboard_event_log_get(999);
+	assert(last->offset_seconds == 9990);
+	assert(strcmp(last->label, "Event 999") == 0);
+	assert(scoreboard_event_log_find_last("Event 5") == 599);
+
+	/* Removing across chunk boundaries closes the gap */
+	assert(scoreboard_event_log_remove(10));
+	assert(scoreboard_event_log_count() == 999);
+	assert(strcmp(scoreboard_event_log_get(10)->label, "Event 11") == 0);
+	assert(strcmp(scoreboard_event_log_get(998)->label, "Event 999") ==
+	       0);
+
+	/* A cleared log reuses its chunks */
+	scoreboard_event_log_clear();
+	assert(scoreboard_event_log_add(5, "Again") == 0);
+	assert(scoreboard_event_log_get(0) == first);
 }
 
 static void test_event_log_get_out_of_bounds(void)
@@ -613,32 +632,31 @@ static void test_event_log_read_empty_label(void)
 	cleanup_tmp_dir();
 }
 
-static void test_event_log_read_capacity_limit(void)
+static void test_event_log_read_into_long_log(void)
 {
 	scoreboard_reset_state_for_tests();
 	setup_tmp_dir();
 
-	/* Fill event log to capacity */
-	for (int i = 0; i < SCOREBOARD_MAX_EVENTS; i++) {
+	for (int i = 0; i < 300; i++) {
 		char label[32];
 		snprintf(label, sizeof(label), "Event %d", i);
 		scoreboard_event_log_add(i, label);
 	}
-	assert(scoreboard_event_log_count() == SCOREBOARD_MAX_EVENTS);
 
-	/* Write a file with one more event */
 	char path[512];
-	snprintf(path, sizeof(path), "%s/timestamps_cap.txt", g_tmp_dir);
+	snprintf(path, sizeof(path), "%s/timestamps_long.txt", g_tmp_dir);
 
 	FILE *f = fopen(path, "w");
 	assert(f != NULL);
-	fprintf(f, "0:00:00 Overflow Event\n");
+	fprintf(f, "0:00:00 Extra Event\n");
 	fclose(f);
 
-	/* Read should stop at capacity */
+	/* Reading appends after the existing entries */
 	int loaded = scoreboard_event_log_read(path);
-	assert(loaded == 0);
-	assert(scoreboard_event_log_count() == SCOREBOARD_MAX_EVENTS);
+	assert(loaded == 1);
+	assert(scoreboard_event_log_count() == 301);
+	assert(strcmp(scoreboard_event_log_get(300)->label, "Extra Event") ==
+	       0);
 
 	cleanup_tmp_dir();
 }
@@ -677,6 +695,342 @@ static void test_event_log_find_and_remove(void)
 		     "Power Play: Hawks #7") == 0);
 }
 
+/* ---- typed events ---- */
+
+static const char *last_label(enum scoreboard_event_kind kind,
+			      enum scoreboard_team team, int player_number)
+{
+	const struct scoreboard_game_event *ev =
+		scoreboard_event_log_last_of(kind, team, player_number);
+	return ev != NULL ? ev->label : NULL;
+}
+
+static void test_event_log_typed(void)
+{
+	scoreboard_reset_state_for_tests();
+	scoreboard_set_period(2);
+	assert(scoreboard_event_log_add_typed(5, "Period 2 Start",
+					      SCOREBOARD_EVENT_PERIOD_START,
+					      SCOREBOARD_TEAM_NONE, 0) == 0);
+	assert(scoreboard_event_log_add_typed(
+		       60, "Goal: Eagles (1-0)", SCOREBOARD_EVENT_GOAL,
+		       SCOREBOARD_TEAM_HOME, 0) == 1);
+	assert(scoreboard_event_log_add_typed(
+		       90, "Power Play: Hawks #12", SCOREBOARD_EVENT_PENALTY,
+		       SCOREBOARD_TEAM_HOME, 12) == 2);
+
+	const struct scoreboard_game_event *ev = scoreboard_event_log_get(2);
+	assert(ev->kind == SCOREBOARD_EVENT_PENALTY);
+	assert(ev->team == SCOREBOARD_TEAM_HOME);
+	assert(ev->player_number == 12);
+	assert(ev->period == 2);
+	assert(ev->clock_tenths == scoreboard_clock_get_tenths());
+
+	/* Plain adds and out-of-range values are untyped */
+	scoreboard_event_log_add(100, "Note");
+	ev = scoreboard_event_log_get(3);
+	assert(ev->kind == SCOREBOARD_EVENT_OTHER);
+	assert(ev->team == SCOREBOARD_TEAM_NONE);
+	assert(ev->player_number == 0);
+	scoreboard_event_log_add_typed(101, "Odd",
+				       (enum scoreboard_event_kind)99,
+				       (enum scoreboard_team)7, -3);
+	ev = scoreboard_event_log_get(4);
+	assert(ev->kind == SCOREBOARD_EVENT_OTHER);
+	assert(ev->team == SCOREBOARD_TEAM_NONE);
+	assert(ev->player_number == 0);
+	assert(scoreboard_event_log_add_typed(0, NULL, SCOREBOARD_EVENT_GOAL,
+					      SCOREBOARD_TEAM_HOME, 0) == -1);
+
+	assert(strcmp(last_label(SCOREBOARD_EVENT_GOAL, SCOREBOARD_TEAM_HOME,
+				 0),
+		      "Goal: Eagles (1-0)") == 0);
+	assert(strcmp(last_label(SCOREBOARD_EVENT_PENALTY,
+				 SCOREBOARD_TEAM_HOME, 12),
+		      "Power Play: Hawks #12") == 0);
+	assert(last_label(SCOREBOARD_EVENT_PENALTY, SCOREBOARD_TEAM_HOME,
+			  13) == NULL);
+	assert(last_label(SCOREBOARD_EVENT_GOAL, SCOREBOARD_TEAM_AWAY, 0) ==
+	       NULL);
+	assert(last_label((enum scoreboard_event_kind)-1,
+			  SCOREBOARD_TEAM_HOME, 0) == NULL);
+	assert(last_label(SCOREBOARD_EVENT_GOAL, (enum scoreboard_team)2,
+			  0) == NULL);
+	assert(!scoreboard_event_log_remove_last_of(
+		SCOREBOARD_EVENT_GOAL, SCOREBOARD_TEAM_AWAY, 0));
+}
+
+static void test_event_log_remove_last_of(void)
+{
+	scoreboard_reset_state_for_tests();
+	scoreboard_event_log_add_typed(10, "Goal: Eagles (1-0)",
+				       SCOREBOARD_EVENT_GOAL,
+				       SCOREBOARD_TEAM_HOME, 0);
+	scoreboard_event_log_add_typed(20, "Power Play: Hawks #7",
+				       SCOREBOARD_EVENT_PENALTY,
+				       SCOREBOARD_TEAM_HOME, 7);
+	/* The team is renamed mid-game; its goals are still its goals */
+	scoreboard_event_log_add_typed(30, "Goal: Falcons (2-0)",
+				       SCOREBOARD_EVENT_GOAL,
+				       SCOREBOARD_TEAM_HOME, 0);
+	scoreboard_event_log_add_typed(40, "Power Play: Hawks #9",
+				       SCOREBOARD_EVENT_PENALTY,
+				       SCOREBOARD_TEAM_HOME, 9);
+	scoreboard_event_log_add(50, "Shot");
+
+	/* Taking back a player's penalty skips the newer one */
+	assert(scoreboard_event_log_remove_last_of(SCOREBOARD_EVENT_PENALTY,
+						   SCOREBOARD_TEAM_HOME, 7));
+	assert(scoreboard_event_log_count() == 4);
+	assert(strcmp(scoreboard_event_log_get(1)->label,
+		      "Goal: Falcons (2-0)") == 0);
+	assert(strcmp(scoreboard_event_log_get(3)->label, "Shot") == 0);
+	assert(scoreboard_event_log_find_last("Shot") == 3);
+	assert(last_label(SCOREBOARD_EVENT_PENALTY, SCOREBOARD_TEAM_HOME,
+			  7) == NULL);
+
+	assert(scoreboard_event_log_remove_last_of(SCOREBOARD_EVENT_GOAL,
+						   SCOREBOARD_TEAM_HOME, 0));
+	assert(strcmp(last_label(SCOREBOARD_EVENT_GOAL, SCOREBOARD_TEAM_HOME,
+				 0),
+		      "Goal: Eagles (1-0)") == 0);
+	assert(scoreboard_event_log_remove_last_of(SCOREBOARD_EVENT_GOAL,
+						   SCOREBOARD_TEAM_HOME, 0));
+	assert(!scoreboard_event_log_remove_last_of(
+		SCOREBOARD_EVENT_GOAL, SCOREBOARD_TEAM_HOME, 0));
+	assert(scoreboard_event_log_count() == 2);
+	assert(strcmp(scoreboard_event_log_get(0)->label,
+		      "Power Play: Hawks #9") == 0);
+
+	/* Removing by index goes past the removed entries too */
+	assert(scoreboard_event_log_remove(1));
+	assert(scoreboard_event_log_count() == 1);
+	assert(scoreboard_event_log_get(1) == NULL);
+	assert(strcmp(last_label(SCOREBOARD_EVENT_PENALTY,
+				 SCOREBOARD_TEAM_HOME, 0),
+		      "Power Play: Hawks #9") == 0);
+
+	/* A new goal is found again after the old ones were removed */
+	scoreboard_event_log_add_typed(60, "Goal: Falcons (1-0)",
+				       SCOREBOARD_EVENT_GOAL,
+				       SCOREBOARD_TEAM_HOME, 0);
+	assert(strcmp(last_label(SCOREBOARD_EVENT_GOAL, SCOREBOARD_TEAM_HOME,
+				 0),
+		      "Goal: Falcons (1-0)") == 0);
+	scoreboard_event_log_clear();
+	assert(last_label(SCOREBOARD_EVENT_GOAL, SCOREBOARD_TEAM_HOME, 0) ==
+	       NULL);
+}
+
+static void test_event_log_typed_undo(void)
+{
+	scoreboard_reset_state_for_tests();
+	scoreboard_event_log_add_typed(10, "Goal: Eagles (1-0)",
+				       SCOREBOARD_EVENT_GOAL,
+				       SCOREBOARD_TEAM_HOME, 0);
+	scoreboard_event_log_add_typed(20, "Goal: Eagles (2-0)",
+				       SCOREBOARD_EVENT_GOAL,
+				       SCOREBOARD_TEAM_HOME, 0);
+	scoreboard_event_log_add(30, "Shot");
+
+	/* Undo puts a removed goal back where it was, typed as before */
+	scoreboard_undo_begin();
+	scoreboard_event_log_remove_last_of(SCOREBOARD_EVENT_GOAL,
+					    SCOREBOARD_TEAM_HOME, 0);
+	scoreboard_undo_end("Home goal -");
+	scoreboard_undo_begin();
+	scoreboard_event_log_remove_last_of(SCOREBOARD_EVENT_GOAL,
+					    SCOREBOARD_TEAM_HOME, 0);
+	scoreboard_undo_end("Home goal -");
+	assert(scoreboard_event_log_count() == 1);
+	assert(scoreboard_undo());
+	assert(strcmp(last_label(SCOREBOARD_EVENT_GOAL, SCOREBOARD_TEAM_HOME,
+				 0),
+		      "Goal: Eagles (1-0)") == 0);
+	assert(scoreboard_undo());
+	assert(scoreboard_event_log_count() == 3);
+	assert(strcmp(scoreboard_event_log_get(1)->label,
+		      "Goal: Eagles (2-0)") == 0);
+	assert(scoreboard_event_log_get(1)->kind == SCOREBOARD_EVENT_GOAL);
+	assert(strcmp(last_label(SCOREBOARD_EVENT_GOAL, SCOREBOARD_TEAM_HOME,
+				 0),
+		      "Goal: Eagles (2-0)") == 0);
+
+	/* Redo takes them out again, oldest first */
+	assert(scoreboard_redo());
+	assert(scoreboard_redo());
+	assert(scoreboard_event_log_count() == 1);
+	assert(last_label(SCOREBOARD_EVENT_GOAL, SCOREBOARD_TEAM_HOME, 0) ==
+	       NULL);
+}
+
+/* ---- append-mode timestamps file ---- */
+
+static long file_size(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	assert(f != NULL);
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fclose(f);
+	return size;
+}
+
+static void assert_file_is(const char *path, const char *expected)
+{
+	char *content = read_file_content(path);
+	assert(content != NULL);
+	assert(strcmp(content, expected) == 0);
+	free(content);
+}
+
+static void test_event_log_append_file(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	char path[512];
+	snprintf(path, sizeof(path), "%s/timestamps.txt", g_tmp_dir);
+
+	scoreboard_event_log_add(0, "Stream Start");
+	assert(scoreboard_event_log_open(path));
+	assert(scoreboard_event_log_is_open());
+	assert_file_is(path, "0:00:00 Stream Start\n");
+
+	/* Adds append one line each */
+	scoreboard_event_log_add(754, "Period 1 Start");
+	scoreboard_event_log_add(1322, "Goal: Eagles (1-0)");
+	long before = file_size(path);
+	const char *line = "0:23:20 Goal: Eagles (2-0)\n";
+	scoreboard_event_log_add(1400, "Goal: Eagles (2-0)");
+	assert(file_size(path) == before + (long)strlen(line));
+
+	/* A removal appends a tombstone and leaves the rest alone */
+	assert(scoreboard_event_log_remove(
+		scoreboard_event_log_find_last("Goal")));
+	assert_file_is(path, "0:00:00 Stream Start\n"
+			     "0:12:34 Period 1 Start\n"
+			     "0:22:02 Goal: Eagles (1-0)\n"
+			     "0:23:20 Goal: Eagles (2-0)\n"
+			     "- 0:23:20 Goal: Eagles (2-0)\n");
+
+	/* Reading the file applies the tombstone */
+	scoreboard_event_log_close();
+	assert(!scoreboard_event_log_is_open());
+	scoreboard_event_log_clear();
+	scoreboard_event_log_add(5, "Earlier");
+	assert(scoreboard_event_log_read(path) == 3);
+	assert(scoreboard_event_log_count() == 4);
+	assert(strcmp(scoreboard_event_log_get(3)->label,
+		      "Goal: Eagles (1-0)") == 0);
+
+	/* Closing compacted it */
+	assert_file_is(path, "0:00:00 Stream Start\n"
+			     "0:12:34 Period 1 Start\n"
+			     "0:22:02 Goal: Eagles (1-0)\n");
+
+	/* Compacting on request */
+	assert(!scoreboard_event_log_compact());
+	assert(scoreboard_event_log_open(path));
+	assert(scoreboard_event_log_remove(0));
+	assert(scoreboard_event_log_compact());
+	assert_file_is(path, "0:00:00 Stream Start\n"
+			     "0:12:34 Period 1 Start\n"
+			     "0:22:02 Goal: Eagles (1-0)\n");
+
+	/* Clearing empties the file */
+	scoreboard_event_log_clear();
+	assert(file_size(path) == 0);
+	scoreboard_event_log_close();
+	scoreboard_event_log_close();
+	cleanup_tmp_dir();
+}
+
+static void test_event_log_append_file_tombstones(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	char path[512];
+	snprintf(path, sizeof(path), "%s/timestamps.txt", g_tmp_dir);
+	FILE *f = fopen(path, "w");
+	assert(f != NULL);
+	fprintf(f, "0:00:10 Shot\n"
+		   "0:00:20 Shot\n"
+		   "0:00:10 Shot\n"
+		   "- 0:00:10 Shot\n"
+		   "- 0:05:00 Never logged\n"
+		   "- bad\n");
+	fclose(f);
+
+	/* A tombstone takes out the latest equal entry only */
+	assert(scoreboard_event_log_read(path) == 2);
+	assert(scoreboard_event_log_count() == 2);
+	assert(scoreboard_event_log_get(0)->offset_seconds == 10);
+	assert(scoreboard_event_log_get(1)->offset_seconds == 20);
+	cleanup_tmp_dir();
+}
+
+static void test_event_log_append_file_undo(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	char path[512];
+	snprintf(path, sizeof(path), "%s/timestamps.txt", g_tmp_dir);
+	assert(scoreboard_event_log_open(path));
+	scoreboard_event_log_add(10, "Period 1 Start");
+	scoreboard_event_log_add(30, "Goal: Away (0-1)");
+	scoreboard_event_log_add(50, "Goal: Home (1-1)");
+
+	scoreboard_undo_begin();
+	scoreboard_event_log_remove(1);
+	scoreboard_undo_end("Away goal -");
+	/* Putting it back in the middle rewrites the file in order */
+	assert(scoreboard_undo());
+	assert_file_is(path, "0:00:10 Period 1 Start\n"
+			     "0:00:30 Goal: Away (0-1)\n"
+			     "0:00:50 Goal: Home (1-1)\n");
+	/* Taking it out again is a tombstone */
+	assert(scoreboard_redo());
+	assert_file_is(path, "0:00:10 Period 1 Start\n"
+			     "0:00:30 Goal: Away (0-1)\n"
+			     "0:00:50 Goal: Home (1-1)\n"
+			     "- 0:00:30 Goal: Away (0-1)\n");
+	scoreboard_event_log_close();
+	cleanup_tmp_dir();
+}
+
+static void test_event_log_append_file_contexts(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	char path[512];
+	snprintf(path, sizeof(path), "%s/timestamps.txt", g_tmp_dir);
+
+	assert(!scoreboard_event_log_open(NULL));
+	assert(!scoreboard_event_log_open(""));
+	char long_path[2048];
+	memset(long_path, 'a', sizeof(long_path) - 1);
+	long_path[sizeof(long_path) - 1] = '\0';
+	assert(!scoreboard_event_log_open(long_path));
+	assert(!scoreboard_event_log_open("/nonexistent/dir/timestamps.txt"));
+	assert(!scoreboard_event_log_is_open());
+
+	/* The file follows the context it was opened in */
+	struct scoreboard_ctx *other = scoreboard_ctx_create();
+	struct scoreboard_ctx *def = scoreboard_ctx_select(other);
+	assert(scoreboard_event_log_open(path));
+	scoreboard_event_log_add(1, "Rink 2");
+	scoreboard_ctx_select(def);
+	scoreboard_event_log_add(2, "Rink 1");
+	scoreboard_event_log_clear();
+	assert(scoreboard_event_log_compact());
+	assert_file_is(path, "0:00:01 Rink 2\n");
+
+	/* Destroying that context closes it */
+	scoreboard_ctx_destroy(other);
+	assert(!scoreboard_event_log_is_open());
+	cleanup_tmp_dir();
+}
+
 int main(void)
 {
 	test_event_log_empty();
@@ -685,7 +1039,7 @@ int main(void)
 	test_event_log_clear();
 	test_event_log_null_label();
 	test_event_log_negative_offset();
-	test_event_log_capacity();
+	test_event_log_grows();
 	test_event_log_get_out_of_bounds();
 	test_event_log_write();
 	test_event_log_write_empty();
@@ -706,6 +1060,9 @@ int main(void)
 	test_event_log_find_last_empty_log();
 	test_event_log_find_last_empty_prefix();
 	test_event_log_find_and_remove();
+	test_event_log_typed();
+	test_event_log_remove_last_of();
+	test_event_log_typed_undo();
 	test_event_log_file_has_content();
 	test_event_log_file_has_content_empty();
 	test_event_log_file_has_content_missing();
@@ -717,7 +1074,11 @@ int main(void)
 	test_event_log_read_malformed_lines();
 	test_event_log_read_preserves_existing();
 	test_event_log_read_empty_label();
-	test_event_log_read_capacity_limit();
+	test_event_log_read_into_long_log();
+	test_event_log_append_file();
+	test_event_log_append_file_tombstones();
+	test_event_log_append_file_undo();
+	test_event_log_append_file_contexts();
 	printf("All event log tests passed!\n");
 	return 0;
 }
@@ -0,0 +1,275 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L /* sockets */
+#endif
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#endif
+
+#include "scoreboard-core.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+typedef SOCKET test_socket_t;
+#define close_socket closesocket
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+typedef int test_socket_t;
+#define close_socket close
+#endif
+
+#define RESPONSE_SIZE 16384
+
+static test_socket_t connect_server(void)
+{
+	test_socket_t sock = socket(AF_INET, SOCK_STREAM, 0);
+	assert(sock >= 0);
+#ifdef _WIN32
+	DWORD timeout = 5000;
+#else
+	struct timeval timeout = {5, 0};
+#endif
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char *)&timeout,
+		   sizeof(timeout));
+
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(scoreboard_http_get_port());
+	assert(connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+	return sock;
+}
+
+static void send_text(test_socket_t sock, const char *text)
+{
+	assert(send(sock, text, (int)strlen(text), 0) == (int)strlen(text));
+}
+
+/* Read until the server closes the connection */
+static void http_request(const char *request, char *response)
+{
+	test_socket_t sock = connect_server();
+	send_text(sock, request);
+	size_t len = 0;
+	int n;
+	while ((n = (int)recv(sock, response + len,
+			      (int)(RESPONSE_SIZE - 1 - len), 0)) > 0)
+		len += (size_t)n;
+	response[len] = '\0';
+	close_socket(sock);
+}
+
+/* Read a stream until needle shows up; returns the text after it */
+static const char *read_until(test_socket_t sock, char *buf, size_t *len,
+			      const char *needle)
+{
+	for (;;) {
+		buf[*len] = '\0';
+		const char *found = strstr(buf, needle);
+		if (found != NULL)
+			return found;
+		int n = (int)recv(sock, buf + *len,
+				  (int)(RESPONSE_SIZE - 1 - *len), 0);
+		assert(n > 0);
+		*len += (size_t)n;
+	}
+}
+
+static void test_http_start_stop(void)
+{
+	scoreboard_reset_state_for_tests();
+	assert(!scoreboard_http_is_running());
+	assert(!scoreboard_http_publish());
+	assert(scoreboard_http_get_port() == 0);
+
+	assert(scoreboard_http_start(0));
+	assert(scoreboard_http_is_running());
+	assert(scoreboard_http_get_port() != 0);
+	/* Starting twice is a no-op */
+	assert(scoreboard_http_start(0));
+
+	unsigned short port = scoreboard_http_get_port();
+	scoreboard_http_stop();
+	assert(!scoreboard_http_is_running());
+	assert(scoreboard_http_get_port() == 0);
+	scoreboard_http_stop();
+
+	/* The port is reusable right after a stop */
+	assert(scoreboard_http_start(port));
+	assert(scoreboard_http_get_port() == port);
+	scoreboard_http_stop();
+}
+
+static void test_http_serves_state(void)
+{
+	static char response[RESPONSE_SIZE];
+
+	scoreboard_reset_state_for_tests();
+	scoreboard_set_home_name("Eagles");
+	assert(scoreboard_http_start(0));
+
+	http_request("GET /state HTTP/1.1\r\nHost: localhost\r\n\r\n",
+		     response);
+	assert(strncmp(response, "HTTP/1.1 200 OK\r\n", 17) == 0);
+	assert(strstr(response, "Content-Type: application/json") != NULL);
+	assert(strstr(response, "Access-Control-Allow-Origin: *") != NULL);
+	assert(strstr(response, "\"home_name\": \"Eagles\"") != NULL);
+	assert(strstr(response, "\"home_score\": \"0\"") != NULL);
+
+	/* Nothing changed, nothing published */
+	assert(!scoreboard_http_publish());
+	scoreboard_set_home_score(2);
+	assert(scoreboard_http_publish());
+	http_request("GET /?ts=1 HTTP/1.1\r\n\r\n", response);
+	assert(strstr(response, "\"home_score\": \"2\"") != NULL);
+
+	http_request("GET /nope HTTP/1.1\r\n\r\n", response);
+	assert(strncmp(response, "HTTP/1.1 404", 12) == 0);
+	http_request("POST /state HTTP/1.1\r\n\r\n", response);
+	assert(strncmp(response, "HTTP/1.1 405", 12) == 0);
+
+	scoreboard_http_stop();
+}
+
+static void test_http_rejects_oversized_request(void)
+{
+	static char response[RESPONSE_SIZE];
+	char request[2048];
+
+	scoreboard_reset_state_for_tests();
+	assert(scoreboard_http_start(0));
+	memset(request, 'a', sizeof(request) - 1);
+	request[sizeof(request) - 1] = '\0';
+	/* Fills the request buffer without ever ending the headers */
+	http_request(request, response);
+	assert(strncmp(response, "HTTP/1.1 431", 12) == 0);
+	scoreboard_http_stop();
+}
+
+static void test_http_event_stream_pushes_deltas(void)
+{
+	static char buf[RESPONSE_SIZE];
+	size_t len = 0;
+
+	scoreboard_reset_state_for_tests();
+	assert(scoreboard_http_start(0));
+
+	test_socket_t sock = connect_server();
+	send_text(sock, "GET /events HTTP/1.1\r\nAccept: text/event-stream"
+			"\r\n\r\n");
+	read_until(sock, buf, &len, "Content-Type: text/event-stream");
+	/* A new stream starts with the full state */
+	const char *state = read_until(sock, buf, &len, "event: state\n");
+	read_until(sock, buf, &len, "}\n\n");
+	assert(strstr(state, "data:   \"away_name\"") != NULL);
+
+	/* Then only the fields that changed */
+	len = 0;
+	scoreboard_increment_home_score();
+	assert(scoreboard_http_publish());
+	const char *delta = read_until(sock, buf, &len, "event: delta\n");
+	read_until(sock, buf, &len, "}\n\n");
+	assert(strstr(delta, "id: 2\n") != NULL);
+	assert(strstr(delta, "data:   \"home_score\": \"1\"\n") != NULL);
+	assert(strstr(delta, "away_name") == NULL);
+
+	/* Several changes between wakeups all arrive, in order */
+	len = 0;
+	scoreboard_set_away_name("Hawks");
+	assert(scoreboard_http_publish());
+	scoreboard_set_away_score(4);
+	assert(scoreboard_http_publish());
+	read_until(sock, buf, &len, "\"away_score\": \"4\"");
+	const char *names = strstr(buf, "\"away_name\": \"Hawks\"");
+	assert(names != NULL);
+	assert(names < strstr(buf, "\"away_score\": \"4\""));
+
+	close_socket(sock);
+	scoreboard_http_stop();
+}
+
+static void test_http_lagging_stream_gets_full_state(void)
+{
+	static char buf[RESPONSE_SIZE];
+	size_t len = 0;
+
+	scoreboard_reset_state_for_tests();
+	assert(scoreboard_http_start(0));
+	test_socket_t sock = connect_server();
+	send_text(sock, "GET /events HTTP/1.1\r\n\r\n");
+	read_until(sock, buf, &len, "event: state\n");
+	read_until(sock, buf, &len, "}\n\n");
+
+	/* Far more changes than the delta ring holds may pile up before the
+	   server thread gets to this stream; the client must still converge
+	   on the final value */
+	for (int i = 1; i <= 100; i++) {
+		scoreboard_set_home_shots(i);
+		scoreboard_http_publish();
+	}
+	len = 0;
+	read_until(sock, buf, &len, "\"home_shots\": \"100\"");
+
+	close_socket(sock);
+	scoreboard_http_stop();
+}
+
+static void test_http_drops_stalled_stream(void)
+{
+	static char buf[RESPONSE_SIZE];
+	size_t len = 0;
+
+	scoreboard_reset_state_for_tests();
+	assert(scoreboard_http_start(0));
+	/* A browser source that stopped reading */
+	test_socket_t stalled = connect_server();
+	int small = 4096;
+	setsockopt(stalled, SOL_SOCKET, SO_RCVBUF, (const char *)&small,
+		   sizeof(small));
+	send_text(stalled, "GET /events HTTP/1.1\r\n\r\n");
+	for (int i = 1; i <= 20000; i++) {
+		scoreboard_set_home_shots(i);
+		scoreboard_http_publish();
+	}
+
+	/* The server thread kept going: a new stream is served */
+	test_socket_t sock = connect_server();
+	send_text(sock, "GET /events HTTP/1.1\r\n\r\n");
+	read_until(sock, buf, &len, "\"home_shots\": \"20000\"");
+	len = 0;
+	scoreboard_set_away_shots(3);
+	assert(scoreboard_http_publish());
+	read_until(sock, buf, &len, "\"away_shots\": \"3\"");
+
+	/* Nor does stopping wait on it */
+	scoreboard_http_stop();
+	close_socket(stalled);
+	close_socket(sock);
+}
+
+int main(void)
+{
+#ifdef _WIN32
+	WSADATA wsa;
+	WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+	test_http_start_stop();
+	test_http_serves_state();
+	test_http_rejects_oversized_request();
+	test_http_event_stream_pushes_deltas();
+	test_http_lagging_stream_gets_full_state();
+	test_http_drops_stalled_stream();
+
+	printf("All scoreboard-core http tests passed.\n");
+	return 0;
+}
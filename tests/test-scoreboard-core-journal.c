@@ -0,0 +1,426 @@
+#include "scoreboard-core.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define mkdir(path, mode) _mkdir(path)
+#define getpid() _getpid()
+#else
+#include <unistd.h>
+#endif
+
+#define RECORD_SIZE 16
+
+static char g_tmp_dir[256];
+static char g_snapshot[512];
+static char g_journal[512];
+static char g_crash_snapshot[512];
+static char g_crash_journal[512];
+static char g_last_log[256];
+
+static void setup_tmp_dir(void)
+{
+#ifdef _WIN32
+	snprintf(g_tmp_dir, sizeof(g_tmp_dir), "%s\\scoreboard_journal_%d",
+		 getenv("TEMP") ? getenv("TEMP") : ".", (int)getpid());
+#else
+	snprintf(g_tmp_dir, sizeof(g_tmp_dir), "/tmp/scoreboard_journal_%d",
+		 (int)getpid());
+#endif
+	mkdir(g_tmp_dir, 0755);
+	snprintf(g_snapshot, sizeof(g_snapshot), "%s/state.bin", g_tmp_dir);
+	snprintf(g_journal, sizeof(g_journal), "%s/state.journal", g_tmp_dir);
+	snprintf(g_crash_snapshot, sizeof(g_crash_snapshot), "%s/crash.bin",
+		 g_tmp_dir);
+	snprintf(g_crash_journal, sizeof(g_crash_journal), "%s/crash.journal",
+		 g_tmp_dir);
+}
+
+static void cleanup_tmp_dir(void)
+{
+	char cmd[512];
+	snprintf(cmd, sizeof(cmd), "rm -rf %s", g_tmp_dir);
+	system(cmd);
+}
+
+static void capture_log(enum scoreboard_log_level level, const char *msg)
+{
+	(void)level;
+	snprintf(g_last_log, sizeof(g_last_log), "%s", msg);
+}
+
+static void reset(void)
+{
+	scoreboard_reset_state_for_tests();
+	scoreboard_on_load(capture_log);
+	g_last_log[0] = '\0';
+}
+
+static size_t file_size(const char *path)
+{
+	struct stat st;
+	assert(stat(path, &st) == 0);
+	return (size_t)st.st_size;
+}
+
+/* Copies the first size bytes, or the whole file if size is 0 */
+static void copy_file(const char *from, const char *to, size_t size)
+{
+	static unsigned char buf[65536];
+	FILE *in = fopen(from, "rb");
+	assert(in != NULL);
+	size_t n = fread(buf, 1, sizeof(buf), in);
+	fclose(in);
+	if (size != 0 && size < n)
+		n = size;
+	FILE *out = fopen(to, "wb");
+	assert(out != NULL);
+	assert(fwrite(buf, 1, n, out) == n);
+	fclose(out);
+}
+
+/* What an OBS crash leaves behind: the files as they are right now, with
+   no final checkpoint */
+static void snapshot_crash(size_t journal_size)
+{
+	copy_file(g_snapshot, g_crash_snapshot, 0);
+	copy_file(g_journal, g_crash_journal, journal_size);
+}
+
+static void recover_crash(void)
+{
+	scoreboard_journal_close();
+	reset();
+	assert(scoreboard_journal_open(g_crash_snapshot, g_crash_journal));
+}
+
+static void play_some_game(void)
+{
+	scoreboard_set_home_name("Eagles");
+	scoreboard_set_home_score(2);
+	scoreboard_set_overtime_enabled(false);
+	scoreboard_set_clock_direction(SCOREBOARD_CLOCK_COUNT_UP);
+	scoreboard_home_penalty_add_compound(12, 120, 120);
+	scoreboard_write_all_files();
+}
+
+static void test_journal_recovers_after_crash(void)
+{
+	reset();
+	setup_tmp_dir();
+
+	/* Nothing to recover the first time */
+	assert(scoreboard_journal_open(g_snapshot, g_journal));
+	assert(scoreboard_journal_is_open());
+	assert(scoreboard_journal_get_recovery() == SCOREBOARD_JOURNAL_EMPTY);
+	assert(g_last_log[0] == '\0');
+	assert(file_size(g_journal) == RECORD_SIZE);
+
+	play_some_game();
+	size_t after_game = file_size(g_journal);
+	assert(after_game > RECORD_SIZE);
+
+	/* An action that changes nothing appends nothing */
+	scoreboard_set_home_score(2);
+	assert(scoreboard_journal_sync());
+	assert(file_size(g_journal) == after_game);
+
+	/* One more goal is one more record */
+	scoreboard_increment_away_score();
+	scoreboard_write_all_files();
+	assert(file_size(g_journal) == after_game + RECORD_SIZE);
+
+	snapshot_crash(0);
+	recover_crash();
+	assert(scoreboard_journal_get_recovery() ==
+	       SCOREBOARD_JOURNAL_RECOVERED);
+	assert(strstr(g_last_log, "recovered state") != NULL);
+	assert(strcmp(scoreboard_get_home_name(), "Eagles") == 0);
+	assert(scoreboard_get_home_score() == 2);
+	assert(scoreboard_get_away_score() == 1);
+	assert(!scoreboard_get_overtime_enabled());
+	assert(scoreboard_get_clock_direction() == SCOREBOARD_CLOCK_COUNT_UP);
+	const struct scoreboard_penalty *p = scoreboard_get_home_penalty(0);
+	assert(p->active);
+	assert(p->player_number == 12);
+	assert(p->phase2_tenths == 1200);
+
+	/* Recovery checkpoints: the journal starts over */
+	assert(file_size(g_crash_journal) == RECORD_SIZE);
+
+	scoreboard_journal_close();
+	assert(!scoreboard_journal_is_open());
+	scoreboard_journal_close();
+	cleanup_tmp_dir();
+}
+
+static void test_journal_stops_at_torn_record(void)
+{
+	reset();
+	setup_tmp_dir();
+	assert(scoreboard_journal_open(g_snapshot, g_journal));
+	scoreboard_set_home_score(1);
+	scoreboard_write_all_files();
+	scoreboard_set_away_score(5);
+	scoreboard_write_all_files();
+
+	/* The second change was half written when the process died */
+	snapshot_crash(file_size(g_journal) - RECORD_SIZE / 2);
+	recover_crash();
+	assert(scoreboard_get_home_score() == 1);
+	assert(scoreboard_get_away_score() == 0);
+
+	scoreboard_journal_close();
+	cleanup_tmp_dir();
+}
+
+/* Leaves a crash copy of a journal holding two goals; returns its size */
+static size_t crash_after_two_goals(void)
+{
+	scoreboard_journal_close();
+	remove(g_snapshot);
+	remove(g_journal);
+	reset();
+	assert(scoreboard_journal_open(g_snapshot, g_journal));
+	scoreboard_set_home_score(1);
+	scoreboard_write_all_files();
+	scoreboard_set_away_score(5);
+	scoreboard_write_all_files();
+	snapshot_crash(0);
+	return file_size(g_crash_journal);
+}
+
+static void test_journal_rejects_bad_records(void)
+{
+	static unsigned char buf[4096];
+	reset();
+	setup_tmp_dir();
+
+	/* A flipped bit in the last record fails its checksum */
+	size_t size = crash_after_two_goals();
+	FILE *f = fopen(g_crash_journal, "r+b");
+	assert(f != NULL);
+	fseek(f, (long)(size - RECORD_SIZE + 8), SEEK_SET);
+	fputc(0x7f, f);
+	fclose(f);
+	recover_crash();
+	assert(scoreboard_get_home_score() == 1);
+	assert(scoreboard_get_away_score() == 0);
+
+	/* Records out of sequence are not replayed either */
+	size = crash_after_two_goals();
+	f = fopen(g_crash_journal, "rb");
+	assert(fread(buf, 1, sizeof(buf), f) == size);
+	fclose(f);
+	f = fopen(g_crash_journal, "wb");
+	fwrite(buf, 1, RECORD_SIZE, f);
+	fwrite(buf + 2 * RECORD_SIZE, 1, size - 2 * RECORD_SIZE, f);
+	fclose(f);
+	recover_crash();
+	assert(scoreboard_get_home_score() == 0);
+	assert(scoreboard_get_away_score() == 0);
+
+	scoreboard_journal_close();
+	cleanup_tmp_dir();
+}
+
+static void test_journal_ignores_stale_journal(void)
+{
+	reset();
+	setup_tmp_dir();
+	assert(scoreboard_journal_open(g_snapshot, g_journal));
+	scoreboard_set_home_score(3);
+	scoreboard_write_all_files();
+	copy_file(g_journal, g_crash_journal, 0);
+
+	/* A checkpoint that got its snapshot written but died before the
+	   journal was truncated: the old journal must not replay */
+	scoreboard_set_home_score(4);
+	scoreboard_write_all_files();
+	assert(scoreboard_journal_checkpoint());
+	scoreboard_set_home_score(0);
+	scoreboard_write_all_files();
+	copy_file(g_snapshot, g_crash_snapshot, 0);
+	recover_crash();
+	assert(scoreboard_get_home_score() == 4);
+
+	scoreboard_journal_close();
+	cleanup_tmp_dir();
+}
+
+static void test_journal_rejects_record_outside_snapshot(void)
+{
+	reset();
+	setup_tmp_dir();
+	assert(scoreboard_journal_open(g_snapshot, g_journal));
+	scoreboard_set_home_score(3);
+	scoreboard_write_all_files();
+	size_t size = file_size(g_journal);
+	snapshot_crash(0);
+
+	/* Rewrite the home_score record's offset to land in the header and
+	   fix up its checksum: a record that checks out but points outside
+	   the payload still stops the replay */
+	static unsigned char buf[4096];
+	FILE *f = fopen(g_crash_journal, "rb");
+	assert(fread(buf, 1, sizeof(buf), f) == size);
+	fclose(f);
+	unsigned char *rec = buf + size - RECORD_SIZE;
+	uint32_t offset = 8;
+	memcpy(rec + 4, &offset, 4);
+	uint32_t crc = 0xffffffffu;
+	for (int i = 0; i < 12; i++) {
+		crc ^= rec[i];
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1)));
+	}
+	crc = ~crc;
+	memcpy(rec + 12, &crc, 4);
+	f = fopen(g_crash_journal, "wb");
+	fwrite(buf, 1, size, f);
+	fclose(f);
+
+	recover_crash();
+	assert(scoreboard_get_home_score() == 0);
+
+	scoreboard_journal_close();
+	cleanup_tmp_dir();
+}
+
+static void test_journal_checkpoints_when_long(void)
+{
+	reset();
+	setup_tmp_dir();
+	assert(scoreboard_journal_open(g_snapshot, g_journal));
+	for (int i = 1; i <= 5000; i++) {
+		scoreboard_set_home_shots(i);
+		assert(scoreboard_journal_sync());
+	}
+	assert(file_size(g_journal) < 1000 * RECORD_SIZE);
+
+	snapshot_crash(0);
+	recover_crash();
+	assert(scoreboard_get_home_shots() == 5000);
+
+	scoreboard_journal_close();
+	cleanup_tmp_dir();
+}
+
+static void test_journal_clean_close_replays_nothing(void)
+{
+	reset();
+	setup_tmp_dir();
+	assert(scoreboard_journal_open(g_snapshot, g_journal));
+	play_some_game();
+	scoreboard_journal_close();
+
+	/* The output files were edited while OBS was closed; what the next
+	   startup read from them stands */
+	reset();
+	scoreboard_set_home_score(9);
+	assert(scoreboard_journal_open(g_snapshot, g_journal));
+	assert(scoreboard_journal_get_recovery() == SCOREBOARD_JOURNAL_CLEAN);
+	assert(g_last_log[0] == '\0');
+	assert(scoreboard_get_home_score() == 9);
+	assert(strcmp(scoreboard_get_home_name(), "Home") == 0);
+
+	/* The session after that is journaled as usual */
+	scoreboard_set_away_score(3);
+	scoreboard_write_all_files();
+	snapshot_crash(0);
+	recover_crash();
+	assert(scoreboard_get_home_score() == 9);
+	assert(scoreboard_get_away_score() == 3);
+
+	scoreboard_journal_close();
+	cleanup_tmp_dir();
+}
+
+static void test_journal_crash_leaves_clock_stopped(void)
+{
+	reset();
+	setup_tmp_dir();
+	assert(scoreboard_journal_open(g_snapshot, g_journal));
+	scoreboard_clock_set_tenths(4321);
+	scoreboard_clock_start();
+	scoreboard_write_all_files();
+
+	snapshot_crash(0);
+	recover_crash();
+	assert(scoreboard_journal_get_recovery() ==
+	       SCOREBOARD_JOURNAL_RECOVERED);
+	assert(!scoreboard_clock_is_running());
+	assert(scoreboard_clock_get_tenths() == 4321);
+
+	scoreboard_journal_close();
+	cleanup_tmp_dir();
+}
+
+static void test_journal_bad_paths(void)
+{
+	reset();
+	setup_tmp_dir();
+	assert(!scoreboard_journal_sync());
+	assert(!scoreboard_journal_checkpoint());
+	assert(!scoreboard_journal_open(NULL, g_journal));
+	assert(scoreboard_journal_get_recovery() == SCOREBOARD_JOURNAL_EMPTY);
+	assert(!scoreboard_journal_open(g_snapshot, ""));
+	assert(!scoreboard_journal_open("/nonexistent/dir/state.bin",
+					g_journal));
+	assert(!scoreboard_journal_is_open());
+	assert(!scoreboard_journal_open(g_snapshot,
+					"/nonexistent/dir/state.journal"));
+	assert(!scoreboard_journal_is_open());
+
+	/* A damaged snapshot recovers nothing but still starts a journal */
+	FILE *f = fopen(g_snapshot, "wb");
+	fputs("not a snapshot", f);
+	fclose(f);
+	scoreboard_set_home_score(6);
+	assert(scoreboard_journal_open(g_snapshot, g_journal));
+	assert(g_last_log[0] == '\0');
+	assert(scoreboard_get_home_score() == 6);
+
+	/* Losing the snapshot directory makes checkpoints fail while the
+	   journal keeps appending */
+	scoreboard_journal_close();
+	char dir[512];
+	snprintf(dir, sizeof(dir), "%s/gone", g_tmp_dir);
+	mkdir(dir, 0755);
+	char snapshot[600], journal[600];
+	snprintf(snapshot, sizeof(snapshot), "%s/state.bin", dir);
+	snprintf(journal, sizeof(journal), "%s/state.journal", g_tmp_dir);
+	assert(scoreboard_journal_open(snapshot, journal));
+	char cmd[600];
+	snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+	system(cmd);
+	assert(!scoreboard_journal_checkpoint());
+	assert(scoreboard_journal_is_open());
+	scoreboard_set_home_score(7);
+	assert(scoreboard_journal_sync());
+	scoreboard_journal_close();
+	assert(!scoreboard_journal_is_open());
+
+	cleanup_tmp_dir();
+}
+
+int main(void)
+{
+	test_journal_recovers_after_crash();
+	test_journal_stops_at_torn_record();
+	test_journal_rejects_bad_records();
+	test_journal_ignores_stale_journal();
+	test_journal_rejects_record_outside_snapshot();
+	test_journal_checkpoints_when_long();
+	test_journal_clean_close_replays_nothing();
+	test_journal_crash_leaves_clock_stopped();
+	test_journal_bad_paths();
+
+	printf("All scoreboard-core journal tests passed.\n");
+	return 0;
+}
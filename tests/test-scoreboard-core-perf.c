@@ -0,0 +1,164 @@
+#include "scoreboard-core.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define mkdir(path, mode) _mkdir(path)
+#define getpid() _getpid()
+#else
+#include <unistd.h>
+#endif
+
+static char g_tmp_dir[256];
+
+static void setup_tmp_dir(void)
+{
+#ifdef _WIN32
+	snprintf(g_tmp_dir, sizeof(g_tmp_dir), "%s\\scoreboard_perf_%d",
+		 getenv("TEMP") ? getenv("TEMP") : ".", (int)getpid());
+#else
+	snprintf(g_tmp_dir, sizeof(g_tmp_dir), "/tmp/scoreboard_perf_%d",
+		 (int)getpid());
+#endif
+	mkdir(g_tmp_dir, 0755);
+}
+
+static void cleanup_tmp_dir(void)
+{
+	char cmd[512];
+	snprintf(cmd, sizeof(cmd), "rm -rf %s", g_tmp_dir);
+	system(cmd);
+}
+
+static void test_perf_histogram_buckets(void)
+{
+	struct scoreboard_perf_stats stats;
+	memset(&stats, 0, sizeof(stats));
+
+	scoreboard_perf_add(&stats, 500, 1);      /* <10us */
+	scoreboard_perf_add(&stats, 10000, 2);    /* an edge goes up */
+	scoreboard_perf_add(&stats, 20000000, 0); /* <50ms */
+	scoreboard_perf_add(&stats, 3000000000ull, 0);
+	assert(stats.calls == 4);
+	assert(stats.items == 3);
+	assert(stats.total_ns == 500 + 10000 + 20000000 + 3000000000ull);
+	assert(stats.max_ns == 3000000000ull);
+	assert(stats.buckets[0] == 1);
+	assert(stats.buckets[1] == 1);
+	assert(stats.buckets[5] == 1);
+	assert(stats.buckets[SCOREBOARD_PERF_BUCKETS - 1] == 1);
+
+	assert(scoreboard_perf_bucket_limit_ns(0) == 10000);
+	assert(scoreboard_perf_bucket_limit_ns(SCOREBOARD_PERF_BUCKETS - 1) ==
+	       0);
+	assert(scoreboard_perf_bucket_limit_ns(-1) == 0);
+	assert(scoreboard_perf_bucket_limit_ns(SCOREBOARD_PERF_BUCKETS) == 0);
+}
+
+static void test_perf_record_paths(void)
+{
+	struct scoreboard_perf_stats stats;
+
+	scoreboard_reset_state_for_tests();
+	uint64_t start = scoreboard_perf_now();
+	assert(scoreboard_perf_now() >= start);
+	scoreboard_perf_record(SCOREBOARD_PERF_TICK, start, 3);
+	scoreboard_perf_record(SCOREBOARD_PERF_TICK, start, 1);
+	scoreboard_get_perf_stats(SCOREBOARD_PERF_TICK, &stats);
+	assert(stats.calls == 2);
+	assert(stats.items == 4);
+
+	/* Out-of-range paths are ignored */
+	scoreboard_perf_record(SCOREBOARD_PERF_PATH_COUNT, start, 1);
+	scoreboard_get_perf_stats(SCOREBOARD_PERF_PATH_COUNT, &stats);
+	assert(stats.calls == 0);
+	scoreboard_get_perf_stats(SCOREBOARD_PERF_TICK, NULL);
+
+	assert(strcmp(scoreboard_perf_path_name(SCOREBOARD_PERF_TICK),
+		      "on_tick") == 0);
+	assert(strcmp(scoreboard_perf_path_name(SCOREBOARD_PERF_PATH_COUNT),
+		      "unknown") == 0);
+
+	scoreboard_reset_perf_stats();
+	scoreboard_get_perf_stats(SCOREBOARD_PERF_TICK, &stats);
+	assert(stats.calls == 0);
+}
+
+static void test_perf_counts_file_io(void)
+{
+	struct scoreboard_perf_stats stats;
+
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	scoreboard_set_output_directory(g_tmp_dir);
+	assert(scoreboard_write_all_files());
+	scoreboard_set_home_score(2);
+	assert(scoreboard_write_all_files());
+	/* Nothing dirty: still a call, but no files */
+	assert(scoreboard_write_all_files());
+
+	scoreboard_get_perf_stats(SCOREBOARD_PERF_WRITE_FILES, &stats);
+	assert(stats.calls == 3);
+	assert(stats.items == SCOREBOARD_FIELD_COUNT + 1);
+
+	assert(scoreboard_read_all_files());
+	scoreboard_get_perf_stats(SCOREBOARD_PERF_READ_FILES, &stats);
+	assert(stats.calls == 1);
+
+	cleanup_tmp_dir();
+}
+
+static void test_perf_report(void)
+{
+	char buf[4096];
+	char small[32];
+
+	scoreboard_reset_state_for_tests();
+	scoreboard_perf_record(SCOREBOARD_PERF_UPDATE_LABELS,
+			       scoreboard_perf_now(), 0);
+	size_t len = scoreboard_format_perf_stats(buf, sizeof(buf));
+	assert(len == strlen(buf));
+	assert(strstr(buf, "update_all_labels: calls=1 items=0") != NULL);
+	assert(strstr(buf, "write_all_files: calls=0") != NULL);
+	assert(strstr(buf, "writer_replace_file: calls=") != NULL);
+	assert(strstr(buf, " <10us=") != NULL);
+	assert(strstr(buf, " <4ms=") != NULL);
+	assert(strstr(buf, " >=100ms=") != NULL);
+
+	/* Truncated, never overrun */
+	len = scoreboard_format_perf_stats(small, sizeof(small));
+	assert(len == sizeof(small) - 1);
+	assert(strlen(small) == len);
+	assert(scoreboard_format_perf_stats(NULL, 16) == 0);
+	assert(scoreboard_format_perf_stats(small, 0) == 0);
+
+	setup_tmp_dir();
+	char path[512];
+	snprintf(path, sizeof(path), "%s/perf_stats.txt", g_tmp_dir);
+	assert(scoreboard_write_perf_stats(path));
+	FILE *f = fopen(path, "r");
+	assert(f != NULL);
+	char line[128];
+	assert(fgets(line, sizeof(line), f) != NULL);
+	assert(strncmp(line, "write_all_files:", 16) == 0);
+	fclose(f);
+	assert(!scoreboard_write_perf_stats(NULL));
+	assert(!scoreboard_write_perf_stats(""));
+	cleanup_tmp_dir();
+}
+
+int main(void)
+{
+	test_perf_histogram_buckets();
+	test_perf_record_paths();
+	test_perf_counts_file_io();
+	test_perf_report();
+
+	printf("All scoreboard-core perf tests passed.\n");
+	return 0;
+}
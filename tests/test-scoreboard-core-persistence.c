@@ -435,6 +435,477 @@ static void test_load_state_string_not_quoted(void)
 	cleanup_tmp_dir();
 }
 
+static void write_raw_file(const char *path, const char *content)
+{
+	FILE *f = fopen(path, "w");
+	assert(f != NULL);
+	fputs(content, f);
+	fclose(f);
+}
+
+static void test_load_state_tokenizer(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	char path[512];
+	snprintf(path, sizeof(path), "%s/tokens.json", g_tmp_dir);
+
+	/* Nested values are skipped whole, keys inside them and inside
+	   strings don't count, and the first of duplicate keys wins */
+	write_raw_file(path,
+		       "{\"extra\": {\"home_score\": 9, \"list\": [1, \"x]\", "
+		       "{\"a\": 2}]},\n\"away_name\": \"say \\\"home_score\\\": 7\","
+		       "\"home_score\":3,\"home_score\": 8,\"period_length\": "
+		       "600, \"period\": 2, \"away_score\": 4}");
+	assert(scoreboard_load_state(path));
+	assert(scoreboard_get_home_score() == 3);
+	assert(scoreboard_get_away_score() == 4);
+	assert(strcmp(scoreboard_get_away_name(), "say \"home_score\": 7") ==
+	       0);
+	assert(scoreboard_get_period() == 2);
+	assert(scoreboard_get_period_length() == 600);
+
+	/* A document cut short keeps every member before the damage */
+	scoreboard_reset_state_for_tests();
+	write_raw_file(path, "{\"home_score\": 4, \"away_score\": 6");
+	assert(scoreboard_load_state(path));
+	assert(scoreboard_get_home_score() == 4);
+	assert(scoreboard_get_away_score() == 6);
+
+	const char *damaged[] = {
+		"{\"home_score\": 5, \"away_name\": \"abc",
+		"{\"home_score\": 5, \"x\": {\"a\": 1",
+		"{\"home_score\": 5, \"away_sc",
+		"{\"home_score\": 5, \"away_score\" 6}",
+		"{\"home_score\": 5, away_score: 6}",
+	};
+	for (size_t i = 0; i < sizeof(damaged) / sizeof(damaged[0]); i++) {
+		scoreboard_reset_state_for_tests();
+		write_raw_file(path, damaged[i]);
+		assert(scoreboard_load_state(path));
+		assert(scoreboard_get_home_score() == 5);
+		assert(scoreboard_get_away_score() == 0);
+	}
+
+	/* Not an object at all: nothing is read */
+	scoreboard_reset_state_for_tests();
+	write_raw_file(path, "[{\"home_score\": 5}]");
+	assert(scoreboard_load_state(path));
+	assert(scoreboard_get_home_score() == 0);
+
+	cleanup_tmp_dir();
+}
+
+static void set_binary_test_state(void)
+{
+	scoreboard_set_sport(SCOREBOARD_SPORT_LACROSSE);
+	scoreboard_set_home_name("Eagles");
+	scoreboard_set_away_name("Hawks");
+	scoreboard_set_home_score(3);
+	scoreboard_set_away_score(2);
+	scoreboard_set_home_faceoffs(9);
+	scoreboard_set_away_fouls2(1);
+	scoreboard_set_period(2);
+	scoreboard_clock_set_tenths(5000);
+	scoreboard_set_clock_direction(SCOREBOARD_CLOCK_COUNT_UP);
+	scoreboard_set_period_length(1200);
+	scoreboard_set_overtime_enabled(true);
+	scoreboard_set_period_labels("Q1\nQ2\nQ3\nQ4\nOT");
+	scoreboard_home_penalty_add_compound(12, 120, 120);
+	scoreboard_away_penalty_add(22, 60);
+	scoreboard_clock_start();
+}
+
+static void assert_binary_test_state(void)
+{
+	assert(scoreboard_get_sport() == SCOREBOARD_SPORT_LACROSSE);
+	assert(strcmp(scoreboard_get_home_name(), "Eagles") == 0);
+	assert(strcmp(scoreboard_get_away_name(), "Hawks") == 0);
+	assert(scoreboard_get_home_score() == 3);
+	assert(scoreboard_get_away_score() == 2);
+	assert(scoreboard_get_home_faceoffs() == 9);
+	assert(scoreboard_get_away_fouls2() == 1);
+	assert(scoreboard_get_period() == 2);
+	assert(scoreboard_clock_get_tenths() == 5000);
+	assert(scoreboard_get_clock_direction() == SCOREBOARD_CLOCK_COUNT_UP);
+	assert(scoreboard_get_period_length() == 1200);
+	assert(scoreboard_get_overtime_enabled());
+	assert(scoreboard_clock_is_running());
+	assert(scoreboard_get_period_label_count() == 5);
+	assert(strcmp(scoreboard_get_period_label(4), "OT") == 0);
+
+	const struct scoreboard_penalty *hp = scoreboard_get_home_penalty(0);
+	assert(hp->active);
+	assert(hp->player_number == 12);
+	assert(hp->remaining_tenths == 1200);
+	assert(hp->phase2_tenths == 1200);
+	const struct scoreboard_penalty *ap = scoreboard_get_away_penalty(0);
+	assert(ap->active);
+	assert(ap->player_number == 22);
+	assert(ap->remaining_tenths == 600);
+}
+
+static void test_save_load_state_binary(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	char path[512];
+	snprintf(path, sizeof(path), "%s/state.bin", g_tmp_dir);
+
+	set_binary_test_state();
+	assert(scoreboard_save_state_binary(path));
+	scoreboard_reset_state_for_tests();
+	assert(scoreboard_load_state_binary(path));
+	assert_binary_test_state();
+	assert(scoreboard_is_dirty());
+
+	assert(!scoreboard_save_state_binary(NULL));
+	assert(!scoreboard_save_state_binary("/nonexistent/dir/state.bin"));
+	assert(!scoreboard_load_state_binary(NULL));
+	assert(!scoreboard_load_state_binary("/nonexistent/state.bin"));
+
+	cleanup_tmp_dir();
+}
+
+/* Header layout: magic[8], version, byte_order, file_size, crc,
+   section_count, reserved, then (offset, size) per section */
+#define BIN_VERSION 8
+#define BIN_BYTE_ORDER 12
+#define BIN_FILE_SIZE 16
+#define BIN_CRC 20
+#define BIN_SECTION_COUNT 24
+#define BIN_SECTION(i) (32 + 8 * (i))
+#define BIN_SECTION_SIZE(i) (36 + 8 * (i))
+#define BIN_HEADER_SIZE 64
+
+static size_t read_binary(const char *path, unsigned char *buf, size_t size)
+{
+	FILE *f = fopen(path, "rb");
+	assert(f != NULL);
+	size_t n = fread(buf, 1, size, f);
+	fclose(f);
+	return n;
+}
+
+static void write_binary(const char *path, const unsigned char *buf,
+			 size_t size)
+{
+	FILE *f = fopen(path, "wb");
+	assert(f != NULL);
+	assert(fwrite(buf, 1, size, f) == size);
+	fclose(f);
+}
+
+static uint32_t get_u32(const unsigned char *buf, size_t offset)
+{
+	uint32_t value;
+	memcpy(&value, buf + offset, sizeof(value));
+	return value;
+}
+
+static void put_u32(unsigned char *buf, size_t offset, uint32_t value)
+{
+	memcpy(buf + offset, &value, sizeof(value));
+}
+
+static uint32_t test_crc32(const unsigned char *p, size_t size)
+{
+	uint32_t crc = 0xffffffffu;
+	for (size_t i = 0; i < size; i++) {
+		crc ^= p[i];
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1)));
+	}
+	return ~crc;
+}
+
+/* Writes buf with one header word replaced and checks it is rejected */
+static void assert_patch_rejected(const char *path, const unsigned char *buf,
+				  size_t size, size_t offset, uint32_t value)
+{
+	static unsigned char copy[8192];
+	memcpy(copy, buf, size);
+	put_u32(copy, offset, value);
+	write_binary(path, copy, size);
+	assert(!scoreboard_load_state_binary(path));
+}
+
+static void test_load_state_binary_rejects_damage(void)
+{
+	static unsigned char buf[8192];
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	char path[512], bad_path[512];
+	snprintf(path, sizeof(path), "%s/state.bin", g_tmp_dir);
+	snprintf(bad_path, sizeof(bad_path), "%s/bad.bin", g_tmp_dir);
+
+	scoreboard_set_home_score(4);
+	assert(scoreboard_save_state_binary(path));
+	size_t size = read_binary(path, buf, sizeof(buf));
+	assert(size > BIN_HEADER_SIZE && size < sizeof(buf));
+	assert(get_u32(buf, BIN_FILE_SIZE) == size);
+	assert(get_u32(buf, BIN_CRC) ==
+	       test_crc32(buf + BIN_HEADER_SIZE, size - BIN_HEADER_SIZE));
+
+	scoreboard_reset_state_for_tests();
+
+	/* Empty, short and JSON files */
+	write_binary(bad_path, buf, 0);
+	assert(!scoreboard_load_state_binary(bad_path));
+	write_binary(bad_path, buf, 16);
+	assert(!scoreboard_load_state_binary(bad_path));
+	write_binary(bad_path, (const unsigned char *)"{\"home_score\": 4}",
+		     17);
+	assert(!scoreboard_load_state_binary(bad_path));
+
+	/* A flipped payload bit fails the checksum; a truncated or extended
+	   file no longer matches its recorded size */
+	buf[size - 1] ^= 0x01;
+	write_binary(bad_path, buf, size);
+	assert(!scoreboard_load_state_binary(bad_path));
+	buf[size - 1] ^= 0x01;
+	write_binary(bad_path, buf, size - 8);
+	assert(!scoreboard_load_state_binary(bad_path));
+
+	assert_patch_rejected(bad_path, buf, size, BIN_VERSION, 2);
+	assert_patch_rejected(bad_path, buf, size, BIN_BYTE_ORDER, 0x04030201u);
+	assert_patch_rejected(bad_path, buf, size, BIN_SECTION_COUNT, 3);
+
+	/* Section table entries outside the file, misaligned, overlapping
+	   the header or smaller than this version reads */
+	uint32_t game = get_u32(buf, BIN_SECTION(0));
+	uint32_t labels_size = get_u32(buf, BIN_SECTION_SIZE(3));
+	assert_patch_rejected(bad_path, buf, size, BIN_SECTION(0), game + 4);
+	assert_patch_rejected(bad_path, buf, size, BIN_SECTION(0), 0);
+	assert_patch_rejected(bad_path, buf, size, BIN_SECTION(1),
+			      (uint32_t)size + 8);
+	assert_patch_rejected(bad_path, buf, size, BIN_SECTION_SIZE(2),
+			      (uint32_t)size);
+	assert_patch_rejected(bad_path, buf, size, BIN_SECTION_SIZE(3),
+			      labels_size - 8);
+
+	/* Nothing was applied by any of the rejected loads */
+	assert(scoreboard_get_home_score() == 0);
+
+	/* A section bigger than this version knows is fine */
+	put_u32(buf, BIN_SECTION_SIZE(0), 80);
+	write_binary(bad_path, buf, size);
+	assert(scoreboard_load_state_binary(bad_path));
+	assert(scoreboard_get_home_score() == 4);
+
+	cleanup_tmp_dir();
+}
+
+static void test_load_state_binary_clamps_text_and_labels(void)
+{
+	static unsigned char buf[8192];
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	char path[512];
+	snprintf(path, sizeof(path), "%s/state.bin", g_tmp_dir);
+
+	assert(scoreboard_save_state_binary(path));
+	size_t size = read_binary(path, buf, sizeof(buf));
+
+	/* Unterminated names and an oversized label count, re-checksummed
+	   so only the loader's own bounds stand in the way */
+	uint32_t names = get_u32(buf, BIN_SECTION(1));
+	memset(buf + names, 'x', get_u32(buf, BIN_SECTION_SIZE(1)));
+	uint32_t labels = get_u32(buf, BIN_SECTION(3));
+	put_u32(buf, labels, 1000);
+	put_u32(buf, BIN_CRC,
+		test_crc32(buf + BIN_HEADER_SIZE, size - BIN_HEADER_SIZE));
+	write_binary(path, buf, size);
+
+	assert(scoreboard_load_state_binary(path));
+	assert(strlen(scoreboard_get_home_name()) == 64);
+	assert(strlen(scoreboard_get_away_name()) == 64);
+	assert(scoreboard_get_period_label_count() ==
+	       SCOREBOARD_MAX_PERIOD_LABELS);
+
+	cleanup_tmp_dir();
+}
+
+static void test_convert_state_files(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	char json_path[512], bin_path[512], json_again[512];
+	snprintf(json_path, sizeof(json_path), "%s/state.json", g_tmp_dir);
+	snprintf(bin_path, sizeof(bin_path), "%s/state.bin", g_tmp_dir);
+	snprintf(json_again, sizeof(json_again), "%s/again.json", g_tmp_dir);
+
+	set_binary_test_state();
+	assert(scoreboard_save_state(json_path));
+
+	/* The live state is left alone by both conversions */
+	scoreboard_reset_state_for_tests();
+	scoreboard_set_home_score(7);
+	scoreboard_set_output_directory(g_tmp_dir);
+	assert(scoreboard_write_all_files());
+	assert(scoreboard_convert_state_to_binary(json_path, bin_path));
+	assert(scoreboard_convert_state_to_json(bin_path, json_again));
+	assert(scoreboard_get_home_score() == 7);
+	assert(strcmp(scoreboard_get_home_name(), "Home") == 0);
+	assert(!scoreboard_clock_is_running());
+	assert(!scoreboard_is_dirty());
+
+	/* And the JSON survives the round trip byte for byte */
+	char slot_before[600], slot_after[600];
+	snprintf(slot_before, sizeof(slot_before), "%s.0", json_path);
+	snprintf(slot_after, sizeof(slot_after), "%s.0", json_again);
+	char *before = read_file_content(slot_before);
+	char *after = read_file_content(slot_after);
+	assert(strcmp(before, after) == 0);
+	free(before);
+	free(after);
+
+	scoreboard_reset_state_for_tests();
+	assert(scoreboard_load_state_binary(bin_path));
+	assert_binary_test_state();
+
+	assert(!scoreboard_convert_state_to_binary(NULL, bin_path));
+	assert(!scoreboard_convert_state_to_json(bin_path, NULL));
+	assert(!scoreboard_convert_state_to_json(json_path, json_again));
+
+	cleanup_tmp_dir();
+}
+
+/* ---- state file slots ---- */
+
+static void slot_path(const char *path, int slot, char *out, size_t size)
+{
+	snprintf(out, size, "%s.%d", path, slot);
+}
+
+/* Cuts a slot short, as a crash part way through writing it would */
+static void truncate_slot(const char *path, int slot)
+{
+	char name[600];
+	slot_path(path, slot, name, sizeof(name));
+	char *content = read_file_content(name);
+	assert(content != NULL);
+	content[strlen(content) / 2] = '\0';
+	write_raw_file(name, content);
+	free(content);
+}
+
+static void test_state_slots_alternate(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	char path[512], name[600];
+	snprintf(path, sizeof(path), "%s/state.json", g_tmp_dir);
+
+	scoreboard_set_home_score(1);
+	assert(scoreboard_save_state(path));
+	scoreboard_set_home_score(2);
+	assert(scoreboard_save_state(path));
+	scoreboard_set_home_score(3);
+	assert(scoreboard_save_state(path));
+
+	/* Saves 1 and 3 went to slot 0, save 2 to slot 1 */
+	slot_path(path, 0, name, sizeof(name));
+	char *content = read_file_content(name);
+	assert(strncmp(content, "{\n  \"save_generation\": 3,", 25) == 0);
+	assert(strstr(content, "\"home_score\": 3,") != NULL);
+	free(content);
+	slot_path(path, 1, name, sizeof(name));
+	content = read_file_content(name);
+	assert(strstr(content, "\"home_score\": 2,") != NULL);
+	free(content);
+
+	scoreboard_reset_state_for_tests();
+	assert(scoreboard_load_state(path));
+	assert(scoreboard_get_home_score() == 3);
+
+	/* A save torn by a crash falls back to the one before */
+	truncate_slot(path, 0);
+	scoreboard_reset_state_for_tests();
+	assert(scoreboard_load_state(path));
+	assert(scoreboard_get_home_score() == 2);
+
+	/* The next save overwrites the damaged slot, not the good one */
+	scoreboard_set_home_score(4);
+	assert(scoreboard_save_state(path));
+	scoreboard_reset_state_for_tests();
+	assert(scoreboard_load_state(path));
+	assert(scoreboard_get_home_score() == 4);
+	truncate_slot(path, 0);
+	scoreboard_reset_state_for_tests();
+	assert(scoreboard_load_state(path));
+	assert(scoreboard_get_home_score() == 2);
+
+	/* With neither slot intact nothing is applied */
+	truncate_slot(path, 1);
+	scoreboard_reset_state_for_tests();
+	scoreboard_set_away_score(6);
+	assert(!scoreboard_load_state(path));
+	assert(scoreboard_get_home_score() == 0);
+	assert(scoreboard_get_away_score() == 6);
+
+	cleanup_tmp_dir();
+}
+
+static void test_state_slot_damage(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	char path[512], name[600];
+	snprintf(path, sizeof(path), "%s/state.json", g_tmp_dir);
+	scoreboard_set_home_score(5);
+	assert(scoreboard_save_state(path));
+	slot_path(path, 0, name, sizeof(name));
+	char *good = read_file_content(name);
+
+	/* One flipped byte fails the checksum */
+	static char bad[8192];
+	snprintf(bad, sizeof(bad), "%s", good);
+	*strstr(bad, "\"home_score\": 5") = '\'';
+	write_raw_file(name, bad);
+	scoreboard_reset_state_for_tests();
+	assert(!scoreboard_load_state(path));
+
+	/* Too short to hold the checksum at all */
+	write_raw_file(name, "{\n}\n");
+	assert(!scoreboard_load_state(path));
+
+	/* A checksum that holds over a document without a generation */
+	const char *body = "{\n  \"home_score\": 8";
+	char text[128];
+	snprintf(text, sizeof(text),
+		 "%s,\n  \"checksum\": \"%08x\"\n}\n", body,
+		 (unsigned int)test_crc32((const unsigned char *)body,
+					  strlen(body)));
+	write_raw_file(name, text);
+	assert(!scoreboard_load_state(path));
+
+	/* An older slot never wins over a newer one */
+	write_raw_file(name, good);
+	scoreboard_set_home_score(9);
+	assert(scoreboard_save_state(path));
+	slot_path(path, 1, name, sizeof(name));
+	char *newer = read_file_content(name);
+	slot_path(path, 0, name, sizeof(name));
+	write_raw_file(name, newer);
+	slot_path(path, 1, name, sizeof(name));
+	write_raw_file(name, good);
+	scoreboard_reset_state_for_tests();
+	assert(scoreboard_load_state(path));
+	assert(scoreboard_get_home_score() == 9);
+
+	/* A slot that can't be opened for writing fails the save */
+	char blocked[512];
+	snprintf(blocked, sizeof(blocked), "%s/blocked.json", g_tmp_dir);
+	slot_path(blocked, 0, name, sizeof(name));
+	mkdir(name, 0755);
+	assert(!scoreboard_save_state(blocked));
+
+	free(good);
+	free(newer);
+	cleanup_tmp_dir();
+}
+
 static void test_output_directory_null(void)
 {
 	scoreboard_reset_state_for_tests();
@@ -1286,6 +1757,525 @@ static void test_load_old_json_no_phase2(void)
 	cleanup_tmp_dir();
 }
 
+/* ---- per-file dirty tracking ---- */
+
+static bool output_file_exists(const char *name)
+{
+	char path[512];
+	snprintf(path, sizeof(path), "%s/%s", g_tmp_dir, name);
+	FILE *f = fopen(path, "r");
+	if (f == NULL)
+		return false;
+	fclose(f);
+	return true;
+}
+
+static void remove_output_file(const char *name)
+{
+	char path[512];
+	snprintf(path, sizeof(path), "%s/%s", g_tmp_dir, name);
+	remove(path);
+}
+
+static void test_write_only_changed_files(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	scoreboard_set_output_directory(g_tmp_dir);
+	assert(scoreboard_get_dirty_fields() == SCOREBOARD_FIELDS_ALL);
+	assert(scoreboard_write_all_files());
+
+	struct scoreboard_write_stats stats;
+	scoreboard_get_write_stats(&stats);
+	assert(stats.writes == 1);
+	assert(stats.files_written == SCOREBOARD_FIELD_COUNT);
+	assert(stats.files_skipped == 0);
+
+	/* Remove two files; only the one whose field changed comes back */
+	remove_output_file("home_score.txt");
+	remove_output_file("clock.txt");
+	scoreboard_increment_home_score();
+	assert(scoreboard_get_dirty_fields() ==
+	       SCOREBOARD_FIELD_BIT(SCOREBOARD_FIELD_HOME_SCORE));
+	assert(scoreboard_write_all_files());
+	assert(output_file_exists("home_score.txt"));
+	assert(!output_file_exists("clock.txt"));
+
+	scoreboard_get_write_stats(&stats);
+	assert(stats.writes == 2);
+	assert(stats.files_written == SCOREBOARD_FIELD_COUNT + 1);
+	assert(stats.files_skipped == SCOREBOARD_FIELD_COUNT - 1);
+	assert(stats.write_errors == 0);
+
+	scoreboard_reset_write_stats();
+	scoreboard_get_write_stats(&stats);
+	assert(stats.writes == 0 && stats.files_written == 0);
+	scoreboard_get_write_stats(NULL);
+
+	cleanup_tmp_dir();
+}
+
+static void test_dirty_fields_per_setter(void)
+{
+	scoreboard_reset_state_for_tests();
+	scoreboard_home_penalty_add(12, 120);
+	assert(scoreboard_get_dirty_fields() ==
+	       (SCOREBOARD_FIELD_BIT(SCOREBOARD_FIELD_HOME_PENALTY_NUMBERS) |
+		SCOREBOARD_FIELD_BIT(SCOREBOARD_FIELD_HOME_PENALTY_TIMES)));
+
+	scoreboard_reset_state_for_tests();
+	scoreboard_set_default_penalty_duration(90);
+	assert(scoreboard_get_dirty_fields() ==
+	       SCOREBOARD_FIELD_BIT(SCOREBOARD_FIELD_DEFAULT_PENALTY_DURATION));
+
+	/* Non-file state is dirty without touching any output file */
+	scoreboard_reset_state_for_tests();
+	scoreboard_clock_start();
+	assert(scoreboard_is_dirty());
+	assert(scoreboard_get_dirty_fields() == 0);
+}
+
+static void test_output_directory_change_marks_all(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	scoreboard_set_output_directory(g_tmp_dir);
+	assert(scoreboard_write_all_files());
+	assert(!scoreboard_is_dirty());
+
+	/* Same path again is not a change */
+	scoreboard_set_output_directory(g_tmp_dir);
+	assert(!scoreboard_is_dirty());
+
+	scoreboard_set_output_directory("/tmp");
+	assert(scoreboard_get_dirty_fields() == SCOREBOARD_FIELDS_ALL);
+
+	cleanup_tmp_dir();
+}
+
+static void test_write_failure_keeps_field_dirty(void)
+{
+	scoreboard_reset_state_for_tests();
+	scoreboard_set_output_directory("/nonexistent/path/that/does/not/exist");
+	scoreboard_set_home_score(2);
+	assert(!scoreboard_write_all_files());
+	assert(scoreboard_is_dirty());
+
+	struct scoreboard_write_stats stats;
+	scoreboard_get_write_stats(&stats);
+	assert(stats.write_errors == SCOREBOARD_FIELD_COUNT);
+}
+
+static void test_output_field_filename(void)
+{
+	assert(strcmp(scoreboard_output_field_filename(
+			      SCOREBOARD_FIELD_CLOCK),
+		      "clock.txt") == 0);
+	assert(strcmp(scoreboard_output_field_filename(
+			      SCOREBOARD_FIELD_PERIOD_LABELS),
+		      "period_labels.txt") == 0);
+	assert(strcmp(scoreboard_output_field_filename(SCOREBOARD_FIELD_COUNT),
+		      "") == 0);
+	assert(strcmp(scoreboard_output_field_filename(
+			      (enum scoreboard_output_field)-1),
+		      "") == 0);
+}
+
+/* Every field has its own file in the registry */
+static void test_output_field_registry(void)
+{
+	const char *names[SCOREBOARD_FIELD_COUNT];
+	for (int i = 0; i < SCOREBOARD_FIELD_COUNT; i++) {
+		names[i] = scoreboard_output_field_filename(
+			(enum scoreboard_output_field)i);
+		size_t len = strlen(names[i]);
+		assert(len > 4);
+		assert(strcmp(names[i] + len - 4, ".txt") == 0);
+		for (int j = 0; j < i; j++)
+			assert(strcmp(names[i], names[j]) != 0);
+	}
+}
+
+/* The last penalty slot and period label round-trip like the first */
+static void test_save_load_last_slots(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	for (int i = 0; i < SCOREBOARD_MAX_PENALTIES; i++)
+		assert(scoreboard_away_penalty_add(10 + i, 60 + i) == i);
+	char labels[SCOREBOARD_MAX_PERIOD_LABELS * 8] = "";
+	for (int i = 0; i < SCOREBOARD_MAX_PERIOD_LABELS; i++) {
+		char label[8];
+		snprintf(label, sizeof(label), "Q%d\n", i + 1);
+		strcat(labels, label);
+	}
+	scoreboard_set_period_labels(labels);
+
+	char save_path[512];
+	snprintf(save_path, sizeof(save_path), "%s/state.json", g_tmp_dir);
+	assert(scoreboard_save_state(save_path));
+	scoreboard_reset_state_for_tests();
+	assert(scoreboard_load_state(save_path));
+
+	const struct scoreboard_penalty *last =
+		scoreboard_get_away_penalty(SCOREBOARD_MAX_PENALTIES - 1);
+	assert(last->active);
+	assert(last->player_number == 10 + SCOREBOARD_MAX_PENALTIES - 1);
+	assert(last->remaining_tenths ==
+	       (60 + SCOREBOARD_MAX_PENALTIES - 1) * 10);
+	assert(scoreboard_get_period_label_count() ==
+	       SCOREBOARD_MAX_PERIOD_LABELS);
+	assert(strcmp(scoreboard_get_period_label(
+			      SCOREBOARD_MAX_PERIOD_LABELS - 1),
+		      "Q16") == 0);
+	cleanup_tmp_dir();
+}
+
+static void test_clock_tick_dirty_only_on_visible_change(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	scoreboard_set_output_directory(g_tmp_dir);
+	scoreboard_clock_start();
+	assert(scoreboard_write_all_files());
+
+	/* 15:00 -> 14:59.9 changes the text */
+	scoreboard_clock_tick(1);
+	assert(scoreboard_is_dirty());
+	assert(scoreboard_write_all_files());
+
+	/* 14:59.9 .. 14:59.0 all render as "14:59" */
+	for (int i = 0; i < 9; i++) {
+		scoreboard_clock_tick(1);
+		assert(!scoreboard_is_dirty());
+	}
+	scoreboard_clock_tick(1);
+	assert(scoreboard_get_dirty_fields() ==
+	       SCOREBOARD_FIELD_BIT(SCOREBOARD_FIELD_CLOCK));
+
+	/* A full running minute at 10 Hz rewrites clock.txt once a second */
+	assert(scoreboard_write_all_files());
+	scoreboard_reset_write_stats();
+	for (int i = 0; i < 600; i++) {
+		scoreboard_clock_tick(1);
+		assert(scoreboard_write_all_files());
+	}
+	struct scoreboard_write_stats stats;
+	scoreboard_get_write_stats(&stats);
+	assert(stats.files_written == 60);
+
+	cleanup_tmp_dir();
+}
+
+static void test_clock_adjust_then_tick_rewrites(void)
+{
+	/* The rendered cache follows writes, not ticks: an adjust followed by
+	   a tick back to the previously written text must still be written. */
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	scoreboard_set_output_directory(g_tmp_dir);
+	scoreboard_clock_set_tenths(8995);
+	scoreboard_clock_start();
+	assert(scoreboard_write_all_files());
+	scoreboard_clock_adjust_seconds(1);
+	assert(scoreboard_write_all_files());
+	scoreboard_clock_tick(10);
+	assert(scoreboard_is_dirty());
+	assert(scoreboard_write_all_files());
+
+	char path[512];
+	snprintf(path, sizeof(path), "%s/clock.txt", g_tmp_dir);
+	char *content = read_file_content(path);
+	assert(content != NULL);
+	assert(strcmp(content, "14:59") == 0);
+	free(content);
+
+	cleanup_tmp_dir();
+}
+
+static void test_penalty_tick_dirty_only_on_visible_change(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	scoreboard_set_output_directory(g_tmp_dir);
+	scoreboard_away_penalty_add(7, 120);
+	assert(scoreboard_write_all_files());
+
+	scoreboard_penalty_tick(1);
+	assert(scoreboard_get_dirty_fields() ==
+	       SCOREBOARD_FIELD_BIT(SCOREBOARD_FIELD_AWAY_PENALTY_TIMES));
+	assert(scoreboard_write_all_files());
+	scoreboard_penalty_tick(9);
+	assert(!scoreboard_is_dirty());
+	scoreboard_penalty_tick(1);
+	assert(scoreboard_is_dirty());
+
+	cleanup_tmp_dir();
+}
+
+/* ---- consolidated output modes ---- */
+
+static void test_output_mode_names(void)
+{
+	assert(strcmp(scoreboard_output_mode_name(SCOREBOARD_OUTPUT_JSON),
+		      "json") == 0);
+	assert(strcmp(scoreboard_output_mode_name(
+			      (enum scoreboard_output_mode)99),
+		      "files") == 0);
+	assert(scoreboard_output_mode_from_name("keyvalue") ==
+	       SCOREBOARD_OUTPUT_KEY_VALUE);
+	assert(scoreboard_output_mode_from_name("bogus") ==
+	       SCOREBOARD_OUTPUT_FILES);
+	assert(scoreboard_output_mode_from_name(NULL) ==
+	       SCOREBOARD_OUTPUT_FILES);
+	assert(strcmp(scoreboard_output_mode_filename(SCOREBOARD_OUTPUT_JSON),
+		      "scoreboard.json") == 0);
+	assert(strcmp(scoreboard_output_mode_filename(
+			      SCOREBOARD_OUTPUT_KEY_VALUE),
+		      "scoreboard.txt") == 0);
+	assert(strcmp(scoreboard_output_mode_filename(SCOREBOARD_OUTPUT_FILES),
+		      "") == 0);
+	assert(strcmp(scoreboard_output_mode_filename(
+			      (enum scoreboard_output_mode)-1),
+		      "") == 0);
+}
+
+static void test_output_mode_marks_dirty(void)
+{
+	scoreboard_reset_state_for_tests();
+	assert(scoreboard_get_output_mode() == SCOREBOARD_OUTPUT_FILES);
+	scoreboard_set_output_mode(SCOREBOARD_OUTPUT_FILES);
+	assert(!scoreboard_is_dirty());
+	scoreboard_set_output_mode(SCOREBOARD_OUTPUT_JSON);
+	assert(scoreboard_get_dirty_fields() == SCOREBOARD_FIELDS_ALL);
+	scoreboard_set_output_mode((enum scoreboard_output_mode)42);
+	assert(scoreboard_get_output_mode() == SCOREBOARD_OUTPUT_FILES);
+}
+
+static void populate_snapshot_state(void)
+{
+	scoreboard_set_home_name("The \"Eagles\"\x01\x1f");
+	scoreboard_set_away_name("sport");
+	scoreboard_set_home_score(3);
+	scoreboard_set_away_score(1);
+	scoreboard_set_home_shots(21);
+	scoreboard_set_away_faceoffs(9);
+	scoreboard_set_home_fouls2(2);
+	scoreboard_clock_set_tenths(7234);
+	scoreboard_set_period(2);
+	scoreboard_home_penalty_add(12, 120);
+	scoreboard_home_penalty_add(4, 300);
+	scoreboard_away_penalty_add(0, 60);
+	scoreboard_set_default_penalty_duration(90);
+	scoreboard_set_default_major_penalty_duration(240);
+}
+
+static void check_snapshot_state(void)
+{
+	/* Control characters come back from their \u escapes */
+	assert(strcmp(scoreboard_get_home_name(), "The \"Eagles\"\x01\x1f") ==
+	       0);
+	assert(strcmp(scoreboard_get_away_name(), "sport") == 0);
+	assert(scoreboard_get_home_score() == 3);
+	assert(scoreboard_get_away_score() == 1);
+	assert(scoreboard_get_home_shots() == 21);
+	assert(scoreboard_get_away_faceoffs() == 9);
+	assert(scoreboard_get_home_fouls2() == 2);
+	assert(scoreboard_clock_get_tenths() == 7230);
+	assert(scoreboard_get_period() == 2);
+	assert(scoreboard_get_home_penalty_count() == 2);
+	assert(scoreboard_get_home_penalty(1)->player_number == 4);
+	assert(scoreboard_get_away_penalty_count() == 1);
+	assert(scoreboard_get_default_penalty_duration() == 90);
+	assert(scoreboard_get_default_major_penalty_duration() == 240);
+	assert(strcmp(scoreboard_get_period_label(3), "OT") == 0);
+}
+
+static void check_snapshot_round_trip(enum scoreboard_output_mode mode)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	scoreboard_set_output_directory(g_tmp_dir);
+	scoreboard_set_output_mode(mode);
+	populate_snapshot_state();
+	assert(scoreboard_write_all_files());
+	assert(!scoreboard_is_dirty());
+
+	/* One file per write, none of the per-field files */
+	assert(output_file_exists(scoreboard_output_mode_filename(mode)));
+	assert(!output_file_exists("clock.txt"));
+	struct scoreboard_write_stats stats;
+	scoreboard_get_write_stats(&stats);
+	assert(stats.files_written == 1);
+
+	scoreboard_reset_state_for_tests();
+	scoreboard_set_output_directory(g_tmp_dir);
+	scoreboard_set_output_mode(mode);
+	assert(scoreboard_read_all_files());
+	assert(!scoreboard_is_dirty());
+	check_snapshot_state();
+
+	cleanup_tmp_dir();
+}
+
+static void test_json_snapshot_round_trip(void)
+{
+	check_snapshot_round_trip(SCOREBOARD_OUTPUT_JSON);
+}
+
+static void test_key_value_snapshot_round_trip(void)
+{
+	check_snapshot_round_trip(SCOREBOARD_OUTPUT_KEY_VALUE);
+}
+
+static void test_json_snapshot_unicode_escapes(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	scoreboard_set_output_directory(g_tmp_dir);
+	scoreboard_set_output_mode(SCOREBOARD_OUTPUT_JSON);
+
+	/* Any escaped code point reads back as UTF-8; malformed escapes
+	   and NUL are kept as text */
+	write_file(g_tmp_dir, "scoreboard.json",
+		   "{\"home_name\": \"\\u00e9\\u20AC\\u0041\\u00zz\\u0000\","
+		   " \"away_name\": \"\\u0009\"}");
+	scoreboard_read_all_files();
+	assert(strcmp(scoreboard_get_home_name(),
+		      "\xc3\xa9\xe2\x82\xac" "Au00zzu0000") == 0);
+	assert(strcmp(scoreboard_get_away_name(), "\t") == 0);
+
+	/* A character that doesn't fit ends the value, never half of it */
+	char name[511];
+	memset(name, 'x', sizeof(name) - 1);
+	name[sizeof(name) - 1] = '\0';
+	char text[1024];
+	snprintf(text, sizeof(text), "{\"home_name\": \"%s\\u20ac\"}",
+		 name);
+	write_file(g_tmp_dir, "scoreboard.json", text);
+	scoreboard_read_all_files();
+	assert(strspn(scoreboard_get_home_name(), "x") == 64);
+
+	cleanup_tmp_dir();
+}
+
+static void test_json_snapshot_format(void)
+{
+	scoreboard_reset_state_for_tests();
+	scoreboard_set_home_score(5);
+	scoreboard_set_home_name("A\tB\r\x01");
+	char buf[8192];
+	size_t len = scoreboard_format_output_snapshot(SCOREBOARD_OUTPUT_JSON,
+						       buf, sizeof(buf));
+	assert(len == strlen(buf));
+	assert(buf[0] == '{');
+	assert(strstr(buf, "\"home_score\": \"5\",") != NULL);
+	assert(strstr(buf, "\"home_name\": \"A\\tB\\r\\u0001\"") != NULL);
+	/* Multi-line values are escaped, keeping one line per key */
+	assert(strstr(buf, "\"period_labels\": \"1\\n2\\n3\\nOT") != NULL);
+	assert(strstr(buf, "\"\n}\n") != NULL);
+
+	len = scoreboard_format_output_snapshot(SCOREBOARD_OUTPUT_KEY_VALUE,
+						buf, sizeof(buf));
+	assert(strncmp(buf, "clock=15:00\n", 12) == 0);
+	assert(strstr(buf, "\nhome_score=5\n") != NULL);
+
+	/* Files mode has no snapshot; tiny buffers truncate safely */
+	assert(scoreboard_format_output_snapshot(SCOREBOARD_OUTPUT_FILES, buf,
+						 sizeof(buf)) == 0);
+	assert(buf[0] == '\0');
+	assert(scoreboard_format_output_snapshot(SCOREBOARD_OUTPUT_JSON, NULL,
+						 16) == 0);
+	assert(scoreboard_format_output_snapshot(SCOREBOARD_OUTPUT_JSON, buf,
+						 0) == 0);
+	len = scoreboard_format_output_snapshot(SCOREBOARD_OUTPUT_JSON, buf, 16);
+	assert(len == 15 && strlen(buf) == 15);
+}
+
+static void test_output_field_subset(void)
+{
+	scoreboard_reset_state_for_tests();
+	scoreboard_set_home_score(3);
+	scoreboard_set_away_name("Hawks");
+	char buf[512];
+
+	scoreboard_format_output_field(SCOREBOARD_FIELD_HOME_SCORE, buf,
+				       sizeof(buf));
+	assert(strcmp(buf, "3") == 0);
+	scoreboard_format_output_field(SCOREBOARD_FIELD_COUNT, buf,
+				       sizeof(buf));
+	assert(buf[0] == '\0');
+	scoreboard_format_output_field(SCOREBOARD_FIELD_CLOCK, NULL, 16);
+
+	unsigned int fields = SCOREBOARD_FIELD_BIT(SCOREBOARD_FIELD_AWAY_NAME) |
+			      SCOREBOARD_FIELD_BIT(SCOREBOARD_FIELD_HOME_SCORE);
+	scoreboard_format_output_fields(SCOREBOARD_OUTPUT_JSON, fields, buf,
+					sizeof(buf));
+	assert(strcmp(buf, "{\n  \"away_name\": \"Hawks\",\n"
+			   "  \"home_score\": \"3\"\n}\n") == 0);
+	scoreboard_format_output_fields(SCOREBOARD_OUTPUT_KEY_VALUE, fields,
+					buf, sizeof(buf));
+	assert(strcmp(buf, "away_name=Hawks\nhome_score=3\n") == 0);
+	scoreboard_format_output_fields(SCOREBOARD_OUTPUT_JSON, 0, buf,
+					sizeof(buf));
+	assert(strcmp(buf, "{}\n") == 0);
+}
+
+static void test_key_value_snapshot_partial(void)
+{
+	/* Hand-written snapshot: missing optional keys keep defaults,
+	   missing required keys report failure */
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	scoreboard_set_output_directory(g_tmp_dir);
+	scoreboard_set_output_mode(SCOREBOARD_OUTPUT_KEY_VALUE);
+	write_file(g_tmp_dir, "scoreboard.txt",
+		   "home_score=7\r\nhome_name=Back\\\\slash\nnot a pair\n"
+		   "away_score");
+	assert(!scoreboard_read_all_files());
+	assert(scoreboard_get_home_score() == 7);
+	assert(strcmp(scoreboard_get_home_name(), "Back\\slash") == 0);
+	assert(scoreboard_get_away_score() == 0);
+	cleanup_tmp_dir();
+}
+
+static void test_snapshot_missing_file(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	scoreboard_set_output_directory(g_tmp_dir);
+	scoreboard_set_output_mode(SCOREBOARD_OUTPUT_JSON);
+	assert(!scoreboard_read_all_files());
+	cleanup_tmp_dir();
+}
+
+static void test_snapshot_write_failure(void)
+{
+	scoreboard_reset_state_for_tests();
+	scoreboard_set_output_directory("/nonexistent/path/that/does/not/exist");
+	scoreboard_set_output_mode(SCOREBOARD_OUTPUT_JSON);
+	assert(!scoreboard_write_all_files());
+	assert(scoreboard_get_dirty_fields() == SCOREBOARD_FIELDS_ALL);
+	struct scoreboard_write_stats stats;
+	scoreboard_get_write_stats(&stats);
+	assert(stats.write_errors == 1);
+}
+
+static void test_json_snapshot_partial(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	scoreboard_set_output_directory(g_tmp_dir);
+	scoreboard_set_output_mode(SCOREBOARD_OUTPUT_JSON);
+	write_file(g_tmp_dir, "scoreboard.json",
+		   "{\n  \"home_name\" : \"Tab\\there\\r\",\n"
+		   "  \"away_score\": \"6\"\n}\n");
+	assert(!scoreboard_read_all_files());
+	assert(strcmp(scoreboard_get_home_name(), "Tab\there\r") == 0);
+	assert(scoreboard_get_away_score() == 6);
+	cleanup_tmp_dir();
+}
+
 int main(void)
 {
 	test_write_all_files();
@@ -1307,6 +2297,13 @@ int main(void)
 	test_load_state_invalid_bool();
 	test_save_load_special_chars();
 	test_load_state_string_not_quoted();
+	test_load_state_tokenizer();
+	test_save_load_state_binary();
+	test_load_state_binary_rejects_damage();
+	test_load_state_binary_clamps_text_and_labels();
+	test_convert_state_files();
+	test_state_slots_alternate();
+	test_state_slot_damage();
 	test_cli_settings();
 	test_cli_settings_null();
 	test_output_directory_null();
@@ -1340,6 +2337,27 @@ int main(void)
 	test_read_all_files_preserves_compound();
 	test_save_load_compound_penalty();
 	test_load_old_json_no_phase2();
+	test_write_only_changed_files();
+	test_dirty_fields_per_setter();
+	test_output_directory_change_marks_all();
+	test_write_failure_keeps_field_dirty();
+	test_output_field_filename();
+	test_output_field_registry();
+	test_save_load_last_slots();
+	test_clock_tick_dirty_only_on_visible_change();
+	test_clock_adjust_then_tick_rewrites();
+	test_penalty_tick_dirty_only_on_visible_change();
+	test_output_mode_names();
+	test_output_mode_marks_dirty();
+	test_json_snapshot_round_trip();
+	test_key_value_snapshot_round_trip();
+	test_json_snapshot_unicode_escapes();
+	test_json_snapshot_format();
+	test_output_field_subset();
+	test_key_value_snapshot_partial();
+	test_snapshot_missing_file();
+	test_snapshot_write_failure();
+	test_json_snapshot_partial();
 
 	printf("All scoreboard-core persistence tests passed.\n");
 	return 0;
@@ -0,0 +1,212 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L /* fork, waitpid, alarm */
+#endif
+
+#include "scoreboard-core.h"
+#include "scoreboard-shm.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <process.h>
+#define getpid() _getpid()
+#else
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+static char g_name[64];
+
+static void setup_name(void)
+{
+	snprintf(g_name, sizeof(g_name), "streamn-scoreboard-test-%d",
+		 (int)getpid());
+}
+
+static void test_shm_open_close(void)
+{
+	struct scoreboard_shm_reader reader;
+	struct scoreboard_shm_state state;
+
+	scoreboard_reset_state_for_tests();
+	setup_name();
+	assert(!scoreboard_shm_open(NULL));
+	assert(!scoreboard_shm_open(""));
+	assert(!scoreboard_shm_is_open());
+	/* Nothing to publish into until a segment is open */
+	assert(!scoreboard_shm_publish());
+	assert(!scoreboard_shm_reader_open(&reader, g_name));
+
+	scoreboard_set_home_name("Eagles");
+	assert(scoreboard_shm_open(g_name));
+	assert(scoreboard_shm_is_open());
+
+	assert(scoreboard_shm_reader_open(&reader, g_name));
+	assert(scoreboard_shm_reader_read(&reader, &state));
+	assert(state.generation == 1);
+	assert(strcmp(state.home_name, "Eagles") == 0);
+	assert(strcmp(state.sport_name, "hockey") == 0);
+
+	/* Reopening replaces the segment */
+	assert(scoreboard_shm_open(g_name));
+	scoreboard_shm_close();
+	assert(!scoreboard_shm_is_open());
+	scoreboard_shm_close();
+
+	/* A reader still mapped after close sees the segment retired */
+	assert(!scoreboard_shm_reader_read(&reader, &state));
+	scoreboard_shm_reader_close(&reader);
+	scoreboard_shm_reader_close(&reader);
+	assert(!scoreboard_shm_reader_open(&reader, g_name));
+	assert(!scoreboard_shm_reader_open(NULL, g_name));
+	assert(!scoreboard_shm_reader_read(NULL, &state));
+}
+
+static void test_shm_publish_only_on_change(void)
+{
+	struct scoreboard_shm_reader reader;
+	struct scoreboard_shm_state state;
+
+	scoreboard_reset_state_for_tests();
+	setup_name();
+	assert(scoreboard_shm_open(g_name));
+	assert(scoreboard_shm_reader_open(&reader, g_name));
+
+	assert(!scoreboard_shm_publish());
+	scoreboard_set_home_score(3);
+	scoreboard_home_penalty_add(12, 120);
+	scoreboard_clock_start();
+	assert(scoreboard_shm_publish());
+	assert(!scoreboard_shm_publish());
+
+	assert(scoreboard_shm_reader_read(&reader, &state));
+	assert(state.generation == 2);
+	assert(state.home_score == 3);
+	assert(state.clock_running == 1);
+	assert(state.home_penalties[0].active == 1);
+	assert(state.home_penalties[0].player_number == 12);
+	assert(state.home_penalties[0].remaining_tenths == 1200);
+	assert(state.away_penalties[0].active == 0);
+
+	/* Every tenth is published, not just visible second changes */
+	scoreboard_clock_tick(1);
+	assert(scoreboard_shm_publish());
+	assert(scoreboard_shm_reader_read(&reader, &state));
+	assert(state.generation == 3);
+	assert(state.clock_tenths == scoreboard_clock_get_tenths());
+
+	char clock[16];
+	scoreboard_clock_format(clock, sizeof(clock));
+	assert(strcmp(state.clock_text, clock) == 0);
+
+	scoreboard_shm_reader_close(&reader);
+	scoreboard_shm_close();
+}
+
+static void test_shm_read_rejects_bad_segment(void)
+{
+	static struct scoreboard_shm_segment segment;
+	struct scoreboard_shm_state state;
+
+	memset(&segment, 0, sizeof(segment));
+	assert(!scoreboard_shm_read_state(NULL, &state));
+	assert(!scoreboard_shm_read_state(&segment, NULL));
+	/* Not yet initialized */
+	assert(!scoreboard_shm_read_state(&segment, &state));
+
+	segment.magic = SCOREBOARD_SHM_MAGIC;
+	segment.version = SCOREBOARD_SHM_VERSION + 1;
+	segment.size = sizeof(segment);
+	assert(!scoreboard_shm_read_state(&segment, &state));
+	segment.version = SCOREBOARD_SHM_VERSION;
+	segment.size = sizeof(segment) - 4;
+	assert(!scoreboard_shm_read_state(&segment, &state));
+	segment.size = sizeof(segment);
+	assert(scoreboard_shm_read_state(&segment, &state));
+
+	/* A writer stuck mid-update makes the reader give up, not spin */
+	segment.seq = 1;
+	assert(!scoreboard_shm_read_state(&segment, &state));
+}
+
+#ifndef _WIN32
+/* Child side: read as fast as possible while the parent keeps publishing.
+   Both scores and the home name are always set together, so any mismatch
+   means a torn snapshot. */
+static int run_reader_process(void)
+{
+	struct scoreboard_shm_reader reader;
+	struct scoreboard_shm_state state;
+	uint32_t last_generation = 0;
+	int changes = 0;
+
+	alarm(20);
+	if (!scoreboard_shm_reader_open(&reader, g_name))
+		return 2;
+	for (int i = 0; i < 200000 || changes < 100; i++) {
+		if (!scoreboard_shm_reader_read(&reader, &state))
+			continue;
+		char expected[SCOREBOARD_SHM_NAME_SIZE];
+		snprintf(expected, sizeof(expected), "Team %d",
+			 (int)state.home_score);
+		if (state.home_score != state.away_score ||
+		    strcmp(state.home_name, expected) != 0)
+			return 3;
+		if (state.generation < last_generation)
+			return 4;
+		if (state.generation != last_generation)
+			changes++;
+		last_generation = state.generation;
+	}
+	scoreboard_shm_reader_close(&reader);
+	return 0;
+}
+
+static void test_shm_second_process_reads_consistent_snapshots(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_name();
+	scoreboard_set_home_name("Team 0");
+	assert(scoreboard_shm_open(g_name));
+
+	pid_t pid = fork();
+	assert(pid >= 0);
+	if (pid == 0)
+		exit(run_reader_process());
+
+	int status = 0;
+	bool exited = false;
+	time_t deadline = time(NULL) + 30;
+	for (int i = 1; !exited && time(NULL) < deadline; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "Team %d", i);
+		scoreboard_set_home_score(i);
+		scoreboard_set_away_score(i);
+		scoreboard_set_home_name(name);
+		scoreboard_shm_publish();
+		exited = waitpid(pid, &status, WNOHANG) == pid;
+	}
+	assert(exited);
+	assert(WIFEXITED(status));
+	assert(WEXITSTATUS(status) == 0);
+
+	scoreboard_shm_close();
+}
+#endif
+
+int main(void)
+{
+	test_shm_open_close();
+	test_shm_publish_only_on_change();
+	test_shm_read_rejects_bad_segment();
+#ifndef _WIN32
+	test_shm_second_process_reads_consistent_snapshots();
+#endif
+
+	printf("All scoreboard-core shm tests passed.\n");
+	return 0;
+}
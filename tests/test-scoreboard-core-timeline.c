@@ -0,0 +1,239 @@
+#include "scoreboard-core.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define mkdir(path, mode) _mkdir(path)
+#define getpid() _getpid()
+#else
+#include <unistd.h>
+#endif
+
+#define NS_PER_MS 1000000ull
+#define NS(seconds) ((uint64_t)(seconds) * 1000000000ull)
+
+static char g_tmp_dir[256];
+static uint64_t g_now_ns;
+
+static void setup_tmp_dir(void)
+{
+#ifdef _WIN32
+	snprintf(g_tmp_dir, sizeof(g_tmp_dir), "%s\\scoreboard_timeline_%d",
+		 getenv("TEMP") ? getenv("TEMP") : ".", (int)getpid());
+#else
+	snprintf(g_tmp_dir, sizeof(g_tmp_dir), "/tmp/scoreboard_timeline_%d",
+		 (int)getpid());
+#endif
+	mkdir(g_tmp_dir, 0755);
+}
+
+static void cleanup_tmp_dir(void)
+{
+	char cmd[512];
+	snprintf(cmd, sizeof(cmd), "rm -rf %s", g_tmp_dir);
+	system(cmd);
+}
+
+static uint64_t fake_now(void)
+{
+	return g_now_ns;
+}
+
+static char *read_file(const char *path)
+{
+	FILE *f = fopen(path, "rb");
+	assert(f != NULL);
+	static char buf[8192];
+	size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+	buf[n] = '\0';
+	fclose(f);
+	return buf;
+}
+
+static void reset(void)
+{
+	scoreboard_reset_state_for_tests();
+	g_now_ns = NS(1000);
+	scoreboard_set_time_source(fake_now);
+}
+
+static bool mark(enum scoreboard_timeline tl,
+		 enum scoreboard_timeline_mark m, uint64_t time_ns)
+{
+	return scoreboard_timeline_mark(tl, m, time_ns);
+}
+
+static void test_marks(void)
+{
+	reset();
+	const enum scoreboard_timeline rec = SCOREBOARD_TIMELINE_RECORDING;
+	assert(scoreboard_timeline_now() == NS(1000));
+	assert(!scoreboard_timeline_is_active(rec));
+	assert(scoreboard_timeline_offset_ns(rec, NS(1000)) == -1);
+	assert(scoreboard_timeline_length_ns(rec) == -1);
+
+	/* Only the moves OBS makes */
+	assert(!mark(rec, SCOREBOARD_MARK_STOP, NS(1)));
+	assert(!mark(rec, SCOREBOARD_MARK_PAUSE, NS(1)));
+	assert(!mark(rec, SCOREBOARD_MARK_RESUME, NS(1)));
+	assert(mark(rec, SCOREBOARD_MARK_START, NS(100)));
+	assert(!mark(rec, SCOREBOARD_MARK_START, NS(101)));
+	assert(!mark(rec, SCOREBOARD_MARK_RESUME, NS(101)));
+	assert(scoreboard_timeline_is_active(rec));
+	assert(!scoreboard_timeline_is_paused(rec));
+	assert(mark(rec, SCOREBOARD_MARK_PAUSE, NS(110)));
+	assert(!mark(rec, SCOREBOARD_MARK_PAUSE, NS(111)));
+	assert(scoreboard_timeline_is_paused(rec));
+	assert(scoreboard_timeline_is_active(rec));
+	assert(mark(rec, SCOREBOARD_MARK_RESUME, NS(130)));
+	assert(mark(rec, SCOREBOARD_MARK_PAUSE, NS(140)));
+	assert(mark(rec, SCOREBOARD_MARK_STOP, NS(150)));
+	assert(!scoreboard_timeline_is_active(rec));
+	assert(!scoreboard_timeline_is_paused(rec));
+
+	assert(!mark((enum scoreboard_timeline)2, SCOREBOARD_MARK_START, 0));
+	assert(!mark(rec, (enum scoreboard_timeline_mark)9, 0));
+	assert(!scoreboard_timeline_is_active((enum scoreboard_timeline)-1));
+	assert(!scoreboard_timeline_is_paused((enum scoreboard_timeline)2));
+	assert(scoreboard_timeline_offset_ns((enum scoreboard_timeline)2,
+					     0) == -1);
+	assert(scoreboard_timeline_length_ns((enum scoreboard_timeline)2) ==
+	       -1);
+}
+
+static void test_offsets(void)
+{
+	reset();
+	const enum scoreboard_timeline rec = SCOREBOARD_TIMELINE_RECORDING;
+	const enum scoreboard_timeline stream = SCOREBOARD_TIMELINE_STREAM;
+	mark(stream, SCOREBOARD_MARK_START, NS(50));
+	mark(rec, SCOREBOARD_MARK_START, NS(100));
+	mark(rec, SCOREBOARD_MARK_PAUSE, NS(110));
+	mark(rec, SCOREBOARD_MARK_RESUME, NS(130));
+
+	/* The same moment in both, the recording less its pause */
+	uint64_t t = NS(140) + 250 * NS_PER_MS;
+	assert(scoreboard_timeline_offset_ns(stream, t) ==
+	       (int64_t)(NS(90) + 250 * NS_PER_MS));
+	assert(scoreboard_timeline_offset_ns(rec, t) ==
+	       (int64_t)(NS(20) + 250 * NS_PER_MS));
+	/* Inside the pause it is where the pause began */
+	assert(scoreboard_timeline_offset_ns(rec, NS(120)) == (int64_t)NS(10));
+	assert(scoreboard_timeline_offset_ns(rec, NS(99)) == -1);
+
+	/* Running: up to now; stopped: up to the stop and no further */
+	g_now_ns = NS(160);
+	assert(scoreboard_timeline_length_ns(rec) == (int64_t)NS(40));
+	mark(stream, SCOREBOARD_MARK_STOP, NS(170));
+	mark(rec, SCOREBOARD_MARK_STOP, NS(180));
+	g_now_ns = NS(500);
+	assert(scoreboard_timeline_length_ns(rec) == (int64_t)NS(60));
+	assert(scoreboard_timeline_length_ns(stream) == (int64_t)NS(120));
+	assert(scoreboard_timeline_offset_ns(rec, NS(180)) ==
+	       (int64_t)NS(60));
+	assert(scoreboard_timeline_offset_ns(rec, NS(181)) == -1);
+
+	/* A new recording starts its offsets over */
+	mark(rec, SCOREBOARD_MARK_START, NS(600));
+	assert(scoreboard_timeline_offset_ns(rec, t) == -1);
+	assert(scoreboard_timeline_offset_ns(rec, NS(605)) == (int64_t)NS(5));
+
+	scoreboard_timeline_reset();
+	assert(scoreboard_timeline_offset_ns(rec, NS(605)) == -1);
+	assert(!scoreboard_timeline_is_active(rec));
+}
+
+static void test_timed_events(void)
+{
+	setup_tmp_dir();
+	reset();
+	const enum scoreboard_timeline rec = SCOREBOARD_TIMELINE_RECORDING;
+	const enum scoreboard_timeline stream = SCOREBOARD_TIMELINE_STREAM;
+	char path[608]; /* the base below plus an extension */
+	snprintf(path, sizeof(path), "%s/timestamps.txt", g_tmp_dir);
+
+	/* Recording first; the stream starts later */
+	mark(rec, SCOREBOARD_MARK_START, NS(1000));
+	assert(scoreboard_event_log_add_timed(NS(1005), 0, "Before stream",
+					      SCOREBOARD_EVENT_OTHER,
+					      SCOREBOARD_TEAM_NONE, 0) == 0);
+	assert(scoreboard_event_log_get(0)->offset_seconds == -1);
+	assert(scoreboard_event_log_get(0)->time_ns == NS(1005));
+
+	mark(stream, SCOREBOARD_MARK_START, NS(1010));
+	assert(scoreboard_event_log_open(path));
+	scoreboard_event_log_add_timed(NS(1010), 0, "Stream Start",
+				       SCOREBOARD_EVENT_OTHER,
+				       SCOREBOARD_TEAM_NONE, 0);
+	mark(rec, SCOREBOARD_MARK_PAUSE, NS(1020));
+	mark(rec, SCOREBOARD_MARK_RESUME, NS(1050));
+	/* A goal seen 10 s late, in both */
+	scoreboard_event_log_add_timed(NS(1080) + 500 * NS_PER_MS, 10000,
+				       "Goal: Eagles (1-0)",
+				       SCOREBOARD_EVENT_GOAL,
+				       SCOREBOARD_TEAM_HOME, 0);
+	const struct scoreboard_game_event *goal =
+		scoreboard_event_log_last_of(SCOREBOARD_EVENT_GOAL,
+					     SCOREBOARD_TEAM_HOME, 0);
+	assert(goal->offset_seconds == 60);
+	assert(goal->delay_ms == 10000);
+	/* Time 0 marks fixed-offset events, so a timed one moves off it */
+	scoreboard_event_log_add_timed(0, -5, "Odd", SCOREBOARD_EVENT_OTHER,
+				       SCOREBOARD_TEAM_NONE, 0);
+	assert(scoreboard_event_log_get(3)->time_ns == 1);
+	assert(scoreboard_event_log_get(3)->offset_seconds == -1);
+	scoreboard_event_log_remove(3);
+	scoreboard_event_log_remove(0);
+
+	/* The events outside the stream never reach its file */
+	assert(strcmp(read_file(path), "0:00:00 Stream Start\n"
+				       "0:01:00 Goal: Eagles (1-0)\n") == 0);
+
+	g_now_ns = NS(1100);
+	mark(stream, SCOREBOARD_MARK_STOP, NS(1100));
+	mark(rec, SCOREBOARD_MARK_STOP, NS(1100));
+	char base[600];
+	snprintf(base, sizeof(base), "%s/timestamps", g_tmp_dir);
+	assert(scoreboard_event_log_export(stream, base,
+					   SCOREBOARD_CHAPTERS_WEBVTT));
+	snprintf(path, sizeof(path), "%s.vtt", base);
+	assert(strcmp(read_file(path),
+		      "WEBVTT\n"
+		      "\n1\n00:00:00.000 --> 00:01:00.500\nStream Start\n"
+		      "\n2\n00:01:00.500 --> 00:01:30.000\n"
+		      "Goal: Eagles (1-0)\n") == 0);
+
+	/* The recording has the same goal at its own offset: it started
+	   10 s sooner and then spent 30 s paused. Fixed-offset events
+	   belong to the stream only. */
+	snprintf(base, sizeof(base), "%s/game.mkv.chapters", g_tmp_dir);
+	scoreboard_event_log_add(5, "Read back");
+	assert(scoreboard_event_log_export(rec, base,
+					   SCOREBOARD_CHAPTERS_WEBVTT));
+	snprintf(path, sizeof(path), "%s.vtt", base);
+	assert(strcmp(read_file(path),
+		      "WEBVTT\n"
+		      "\n1\n00:00:00.000 --> 00:00:10.000\nRecording Start\n"
+		      "\n2\n00:00:10.000 --> 00:00:40.500\nStream Start\n"
+		      "\n3\n00:00:40.500 --> 00:01:10.000\n"
+		      "Goal: Eagles (1-0)\n") == 0);
+	assert(!scoreboard_event_log_export((enum scoreboard_timeline)5, base,
+					    SCOREBOARD_CHAPTERS_ALL));
+	scoreboard_event_log_close();
+	cleanup_tmp_dir();
+}
+
+int main(void)
+{
+	test_marks();
+	test_offsets();
+	test_timed_events();
+
+	printf("All scoreboard-core timeline tests passed.\n");
+	return 0;
+}
@@ -0,0 +1,488 @@
+#include "scoreboard-core.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define mkdir(path, mode) _mkdir(path)
+#define getpid() _getpid()
+#else
+#include <unistd.h>
+#endif
+
+#define NS_PER_MS 1000000ull
+#define NS_PER_SEC 1000000000ull
+
+static char g_tmp_dir[256];
+static char g_trace_path[512];
+static uint64_t g_now_ns;
+static int g_user_count;
+
+static void setup_tmp_dir(void)
+{
+#ifdef _WIN32
+	snprintf(g_tmp_dir, sizeof(g_tmp_dir), "%s\\scoreboard_trace_%d",
+		 getenv("TEMP") ? getenv("TEMP") : ".", (int)getpid());
+#else
+	snprintf(g_tmp_dir, sizeof(g_tmp_dir), "/tmp/scoreboard_trace_%d",
+		 (int)getpid());
+#endif
+	mkdir(g_tmp_dir, 0755);
+	snprintf(g_trace_path, sizeof(g_trace_path), "%s/game.sbtrace",
+		 g_tmp_dir);
+}
+
+static void cleanup_tmp_dir(void)
+{
+	char cmd[512];
+	snprintf(cmd, sizeof(cmd), "rm -rf %s", g_tmp_dir);
+	system(cmd);
+}
+
+static uint64_t fake_now(void)
+{
+	return g_now_ns;
+}
+
+static void count_user(const struct scoreboard_command *cmd, void *data)
+{
+	(void)data;
+	assert(cmd->type == SCOREBOARD_CMD_USER + 2);
+	g_user_count++;
+}
+
+/* Moves the fake clock the way the dock's timer would */
+static void advance_to(uint64_t ns)
+{
+	g_now_ns = ns;
+	scoreboard_clock_sync();
+}
+
+static void post_at(uint64_t ns, int type, int a, int b, int c)
+{
+	struct scoreboard_command cmd;
+	cmd.type = type;
+	cmd.a = a;
+	cmd.b = b;
+	cmd.c = c;
+	advance_to(ns);
+	assert(scoreboard_command_post(&cmd));
+	assert(scoreboard_command_drain(count_user, NULL) == 1);
+}
+
+/* Records a stretch of game into g_trace_path and leaves the final JSON
+   snapshot in expected */
+static void record_game(char *expected, size_t size)
+{
+	scoreboard_reset_state_for_tests();
+	g_now_ns = 0;
+	scoreboard_set_time_source(fake_now);
+	g_user_count = 0;
+
+	scoreboard_set_home_name("Eagles");
+	scoreboard_home_penalty_add(12, 120);
+	scoreboard_clock_start();
+	/* Starts part way through a tenth */
+	advance_to(3250 * NS_PER_MS);
+	assert(scoreboard_trace_start(g_trace_path));
+	assert(scoreboard_trace_is_recording());
+
+	post_at(10 * NS_PER_SEC, SCOREBOARD_CMD_SCORE, SCOREBOARD_TEAM_HOME,
+		1, 0);
+	post_at(12340 * NS_PER_MS, SCOREBOARD_CMD_SHOTS, SCOREBOARD_TEAM_AWAY,
+		1, 0);
+	post_at(20 * NS_PER_SEC, SCOREBOARD_CMD_USER + 2, 0, 0, 0);
+	post_at(30 * NS_PER_SEC, SCOREBOARD_CMD_CLOCK_STOP, 0, 0, 0);
+	post_at(31 * NS_PER_SEC, SCOREBOARD_CMD_PENALTY_ADD,
+		SCOREBOARD_TEAM_AWAY, 7, 120);
+	post_at(35 * NS_PER_SEC, SCOREBOARD_CMD_CLOCK_START, 0, 0, 0);
+	/* Syncs between commands don't need to be in the trace */
+	advance_to(60 * NS_PER_SEC);
+	advance_to(95050 * NS_PER_MS);
+	assert(scoreboard_trace_stop());
+	assert(!scoreboard_trace_is_recording());
+	assert(g_user_count == 1);
+
+	scoreboard_format_output_snapshot(SCOREBOARD_OUTPUT_JSON, expected,
+					  size);
+}
+
+static void test_replay_reproduces_outputs(void)
+{
+	char expected[8192], replayed[8192];
+	setup_tmp_dir();
+	record_game(expected, sizeof(expected));
+
+	/* Replay onto a different game */
+	scoreboard_reset_state_for_tests();
+	scoreboard_set_away_name("Hawks");
+	scoreboard_set_away_score(5);
+	g_user_count = 0;
+	struct scoreboard_replay_stats stats;
+	assert(scoreboard_trace_replay(g_trace_path, 0, count_user, NULL,
+				       &stats));
+	assert(stats.commands == 6);
+	assert(stats.user_commands == 1);
+	assert(g_user_count == 1);
+	assert(stats.outputs_match);
+	/* Recording started at the clock's last whole tenth, 3.2 s */
+	assert(stats.trace_ns == 91850 * NS_PER_MS);
+
+	scoreboard_format_output_snapshot(SCOREBOARD_OUTPUT_JSON, replayed,
+					  sizeof(replayed));
+	assert(strcmp(expected, replayed) == 0);
+	assert(strcmp(scoreboard_get_home_name(), "Eagles") == 0);
+	assert(scoreboard_get_home_score() == 1);
+	assert(scoreboard_get_away_shots() == 1);
+	assert(scoreboard_get_away_penalty(0)->player_number == 7);
+
+	/* The replay can be run again, with or without a callback, and
+	   leaves the real clock in charge */
+	assert(scoreboard_trace_replay(g_trace_path, -1, NULL, NULL, NULL));
+	assert(g_user_count == 1);
+	assert(scoreboard_clock_is_running());
+	cleanup_tmp_dir();
+}
+
+static void test_replay_writes_outputs(void)
+{
+	char expected[8192];
+	setup_tmp_dir();
+	record_game(expected, sizeof(expected));
+
+	char out_dir[512];
+	snprintf(out_dir, sizeof(out_dir), "%s/out", g_tmp_dir);
+	mkdir(out_dir, 0755);
+	scoreboard_reset_state_for_tests();
+	scoreboard_set_output_directory(out_dir);
+	struct scoreboard_write_stats before;
+	scoreboard_get_write_stats(&before);
+	assert(scoreboard_trace_replay(g_trace_path, 0, NULL, NULL, NULL));
+	struct scoreboard_write_stats after;
+	scoreboard_get_write_stats(&after);
+	assert(after.writes >= before.writes + 6);
+
+	char path[600], buf[32];
+	snprintf(path, sizeof(path), "%s/home_score.txt", out_dir);
+	FILE *f = fopen(path, "r");
+	assert(f != NULL);
+	size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+	buf[n] = '\0';
+	fclose(f);
+	assert(strcmp(buf, "1") == 0);
+	cleanup_tmp_dir();
+}
+
+static void test_paced_replay(void)
+{
+	setup_tmp_dir();
+	scoreboard_reset_state_for_tests();
+	g_now_ns = 0;
+	scoreboard_set_time_source(fake_now);
+	assert(scoreboard_trace_start(g_trace_path));
+	post_at(40 * NS_PER_MS, SCOREBOARD_CMD_SCORE, SCOREBOARD_TEAM_AWAY, 1,
+		0);
+	advance_to(40 * NS_PER_MS);
+	assert(scoreboard_trace_stop());
+
+	struct scoreboard_replay_stats stats;
+	assert(scoreboard_trace_replay(g_trace_path, 1.0, NULL, NULL,
+				       &stats));
+	assert(stats.outputs_match);
+	assert(stats.elapsed_ns >= 40 * NS_PER_MS);
+	assert(scoreboard_trace_replay(g_trace_path, 4.0, NULL, NULL,
+				       &stats));
+	assert(stats.elapsed_ns >= 10 * NS_PER_MS);
+	assert(stats.trace_ns == 40 * NS_PER_MS);
+	cleanup_tmp_dir();
+}
+
+/* ---- changes outside commands ---- */
+
+/* A hotkey the dock applies itself rather than as a built-in command */
+static void away_goal_hotkey(const struct scoreboard_command *cmd,
+			     void *data)
+{
+	(void)data;
+	assert(cmd->type == SCOREBOARD_CMD_USER + 5);
+	scoreboard_increment_away_score();
+}
+
+/* The dock's buttons and dialogs change the game and write at once */
+static void write_at(uint64_t ns)
+{
+	advance_to(ns);
+	scoreboard_write_all_files();
+}
+
+static void write_text(const char *dir, const char *name, const char *text)
+{
+	char path[700];
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	FILE *f = fopen(path, "w");
+	assert(f != NULL);
+	fputs(text, f);
+	fclose(f);
+}
+
+static void test_replay_button_session(void)
+{
+	char expected[8192], replayed[8192], out_dir[600];
+	setup_tmp_dir();
+	snprintf(out_dir, sizeof(out_dir), "%s/out", g_tmp_dir);
+	mkdir(out_dir, 0755);
+	scoreboard_reset_state_for_tests();
+	g_now_ns = 0;
+	scoreboard_set_time_source(fake_now);
+	scoreboard_set_output_directory(out_dir);
+	assert(scoreboard_trace_start(g_trace_path));
+
+	/* The clock button, then a goal button with its event */
+	advance_to(1 * NS_PER_SEC);
+	scoreboard_clock_start();
+	write_at(1 * NS_PER_SEC);
+	advance_to(5250 * NS_PER_MS);
+	scoreboard_undo_begin();
+	scoreboard_increment_home_score();
+	scoreboard_event_log_add(5, "Goal: Home (1-0)");
+	scoreboard_undo_end("Home Goal +");
+	write_at(5250 * NS_PER_MS);
+
+	/* A penalty dialog and a settings change */
+	advance_to(8 * NS_PER_SEC);
+	scoreboard_away_penalty_add_compound(9, 120, 120);
+	scoreboard_set_default_penalty_duration(90);
+	write_at(8 * NS_PER_SEC);
+
+	/* A hotkey the dock runs itself, written by the tick after it */
+	struct scoreboard_command hotkey = {SCOREBOARD_CMD_USER + 5, 0, 0, 0};
+	advance_to(9 * NS_PER_SEC);
+	assert(scoreboard_command_post(&hotkey));
+	assert(scoreboard_command_drain(away_goal_hotkey, NULL) == 1);
+	write_at(9500 * NS_PER_MS);
+
+	/* A name edited on disk and reloaded, then a dialog change that
+	   only reaches the trace with the next command */
+	advance_to(12 * NS_PER_SEC);
+	write_text(out_dir, "away_name.txt", "Hawks");
+	assert(scoreboard_read_all_files());
+	scoreboard_set_home_name("Eagles");
+	post_at(13 * NS_PER_SEC, SCOREBOARD_CMD_SHOTS, SCOREBOARD_TEAM_HOME,
+		1, 0);
+
+	/* The undo button, then the clock button again */
+	advance_to(20 * NS_PER_SEC);
+	assert(scoreboard_undo());
+	write_at(20 * NS_PER_SEC);
+	advance_to(47 * NS_PER_SEC);
+	scoreboard_clock_stop();
+	write_at(47 * NS_PER_SEC);
+	advance_to(50 * NS_PER_SEC);
+	assert(scoreboard_trace_stop());
+	scoreboard_format_output_snapshot(SCOREBOARD_OUTPUT_JSON, expected,
+					  sizeof(expected));
+
+	/* Replayed headless, with nothing to run the hotkey */
+	scoreboard_reset_state_for_tests();
+	struct scoreboard_replay_stats stats;
+	assert(scoreboard_trace_replay(g_trace_path, 0, NULL, NULL, &stats));
+	assert(stats.commands == 2);
+	assert(stats.user_commands == 1);
+	assert(stats.changes > 0);
+	assert(stats.outputs_match);
+	scoreboard_format_output_snapshot(SCOREBOARD_OUTPUT_JSON, replayed,
+					  sizeof(replayed));
+	assert(strcmp(expected, replayed) == 0);
+	assert(scoreboard_get_home_score() == 1);
+	assert(scoreboard_get_away_score() == 1);
+	assert(scoreboard_get_home_shots() == 0);
+	assert(strcmp(scoreboard_get_home_name(), "Eagles") == 0);
+	assert(strcmp(scoreboard_get_away_name(), "Hawks") == 0);
+	assert(scoreboard_get_away_penalty(0)->phase2_tenths == 1200);
+	assert(scoreboard_get_default_penalty_duration() == 90);
+	assert(!scoreboard_clock_is_running());
+	cleanup_tmp_dir();
+}
+
+/* ---- damaged traces ---- */
+
+static size_t read_trace(unsigned char *buf, size_t size)
+{
+	FILE *f = fopen(g_trace_path, "rb");
+	assert(f != NULL);
+	size_t n = fread(buf, 1, size, f);
+	fclose(f);
+	return n;
+}
+
+static bool replay_bytes(const unsigned char *buf, size_t size,
+			 struct scoreboard_replay_stats *stats)
+{
+	char path[600];
+	snprintf(path, sizeof(path), "%s/damaged.sbtrace", g_tmp_dir);
+	FILE *f = fopen(path, "wb");
+	assert(f != NULL);
+	assert(fwrite(buf, 1, size, f) == size);
+	fclose(f);
+	return scoreboard_trace_replay(path, 0, NULL, NULL, stats);
+}
+
+static void test_replay_rejects_damage(void)
+{
+	static unsigned char good[16384], bad[16384];
+	char expected[8192];
+	setup_tmp_dir();
+	record_game(expected, sizeof(expected));
+	size_t size = read_trace(good, sizeof(good));
+	assert(size < sizeof(good));
+	/* Header, snapshot, six commands and the end record */
+	size_t records_at = size - 7 * 24;
+
+	struct scoreboard_replay_stats stats;
+	assert(!scoreboard_trace_replay(NULL, 0, NULL, NULL, &stats));
+	assert(stats.commands == 0);
+	assert(!scoreboard_trace_replay("/nonexistent/game.sbtrace", 0, NULL,
+					NULL, NULL));
+
+	memcpy(bad, good, size);
+	bad[0] = 'X';
+	assert(!replay_bytes(bad, size, NULL));
+
+	memcpy(bad, good, size);
+	bad[16] = 0; /* record size */
+	assert(!replay_bytes(bad, size, NULL));
+
+	memcpy(bad, good, size);
+	bad[records_at - 8] ^= 0x40; /* inside the snapshot's settings */
+	assert(!replay_bytes(bad, size, NULL));
+	memcpy(bad, good, size);
+	bad[records_at - 24] ^= 0x40; /* inside its state */
+	assert(!replay_bytes(bad, size, NULL));
+	assert(!replay_bytes(good, records_at - 1, NULL));
+
+	/* A trace cut short replays what it has but can't match */
+	assert(replay_bytes(good, records_at + 3 * 24 + 5, &stats));
+	assert(stats.commands == 3);
+	assert(!stats.outputs_match);
+
+	/* So does one whose final outputs differ */
+	memcpy(bad, good, size);
+	bad[size - 24 + 12] ^= 0x01; /* end record checksum */
+	assert(replay_bytes(bad, size, &stats));
+	assert(stats.commands == 6);
+	assert(!stats.outputs_match);
+	assert(replay_bytes(good, size, &stats));
+	assert(stats.outputs_match);
+	cleanup_tmp_dir();
+}
+
+static void test_recording_edges(void)
+{
+	setup_tmp_dir();
+	scoreboard_reset_state_for_tests();
+	assert(!scoreboard_trace_start(NULL));
+	assert(!scoreboard_trace_start(""));
+	assert(!scoreboard_trace_start("/nonexistent/dir/game.sbtrace"));
+#ifndef _WIN32
+	assert(!scoreboard_trace_start("/dev/full"));
+#endif
+	assert(!scoreboard_trace_is_recording());
+	assert(!scoreboard_trace_stop());
+
+	/* Only drained commands are recorded */
+	struct scoreboard_command cmd = {SCOREBOARD_CMD_SCORE,
+					 SCOREBOARD_TEAM_HOME, 1, 0};
+	scoreboard_trace_record(&cmd);
+	assert(scoreboard_trace_start(g_trace_path));
+	scoreboard_trace_record(NULL);
+	scoreboard_command_apply(&cmd);
+	/* Starting again finishes the first trace */
+	assert(scoreboard_trace_start(g_trace_path));
+	assert(scoreboard_trace_stop());
+
+	struct scoreboard_replay_stats stats;
+	assert(scoreboard_trace_replay(g_trace_path, 0, NULL, NULL, &stats));
+	assert(stats.commands == 0);
+	assert(stats.outputs_match);
+	assert(scoreboard_get_home_score() == 1);
+	cleanup_tmp_dir();
+}
+
+static void test_trace_follows_its_context(void)
+{
+	static unsigned char good[16384], bad[16384];
+	setup_tmp_dir();
+	scoreboard_reset_state_for_tests();
+	g_now_ns = 0;
+	scoreboard_set_time_source(fake_now);
+	g_user_count = 0;
+	struct scoreboard_ctx *def = scoreboard_ctx_default();
+	struct scoreboard_ctx *rink_b = scoreboard_ctx_create();
+	scoreboard_ctx_select(rink_b);
+	assert(scoreboard_trace_start(g_trace_path));
+	size_t records_at = read_trace(good, sizeof(good));
+
+	/* Another context's commands and changes aren't part of it */
+	scoreboard_ctx_select(def);
+	post_at(1 * NS_PER_SEC, SCOREBOARD_CMD_SCORE, SCOREBOARD_TEAM_AWAY,
+		1, 0);
+	scoreboard_set_home_name("Elsewhere");
+	scoreboard_write_all_files();
+	assert(read_trace(good, sizeof(good)) == records_at);
+
+	/* Each record is on disk as soon as it is written */
+	scoreboard_ctx_select(rink_b);
+	post_at(2 * NS_PER_SEC, SCOREBOARD_CMD_SCORE, SCOREBOARD_TEAM_HOME,
+		1, 0);
+	assert(read_trace(good, sizeof(good)) == records_at + 24);
+
+	/* Dropping the context stops its trace, with the change it never
+	   wrote */
+	scoreboard_set_away_name("Hawks");
+	scoreboard_ctx_destroy(rink_b);
+	assert(!scoreboard_trace_is_recording());
+	size_t size = read_trace(good, sizeof(good));
+	assert(size > records_at + 2 * 24);
+
+	struct scoreboard_replay_stats stats;
+	assert(scoreboard_trace_replay(g_trace_path, 0, NULL, NULL, &stats));
+	assert(stats.commands == 1);
+	assert(stats.changes > 0);
+	assert(stats.outputs_match);
+	assert(scoreboard_get_home_score() == 1);
+	assert(scoreboard_get_away_score() == 0);
+	assert(strcmp(scoreboard_get_away_name(), "Hawks") == 0);
+
+	/* Cut after its first change, a trace still ends on that change */
+	assert(replay_bytes(good, records_at + 2 * 24, &stats));
+	assert(stats.commands == 1);
+	assert(stats.changes == 1);
+	assert(!stats.outputs_match);
+
+	/* A change to a word outside the image is skipped */
+	memcpy(bad, good, size);
+	/* Offset 2, inside the state header */
+	memset(bad + records_at + 24 + 12, 0, 4);
+	bad[records_at + 24 + 12] = 2;
+	assert(replay_bytes(bad, size, &stats));
+	assert(stats.commands == 1);
+	cleanup_tmp_dir();
+}
+
+int main(void)
+{
+	test_replay_reproduces_outputs();
+	test_replay_writes_outputs();
+	test_paced_replay();
+	test_replay_button_session();
+	test_replay_rejects_damage();
+	test_recording_edges();
+	test_trace_follows_its_context();
+
+	printf("All scoreboard-core trace tests passed.\n");
+	return 0;
+}
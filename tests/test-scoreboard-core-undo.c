@@ -0,0 +1,448 @@
+#include "scoreboard-core.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NS_PER_SEC 1000000000ull
+
+static uint64_t g_now_ns;
+
+static uint64_t fake_now(void)
+{
+	return g_now_ns;
+}
+
+static void reset(void)
+{
+	scoreboard_reset_state_for_tests();
+	g_now_ns = 0;
+	scoreboard_set_time_source(fake_now);
+}
+
+static void run_clock(int seconds)
+{
+	g_now_ns += (uint64_t)seconds * NS_PER_SEC;
+	scoreboard_clock_sync();
+}
+
+static const char *event_label(int index)
+{
+	const struct scoreboard_game_event *e = scoreboard_event_log_get(index);
+	return e != NULL ? e->label : NULL;
+}
+
+static void home_goal(int offset)
+{
+	char label[64];
+	scoreboard_undo_begin();
+	scoreboard_increment_home_score();
+	snprintf(label, sizeof(label), "Goal: Home (%d-%d)",
+		 scoreboard_get_home_score(), scoreboard_get_away_score());
+	scoreboard_event_log_add(offset, label);
+	scoreboard_undo_end("Home goal");
+}
+
+static void test_undo_redo_counters(void)
+{
+	reset();
+	assert(!scoreboard_undo());
+	assert(!scoreboard_redo());
+	assert(scoreboard_undo_label() == NULL);
+	assert(scoreboard_redo_label() == NULL);
+
+	home_goal(30);
+	scoreboard_undo_begin();
+	scoreboard_increment_away_shots();
+	scoreboard_increment_home_faceoffs();
+	scoreboard_increment_away_fouls();
+	scoreboard_increment_home_fouls2();
+	scoreboard_undo_end(NULL);
+	assert(scoreboard_undo_count() == 2);
+	assert(strcmp(scoreboard_undo_label(), "") == 0);
+
+	assert(scoreboard_undo());
+	assert(scoreboard_get_away_shots() == 0);
+	assert(scoreboard_get_home_faceoffs() == 0);
+	assert(scoreboard_get_away_fouls() == 0);
+	assert(scoreboard_get_home_fouls2() == 0);
+	assert(strcmp(scoreboard_undo_label(), "Home goal") == 0);
+	assert(scoreboard_undo());
+	assert(scoreboard_get_home_score() == 0);
+	assert(scoreboard_event_log_count() == 0);
+	assert(scoreboard_undo_count() == 0);
+	assert(scoreboard_redo_count() == 2);
+	assert(strcmp(scoreboard_redo_label(), "Home goal") == 0);
+
+	assert(scoreboard_redo());
+	assert(scoreboard_get_home_score() == 1);
+	assert(strcmp(event_label(0), "Goal: Home (1-0)") == 0);
+	assert(scoreboard_event_log_get(0)->offset_seconds == 30);
+	assert(scoreboard_redo());
+	assert(scoreboard_get_away_shots() == 1);
+	assert(!scoreboard_redo());
+
+	/* A new action drops what could be redone */
+	assert(scoreboard_undo());
+	scoreboard_undo_begin();
+	scoreboard_increment_away_score();
+	scoreboard_undo_end("Away goal");
+	assert(scoreboard_redo_count() == 0);
+	assert(scoreboard_undo_count() == 2);
+
+	scoreboard_undo_clear();
+	assert(scoreboard_undo_count() == 0);
+	assert(!scoreboard_undo());
+	assert(scoreboard_get_away_score() == 1);
+}
+
+static void test_undo_keeps_unrelated_changes(void)
+{
+	reset();
+	home_goal(30);
+	/* Changes made outside a step stay */
+	scoreboard_set_away_score(3);
+	scoreboard_set_home_score(5);
+	assert(scoreboard_undo());
+	assert(scoreboard_get_away_score() == 3);
+	assert(scoreboard_get_home_score() == 4);
+
+	/* Values never go below their floor */
+	scoreboard_set_home_score(0);
+	assert(scoreboard_redo());
+	assert(scoreboard_get_home_score() == 1);
+	scoreboard_set_home_score(0);
+	assert(scoreboard_undo());
+	assert(scoreboard_get_home_score() == 0);
+}
+
+static void test_undo_restores_the_exact_event(void)
+{
+	reset();
+	home_goal(30);
+	/* A later goal with the same prefix, logged outside any step */
+	scoreboard_event_log_add(90, "Goal: Home (2-0)");
+	assert(scoreboard_undo());
+	assert(scoreboard_event_log_count() == 1);
+	assert(strcmp(event_label(0), "Goal: Home (2-0)") == 0);
+
+	/* Redo puts it back where it was */
+	assert(scoreboard_redo());
+	assert(strcmp(event_label(0), "Goal: Home (1-0)") == 0);
+	assert(strcmp(event_label(1), "Goal: Home (2-0)") == 0);
+
+	/* An entry that moved is found by its exact contents */
+	scoreboard_event_log_remove(0);
+	scoreboard_event_log_add(30, "Goal: Home (1-0)");
+	scoreboard_event_log_add(95, "Period 1 End");
+	assert(scoreboard_undo());
+	assert(scoreboard_event_log_count() == 2);
+	assert(strcmp(event_label(0), "Goal: Home (2-0)") == 0);
+	assert(strcmp(event_label(1), "Period 1 End") == 0);
+
+	/* One that is gone is left alone */
+	assert(scoreboard_redo());
+	scoreboard_event_log_clear();
+	assert(scoreboard_undo());
+	assert(scoreboard_event_log_count() == 0);
+	assert(scoreboard_get_home_score() == 0);
+}
+
+static void test_undo_removed_event(void)
+{
+	reset();
+	scoreboard_event_log_add(10, "Period 1 Start");
+	scoreboard_event_log_add(30, "Goal: Away (0-1)");
+	scoreboard_event_log_add(50, "Goal: Home (1-1)");
+	scoreboard_set_away_score(1);
+
+	scoreboard_undo_begin();
+	scoreboard_event_log_remove(1);
+	scoreboard_decrement_away_score();
+	scoreboard_undo_end("Away goal -");
+	assert(scoreboard_undo());
+	assert(scoreboard_get_away_score() == 1);
+	assert(strcmp(event_label(1), "Goal: Away (0-1)") == 0);
+	assert(scoreboard_redo());
+	assert(scoreboard_event_log_count() == 2);
+	assert(strcmp(event_label(1), "Goal: Home (1-1)") == 0);
+
+	/* Past the end of a shorter log it goes last */
+	scoreboard_event_log_clear();
+	assert(scoreboard_undo());
+	assert(scoreboard_redo());
+	assert(scoreboard_event_log_count() == 0);
+	assert(scoreboard_undo());
+	assert(strcmp(event_label(0), "Goal: Away (0-1)") == 0);
+	assert(scoreboard_redo());
+
+	/* A long log takes it back too */
+	while (scoreboard_event_log_count() < 300)
+		scoreboard_event_log_add(60, "Shot");
+	assert(scoreboard_undo());
+	assert(scoreboard_event_log_count() == 301);
+	assert(strcmp(event_label(1), "Goal: Away (0-1)") == 0);
+	assert(strcmp(event_label(300), "Shot") == 0);
+	assert(scoreboard_get_away_score() == 1);
+
+	/* A step keeps its first two event changes */
+	scoreboard_event_log_clear();
+	scoreboard_undo_begin();
+	scoreboard_event_log_add(1, "one");
+	scoreboard_event_log_add(2, "two");
+	scoreboard_event_log_add(3, "three");
+	scoreboard_undo_end("Three events");
+	assert(scoreboard_undo());
+	assert(scoreboard_event_log_count() == 1);
+	assert(strcmp(event_label(0), "three") == 0);
+}
+
+static void test_undo_penalties(void)
+{
+	reset();
+	scoreboard_home_penalty_add(12, 120);
+	scoreboard_clock_start();
+
+	scoreboard_undo_begin();
+	scoreboard_away_penalty_add(7, 120);
+	scoreboard_event_log_add(20, "Power Play: Home #7");
+	scoreboard_undo_end("Away penalty");
+	run_clock(10);
+	assert(scoreboard_undo());
+	assert(scoreboard_get_away_penalty_count() == 0);
+	assert(scoreboard_event_log_count() == 0);
+	/* The penalty that was already running keeps running */
+	assert(scoreboard_get_home_penalty(0)->remaining_tenths == 1100);
+	assert(scoreboard_redo());
+	assert(scoreboard_get_away_penalty(0)->player_number == 7);
+	assert(scoreboard_get_away_penalty(0)->remaining_tenths == 1200);
+
+	/* Clearing one slot compacts the others; undo puts both back */
+	scoreboard_home_penalty_add(44, 300);
+	scoreboard_undo_begin();
+	scoreboard_home_penalty_clear(0);
+	scoreboard_penalty_compact();
+	scoreboard_undo_end("Home penalty clear");
+	assert(scoreboard_get_home_penalty(0)->player_number == 44);
+	assert(scoreboard_undo());
+	assert(scoreboard_get_home_penalty(0)->player_number == 12);
+	assert(scoreboard_get_home_penalty(0)->remaining_tenths == 1100);
+	assert(scoreboard_get_home_penalty(1)->player_number == 44);
+	assert(scoreboard_get_home_penalty_count() == 2);
+
+	/* A time edit on a penalty that keeps running moves it by the
+	   edit, not back to the time it had then */
+	scoreboard_undo_begin();
+	scoreboard_away_penalty_set_time(0, 10);
+	scoreboard_undo_end("Away penalty time");
+	assert(scoreboard_get_away_penalty(0)->remaining_tenths == 100);
+	run_clock(4);
+	assert(scoreboard_undo());
+	assert(scoreboard_get_away_penalty(0)->remaining_tenths == 1160);
+	run_clock(100);
+	assert(scoreboard_redo());
+	assert(scoreboard_get_away_penalty(0)->active);
+	assert(scoreboard_get_away_penalty(0)->remaining_tenths == 0);
+}
+
+/* A clear that compacts moves the penalties after it, so undo has to
+   find each one by who it is, not by the slot it had */
+static void test_undo_penalty_clear_after_compact(void)
+{
+	reset();
+	scoreboard_home_penalty_add(7, 120);
+	scoreboard_home_penalty_add(9, 120);
+	scoreboard_clock_start();
+	run_clock(10);
+
+	scoreboard_undo_begin();
+	scoreboard_home_penalty_clear(0);
+	scoreboard_penalty_compact();
+	scoreboard_undo_end("Home penalty clear");
+	assert(scoreboard_get_home_penalty(0)->player_number == 9);
+	run_clock(20);
+	assert(scoreboard_get_home_penalty(0)->remaining_tenths == 900);
+
+	assert(scoreboard_undo());
+	assert(scoreboard_get_home_penalty_count() == 2);
+	assert(scoreboard_get_home_penalty(0)->player_number == 7);
+	assert(scoreboard_get_home_penalty(0)->remaining_tenths == 1100);
+	/* #9 kept running the whole time */
+	assert(scoreboard_get_home_penalty(1)->player_number == 9);
+	assert(scoreboard_get_home_penalty(1)->remaining_tenths == 900);
+
+	run_clock(5);
+	assert(scoreboard_redo());
+	assert(scoreboard_get_home_penalty_count() == 1);
+	assert(scoreboard_get_home_penalty(0)->player_number == 9);
+	assert(scoreboard_get_home_penalty(0)->remaining_tenths == 850);
+
+	/* A penalty that expired since stays gone */
+	scoreboard_undo_begin();
+	scoreboard_home_penalty_add(7, 30);
+	scoreboard_home_penalty_add(3, 120);
+	scoreboard_undo_end("Home penalties");
+	run_clock(30);
+	assert(scoreboard_get_home_penalty_count() == 2);
+	assert(scoreboard_undo());
+	assert(scoreboard_get_home_penalty_count() == 1);
+	assert(scoreboard_get_home_penalty(0)->player_number == 9);
+	assert(scoreboard_redo());
+	assert(scoreboard_get_home_penalty_count() == 3);
+	assert(scoreboard_get_home_penalty(1)->player_number == 7);
+	assert(scoreboard_get_home_penalty(2)->player_number == 3);
+}
+
+static void test_undo_penalty_restore_limits(void)
+{
+	reset();
+	/* The same player twice: undo puts back the second one only */
+	scoreboard_away_penalty_add(5, 60);
+	scoreboard_away_penalty_add(5, 120);
+	scoreboard_undo_begin();
+	scoreboard_away_penalty_clear(1);
+	scoreboard_undo_end("Away penalty clear");
+	/* With the list emptied since, it goes back first */
+	scoreboard_away_penalty_clear(0);
+	assert(scoreboard_undo());
+	assert(scoreboard_get_away_penalty_count() == 1);
+	assert(scoreboard_get_away_penalty(0)->player_number == 5);
+	assert(scoreboard_get_away_penalty(0)->remaining_tenths == 1200);
+
+	/* A list filled since has no room for it */
+	scoreboard_undo_begin();
+	scoreboard_away_penalty_clear(0);
+	scoreboard_undo_end("Away penalty clear");
+	for (int i = 0; i < SCOREBOARD_MAX_PENALTIES; i++)
+		scoreboard_away_penalty_add(10 + i, 120);
+	assert(scoreboard_undo());
+	assert(scoreboard_get_away_penalty_count() ==
+	       SCOREBOARD_MAX_PENALTIES);
+	assert(scoreboard_get_away_penalty(0)->player_number == 10);
+}
+
+static void test_undo_period_and_clock(void)
+{
+	reset();
+	scoreboard_clock_start();
+	run_clock(60);
+	scoreboard_clock_stop();
+	int clock = scoreboard_clock_get_tenths();
+
+	scoreboard_undo_begin();
+	scoreboard_period_advance();
+	scoreboard_undo_end("Period advance");
+	assert(scoreboard_get_period() == 2);
+	assert(scoreboard_undo());
+	assert(scoreboard_get_period() == 1);
+	assert(scoreboard_clock_get_tenths() == clock);
+
+	scoreboard_undo_begin();
+	scoreboard_clock_adjust_minutes(-1);
+	scoreboard_undo_end("Clock -1 min");
+	/* The clock running between the edit and the undo is kept */
+	scoreboard_clock_start();
+	run_clock(5);
+	assert(scoreboard_undo());
+	assert(scoreboard_clock_get_tenths() == clock - 50);
+	scoreboard_clock_stop();
+
+	/* The period never goes below 1 */
+	assert(scoreboard_redo());
+	scoreboard_undo_begin();
+	scoreboard_period_advance();
+	scoreboard_undo_end("Period advance");
+	scoreboard_period_rewind();
+	scoreboard_period_rewind();
+	assert(scoreboard_undo());
+	assert(scoreboard_get_period() == 1);
+}
+
+static void test_undo_steps(void)
+{
+	reset();
+	/* Nested begin/end make one step */
+	scoreboard_undo_begin();
+	scoreboard_increment_home_shots();
+	scoreboard_undo_begin();
+	scoreboard_increment_home_shots();
+	scoreboard_undo_end("inner");
+	/* No undo in the middle of recording */
+	assert(!scoreboard_undo());
+	assert(!scoreboard_redo());
+	scoreboard_undo_end("Two shots");
+	assert(scoreboard_undo_count() == 1);
+	assert(strcmp(scoreboard_undo_label(), "Two shots") == 0);
+
+	/* Unmatched end and empty steps record nothing */
+	scoreboard_undo_end("stray");
+	assert(scoreboard_undo());
+	scoreboard_undo_begin();
+	scoreboard_clock_start();
+	scoreboard_clock_stop();
+	scoreboard_undo_end("Clock start/stop");
+	assert(scoreboard_undo_count() == 0);
+	assert(scoreboard_redo_count() == 1);
+
+	/* The history keeps the newest SCOREBOARD_UNDO_DEPTH steps */
+	for (int i = 0; i < SCOREBOARD_UNDO_DEPTH + 8; i++) {
+		scoreboard_undo_begin();
+		scoreboard_increment_away_shots();
+		scoreboard_undo_end("Away shot");
+	}
+	assert(scoreboard_undo_count() == SCOREBOARD_UNDO_DEPTH);
+	while (scoreboard_undo())
+		;
+	assert(scoreboard_get_away_shots() == 8);
+	assert(scoreboard_redo_count() == SCOREBOARD_UNDO_DEPTH);
+}
+
+static void test_commands_are_undo_steps(void)
+{
+	reset();
+	struct scoreboard_command cmd = {SCOREBOARD_CMD_SCORE,
+					 SCOREBOARD_TEAM_AWAY, 1, 0};
+	assert(scoreboard_command_post(&cmd));
+	cmd.type = SCOREBOARD_CMD_CLOCK_START;
+	assert(scoreboard_command_post(&cmd));
+	cmd.type = SCOREBOARD_CMD_CLOCK_STOP;
+	assert(scoreboard_command_post(&cmd));
+	cmd.type = 99;
+	assert(scoreboard_command_post(&cmd));
+	assert(scoreboard_command_drain(NULL, NULL) == 4);
+	assert(scoreboard_undo_count() == 1);
+	assert(strcmp(scoreboard_undo_label(), "Score") == 0);
+	assert(scoreboard_undo());
+	assert(scoreboard_get_away_score() == 0);
+}
+
+static void test_undo_is_per_context(void)
+{
+	reset();
+	home_goal(10);
+	struct scoreboard_ctx *other = scoreboard_ctx_create();
+	struct scoreboard_ctx *def = scoreboard_ctx_select(other);
+	assert(scoreboard_undo_count() == 0);
+	assert(!scoreboard_undo());
+	scoreboard_ctx_select(def);
+	assert(scoreboard_undo());
+	assert(scoreboard_get_home_score() == 0);
+}
+
+int main(void)
+{
+	test_undo_redo_counters();
+	test_undo_keeps_unrelated_changes();
+	test_undo_restores_the_exact_event();
+	test_undo_removed_event();
+	test_undo_penalties();
+	test_undo_penalty_clear_after_compact();
+	test_undo_penalty_restore_limits();
+	test_undo_period_and_clock();
+	test_undo_steps();
+	test_commands_are_undo_steps();
+	test_undo_is_per_context();
+
+	printf("All scoreboard-core undo tests passed.\n");
+	return 0;
+}
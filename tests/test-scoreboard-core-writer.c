@@ -0,0 +1,256 @@
+#include "scoreboard-core.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define mkdir(path, mode) _mkdir(path)
+#define getpid() _getpid()
+#else
+#include <unistd.h>
+#endif
+
+static char g_tmp_dir[256];
+
+static void setup_tmp_dir(void)
+{
+#ifdef _WIN32
+	snprintf(g_tmp_dir, sizeof(g_tmp_dir), "%s\\scoreboard_writer_%d",
+		 getenv("TEMP") ? getenv("TEMP") : ".", (int)getpid());
+#else
+	snprintf(g_tmp_dir, sizeof(g_tmp_dir), "/tmp/scoreboard_writer_%d",
+		 (int)getpid());
+#endif
+	mkdir(g_tmp_dir, 0755);
+}
+
+static void cleanup_tmp_dir(void)
+{
+	char cmd[512];
+	snprintf(cmd, sizeof(cmd), "rm -rf %s", g_tmp_dir);
+	system(cmd);
+}
+
+static char *read_output(const char *name)
+{
+	char path[512];
+	snprintf(path, sizeof(path), "%s/%s", g_tmp_dir, name);
+	FILE *f = fopen(path, "r");
+	if (f == NULL)
+		return NULL;
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	char *buf = (char *)malloc((size_t)size + 1);
+	size_t n = fread(buf, 1, (size_t)size, f);
+	buf[n] = '\0';
+	fclose(f);
+	return buf;
+}
+
+static bool output_exists(const char *name)
+{
+	char *content = read_output(name);
+	free(content);
+	return content != NULL;
+}
+
+static void test_writer_start_stop(void)
+{
+	assert(!scoreboard_writer_is_running());
+	assert(scoreboard_writer_start());
+	assert(scoreboard_writer_is_running());
+	/* Starting twice is a no-op */
+	assert(scoreboard_writer_start());
+	scoreboard_writer_stop();
+	assert(!scoreboard_writer_is_running());
+	/* Stopping or flushing a stopped writer is harmless */
+	scoreboard_writer_stop();
+	scoreboard_writer_flush();
+}
+
+static void test_writer_publishes_all_files(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	assert(scoreboard_writer_start());
+	scoreboard_set_output_directory(g_tmp_dir);
+	scoreboard_set_home_name("Eagles");
+	scoreboard_set_home_score(4);
+	assert(scoreboard_write_all_files());
+	scoreboard_writer_flush();
+
+	char *content = read_output("home_name.txt");
+	assert(content != NULL);
+	assert(strcmp(content, "Eagles") == 0);
+	free(content);
+	content = read_output("home_score.txt");
+	assert(strcmp(content, "4") == 0);
+	free(content);
+	/* Temp files never linger once published */
+	assert(!output_exists("home_score.txt.tmp"));
+
+	struct scoreboard_writer_stats stats;
+	scoreboard_writer_get_stats(&stats);
+	assert(stats.queued == SCOREBOARD_FIELD_COUNT);
+	assert(stats.written + stats.coalesced == stats.queued);
+	assert(stats.errors == 0);
+	/* Every file the thread wrote was timed */
+	assert(stats.replace.calls == stats.written);
+	assert(stats.replace.items == stats.written);
+
+	scoreboard_writer_stop();
+	cleanup_tmp_dir();
+}
+
+static void test_writer_coalesces_to_latest(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	assert(scoreboard_writer_start());
+	scoreboard_set_output_directory(g_tmp_dir);
+	for (int i = 1; i <= 500; i++) {
+		scoreboard_set_away_score(i);
+		assert(scoreboard_write_all_files());
+	}
+	scoreboard_writer_stop();
+
+	/* Stop drains the queue; only the newest value matters */
+	char *content = read_output("away_score.txt");
+	assert(content != NULL);
+	assert(strcmp(content, "500") == 0);
+	free(content);
+
+	struct scoreboard_writer_stats stats;
+	scoreboard_writer_get_stats(&stats);
+	assert(stats.written + stats.coalesced == stats.queued);
+	assert(stats.written <= stats.queued);
+
+	cleanup_tmp_dir();
+}
+
+static void test_writer_replaces_existing_file(void)
+{
+	setup_tmp_dir();
+	char path[512];
+	snprintf(path, sizeof(path), "%s/replace.txt", g_tmp_dir);
+	assert(scoreboard_writer_submit(path, "a much longer first value"));
+	assert(scoreboard_writer_submit(path, "short"));
+	char *content = read_output("replace.txt");
+	assert(strcmp(content, "short") == 0);
+	free(content);
+	cleanup_tmp_dir();
+}
+
+static void test_writer_submit_errors(void)
+{
+	assert(!scoreboard_writer_submit(NULL, "x"));
+	assert(!scoreboard_writer_submit("/tmp/x", NULL));
+	/* Synchronous path reports failure directly */
+	assert(!scoreboard_writer_submit("/nonexistent/dir/file.txt", "x"));
+
+	/* Asynchronous path counts the failure */
+	assert(scoreboard_writer_start());
+	assert(scoreboard_writer_submit("/nonexistent/dir/file.txt", "x"));
+	scoreboard_writer_flush();
+	struct scoreboard_writer_stats stats;
+	scoreboard_writer_get_stats(&stats);
+	assert(stats.errors == 1);
+	scoreboard_writer_stop();
+	scoreboard_writer_get_stats(NULL);
+}
+
+/* A failure on the worker reaches the core, which retries the file */
+static void test_writer_failure_marks_dirty(void)
+{
+	scoreboard_reset_state_for_tests();
+	setup_tmp_dir();
+	char missing[300];
+	snprintf(missing, sizeof(missing), "%s/missing", g_tmp_dir);
+	assert(scoreboard_writer_start());
+	scoreboard_set_output_directory(missing);
+	scoreboard_reset_write_stats();
+	/* Queued, so the failure only shows once the worker tries */
+	assert(scoreboard_write_all_files());
+	scoreboard_writer_flush();
+
+	assert(scoreboard_is_dirty());
+	assert(scoreboard_get_dirty_fields() == SCOREBOARD_FIELDS_ALL);
+	struct scoreboard_write_stats stats;
+	scoreboard_get_write_stats(&stats);
+	assert(stats.write_errors == SCOREBOARD_FIELD_COUNT);
+
+	/* The retry needs no further change */
+	mkdir(missing, 0755);
+	assert(scoreboard_write_all_files());
+	scoreboard_writer_flush();
+	assert(!scoreboard_is_dirty());
+	char path[400];
+	snprintf(path, sizeof(path), "%s/home_score.txt", missing);
+	FILE *f = fopen(path, "r");
+	assert(f != NULL);
+	fclose(f);
+
+	/* A failed snapshot file leaves every field dirty */
+	snprintf(missing, sizeof(missing), "%s/gone", g_tmp_dir);
+	scoreboard_set_output_directory(missing);
+	scoreboard_set_output_mode(SCOREBOARD_OUTPUT_JSON);
+	assert(scoreboard_write_all_files());
+	scoreboard_writer_flush();
+	assert(scoreboard_get_dirty_fields() == 0);
+	assert(scoreboard_is_dirty());
+	assert(scoreboard_get_dirty_fields() == SCOREBOARD_FIELDS_ALL);
+
+	/* Failures under another directory are left for their owner */
+	scoreboard_set_output_directory(g_tmp_dir);
+	assert(scoreboard_write_all_files());
+	scoreboard_writer_flush();
+	assert(!scoreboard_is_dirty());
+	char other[300];
+	snprintf(other, sizeof(other), "%s/other/file.txt", g_tmp_dir);
+	assert(scoreboard_writer_submit(other, "x"));
+	assert(scoreboard_writer_submit("/nonexistent/dir/file.txt", "x"));
+	scoreboard_writer_flush();
+	assert(!scoreboard_is_dirty());
+
+	scoreboard_writer_stop();
+	cleanup_tmp_dir();
+}
+
+static void test_writer_overflow_writes_inline(void)
+{
+	setup_tmp_dir();
+	assert(scoreboard_writer_start());
+	/* More distinct files than the queue has slots; all must land */
+	char path[512];
+	for (int i = 0; i < 200; i++) {
+		snprintf(path, sizeof(path), "%s/file%d.txt", g_tmp_dir, i);
+		assert(scoreboard_writer_submit(path, "v"));
+	}
+	scoreboard_writer_flush();
+	for (int i = 0; i < 200; i++) {
+		char name[32];
+		snprintf(name, sizeof(name), "file%d.txt", i);
+		assert(output_exists(name));
+	}
+	scoreboard_writer_stop();
+	cleanup_tmp_dir();
+}
+
+int main(void)
+{
+	test_writer_start_stop();
+	test_writer_publishes_all_files();
+	test_writer_coalesces_to_latest();
+	test_writer_replaces_existing_file();
+	test_writer_submit_errors();
+	test_writer_failure_marks_dirty();
+	test_writer_overflow_writes_inline();
+
+	printf("All scoreboard-core writer tests passed.\n");
+	return 0;
+}
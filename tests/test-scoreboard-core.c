@@ -2,7 +2,17 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define mkdir(path, mode) _mkdir(path)
+#define getpid() _getpid()
+#else
+#include <unistd.h>
+#endif
 
 static int g_log_call_count = 0;
 static enum scoreboard_log_level g_last_log_level;
@@ -113,6 +123,232 @@ static void test_clock_tick_countup_cap(void)
 	assert(scoreboard_clock_get_tenths() == max);
 }
 
+static void test_display_change_clock(void)
+{
+	scoreboard_reset_state_for_tests();
+	/* Nothing changes by itself while stopped */
+	assert(scoreboard_tenths_until_display_change() == -1);
+
+	scoreboard_clock_set_tenths(123); /* 0:12 until it drops below 120 */
+	scoreboard_clock_start();
+	assert(scoreboard_tenths_until_display_change() == 4);
+	scoreboard_clock_tick(4);
+	/* Exactly on a second: the next one is a full second away */
+	assert(scoreboard_tenths_until_display_change() == 10);
+
+	/* The last partial second ends with the clock stopping */
+	scoreboard_clock_set_tenths(5);
+	assert(scoreboard_tenths_until_display_change() == 5);
+	scoreboard_clock_set_tenths(0);
+	assert(scoreboard_tenths_until_display_change() == 1);
+
+	scoreboard_set_clock_direction(SCOREBOARD_CLOCK_COUNT_UP);
+	scoreboard_clock_set_tenths(123);
+	assert(scoreboard_tenths_until_display_change() == 7);
+	int max = scoreboard_get_period_length() * 10;
+	scoreboard_clock_set_tenths(max - 3);
+	assert(scoreboard_tenths_until_display_change() == 3);
+}
+
+static void test_display_change_penalties(void)
+{
+	scoreboard_reset_state_for_tests();
+	scoreboard_clock_set_tenths(9000);
+	scoreboard_clock_start();
+	scoreboard_clock_tick(1);
+	assert(scoreboard_tenths_until_display_change() == 10);
+
+	/* A new penalty is out of phase with the clock and wakes it earlier */
+	scoreboard_home_penalty_add(12, 120);
+	assert(scoreboard_tenths_until_display_change() == 1);
+	scoreboard_clock_tick(1);
+	assert(scoreboard_tenths_until_display_change() == 9);
+
+	/* Only running penalties count; queued ones don't tick */
+	scoreboard_reset_state_for_tests();
+	scoreboard_clock_set_tenths(9000);
+	scoreboard_home_penalty_add(1, 120);
+	scoreboard_home_penalty_add(2, 120);
+	scoreboard_clock_start();
+	scoreboard_clock_tick(5);
+	scoreboard_home_penalty_add(3, 120);
+	assert(scoreboard_tenths_until_display_change() == 6);
+}
+
+#define MS 1000000ull
+
+static uint64_t g_fake_now;
+
+static uint64_t fake_now(void)
+{
+	return g_fake_now;
+}
+
+static void test_clock_sync_from_start_time(void)
+{
+	scoreboard_reset_state_for_tests();
+	g_fake_now = 5000 * MS;
+	scoreboard_set_time_source(fake_now);
+	scoreboard_clock_set_tenths(9000);
+
+	/* Nothing runs while stopped */
+	g_fake_now += 500 * MS;
+	scoreboard_clock_sync();
+	assert(scoreboard_clock_get_tenths() == 9000);
+
+	scoreboard_clock_start();
+	g_fake_now += 150 * MS;
+	scoreboard_clock_sync();
+	assert(scoreboard_clock_get_tenths() == 8999);
+	/* Starting again must not restart the partial tenth */
+	scoreboard_clock_start();
+
+	/* Uneven sync intervals neither lose nor gain time: 1000 syncs of
+	   37 ms are exactly 37 s after the 150 ms already run */
+	for (int i = 0; i < 1000; i++) {
+		g_fake_now += 37 * MS;
+		scoreboard_clock_sync();
+	}
+	assert(scoreboard_clock_get_tenths() == 9000 - 371);
+
+	/* A stall is caught up in one go */
+	g_fake_now += 60000 * MS;
+	scoreboard_clock_sync();
+	assert(scoreboard_clock_get_tenths() == 9000 - 971);
+
+	/* Stopping applies the time since the last sync */
+	g_fake_now += 250 * MS;
+	scoreboard_clock_stop();
+	assert(scoreboard_clock_get_tenths() == 9000 - 974);
+	assert(!scoreboard_clock_is_running());
+
+	scoreboard_set_time_source(NULL);
+}
+
+static void test_clock_sync_penalties(void)
+{
+	scoreboard_reset_state_for_tests();
+	g_fake_now = 0;
+	scoreboard_set_time_source(fake_now);
+	scoreboard_home_penalty_add(12, 120);
+	scoreboard_clock_start();
+
+	g_fake_now += 2050 * MS;
+	scoreboard_clock_sync();
+	assert(scoreboard_get_home_penalty(0)->remaining_tenths == 1200 - 20);
+
+	/* A penalty added mid-run starts from its full time */
+	scoreboard_away_penalty_add(7, 120);
+	g_fake_now += 1000 * MS;
+	scoreboard_clock_sync();
+	assert(scoreboard_get_home_penalty(0)->remaining_tenths == 1200 - 30);
+	assert(scoreboard_get_away_penalty(0)->remaining_tenths == 1200 - 10);
+	assert(scoreboard_clock_get_tenths() == 9000 - 30);
+
+	scoreboard_set_time_source(NULL);
+}
+
+static void test_clock_read_without_sync(void)
+{
+	scoreboard_reset_state_for_tests();
+	g_fake_now = 0;
+	scoreboard_set_time_source(fake_now);
+	scoreboard_clock_start();
+
+	/* Readers see the running value before anything syncs */
+	g_fake_now += 2050 * MS;
+	assert(scoreboard_clock_get_tenths() == 9000 - 20);
+	char buf[16];
+	scoreboard_clock_format(buf, sizeof(buf));
+	assert(strcmp(buf, "14:58") == 0);
+	/* A hand tick would count the same time twice */
+	scoreboard_clock_tick(100);
+	scoreboard_clock_sync();
+	assert(scoreboard_clock_get_tenths() == 9000 - 20);
+
+	/* Reads stop at the end of the period, as a sync would */
+	g_fake_now += 1000000 * MS;
+	assert(scoreboard_clock_get_tenths() == 0);
+	scoreboard_set_clock_direction(SCOREBOARD_CLOCK_COUNT_UP);
+	assert(scoreboard_clock_get_tenths() == 9000);
+	scoreboard_clock_sync();
+	assert(!scoreboard_clock_is_running());
+
+	scoreboard_set_time_source(NULL);
+}
+
+static void test_clock_edit_while_running(void)
+{
+	scoreboard_reset_state_for_tests();
+	g_fake_now = 0;
+	scoreboard_set_time_source(fake_now);
+	scoreboard_home_penalty_add(12, 120);
+	scoreboard_clock_start();
+
+	/* Time run before an edit is applied before it, not on top */
+	g_fake_now += 900 * MS;
+	scoreboard_clock_set_tenths(3000);
+	assert(scoreboard_clock_get_tenths() == 3000);
+	assert(scoreboard_get_home_penalty(0)->remaining_tenths == 1200 - 9);
+	g_fake_now += 900 * MS;
+	scoreboard_clock_adjust_seconds(1);
+	assert(scoreboard_clock_get_tenths() == 3000 - 9 + 10);
+	assert(scoreboard_get_home_penalty(0)->remaining_tenths ==
+	       1200 - 18 + 10);
+	g_fake_now += 900 * MS;
+	scoreboard_clock_adjust_minutes(-1);
+	assert(scoreboard_clock_get_tenths() == 3001 - 9 - 600);
+	assert(scoreboard_get_home_penalty(0)->remaining_tenths ==
+	       1192 - 9 - 600);
+
+	/* Reloaded clock and penalty times replace what has run */
+	char dir[256];
+	snprintf(dir, sizeof(dir), "/tmp/scoreboard_core_%d", (int)getpid());
+	mkdir(dir, 0755);
+	scoreboard_set_output_directory(dir);
+	scoreboard_clock_stop();
+	scoreboard_clock_set_tenths(3000);
+	scoreboard_home_penalty_clear(0);
+	scoreboard_home_penalty_add(12, 120);
+	assert(scoreboard_write_all_files());
+	scoreboard_clock_start();
+	g_fake_now += 900 * MS;
+	assert(scoreboard_read_all_files());
+	assert(scoreboard_clock_get_tenths() == 3000);
+	assert(scoreboard_get_home_penalty(0)->remaining_tenths == 1200);
+	g_fake_now += 100 * MS;
+	scoreboard_clock_sync();
+	assert(scoreboard_clock_get_tenths() == 2999);
+	assert(scoreboard_get_home_penalty(0)->remaining_tenths == 1199);
+
+	char cmd[512];
+	snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+	system(cmd);
+	scoreboard_set_time_source(NULL);
+}
+
+static void test_ns_until_display_change(void)
+{
+	scoreboard_reset_state_for_tests();
+	g_fake_now = 0;
+	scoreboard_set_time_source(fake_now);
+	assert(scoreboard_ns_until_display_change() == -1);
+
+	scoreboard_clock_start();
+	/* 900.0 s drops to 899 after one tenth */
+	g_fake_now += 30 * MS;
+	assert(scoreboard_ns_until_display_change() == (int64_t)(70 * MS));
+	g_fake_now += 100 * MS;
+	scoreboard_clock_sync();
+	assert(scoreboard_ns_until_display_change() == (int64_t)(970 * MS));
+
+	/* Overdue deadlines fire right away */
+	g_fake_now += 5000 * MS;
+	assert(scoreboard_ns_until_display_change() == 0);
+
+	scoreboard_set_time_source(NULL);
+}
+
 static void test_clock_reset_countdown(void)
 {
 	scoreboard_reset_state_for_tests();
@@ -797,6 +1033,13 @@ int main(void)
 	test_clock_tick_countdown_floor();
 	test_clock_tick_countup();
 	test_clock_tick_countup_cap();
+	test_display_change_clock();
+	test_display_change_penalties();
+	test_clock_sync_from_start_time();
+	test_clock_sync_penalties();
+	test_clock_read_without_sync();
+	test_clock_edit_while_running();
+	test_ns_until_display_change();
 	test_clock_reset_countdown();
 	test_clock_reset_countup();
 	test_clock_set_tenths_negative();